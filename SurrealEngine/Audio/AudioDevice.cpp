@@ -8,6 +8,7 @@
 #include "UObject/USound.h"
 #include <mutex>
 #include "Exception.h"
+#include "Trace.h"
 #include <map>
 #include <cmath>
 #include <queue>
@@ -234,13 +235,9 @@ public:
 		ALCenum error = alcGetError(alDevice);
 		if (error != ALC_NO_ERROR) {
 			std::cerr << "ALC error: " << error << std::endl;
-		} else {
-			std::cout << "Number of mono sources: " << monoSources << std::endl;
 		}
 
 		// Init sound sources
-		std::cout << "Mono sources count before:" << monoSources << std::endl;
-
 		alcGetIntegerv(alDevice, ALC_MONO_SOURCES, 1, &monoSources);
 		alcGetIntegerv(alDevice, ALC_STEREO_SOURCES, 1, &stereoSources);
 
@@ -248,15 +245,9 @@ public:
 		monoSources = 2048; // for some reason Emscripten's OpenAL gives infinite monoSources count, bug?
 #endif
 
-		std::cout << "Mono sources count after:" << monoSources << std::endl;
+		TRACE_EVENT_TEXT(TraceCategory::Audio, "AudioSources", std::to_string(monoSources) + " mono, " + std::to_string(stereoSources) + " stereo");
 
 		// TODO: how do we prioritize mono vs stereo source count?
-		if (monoSources < 1) {
-			std::cout << "STOP RESIZE TO 0 count!!!" << std::endl;
-		}
-		else {
-			std::cout << "Resize sources to:" << monoSources << std::endl;
-		}
 		sources.resize(monoSources);		
 
 		// init music source/buffer
@@ -355,11 +346,7 @@ public:
 	int PlaySound(int channel, USound* sound, vec3& location, float volume, float radius, float pitch) override
 	{
 		if (!std::isfinite(volume) || volume < 0.0f || !std::isfinite(pitch) || channel >= sources.size()) {
-			std::cout << volume << std::endl;
-			std::cout << pitch << std::endl;
-			std::cout << channel << std::endl;
-			std::cout << sources.size() << std::endl;
-			Exception::Throw("Invalid PlaySound arguments");
+			Exception::Throw("Invalid PlaySound arguments (volume " + std::to_string(volume) + ", pitch " + std::to_string(pitch) + ", channel " + std::to_string(channel) + ")");
 		}
 
 		ALSoundSource& source = sources[channel];
@@ -3,6 +3,7 @@
 #include "AudioMixer.h"
 #include "AudioSource.h"
 #include "AudioPlayer.h"
+#include "AudioVoiceMixer.h"
 #include <mutex>
 #include <stdexcept>
 #include <map>
@@ -49,6 +50,12 @@ public:
 			{
 				loopinfo = {};
 			}
+
+			voicedata.Samples = samples.data();
+			voicedata.Size = samples.size();
+			voicedata.Looped = loopinfo.Looped;
+			voicedata.LoopStart = loopinfo.LoopStart;
+			voicedata.LoopEnd = loopinfo.LoopEnd;
 		}
 		else
 		{
@@ -59,6 +66,7 @@ public:
 	std::vector<float> samples;
 	float duration = 0.0f;
 	AudioLoopInfo loopinfo;
+	AudioVoiceData voicedata;
 };
 
 class ActiveSound
@@ -90,10 +98,8 @@ public:
 	void CopyMusic(float* output, size_t samples);
 	void MixSounds(float* output, size_t samples);
 
-	void GetVolume(const ActiveSound& sound, float& leftVolume, float& rightVolume);
-
 	AudioMixerImpl* mixer = nullptr;
-	std::map<int, ActiveSound> sounds;
+	AudioVoiceMixer voices;
 	std::vector<int> stoppedsounds;
 	std::unique_ptr<AudioSource> music;
 	float soundvolume = 1.0f;
@@ -276,26 +282,22 @@ void AudioMixerSource::TransferFromClient()
 	{
 		if (!s.update) // if play or stop
 		{
-			auto it = sounds.find(s.channel);
-			if (it != sounds.end())
-			{
+			if (voices.StopVoice(s.channel))
 				stoppedsounds.push_back(s.channel);
-				sounds.erase(it);
-			}
 		}
 
 		if (s.play)
 		{
-			sounds[s.channel] = s;
+			voices.StartVoice(s.channel, &s.sound->voicedata, s.volume, s.pan, s.pitch);
 		}
 		else if (s.update)
 		{
-			auto it = sounds.find(s.channel);
-			if (it != sounds.end())
+			AudioVoice* voice = voices.FindVoice(s.channel);
+			if (voice)
 			{
-				it->second.volume = s.volume;
-				it->second.pan = s.pan;
-				it->second.pitch = s.pitch;
+				voice->Volume = s.volume;
+				voice->Pan = s.pan;
+				voice->Pitch = s.pitch;
 			}
 		}
 	}
@@ -334,101 +336,5 @@ void AudioMixerSource::CopyMusic(float* output, size_t samples)
 
 void AudioMixerSource::MixSounds(float* output, size_t samples)
 {
-	samples /= 2;
-
-	auto it = sounds.begin();
-	while (it != sounds.end())
-	{
-		ActiveSound& sound = it->second;
-		const float* src = sound.sound->samples.data();
-		double srcpos = sound.pos;
-		double srcpitch = sound.pitch;
-		int srcsize = (int)sound.sound->samples.size();
-		int srcmax = srcsize - 1;
-		if (srcmax < 0)
-		{
-			stoppedsounds.push_back(sound.channel);
-			it = sounds.erase(it);
-			continue;
-		}
-
-		float leftVolume, rightVolume;
-		GetVolume(sound, leftVolume, rightVolume);
-
-		if (sound.sound->loopinfo.Looped)
-		{
-			double loopStart = (double)sound.sound->loopinfo.LoopStart;
-			double loopEnd = (double)sound.sound->loopinfo.LoopEnd;
-			double loopLen = loopEnd - loopStart;
-
-			for (size_t i = 0; i < samples; i++)
-			{
-				double p0 = srcpos;
-				double p1 = srcpos + 1;
-				if (p0 >= loopEnd) p0 -= loopLen;
-				if (p1 >= loopEnd) p1 -= loopLen;
-
-				int pos = (int)p0;
-				int pos2 = (int)p1;
-				float t = (float)(p0 - pos);
-
-				pos = std::min(pos, srcmax);
-				pos2 = std::min(pos2, srcmax);
-
-				float value = (src[pos] * t + src[pos2] * (1.0f - t));
-				output[i << 1] += value * leftVolume;
-				output[(i << 1) + 1] += value * rightVolume;
-
-				srcpos += srcpitch;
-				while (srcpos >= loopEnd)
-					srcpos -= loopLen;
-			}
-
-			sound.pos = srcpos;
-			++it;
-		}
-		else
-		{
-			if (leftVolume > 0.0f || rightVolume > 0.0f)
-			{
-				for (size_t i = 0; i < samples; i++)
-				{
-					int pos = (int)srcpos;
-					int pos2 = pos + 1;
-					float t = (float)(srcpos - pos);
-
-					pos = std::min(pos, srcmax);
-					pos2 = std::min(pos2, srcmax);
-
-					float value = (src[pos] * t + src[pos2] * (1.0f - t));
-					output[i << 1] += value * leftVolume;
-					output[(i << 1) + 1] += value * rightVolume;
-
-					srcpos += srcpitch;
-				}
-			}
-			else
-			{
-				srcpos += srcpitch * samples;
-			}
-
-			if (srcpos < sound.sound->samples.size())
-			{
-				sound.pos = srcpos;
-				++it;
-			}
-			else
-			{
-				stoppedsounds.push_back(sound.channel);
-				it = sounds.erase(it);
-			}
-		}
-	}
-}
-
-void AudioMixerSource::GetVolume(const ActiveSound& sound, float& leftVolume, float& rightVolume)
-{
-	auto clamp = [](float x, float minval, float maxval) { return std::max(std::min(x, maxval), minval); };
-	leftVolume = clamp(sound.volume * std::min(1.0f - sound.pan, 1.0f) * soundvolume, 0.0f, 1.0f);
-	rightVolume = clamp(sound.volume * std::min(1.0f + sound.pan, 1.0f) * soundvolume, 0.0f, 1.0f);
+	voices.Mix(output, samples / 2, soundvolume, stoppedsounds);
 }
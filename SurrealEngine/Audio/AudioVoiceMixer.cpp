@@ -0,0 +1,393 @@
+
+#include "Precomp.h"
+#include "AudioVoiceMixer.h"
+#include <algorithm>
+#include <cmath>
+
+#if !defined(NO_SSE) && !defined(NOSSE)
+#include <immintrin.h>
+#define AUDIOMIXER_SSE
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define AUDIOMIXER_NEON
+#endif
+
+static void GetTargetGains(const AudioVoice& voice, float masterVolume, float& leftGain, float& rightGain)
+{
+	auto clamp = [](float x, float minval, float maxval) { return std::max(std::min(x, maxval), minval); };
+	leftGain = clamp(voice.Volume * std::min(1.0f - voice.Pan, 1.0f) * masterVolume, 0.0f, 1.0f);
+	rightGain = clamp(voice.Volume * std::min(1.0f + voice.Pan, 1.0f) * masterVolume, 0.0f, 1.0f);
+}
+
+static uint64_t GetPitchStep(const AudioVoice& voice)
+{
+	return (uint64_t)(std::max(voice.Pitch, 0.0f) * 4294967296.0);
+}
+
+static float GetFraction(uint64_t pos)
+{
+	return (float)((uint32_t)pos >> 8) * (1.0f / 16777216.0f);
+}
+
+// Number of steps it takes for pos to reach end (or count if step is zero)
+static size_t StepsUntil(uint64_t pos, uint64_t end, uint64_t step, size_t count)
+{
+	if (pos >= end)
+		return 0;
+	if (step == 0)
+		return count;
+	return (size_t)std::min((end - pos + step - 1) / step, (uint64_t)count);
+}
+
+// Linear interpolation where both src[pos] and src[pos + 1] are known to be in range for all count frames
+static void ResampleLinear(const float* src, uint64_t pos, uint64_t step, float* dest, size_t count)
+{
+	size_t i = 0;
+
+#if defined(AUDIOMIXER_SSE)
+	for (; i + 4 <= count; i += 4)
+	{
+		uint64_t p0 = pos, p1 = pos + step, p2 = pos + step * 2, p3 = pos + step * 3;
+		const float* a0 = src + (p0 >> 32);
+		const float* a1 = src + (p1 >> 32);
+		const float* a2 = src + (p2 >> 32);
+		const float* a3 = src + (p3 >> 32);
+		__m128 s0 = _mm_setr_ps(a0[0], a1[0], a2[0], a3[0]);
+		__m128 s1 = _mm_setr_ps(a0[1], a1[1], a2[1], a3[1]);
+		__m128 t = _mm_setr_ps(GetFraction(p0), GetFraction(p1), GetFraction(p2), GetFraction(p3));
+		_mm_storeu_ps(dest + i, _mm_add_ps(s0, _mm_mul_ps(_mm_sub_ps(s1, s0), t)));
+		pos += step * 4;
+	}
+#elif defined(AUDIOMIXER_NEON)
+	for (; i + 4 <= count; i += 4)
+	{
+		uint64_t p[4] = { pos, pos + step, pos + step * 2, pos + step * 3 };
+		float s0[4], s1[4], t[4];
+		for (int j = 0; j < 4; j++)
+		{
+			const float* a = src + (p[j] >> 32);
+			s0[j] = a[0];
+			s1[j] = a[1];
+			t[j] = GetFraction(p[j]);
+		}
+		float32x4_t v0 = vld1q_f32(s0);
+		float32x4_t v1 = vld1q_f32(s1);
+		vst1q_f32(dest + i, vmlaq_f32(v0, vsubq_f32(v1, v0), vld1q_f32(t)));
+		pos += step * 4;
+	}
+#endif
+
+	for (; i < count; i++)
+	{
+		const float* a = src + (pos >> 32);
+		dest[i] = a[0] + (a[1] - a[0]) * GetFraction(pos);
+		pos += step;
+	}
+}
+
+// Adds mono * gain to the interleaved stereo output, ramping the gains by leftStep/rightStep per frame
+static void MixStereo(float* output, const float* mono, size_t count, float left, float right, float leftStep, float rightStep)
+{
+	size_t i = 0;
+
+#if defined(AUDIOMIXER_SSE)
+	__m128 gainL = _mm_setr_ps(left, left + leftStep, left + leftStep * 2.0f, left + leftStep * 3.0f);
+	__m128 gainR = _mm_setr_ps(right, right + rightStep, right + rightStep * 2.0f, right + rightStep * 3.0f);
+	__m128 stepL = _mm_set1_ps(leftStep * 4.0f);
+	__m128 stepR = _mm_set1_ps(rightStep * 4.0f);
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 m = _mm_loadu_ps(mono + i);
+		__m128 l = _mm_mul_ps(m, gainL);
+		__m128 r = _mm_mul_ps(m, gainR);
+		float* out = output + (i << 1);
+		_mm_storeu_ps(out, _mm_add_ps(_mm_loadu_ps(out), _mm_unpacklo_ps(l, r)));
+		_mm_storeu_ps(out + 4, _mm_add_ps(_mm_loadu_ps(out + 4), _mm_unpackhi_ps(l, r)));
+		gainL = _mm_add_ps(gainL, stepL);
+		gainR = _mm_add_ps(gainR, stepR);
+	}
+#elif defined(AUDIOMIXER_NEON)
+	float initL[4] = { left, left + leftStep, left + leftStep * 2.0f, left + leftStep * 3.0f };
+	float initR[4] = { right, right + rightStep, right + rightStep * 2.0f, right + rightStep * 3.0f };
+	float32x4_t gainL = vld1q_f32(initL);
+	float32x4_t gainR = vld1q_f32(initR);
+	float32x4_t stepL = vdupq_n_f32(leftStep * 4.0f);
+	float32x4_t stepR = vdupq_n_f32(rightStep * 4.0f);
+	for (; i + 4 <= count; i += 4)
+	{
+		float32x4_t m = vld1q_f32(mono + i);
+		float32x4x2_t lr = vzipq_f32(vmulq_f32(m, gainL), vmulq_f32(m, gainR));
+		float* out = output + (i << 1);
+		vst1q_f32(out, vaddq_f32(vld1q_f32(out), lr.val[0]));
+		vst1q_f32(out + 4, vaddq_f32(vld1q_f32(out + 4), lr.val[1]));
+		gainL = vaddq_f32(gainL, stepL);
+		gainR = vaddq_f32(gainR, stepR);
+	}
+#endif
+
+	for (; i < count; i++)
+	{
+		output[i << 1] += mono[i] * (left + leftStep * i);
+		output[(i << 1) + 1] += mono[i] * (right + rightStep * i);
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+AudioVoice* AudioVoiceMixer::FindVoice(int channel)
+{
+	auto it = ChannelToVoice.find(channel);
+	return it != ChannelToVoice.end() ? &Voices[it->second] : nullptr;
+}
+
+AudioVoice& AudioVoiceMixer::StartVoice(int channel, const AudioVoiceData* data, float volume, float pan, float pitch)
+{
+	StopVoice(channel);
+
+	AudioVoice voice;
+	voice.Channel = channel;
+	voice.Data = data;
+	voice.Volume = volume;
+	voice.Pan = pan;
+	voice.Pitch = pitch;
+
+	ChannelToVoice[channel] = Voices.size();
+	Voices.push_back(voice);
+	return Voices.back();
+}
+
+bool AudioVoiceMixer::StopVoice(int channel)
+{
+	auto it = ChannelToVoice.find(channel);
+	if (it == ChannelToVoice.end())
+		return false;
+	RemoveVoice(it->second);
+	return true;
+}
+
+void AudioVoiceMixer::StopAll()
+{
+	Voices.clear();
+	ChannelToVoice.clear();
+}
+
+void AudioVoiceMixer::RemoveVoice(size_t index)
+{
+	ChannelToVoice.erase(Voices[index].Channel);
+	if (index + 1 != Voices.size())
+	{
+		Voices[index] = Voices.back();
+		ChannelToVoice[Voices[index].Channel] = index;
+	}
+	Voices.pop_back();
+}
+
+void AudioVoiceMixer::Mix(float* output, size_t frames, float masterVolume, std::vector<int>& finished)
+{
+	SelectAudibleVoices(masterVolume);
+
+	size_t i = 0;
+	while (i < Voices.size())
+	{
+		AudioVoice& voice = Voices[i];
+
+		bool playing;
+		if (voice.Virtual)
+		{
+			if (voice.LeftGain > 0.0f || voice.RightGain > 0.0f)
+				playing = MixVoice(voice, output, frames, 0.0f, 0.0f); // Fade out before going silent
+			else
+				playing = AdvanceVoice(voice, frames);
+			voice.Started = true;
+		}
+		else
+		{
+			float targetLeft, targetRight;
+			GetTargetGains(voice, masterVolume, targetLeft, targetRight);
+			playing = MixVoice(voice, output, frames, targetLeft, targetRight);
+		}
+
+		if (playing)
+		{
+			i++;
+		}
+		else
+		{
+			finished.push_back(voice.Channel);
+			RemoveVoice(i);
+		}
+	}
+}
+
+void AudioVoiceMixer::SelectAudibleVoices(float masterVolume)
+{
+	size_t count = Voices.size();
+	Priority.resize(count);
+	Audibility.resize(count);
+	for (size_t i = 0; i < count; i++)
+	{
+		float left, right;
+		GetTargetGains(Voices[i], masterVolume, left, right);
+		Priority[i] = (uint32_t)i;
+		Audibility[i] = std::max(left, right);
+	}
+
+	size_t maxVoices = (size_t)std::max(MaxVoices, 0);
+	if (count > maxVoices)
+	{
+		std::nth_element(Priority.begin(), Priority.begin() + maxVoices, Priority.end(), [&](uint32_t a, uint32_t b) {
+			if (Audibility[a] != Audibility[b])
+				return Audibility[a] > Audibility[b];
+			return Voices[a].Channel < Voices[b].Channel;
+		});
+	}
+
+	Stats = {};
+	for (size_t i = 0; i < count; i++)
+	{
+		uint32_t index = Priority[i];
+		AudioVoice& voice = Voices[index];
+		voice.Virtual = i >= maxVoices || Audibility[index] <= 0.0f;
+		if (voice.Virtual)
+			Stats.VirtualVoices++;
+		else
+			Stats.ActiveVoices++;
+	}
+}
+
+bool AudioVoiceMixer::MixVoice(AudioVoice& voice, float* output, size_t frames, float targetLeft, float targetRight)
+{
+	if (!voice.Started)
+	{
+		// Don't ramp in a new sound as that would soften its attack
+		voice.LeftGain = targetLeft;
+		voice.RightGain = targetRight;
+		voice.Started = true;
+	}
+
+	size_t rampFrames = std::min(frames, (size_t)RampFrames);
+	float left = voice.LeftGain;
+	float right = voice.RightGain;
+	float leftStep = rampFrames > 0 ? (targetLeft - left) / rampFrames : 0.0f;
+	float rightStep = rampFrames > 0 ? (targetRight - right) / rampFrames : 0.0f;
+
+	voice.LeftGain = targetLeft;
+	voice.RightGain = targetRight;
+
+	size_t pos = 0;
+	while (pos < frames)
+	{
+		size_t count = std::min(frames - pos, (size_t)BlockSize);
+		size_t produced = Resample(voice, MonoBlock, count);
+
+		size_t rampCount = pos < rampFrames ? std::min(produced, rampFrames - pos) : 0;
+		if (rampCount > 0)
+		{
+			MixStereo(output + (pos << 1), MonoBlock, rampCount, left, right, leftStep, rightStep);
+			left += leftStep * rampCount;
+			right += rightStep * rampCount;
+			if (pos + rampCount == rampFrames)
+			{
+				left = targetLeft;
+				right = targetRight;
+			}
+		}
+
+		if (left > 0.0f || right > 0.0f)
+			MixStereo(output + ((pos + rampCount) << 1), MonoBlock + rampCount, produced - rampCount, left, right, 0.0f, 0.0f);
+
+		pos += produced;
+		if (produced < count)
+			return false;
+	}
+	return true;
+}
+
+bool AudioVoiceMixer::AdvanceVoice(AudioVoice& voice, size_t frames)
+{
+	const AudioVoiceData* data = voice.Data;
+	voice.Position += GetPitchStep(voice) * frames;
+
+	uint64_t loopEnd = std::min(data->LoopEnd, data->Size);
+	if (data->Looped && data->LoopStart < loopEnd)
+	{
+		uint64_t loopStartFixed = data->LoopStart << 32;
+		uint64_t loopEndFixed = loopEnd << 32;
+		if (voice.Position >= loopEndFixed)
+			voice.Position = loopStartFixed + (voice.Position - loopStartFixed) % (loopEndFixed - loopStartFixed);
+		return true;
+	}
+	else
+	{
+		return voice.Position < (data->Size << 32);
+	}
+}
+
+size_t AudioVoiceMixer::Resample(AudioVoice& voice, float* dest, size_t count)
+{
+	const AudioVoiceData* data = voice.Data;
+	const float* src = data->Samples;
+	uint64_t size = data->Size;
+	uint64_t step = GetPitchStep(voice);
+	uint64_t pos = voice.Position;
+
+	if (size == 0)
+		return 0;
+
+	uint64_t lastFixed = (size - 1) << 32;
+	uint64_t loopEnd = std::min(data->LoopEnd, size);
+	if (data->Looped && data->LoopStart < loopEnd)
+	{
+		uint64_t loopStartFixed = data->LoopStart << 32;
+		uint64_t loopEndFixed = loopEnd << 32;
+		uint64_t loopLen = loopEnd - data->LoopStart;
+		uint64_t safeEnd = std::min((loopEnd - 1) << 32, lastFixed);
+
+		size_t i = 0;
+		while (i < count)
+		{
+			// Interpolate without wrapping until the next sample would have to come from the loop start
+			size_t n = StepsUntil(pos, safeEnd, step, count - i);
+			if (n > 0)
+			{
+				ResampleLinear(src, pos, step, dest + i, n);
+				pos += step * n;
+				i += n;
+			}
+			else
+			{
+				uint64_t index0 = std::min(pos >> 32, size - 1);
+				uint64_t index1 = index0 + 1;
+				if (index1 >= loopEnd)
+					index1 -= loopLen;
+				float s0 = src[index0];
+				float s1 = src[std::min(index1, size - 1)];
+				dest[i++] = s0 + (s1 - s0) * GetFraction(pos);
+				pos += step;
+			}
+
+			if (pos >= loopEndFixed)
+				pos = loopStartFixed + (pos - loopStartFixed) % (loopEndFixed - loopStartFixed);
+		}
+
+		voice.Position = pos;
+		return count;
+	}
+	else
+	{
+		count = StepsUntil(pos, size << 32, step, count);
+
+		size_t safe = StepsUntil(pos, lastFixed, step, count);
+		ResampleLinear(src, pos, step, dest, safe);
+		pos += step * safe;
+
+		for (size_t i = safe; i < count; i++)
+		{
+			dest[i] = src[std::min(pos >> 32, size - 1)];
+			pos += step;
+		}
+
+		voice.Position = pos;
+		return count;
+	}
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <unordered_map>
+
+// Mono sample data a voice plays from. Owned by whoever created the sound.
+class AudioVoiceData
+{
+public:
+	const float* Samples = nullptr;
+	uint64_t Size = 0;
+	bool Looped = false;
+	uint64_t LoopStart = 0;
+	uint64_t LoopEnd = 0;
+};
+
+class AudioVoice
+{
+public:
+	int Channel = 0;
+	const AudioVoiceData* Data = nullptr;
+	float Volume = 0.0f;
+	float Pan = 0.0f;
+	float Pitch = 1.0f;
+
+	// Playback position in 32.32 fixed point
+	uint64_t Position = 0;
+
+	// Gains at the end of the last mixed block. Used as the start of the next volume ramp.
+	float LeftGain = 0.0f;
+	float RightGain = 0.0f;
+	bool Started = false;
+	bool Virtual = false;
+};
+
+class AudioVoiceMixerStats
+{
+public:
+	int ActiveVoices = 0;
+	int VirtualVoices = 0;
+};
+
+// Mixes mono voices into an interleaved stereo buffer.
+//
+// Voices are stored contiguously and looked up by channel. When more voices are playing than MaxVoices
+// the least audible ones become virtual: their position keeps advancing but they are not mixed.
+class AudioVoiceMixer
+{
+public:
+	AudioVoice* FindVoice(int channel);
+	AudioVoice& StartVoice(int channel, const AudioVoiceData* data, float volume, float pan, float pitch);
+	bool StopVoice(int channel);
+	void StopAll();
+
+	// Adds all voices to output (interleaved stereo, frames * 2 floats). Channels that finished playing are appended to finished.
+	void Mix(float* output, size_t frames, float masterVolume, std::vector<int>& finished);
+
+	const std::vector<AudioVoice>& GetVoices() const { return Voices; }
+	const AudioVoiceMixerStats& GetStats() const { return Stats; }
+
+	int MaxVoices = 64;
+
+	// Number of frames a volume change is spread over to avoid zipper noise
+	static const int RampFrames = 128;
+
+private:
+	void RemoveVoice(size_t index);
+	void SelectAudibleVoices(float masterVolume);
+	bool MixVoice(AudioVoice& voice, float* output, size_t frames, float targetLeft, float targetRight);
+	bool AdvanceVoice(AudioVoice& voice, size_t frames);
+	size_t Resample(AudioVoice& voice, float* dest, size_t count);
+
+	std::vector<AudioVoice> Voices;
+	std::unordered_map<int, size_t> ChannelToVoice;
+	std::vector<float> Audibility;
+	std::vector<uint32_t> Priority;
+	AudioVoiceMixerStats Stats;
+
+	static const int BlockSize = 256;
+	alignas(16) float MonoBlock[BlockSize];
+};
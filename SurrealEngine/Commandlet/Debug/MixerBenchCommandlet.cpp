@@ -0,0 +1,87 @@
+
+#include "Precomp.h"
+#include "MixerBenchCommandlet.h"
+#include "DebuggerApp.h"
+#include "Audio/AudioVoiceMixer.h"
+#include <chrono>
+#include <cmath>
+#include <random>
+
+MixerBenchCommandlet::MixerBenchCommandlet()
+{
+	SetLongFormName("mixerbench");
+	SetShortDescription("Measure software mixer performance");
+}
+
+void MixerBenchCommandlet::OnCommand(DebuggerApp* console, const std::string& args)
+{
+	std::vector<std::string> params = SplitString(args);
+
+	int voiceCount = params.size() > 0 && !params[0].empty() ? std::stoi(params[0]) : 256;
+	double seconds = params.size() > 1 ? std::stod(params[1]) : 10.0;
+	int maxVoices = params.size() > 2 ? std::stoi(params[2]) : voiceCount;
+
+	const int frequency = 48000;
+	const size_t bufferFrames = 512;
+
+	// A few seconds of looped noise and a one shot sine burst, like weapon loops and impacts
+	std::mt19937 random(1234);
+	std::uniform_real_distribution<float> noise(-1.0f, 1.0f);
+	std::vector<float> loopSamples(frequency * 2);
+	for (float& s : loopSamples)
+		s = noise(random) * 0.25f;
+	std::vector<float> shotSamples(frequency / 2);
+	for (size_t i = 0; i < shotSamples.size(); i++)
+		shotSamples[i] = std::sin(i * 0.05f) * (1.0f - i / (float)shotSamples.size());
+
+	AudioVoiceData loopData;
+	loopData.Samples = loopSamples.data();
+	loopData.Size = loopSamples.size();
+	loopData.Looped = true;
+	loopData.LoopStart = 1000;
+	loopData.LoopEnd = loopSamples.size() - 1000;
+
+	AudioVoiceData shotData;
+	shotData.Samples = shotSamples.data();
+	shotData.Size = shotSamples.size();
+
+	std::uniform_real_distribution<float> volume(0.0f, 1.0f);
+	std::uniform_real_distribution<float> pan(-1.0f, 1.0f);
+	std::uniform_real_distribution<float> pitch(0.5f, 1.5f);
+
+	AudioVoiceMixer mixer;
+	mixer.MaxVoices = maxVoices;
+	for (int i = 0; i < voiceCount; i++)
+		mixer.StartVoice(i, (i & 1) ? &shotData : &loopData, volume(random), pan(random), pitch(random));
+
+	std::vector<float> output(bufferFrames * 2);
+	std::vector<int> finished;
+	size_t totalFrames = (size_t)(seconds * frequency);
+	int mixedVoices = 0;
+	int buffers = 0;
+
+	auto startTime = std::chrono::steady_clock::now();
+	for (size_t frame = 0; frame < totalFrames; frame += bufferFrames)
+	{
+		std::fill(output.begin(), output.end(), 0.0f);
+		mixer.Mix(output.data(), bufferFrames, 1.0f, finished);
+
+		// Keep the voice count constant by restarting finished one shots
+		for (int channel : finished)
+			mixer.StartVoice(channel, &shotData, volume(random), pan(random), pitch(random));
+		finished.clear();
+
+		mixedVoices += mixer.GetStats().ActiveVoices;
+		buffers++;
+	}
+	auto endTime = std::chrono::steady_clock::now();
+
+	double elapsed = std::chrono::duration<double>(endTime - startTime).count();
+	console->WriteOutput("Mixed " + std::to_string(voiceCount) + " voices (" + std::to_string(buffers > 0 ? mixedVoices / buffers : 0) + " audible) for " + std::to_string(seconds) + " seconds of audio" + NewLine());
+	console->WriteOutput("Time: " + std::to_string(elapsed * 1000.0) + " ms, " + std::to_string(elapsed > 0.0 ? seconds / elapsed : 0.0) + "x realtime" + NewLine());
+}
+
+void MixerBenchCommandlet::OnPrintHelp(DebuggerApp* console)
+{
+	console->WriteOutput("Syntax: mixerbench [voices] [seconds] [maxvoices]" + NewLine());
+}
@@ -140,7 +140,6 @@ void ExportCommandlet::ExportScripts(DebuggerApp* console, std::vector<std::stri
 	{
 		if (pkgname == "Editor")
 			continue;
-		std::cout << "GP5" << std::endl;
 		Package* package = engine->packages->GetPackage(pkgname, 997);
 		std::vector<UClass*> classes = package->GetAllObjects<UClass>();
 		if (!classes.empty())
@@ -206,7 +205,6 @@ void ExportCommandlet::ExportTextures(DebuggerApp* console, std::vector<std::str
 	{
 		if (pkgname == "Editor")
 			continue;
-		std::cout << "GP6" << std::endl;
 		Package* package = engine->packages->GetPackage(pkgname, 996);
 		std::vector<UTexture*> objects = package->GetAllObjects<UTexture>();
 		if (!objects.empty())
@@ -16,7 +16,6 @@ std::string NativeObjExtractor::Run(PackageManager* packages)
 	{
 		if (pkgname == "Editor")
 			continue;
-std::cout << "GP8" << std::endl;
 		Package* package = packages->GetPackage(pkgname.ToString(), 994);
 
 		JsonValue jsonPackage = CreatePackageJson(package);
@@ -24,7 +24,7 @@ void PrintCommandlet::OnCommand(DebuggerApp* console, const std::string& args)
 	{
 		obj = frame->Object;
 	}
-	else
+	else if (frame->Variables)
 	{
 		for (UProperty* prop : frame->Func->Properties)
 		{
@@ -9,6 +9,7 @@
 #include "Commandlet/QuitCommandlet.h"
 #include "Commandlet/RunCommandlet.h"
 #include "Commandlet/Debug/CollisionCommandlet.h"
+#include "Commandlet/Debug/MixerBenchCommandlet.h"
 #include "Commandlet/VM/BreakpointCommandlet.h"
 #include "Commandlet/VM/CallstackCommandlet.h"
 #include "Commandlet/VM/DisassemblyCommandlet.h"
@@ -94,6 +95,7 @@ void DebuggerApp::CreateCommandlets()
 	Commandlets.push_back(std::make_unique<ContinueCommandlet>());
 	Commandlets.push_back(std::make_unique<QuitCommandlet>());
 	Commandlets.push_back(std::make_unique<CollisionCommandlet>());
+	Commandlets.push_back(std::make_unique<MixerBenchCommandlet>());
 }
 
 void DebuggerApp::Tick()
@@ -342,6 +342,7 @@ MemoryStreamWriter Exporter::ExportBmpIndexed(UTexture* tex)
 
 	hdr.pixelOffset = data.Tell();
 
+	tex->LoadMipmapData();
 	uint8_t *pixels = tex->Mipmaps[0].Data.data();
 	for (int y = vsize; y > 0; y--)
 	{
@@ -385,6 +386,7 @@ MemoryStreamWriter Exporter::GetImageP8(UTexture* tex)
 {
 	MemoryStreamWriter data;
 	UPalette* palette = tex->Palette();
+	tex->LoadMipmapData();
 	uint8_t* pixels = tex->Mipmaps[0].Data.data();
 
 	int usize = tex->USize();
@@ -2,6 +2,10 @@
 #include "Precomp.h"
 #include "Engine.h"
 #include "File.h"
+#include "MemoryStats.h"
+#include "FrameProfiler.h"
+#include "Trace.h"
+#include "GC/GC.h"
 #include "Render/RenderSubsystem.h"
 #include "Package/PackageManager.h"
 #include "Package/ObjectStream.h"
@@ -21,9 +25,14 @@
 #include "Window/Window.h"
 #include "RenderDevice/RenderDevice.h"
 #include "Audio/AudioSubsystem.h"
+#include "Net/NetServer.h"
+#include "Net/NetClient.h"
+#include "Net/SocketPoller.h"
+#include "UObject/SaveGame.h"
 #include "VM/Frame.h"
 #include "VM/ScriptCall.h"
 #include <chrono>
+#include <thread>
 #include <set>
 #include "Audio/AudioDevice.h"
 
@@ -54,7 +63,7 @@ void Engine::Run()
 	#ifdef EMSCRIPTEN
 	if (engine_initialized != true) {
 	#endif
-		std::cout << "Engine::RUN()" << std::endl;
+		TRACE_EVENT(TraceCategory::Engine, "EngineStartup");
 		std::srand((unsigned int)std::time(nullptr));
 
 		gameengine = UObject::Cast<UGameEngine>(packages->NewObject("gameengine", "Engine", "GameEngine"));
@@ -64,7 +73,6 @@ void Engine::Run()
 		client = UObject::Cast<USurrealClient>(packages->NewObject("client", "Engine", "SurrealClient"));
 		viewport = UObject::Cast<UViewport>(packages->NewObject("viewport", "Engine", "Viewport"));
 		canvas = UObject::Cast<UCanvas>(packages->NewObject("canvas", "Engine", "Canvas"));
-		std::cout << "GP1" << std::endl;
 		DefaultTexture = UObject::Cast<UTexture>(packages->GetPackage("Engine", 999)->GetUObject("Texture", "DefaultTexture"));
 
 		std::string consolestr = packages->GetIniValue("system", "Engine.Engine", "Console");
@@ -79,32 +87,65 @@ void Engine::Run()
 		LoadEngineSettings();
 		LoadKeybindings();
 
-		std::cout << "Engine::RUN::PREOPEN_WINDOW" << std::endl;
-		OpenWindow();
-		std::cout << "Engine::RUN::POSTOPEN_WINDOW" << std::endl;
+		poller = std::make_unique<SocketPoller>();
+		saves = std::make_unique<SaveGame>();
 
-		audio = std::make_unique<AudioSubsystem>();
-		std::cout << "audio = std::make_unique<AudioSubsystem>();" << std::endl;
-		render = std::make_unique<RenderSubsystem>(window->GetRenderDevice());
-		std::cout << "render = std::make_unique<RenderSubsystem>(window->GetRenderDevice());" << std::endl;
+		GC::SetObjectRoots(
+			[this](std::vector<UObject*>& roots) { GetObjectRoots(roots); },
+			[this](std::vector<UObject*>& objects) { packages->GetLoadedObjects(objects); });
+		GC::SetObjectRecycler([this](UObject* obj) { return RecycleObject(obj); });
 
-		if (!client->StartupFullscreen)
-			viewport->bWindowsMouseAvailable() = true;
+		if (LaunchInfo.headless)
+		{
+			// Without a window the log is the only output there is
+			if (!printLogDebugger)
+				printLogDebugger = [](const LogMessageLine& line) { std::cout << line.Text << std::endl; };
+		}
+		else
+		{
+			OpenWindow();
+
+			audio = std::make_unique<AudioSubsystem>();
+			render = std::make_unique<RenderSubsystem>(window->GetRenderDevice());
+
+			if (!client->StartupFullscreen)
+				viewport->bWindowsMouseAvailable() = true;
+		}
 
 		if (!LaunchInfo.noEntryMap)
 			LoadEntryMap();
 
-		if (LaunchInfo.url.empty())
-			LoadMap(GetDefaultURL(packages->GetIniValue("system", "URL", "LocalMap")));
+		if (LaunchInfo.dedicatedServer)
+		{
+			int port = LaunchInfo.port != 0 ? LaunchInfo.port : std::atoi(packages->GetIniValue("system", "URL", "Port", "7777").c_str());
+			auto server = std::make_unique<NetServer>(netdev);
+			if (!server->Listen(port))
+				Exception::Throw("Could not listen on UDP port " + std::to_string(port));
+			net = std::move(server);
+			LogMessage("Dedicated server listening on UDP port " + std::to_string(port));
+		}
+
+		if (!LaunchInfo.connectAddress.empty())
+		{
+			// The server tells the client which map to load
+			net = std::make_unique<NetClient>(netdev);
+			static_cast<NetClient*>(net.get())->Connect(LaunchInfo.connectAddress, GetDefaultURL("").Options);
+		}
 		else
-			LoadMap(UnrealURL(GetDefaultURL(packages->GetIniValue("system", "URL", "LocalMap")), LaunchInfo.url));
+		{
+			if (LaunchInfo.url.empty())
+				LoadMap(GetDefaultURL(packages->GetIniValue("system", "URL", "LocalMap")));
+			else
+				LoadMap(UnrealURL(GetDefaultURL(packages->GetIniValue("system", "URL", "LocalMap")), LaunchInfo.url));
 
-		LoginPlayer();
+			LoginPlayer();
+		}
 
-		window->LockCursor();
+		if (window)
+			window->LockCursor();
 #ifdef EMSCRIPTEN
 		engine_initialized = true;
-		std::cout << "Engine loop started" << std:: endl;		
+		TRACE_EVENT(TraceCategory::Engine, "EngineLoopStarted");
 	}
 	if (!quit)
 #else	
@@ -117,11 +158,23 @@ void Engine::Run()
 		AudioSubsystem::Device.get()->MusicThreadMain();
 	}
 	else {
-		std::cout << "AudioSubsystem::Device is null" << std::endl;
+		TRACE_EVENT(TraceCategory::Audio, "NoAudioDevice");
 	}
 #endif
 
+		if (!window)
+			LimitTickRate(LaunchInfo.dedicatedServer ? netdev->NetServerMaxTickRate : 60.0f);
+
+		FrameProfiler::BeginFrame();
+
 		float realTimeElapsed = CalcTimeElapsed();
+		{
+			PROFILE_ZONE(ProfileZone::Network);
+			if (net)
+				net->TickDispatch(realTimeElapsed);
+			poller->Poll();
+		}
+
 		float entryLevelElapsed = EntryLevel ? clamp(realTimeElapsed * EntryLevelInfo->TimeDilation(), 1.0f / 400.0f, 1.0f / 2.5f) : 0.0f;
 		float levelElapsed = clamp(realTimeElapsed * LevelInfo->TimeDilation(), 1.0f / 400.0f, 1.0f / 2.5f);
 
@@ -129,9 +182,15 @@ void Engine::Run()
 			EntryLevelInfo->TimeSeconds() += entryLevelElapsed;
 		LevelInfo->TimeSeconds() += levelElapsed;
 
-		UpdateInput(realTimeElapsed);
+		if (window)
+		{
+			{
+				PROFILE_ZONE(ProfileZone::Input);
+				UpdateInput(realTimeElapsed);
+			}
 
-		CallEvent(console, EventName::Tick, { ExpressionValue::FloatValue(levelElapsed) });
+			CallEvent(console, EventName::Tick, { ExpressionValue::FloatValue(levelElapsed) });
+		}
 
 		// To do: set these to true if the frame rate is too low
 		if (LaunchInfo.engineVersion >= 436)
@@ -183,6 +242,13 @@ void Engine::Run()
 			}
 		}
 
+		if (!ClientTravelInfo.URL.Map.empty() && net && !net->IsServer())
+		{
+			// Network clients go wherever the server goes
+			LogMessage("Ignoring client travel to " + ClientTravelInfo.URL.ToString());
+			ClientTravelInfo.URL.Map.clear();
+		}
+
 		if (!ClientTravelInfo.URL.Map.empty())
 		{
 			// To do: need to do something about that travel type and transfering of items
@@ -213,34 +279,69 @@ void Engine::Run()
 			LoginPlayer();
 		}
 
-		// To do: improve CallEvent so parameter passing isn't this painful
-		UFunction* funcPlayerCalcView = FindEventFunction(viewport->Actor(), "PlayerCalcView");
-		if (funcPlayerCalcView)
+		if (PendingLoadSlot != -1)
+		{
+			PROFILE_ZONE(ProfileZone::Travel);
+			int slot = PendingLoadSlot;
+			PendingLoadSlot = -1;
+			saves->Load(slot);
+		}
+
+		if (net)
 		{
-			vecprop.Struct = UObject::Cast<UStructProperty>(funcPlayerCalcView->Properties[1])->Struct;
-			rotprop.Struct = UObject::Cast<UStructProperty>(funcPlayerCalcView->Properties[2])->Struct;
-			CameraActor = viewport->Actor();
-			CameraLocation = viewport->Actor()->Location();
-			CameraFovAngle = viewport->Actor()->FovAngle();
-			CallEvent(viewport->Actor(), EventName::PlayerCalcView, {
-				ExpressionValue::Variable(&CameraActor, &objprop),
-				ExpressionValue::Variable(&CameraLocation, &vecprop),
-				ExpressionValue::Variable(&CameraRotation, &rotprop)
-				});
+			PROFILE_ZONE(ProfileZone::Network);
+			net->TickFlush(realTimeElapsed);
 		}
 
-		UpdateAudio();
+		// Dedicated servers and clients still waiting for their pawn have nothing to show
+		if (window && viewport->Actor())
+		{
+			// To do: improve CallEvent so parameter passing isn't this painful
+			UFunction* funcPlayerCalcView = FindEventFunction(viewport->Actor(), "PlayerCalcView");
+			if (funcPlayerCalcView)
+			{
+				vecprop.Struct = UObject::Cast<UStructProperty>(funcPlayerCalcView->Properties[1])->Struct;
+				rotprop.Struct = UObject::Cast<UStructProperty>(funcPlayerCalcView->Properties[2])->Struct;
+				CameraActor = viewport->Actor();
+				CameraLocation = viewport->Actor()->Location();
+				CameraFovAngle = viewport->Actor()->FovAngle();
+				CallEvent(viewport->Actor(), EventName::PlayerCalcView, {
+					ExpressionValue::Variable(&CameraActor, &objprop),
+					ExpressionValue::Variable(&CameraLocation, &vecprop),
+					ExpressionValue::Variable(&CameraRotation, &rotprop)
+					});
+			}
+
+			UpdateAudio();
+
+			ViewportX = 0;
+			ViewportY = 0;
+			ViewportWidth = engine->window->GetPixelWidth();
+			ViewportHeight = engine->window->GetPixelHeight();
+			render->DrawGame(levelElapsed);
+		}
+
+		{
+			PROFILE_ZONE(ProfileZone::GC);
+			GC::Step();
+		}
 
-		ViewportX = 0;
-		ViewportY = 0;
-		ViewportWidth = engine->window->GetPixelWidth();
-		ViewportHeight = engine->window->GetPixelHeight();
-		render->DrawGame(levelElapsed);
+		if (FrameProfiler::EndFrame())
+			LogMessage("Captured " + std::to_string(FrameProfiler::GetCapturedFrameCount()) + " frames. Use 'stat export' to save them.");
 	}
 #ifdef EMSCRIPTEN
 	else {
 #endif
-	window->UnlockCursor();
+	if (net)
+	{
+		net->Shutdown();
+		net.reset();
+	}
+	poller.reset();
+	saves.reset();
+
+	if (window)
+		window->UnlockCursor();
 
 	if (packages->MissingSESystemIni())
 	{
@@ -248,6 +349,7 @@ void Engine::Run()
 		client->SaveConfig();
 		audiodev->SaveConfig();
 		renderdev->SaveConfig();
+		netdev->SaveConfig();
 	}
 	packages->SetIniValue("System", "Engine.SurrealWindowSystem", "WindowSystem", windowingSystemName);
 	packages->SaveAllIniFiles();
@@ -260,6 +362,7 @@ void Engine::Run()
 
 void Engine::UpdateAudio()
 {
+	PROFILE_ZONE(ProfileZone::Audio);
 	mat4 translate = mat4::translate(vec3(0.0f) - CameraLocation);
 	mat4 listener = Coords::ViewToAudioDev().ToMatrix() * Coords::Rotation(CameraRotation).ToMatrix() * translate;
 
@@ -269,6 +372,14 @@ void Engine::UpdateAudio()
 
 void Engine::ClientTravel(const std::string& newURL, uint8_t travelType, bool transferItems)
 {
+	// The load menus travel to "?load=slot"
+	UnrealURL url(newURL);
+	if (url.Map.empty() && url.HasOption("load"))
+	{
+		PendingLoadSlot = std::atoi(url.GetOption("load").c_str());
+		return;
+	}
+
 	ClientTravelInfo.URL = UnrealURL(newURL);
 	ClientTravelInfo.TravelType = travelType;
 	ClientTravelInfo.TransferItems = transferItems;
@@ -319,6 +430,9 @@ void Engine::UnloadMap()
 
 	NameString packageName = LevelPackage->GetPackageName();
 
+	if (poller)
+		poller->CloseLinks(Level);
+
 	LevelInfo = nullptr;
 	Level = nullptr;
 	LevelPackage = nullptr;
@@ -328,6 +442,7 @@ void Engine::UnloadMap()
 
 void Engine::LoadMap(const UnrealURL& url, const std::map<std::string, std::string>& travelInfo)
 {
+	PROFILE_ZONE(ProfileZone::Travel);
 	ClientTravelInfo.URL.Map.clear();
 
 	if (Level)
@@ -343,11 +458,9 @@ void Engine::LoadMap(const UnrealURL& url, const std::map<std::string, std::stri
 	// Determine if we're getting a relative path
 	// Which is the case with Unreal's New game menu
 	if (url.Map.substr(0, 2) == "..") {
-		std::cout << "GP3" << std::endl;
 		LevelPackage = packages->GetPackageFromPath(url.Map);
 	}
 	else {
-		std::cout << "GP2" << std::endl;
 		LevelPackage = packages->GetPackage(FilePath::remove_extension(url.Map), 998);
 	}
 
@@ -366,7 +479,7 @@ void Engine::LoadMap(const UnrealURL& url, const std::map<std::string, std::stri
 	if (packages->GetEngineVersion() > 219)
 		LevelInfo->MinNetVersion() = "500";
 	LevelInfo->bHighDetailMode() = true;
-	LevelInfo->NetMode() = 0; // NM_StandAlone
+	LevelInfo->NetMode() = net ? net->GetNetMode() : NM_Standalone;
 	LevelInfo->DefaultTexture() = engine->DefaultTexture;
 
 	LevelInfo->URL = url;
@@ -378,12 +491,32 @@ void Engine::LoadMap(const UnrealURL& url, const std::map<std::string, std::stri
 	Level->TravelInfo = travelInfo; // Initially used travel info for level restart
 
 	// Remove the actors meant for the editor (to do: should we do this at the package manager level?)
-	for (UActor*& actor : Level->Actors)
+	for (UActor* actor : Level->Actors)
 	{
 		if (actor && AllFlags(actor->Flags, ObjectFlags::NotForServer))
 		{
 			actor->bDeleteMe() = true;
-			actor = nullptr;
+			Level->Actors.Remove(actor);
+		}
+	}
+
+	// Everything but the map itself comes from the server on network clients
+	if (LevelInfo->NetMode() == NM_Client)
+	{
+		for (UActor* actor : Level->Actors)
+		{
+			if (!actor)
+				continue;
+
+			if (actor == LevelInfo || actor->bStatic() || actor->bNoDelete())
+			{
+				std::swap(actor->Role(), actor->RemoteRole());
+			}
+			else
+			{
+				actor->bDeleteMe() = true;
+				Level->Actors.Remove(actor);
+			}
 		}
 	}
 
@@ -397,62 +530,69 @@ void Engine::LoadMap(const UnrealURL& url, const std::map<std::string, std::stri
 		}
 	}
 
-	// Find the game info class
-	UClass* gameInfoClass = packages->FindClass(LevelInfo->URL.GetOption("game"));
-	if (!gameInfoClass)
-		gameInfoClass = LevelInfo->DefaultGameType();
-	if (!gameInfoClass)
-		gameInfoClass = packages->FindClass(packages->GetIniValue("system", "Engine.Engine", "DefaultGame"));
-	if (!gameInfoClass)
-		gameInfoClass = packages->FindClass("Botpack.DeathMatchPlus");
-	if (!gameInfoClass)
-		Exception::Throw("Could not find any gameinfo class!");
-
-	// Spawn GameInfo actor
-	GameInfo = UObject::Cast<UGameInfo>(packages->NewObject("gameinfo", gameInfoClass));
-	GameInfo->XLevel() = Level;
-	GameInfo->Level() = LevelInfo;
-	Level->Hash.AddToCollision(GameInfo);
-	GameInfo->Tag() = gameInfoClass->Name;
-	GameInfo->bTicked() = false;
-	GameInfo->InitActorZone();
-
-	Level->Actors.push_back(GameInfo);
-
-	// Note: this is never true. But maybe it will be once map loading or level hubs are implemented? If not, delete it!
-	if (LevelInfo->bBegunPlay())
-	{
-		CallEvent(GameInfo, EventName::Spawned);
-		CallEvent(GameInfo, EventName::PreBeginPlay);
-		CallEvent(GameInfo, EventName::BeginPlay);
-		CallEvent(GameInfo, EventName::PostBeginPlay);
-		CallEvent(GameInfo, EventName::SetInitialState);
+	Level->Navigation.Build(Level);
 
-		if (packages->GetEngineVersion() > 219)
+	// Only the server runs the game rules
+	GameInfo = nullptr;
+	if (LevelInfo->NetMode() != NM_Client)
+	{
+		// Find the game info class
+		UClass* gameInfoClass = packages->FindClass(LevelInfo->URL.GetOption("game"));
+		if (!gameInfoClass)
+			gameInfoClass = LevelInfo->DefaultGameType();
+		if (!gameInfoClass)
+			gameInfoClass = packages->FindClass(packages->GetIniValue("system", "Engine.Engine", "DefaultGame"));
+		if (!gameInfoClass)
+			gameInfoClass = packages->FindClass("Botpack.DeathMatchPlus");
+		if (!gameInfoClass)
+			Exception::Throw("Could not find any gameinfo class!");
+
+		// Spawn GameInfo actor
+		GameInfo = UObject::Cast<UGameInfo>(packages->NewObject("gameinfo", gameInfoClass));
+		GameInfo->XLevel() = Level;
+		GameInfo->Level() = LevelInfo;
+		Level->Hash.AddToCollision(GameInfo);
+		GameInfo->Tag() = gameInfoClass->Name;
+		GameInfo->bTicked() = false;
+		GameInfo->InitActorZone();
+
+		Level->Actors.Add(GameInfo);
+
+		// Note: this is never true. But maybe it will be once map loading or level hubs are implemented? If not, delete it!
+		if (LevelInfo->bBegunPlay())
 		{
-			NameString attachTag = GameInfo->AttachTag();
-			if (!attachTag.IsNone())
+			CallEvent(GameInfo, EventName::Spawned);
+			CallEvent(GameInfo, EventName::PreBeginPlay);
+			CallEvent(GameInfo, EventName::BeginPlay);
+			CallEvent(GameInfo, EventName::PostBeginPlay);
+			CallEvent(GameInfo, EventName::SetInitialState);
+
+			if (packages->GetEngineVersion() > 219)
 			{
-				for (UActor* actor : Level->Actors)
+				NameString attachTag = GameInfo->AttachTag();
+				if (!attachTag.IsNone())
 				{
-					if (actor && actor->Tag() == attachTag)
+					for (UActor* actor : Level->Actors)
 					{
-						actor->SetBase(GameInfo, false);
+						if (actor && actor->Tag() == attachTag)
+						{
+							actor->SetBase(GameInfo, false);
+						}
 					}
 				}
 			}
-		}
-		if (packages->GetEngineVersion() >= 400)
-		{
-			for (USpawnNotify* notifyObj = LevelInfo->SpawnNotify(); notifyObj != nullptr; notifyObj = notifyObj->Next())
+			if (packages->GetEngineVersion() >= 400)
 			{
-				UClass* cls = notifyObj->ActorClass();
-				if (cls && GameInfo->IsA(cls->Name))
-					GameInfo = UObject::Cast<UGameInfo>(CallEvent(notifyObj, EventName::SpawnNotification, { ExpressionValue::ObjectValue(GameInfo) }).ToObject());
+				for (USpawnNotify* notifyObj = LevelInfo->SpawnNotify(); notifyObj != nullptr; notifyObj = notifyObj->Next())
+				{
+					UClass* cls = notifyObj->ActorClass();
+					if (cls && GameInfo->IsA(cls->Name))
+						GameInfo = UObject::Cast<UGameInfo>(CallEvent(notifyObj, EventName::SpawnNotification, { ExpressionValue::ObjectValue(GameInfo) }).ToObject());
+				}
 			}
 		}
+		LevelInfo->Game() = GameInfo;
 	}
-	LevelInfo->Game() = GameInfo;
 
 	if (!LevelInfo->bBegunPlay())
 	{
@@ -466,9 +606,12 @@ void Engine::LoadMap(const UnrealURL& url, const std::map<std::string, std::stri
 	std::string error;
 
 	LevelInfo->bStartup() = true;
-	CallEvent(GameInfo, EventName::InitGame, { ExpressionValue::StringValue(options), ExpressionValue::Variable(&error, &stringProp) });
-	if (!error.empty())
-		Exception::Throw("InitGame failed: " + error);
+	if (GameInfo)
+	{
+		CallEvent(GameInfo, EventName::InitGame, { ExpressionValue::StringValue(options), ExpressionValue::Variable(&error, &stringProp) });
+		if (!error.empty())
+			Exception::Throw("InitGame failed: " + error);
+	}
 	for (size_t i = 0; i < Level->Actors.size(); i++) { UActor* actor = Level->Actors[i]; if (actor) CallEvent(actor, EventName::PreBeginPlay); }
 	for (size_t i = 0; i < Level->Actors.size(); i++) { UActor* actor = Level->Actors[i]; if (actor) CallEvent(actor, EventName::BeginPlay); }
 	for (size_t i = 0; i < Level->Actors.size(); i++) { UActor* actor = Level->Actors[i]; if (actor) CallEvent(actor, EventName::PostBeginPlay); }
@@ -476,12 +619,25 @@ void Engine::LoadMap(const UnrealURL& url, const std::map<std::string, std::stri
 	for (size_t i = 0; i < Level->Actors.size(); i++) { UActor* actor = Level->Actors[i]; if (actor) actor->InitBase(); }
 	LevelInfo->bStartup() = false;
 
-	audio->StopSounds();
+	if (audio)
+		audio->StopSounds();
+
+	if (net)
+		net->NotifyMapLoaded();
 }
 
 void Engine::LoginPlayer()
 {
-	UnrealURL url = LevelInfo->URL;
+	// Dedicated servers have no local player and network clients get theirs from the server
+	if (!net || net->HasLocalPlayer())
+		SpawnPlayActor(LevelInfo->URL, viewport);
+
+	if (render)
+		render->OnMapLoaded();
+}
+
+UPlayerPawn* Engine::SpawnPlayActor(const UnrealURL& url, UPlayer* player)
+{
 	std::map<std::string, std::string> travelInfo = Level->TravelInfo;
 
 	UStringProperty stringProp("", nullptr, ObjectFlags::NoFlags);
@@ -516,10 +672,10 @@ void Engine::LoginPlayer()
 		Exception::Throw("GameInfo login failed: " + error);
 	bool actorActuallySpawned = Level->Actors.size() != numActors;
 
-	// Assign the pawn to the viewport
-	viewport->Actor() = pawn;
-	viewport->Actor()->Player() = viewport;
-	CallEvent(viewport->Actor(), EventName::Possess);
+	// Assign the pawn to the player
+	player->Actor() = pawn;
+	pawn->Player() = player;
+	CallEvent(pawn, EventName::Possess);
 
 	// Transfer travel actors to the new map
 
@@ -593,7 +749,7 @@ void Engine::LoginPlayer()
 	CallEvent(pawn, EventName::TravelPostAccept);
 	CallEvent(LevelInfo->Game(), EventName::PostLogin, { ExpressionValue::ObjectValue(pawn) });
 
-	render->OnMapLoaded();
+	return pawn;
 }
 
 UObject* Engine::FindObject(NameString name, NameString className)
@@ -620,6 +776,19 @@ float Engine::CalcTimeElapsed()
 	return clamp(deltaTime / 1'000'000.0f, 0.0f, 1.0f);
 }
 
+void Engine::LimitTickRate(float maxTickRate)
+{
+	using namespace std::chrono;
+
+	if (maxTickRate <= 0.0f || lastTime == 0)
+		return;
+
+	uint64_t nextTime = lastTime + (uint64_t)(1'000'000.0f / maxTickRate);
+	uint64_t currentTime = duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+	if (currentTime < nextTime)
+		std::this_thread::sleep_for(microseconds(nextTime - currentTime));
+}
+
 std::string Engine::ParseClassName(std::string className)
 {
 	// Workaround for broken unrealscript code referencing windrv.windowsclient directly
@@ -682,18 +851,73 @@ std::string Engine::ConsoleCommand(UObject* context, const std::string& commandl
 	}
 	else if (command == "timedemo" && args.size() == 2)
 	{
-		render->ShowTimedemoStats = args[1] == "1";
+		if (render)
+			render->ShowTimedemoStats = args[1] == "1";
+	}
+	else if (command == "stat" && args.size() >= 2 && args[1] == "capture")
+	{
+		int frames = args.size() >= 3 ? std::atoi(args[2].c_str()) : 60;
+		FrameProfiler::StartCapture(frames);
 	}
-	else if (command == "stat" && args.size() == 2)
+	else if (command == "stat" && args.size() >= 2 && args[1] == "export")
+	{
+		std::string filename = args.size() >= 3 ? args[2] : "FrameCapture.json";
+		File::write_all_text(filename, FrameProfiler::CaptureToJson());
+		LogMessage("Wrote " + std::to_string(FrameProfiler::GetCapturedFrameCount()) + " captured frames to " + filename);
+	}
+	else if (command == "stat" && args.size() == 2 && render)
 	{
 		render->ShowRenderStats = 0;
+		render->ShowMemoryStats = false;
+		render->ShowGCStats = false;
+		FrameProfiler::SetOverlay(false);
 
 		if (args[1] == "render")
 			render->ShowRenderStats = 1;
+		else if (args[1] == "memory")
+			render->ShowMemoryStats = true;
+		else if (args[1] == "gc")
+			render->ShowGCStats = true;
+		else if (args[1] == "frame")
+			FrameProfiler::SetOverlay(true);
+	}
+	else if (command == "obj" && args.size() == 2 && args[1] == "garbage")
+	{
+		GC::Collect();
+	}
+	else if (command == "dumpmemory")
+	{
+		std::string filename = args.size() >= 2 ? args[1] : "MemoryStats.json";
+		std::string mapName = LevelPackage ? LevelPackage->GetPackageName().ToString() : std::string();
+		File::write_all_text(filename, MemoryStats::ToJson(mapName));
+		LogMessage("Wrote memory stats to " + filename);
+	}
+	else if (command == "trace" && args.size() >= 2)
+	{
+		uint32_t categories = args.size() >= 3 ? Trace::ParseCategories(args[2]) : (uint32_t)TraceCategory::All;
+		if (args[1] == "on")
+		{
+			Trace::Enable(categories);
+		}
+		else if (args[1] == "off")
+		{
+			Trace::Disable(categories);
+		}
+		else if (args[1] == "dump")
+		{
+			std::string filename = args.size() >= 3 ? args[2] : "Trace.json";
+			File::write_all_text(filename, Trace::ToChromeJson());
+			LogMessage("Wrote trace to " + filename);
+		}
+		else if (args[1] == "clear")
+		{
+			Trace::Clear();
+		}
 	}
 	else if (command == "collisiondebug" && args.size() == 2)
 	{
-		render->ShowCollisionDebug = args[1] == "1";
+		if (render)
+			render->ShowCollisionDebug = args[1] == "1";
 	}
 	else if (command == "showlog")
 	{
@@ -711,13 +935,13 @@ std::string Engine::ConsoleCommand(UObject* context, const std::string& commandl
 	}*/
 	else if (command == "getres")
 	{
-		return window->GetAvailableResolutions();
+		return window ? window->GetAvailableResolutions() : std::string();
 	}
 	else if (command == "getcolordepths")
 	{
 		return "32 16";
 	}
-	else if (command == "getcurrentres")
+	else if (command == "getcurrentres" && window)
 	{
 		int width = window->GetPixelWidth();
 		int height = window->GetPixelHeight();
@@ -746,6 +970,16 @@ std::string Engine::ConsoleCommand(UObject* context, const std::string& commandl
 		std::string name = args[1];
 		return keybindings[name];
 	}
+	else if (command == "savegame" && args.size() >= 2)
+	{
+		if (saves)
+			saves->Save(std::atoi(args[1].c_str()), LevelInfo ? LevelInfo->Title() : std::string());
+	}
+	else if (command == "loadgame" && args.size() == 2)
+	{
+		// Loading replaces the level, so wait until the script that asked for it has returned
+		PendingLoadSlot = std::atoi(args[1].c_str());
+	}
 	else if (command == "open" && args.size() == 2)
 	{
 		std::string maparg = args[1];
@@ -853,7 +1087,8 @@ std::string Engine::ConsoleCommand(UObject* context, const std::string& commandl
 	}
 	else if (command == "setres" && args.size() == 2)
 	{
-		window->SetResolution(args[1]);
+		if (window)
+			window->SetResolution(args[1]);
 	}
 	else
 	{
@@ -904,6 +1139,51 @@ std::vector<std::string> Engine::GetSubcommands(const std::string& command)
 	return subcommands;
 }
 
+void Engine::GetObjectRoots(std::vector<UObject*>& roots)
+{
+	for (UObject* obj : std::initializer_list<UObject*>{ gameengine, renderdev, audiodev, netdev, client, viewport, canvas, console, EntryGameInfo, GameInfo, CameraActor })
+	{
+		if (obj)
+			roots.push_back(obj);
+	}
+
+	for (ULevel* level : { EntryLevel, Level })
+	{
+		if (!level)
+			continue;
+
+		roots.push_back(level);
+		for (UActor* actor : level->Actors)
+		{
+			if (actor)
+				roots.push_back(actor);
+		}
+		for (const auto& decal : level->Decals)
+			roots.push_back(decal->Decal);
+		level->Pool.GetObjectRoots(roots);
+	}
+
+	if (net)
+		net->GetObjectRoots(roots);
+	if (poller)
+		poller->GetObjectRoots(roots);
+}
+
+bool Engine::RecycleObject(UObject* obj)
+{
+	// Destroyed actors of the loaded levels go to the actor pool of their level. Actors dropped from a pool
+	// have no property values anymore and are deleted.
+	UActor* actor = UObject::TryCast<UActor>(obj);
+	if (!actor || !actor->PropertyData.Class || !actor->bDeleteMe())
+		return false;
+
+	ULevel* level = actor->XLevel();
+	if (!level || (level != Level && level != EntryLevel))
+		return false;
+
+	return level->Pool.Recycle(actor);
+}
+
 void Engine::LoadEngineSettings()
 {
 	if (packages->MissingSESystemIni())
@@ -968,6 +1248,11 @@ void Engine::UpdateInput(float timeElapsed)
 	TickWindow();
 	if (tickDebugger)
 		tickDebugger();
+
+	// Network clients have no pawn until the server sends it
+	if (!viewport->Actor())
+		return;
+
 	for (auto& it : activeInputButtons)
 		viewport->Actor()->SetBool(it.first, true);
 	for (auto& it : activeInputAxes)
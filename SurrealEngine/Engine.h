@@ -44,6 +44,10 @@ class BspNode;
 class LightMapIndex;
 class FrustumPlanes;
 class AudioSubsystem;
+class NetDriver;
+class SocketPoller;
+class SaveGame;
+class UPlayer;
 class Rotator;
 class ExpressionValue;
 class UnrealURL;
@@ -72,6 +76,7 @@ public:
 	void LoadMap(const UnrealURL& url, const std::map<std::string, std::string>& travelInfo = {});
 	void UnloadMap();
 	void LoginPlayer();
+	UPlayerPawn* SpawnPlayActor(const UnrealURL& url, UPlayer* player);
 
 	UObject* FindObject(NameString name, NameString className);
 
@@ -140,6 +145,7 @@ public:
 		uint8_t TravelType = 0;
 		bool TransferItems = false;
 	} ClientTravelInfo;
+	int PendingLoadSlot = -1;
 
 	void LogMessage(const std::string& message);
 	void LogUnimplemented(const std::string& message);
@@ -151,11 +157,15 @@ public:
 	std::unique_ptr<GameWindow> window; // TODO: Move into UViewport
 	std::unique_ptr<RenderSubsystem> render;
 	std::unique_ptr<AudioSubsystem> audio;
+	std::unique_ptr<NetDriver> net; // Only set for network games
+	std::unique_ptr<SocketPoller> poller; // Services the sockets of all InternetLink actors
+	std::unique_ptr<SaveGame> saves;
 
 	int MouseMoveX = 0;
 	int MouseMoveY = 0;
 
 	float CalcTimeElapsed();
+	void LimitTickRate(float maxTickRate);
 
 	int ViewportX = 0;
 	int ViewportY = 0;
@@ -180,6 +190,13 @@ public:
 	void LoadEngineSettings();
 
 	void LoadKeybindings();
+
+	// The objects native code refers to, which the garbage collector starts from
+	void GetObjectRoots(std::vector<UObject*>& roots);
+
+	// Takes the unreachable objects the actor pools can reuse
+	bool RecycleObject(UObject* obj);
+
 	std::map<std::string, std::string> keybindings;
 	std::map<std::string, std::string> inputAliases;
 	static const char* keynames[256];
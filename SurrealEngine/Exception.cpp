@@ -1,8 +1,8 @@
 #include <ios>
-#include <iostream>
 #include <sstream>
 #include <vector>
 #include "Exception.h"
+#include "Trace.h"
 
 #ifdef WIN32
 
@@ -140,7 +140,7 @@ int Exception::CaptureStackFrames(std::ostringstream& sstream, int maxframes)
 
 void Exception::Throw(const std::string& text)
 {
-	std::cout << "AAAAAAAAA EXCEPTION!!! " << text << std::endl;
+	TRACE_EVENT_TEXT(TraceCategory::Engine, "Exception", text);
 
 	std::ostringstream sstream;
 
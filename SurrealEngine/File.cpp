@@ -2,6 +2,7 @@
 #include "Precomp.h"
 #include "File.h"
 #include "UTF16.h"
+#include "Trace.h"
 #ifdef WIN32
 #include <Windows.h>
 #else
@@ -23,7 +24,6 @@ extern const char* __progname;
 #include "Exception.h"
 #include <string.h>
 #include <sstream>
-#include <iostream>
 
 class FileImpl : public File
 {
@@ -87,9 +87,7 @@ std::shared_ptr<File> File::create_always(const std::string &filename)
 
 std::shared_ptr<File> File::open_existing(const std::string &filename, int debug_index)
 {
-#ifdef DEBUG_INDEXING_ENABLED
-	std::cout << "File::open_existing: " << filename << ", debug_index: " << debug_index << std::endl;
-#endif
+	TRACE_EVENT_TEXT(TraceCategory::File, "OpenFile", filename);
 	FILE* handle = fopen(filename.c_str(), "rb");
 	if (handle == nullptr)
 		Exception::Throw("Could not open " + filename);
@@ -111,9 +109,6 @@ void File::write_all_text(const std::string& filename, const std::string& text)
 
 std::vector<uint8_t> File::read_all_bytes(const std::string& filename, int debug_index)
 {
-#ifdef DEBUG_INDEXING_ENABLED	
-	std::cout << "File::read_all_bytes; debug_index: " << debug_index << std::endl;
-#endif
 	auto file = open_existing(filename, 1);
 	std::vector<uint8_t> buffer(file->size());
 	file->read(buffer.data(), buffer.size());
@@ -510,11 +505,8 @@ std::string FilePath::combine(const std::string &path1, const std::string &path2
 		return path2_conv;
 	else if (path1_conv.back() != '/')
 		return path1_conv + "/" + path2_conv;
-	else {
-		auto value = path1_conv + path2_conv;
-		std::cout << "combine result: "<< value  << std::endl;
-		return value;
-	}
+	else
+		return path1_conv + path2_conv;
 #endif
 }
 
@@ -0,0 +1,165 @@
+
+#include "Precomp.h"
+#include "FrameProfiler.h"
+#include <chrono>
+#include <algorithm>
+
+bool FrameProfiler::Overlay = false;
+bool FrameProfiler::Recording = false;
+bool FrameProfiler::InFrame = false;
+FrameProfiler::ZoneEntry FrameProfiler::Stack[64];
+int FrameProfiler::StackDepth = 0;
+int FrameProfiler::ZoneDepth[(int)ProfileZone::Count];
+ProfiledFrame FrameProfiler::Current;
+ProfiledFrame FrameProfiler::History[HistorySize];
+uint64_t FrameProfiler::FrameCount = 0;
+int FrameProfiler::CaptureFramesLeft = 0;
+std::vector<FrameProfiler::CapturedZone> FrameProfiler::CapturedZones;
+std::vector<FrameProfiler::CapturedFrame> FrameProfiler::CapturedFrames;
+
+uint64_t FrameProfiler::GetMicroseconds()
+{
+	using namespace std::chrono;
+	return (uint64_t)duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+void FrameProfiler::BeginFrame()
+{
+	// Toggling the overlay or starting a capture from the console takes effect on the next frame,
+	// so a frame never has zones that were only half recorded
+	Recording = Overlay || CaptureFramesLeft > 0;
+	if (!Recording)
+		return;
+
+	Current = {};
+	StackDepth = 0;
+	for (int& depth : ZoneDepth)
+		depth = 0;
+	CapturedZones.clear();
+
+	InFrame = true;
+	BeginZone(ProfileZone::Frame);
+	Current.Start = Stack[0].Start;
+}
+
+bool FrameProfiler::EndFrame()
+{
+	if (!InFrame)
+		return false;
+
+	// Zones that did not end cleanly are closed with the frame
+	while (StackDepth > 1)
+		EndZone(Stack[StackDepth - 1].Zone);
+	EndZone(ProfileZone::Frame);
+	InFrame = false;
+
+	Current.Duration = Current.Inclusive[(int)ProfileZone::Frame];
+	History[FrameCount % HistorySize] = Current;
+	FrameCount++;
+
+	if (CaptureFramesLeft > 0)
+	{
+		CapturedFrame frame;
+		frame.Totals = Current;
+		frame.Zones = CapturedZones;
+		CapturedFrames.push_back(std::move(frame));
+
+		CaptureFramesLeft--;
+		return CaptureFramesLeft == 0;
+	}
+	return false;
+}
+
+void FrameProfiler::BeginZone(ProfileZone zone)
+{
+	if (!InFrame || StackDepth == 64)
+		return;
+
+	ZoneEntry& entry = Stack[StackDepth++];
+	entry.Zone = zone;
+	entry.Start = GetMicroseconds();
+	entry.ChildTime = 0;
+	ZoneDepth[(int)zone]++;
+}
+
+void FrameProfiler::EndZone(ProfileZone zone)
+{
+	if (!InFrame || StackDepth == 0 || Stack[StackDepth - 1].Zone != zone)
+		return;
+
+	const ZoneEntry& entry = Stack[--StackDepth];
+	uint64_t total = GetMicroseconds() - entry.Start;
+	int index = (int)zone;
+
+	Current.Self[index] += (uint32_t)(total - std::min(entry.ChildTime, total));
+	if (--ZoneDepth[index] == 0)
+	{
+		// Recursive zones, such as script events called from script, only count the outermost call
+		Current.Inclusive[index] += (uint32_t)total;
+		Current.Calls[index]++;
+	}
+
+	if (StackDepth > 0)
+		Stack[StackDepth - 1].ChildTime += total;
+
+	if (CaptureFramesLeft > 0)
+		CapturedZones.push_back({ zone, entry.Start, (uint32_t)total });
+}
+
+const ProfiledFrame* FrameProfiler::GetFrame(int framesAgo)
+{
+	if (framesAgo < 0 || framesAgo >= HistorySize || (uint64_t)framesAgo >= FrameCount)
+		return nullptr;
+	return &History[(FrameCount - 1 - framesAgo) % HistorySize];
+}
+
+void FrameProfiler::StartCapture(int frames)
+{
+	CapturedFrames.clear();
+	CaptureFramesLeft = std::max(frames, 1);
+}
+
+std::string FrameProfiler::CaptureToJson()
+{
+	std::string json = "{\"traceEvents\":[";
+	bool first = true;
+
+	uint64_t timeOrigin = !CapturedFrames.empty() ? CapturedFrames.front().Totals.Start : 0;
+	for (size_t i = 0; i < CapturedFrames.size(); i++)
+	{
+		const CapturedFrame& frame = CapturedFrames[i];
+		for (const CapturedZone& zone : frame.Zones)
+		{
+			json += first ? "\n" : ",\n";
+			first = false;
+
+			json += "{\"name\":\"";
+			json += zone.Zone == ProfileZone::Frame ? "Frame " + std::to_string(i) : GetZoneName(zone.Zone);
+			json += "\",\"cat\":\"Frame\",\"ph\":\"X\",\"ts\":" + std::to_string(zone.Start - timeOrigin);
+			json += ",\"dur\":" + std::to_string(zone.Duration);
+			json += ",\"pid\":1,\"tid\":1}";
+		}
+	}
+
+	json += "\n]}\n";
+	return json;
+}
+
+const char* FrameProfiler::GetZoneName(ProfileZone zone)
+{
+	switch (zone)
+	{
+	case ProfileZone::Frame: return "Other";
+	case ProfileZone::Input: return "Input";
+	case ProfileZone::Network: return "Network";
+	case ProfileZone::LevelTick: return "LevelTick";
+	case ProfileZone::Script: return "Script";
+	case ProfileZone::Physics: return "Physics";
+	case ProfileZone::Travel: return "Travel";
+	case ProfileZone::Render: return "Render";
+	case ProfileZone::Audio: return "Audio";
+	case ProfileZone::Present: return "Present";
+	case ProfileZone::GC: return "GC";
+	default: return "Unknown";
+	}
+}
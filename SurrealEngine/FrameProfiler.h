@@ -0,0 +1,133 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+enum class ProfileZone : uint8_t
+{
+	Frame, // Time in the frame not covered by any other zone
+	Input,
+	Network,
+	LevelTick,
+	Script,
+	Physics,
+	Travel,
+	Render,
+	Audio,
+	Present,
+	GC,
+	Count
+};
+
+struct ProfiledFrame
+{
+	uint64_t Start = 0;
+	uint32_t Duration = 0;
+
+	// Microseconds spent in each zone, excluding the zones nested inside it. These add up to the frame duration.
+	uint32_t Self[(int)ProfileZone::Count] = {};
+
+	// Microseconds from entering to leaving the outermost instance of each zone
+	uint32_t Inclusive[(int)ProfileZone::Count] = {};
+	uint32_t Calls[(int)ProfileZone::Count] = {};
+};
+
+// Where the time of each engine frame goes.
+//
+// The main loop brackets every frame with BeginFrame and EndFrame, and the subsystems mark their work with
+// PROFILE_ZONE. The totals of the last frames are kept for the overlay graph, and a capture records every
+// zone of the next frames so they can be exported as Chrome trace JSON. Zones are only timed on the thread
+// running the main loop, and only while the overlay or a capture wants them.
+class FrameProfiler
+{
+public:
+	enum { HistorySize = 240 };
+
+	static bool IsRecording() { return Recording; }
+
+	static void SetOverlay(bool enable) { Overlay = enable; }
+	static bool IsOverlayEnabled() { return Overlay; }
+
+	static void BeginFrame();
+	static bool EndFrame(); // Returns true when this frame finished a capture
+
+	static void BeginZone(ProfileZone zone);
+	static void EndZone(ProfileZone zone);
+
+	// Frames ago, where 0 is the last completed frame. Returns null past the recorded history.
+	static const ProfiledFrame* GetFrame(int framesAgo);
+
+	static void StartCapture(int frames);
+	static bool IsCapturing() { return CaptureFramesLeft > 0; }
+	static int GetCapturedFrameCount() { return (int)CapturedFrames.size(); }
+	static std::string CaptureToJson();
+
+	static const char* GetZoneName(ProfileZone zone);
+
+private:
+	struct ZoneEntry
+	{
+		ProfileZone Zone;
+		uint64_t Start;
+		uint64_t ChildTime;
+	};
+
+	struct CapturedZone
+	{
+		ProfileZone Zone;
+		uint64_t Start;
+		uint32_t Duration;
+	};
+
+	struct CapturedFrame
+	{
+		ProfiledFrame Totals;
+		std::vector<CapturedZone> Zones;
+	};
+
+	static uint64_t GetMicroseconds();
+
+	static bool Overlay;
+	static bool Recording;
+	static bool InFrame;
+
+	static ZoneEntry Stack[64];
+	static int StackDepth;
+	static int ZoneDepth[(int)ProfileZone::Count];
+
+	static ProfiledFrame Current;
+	static ProfiledFrame History[HistorySize];
+	static uint64_t FrameCount;
+
+	static int CaptureFramesLeft;
+	static std::vector<CapturedZone> CapturedZones;
+	static std::vector<CapturedFrame> CapturedFrames;
+};
+
+class ProfileScope
+{
+public:
+	ProfileScope(ProfileZone zone) : Zone(zone), Active(FrameProfiler::IsRecording())
+	{
+		if (Active)
+			FrameProfiler::BeginZone(Zone);
+	}
+
+	~ProfileScope()
+	{
+		if (Active)
+			FrameProfiler::EndZone(Zone);
+	}
+
+private:
+	ProfileScope(const ProfileScope&) = delete;
+	ProfileScope& operator=(const ProfileScope&) = delete;
+
+	ProfileZone Zone;
+	bool Active;
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_ZONE(zone) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(zone)
@@ -1,11 +1,63 @@
 
 #include "Precomp.h"
 #include "GC.h"
+#include "GCHeap.h"
+#include "VM/Frame.h"
+#include "UObject/UObject.h"
+#include "UObject/UClass.h"
+#include "UObject/UProperty.h"
+#include "UObject/UActor.h"
+#include "Package/Package.h"
+#include <chrono>
+#include <algorithm>
 
 static GCRoot* roots;
 static GCAllocation* allocations;
 static GCStats stats;
 
+static std::vector<UObject*> objects;
+static std::function<void(std::vector<UObject*>&)> nativeRootsCallback;
+static std::function<void(std::vector<UObject*>&)> packageObjectsCallback;
+static std::function<bool(UObject*)> recyclerCallback;
+static std::unordered_map<UStruct*, std::unique_ptr<GCObjectType>> objectTypes;
+static const GCObjectType objectElementType = { { 0 }, {} };
+
+enum class GCPhase
+{
+	Idle,
+	Mark,
+	Remark,
+	Sweep
+};
+
+static GCPhase phase = GCPhase::Idle;
+static bool fullCycleRequested = false;
+static uint32_t markEpoch = 1;
+static std::vector<UObject*> markStack;
+static std::vector<UObject*> cycleRoots;
+static size_t cycleRootIndex = 0;
+static size_t cycleReached = 0;
+static double cycleTime = 0.0;
+static double cycleLongestStep = 0.0;
+static size_t objectsAfterLastCycle = 0;
+static std::chrono::steady_clock::time_point lastCycleEnd = std::chrono::steady_clock::now();
+
+static size_t sweepIndex = 0;
+static size_t sweepLiveCount = 0;
+static bool sweepSorted = false;
+static std::vector<UObject*> garbage;
+static size_t garbageReleaseIndex = 0;
+static size_t garbageDeleteIndex = 0;
+static size_t garbageRecycled = 0;
+
+bool GC::Marking = false;
+
+// Time a step may spend on the collection, in milliseconds
+static const double StepBudgetMs = 0.5;
+
+// Units of work done between looking at the clock
+static const size_t WorkPerClockCheck = 256;
+
 #define GC_UNREFERENCED_FLAG ((size_t)1)
 
 GCRoot::GCRoot()
@@ -36,9 +88,8 @@ GCRoot::~GCRoot()
 void* GC::Alloc(GCType* type, size_t count)
 {
 	size_t memsize = sizeof(GCAllocation) + type->size * count;
-	GCAllocation* allocation = (GCAllocation*)calloc(1, memsize);
-	if (allocation == nullptr)
-		throw std::bad_alloc();
+	GCAllocation* allocation = (GCAllocation*)GCHeap::Alloc(memsize);
+	memset(allocation, 0, memsize);
 	allocation->allocklistNext = allocations;
 	allocation->type = type;
 	allocation->flags |= GC_UNREFERENCED_FLAG;
@@ -61,10 +112,20 @@ void GC::Collect()
 	}
 
 	Sweep();
+
+	// Script can't have local variables referring to objects when the cycle finishes, so a call
+	// from script, such as the 'obj garbage' console command, leaves the cycle to the next step
+	fullCycleRequested = true;
+	if (Frame::Callstack.empty())
+		Step();
 }
 
 GCStats GC::GetStats()
 {
+	if (!stats.phase)
+		stats.phase = "idle";
+	stats.heapPages = GCHeap::GetPageCount();
+	stats.heapUsedBytes = GCHeap::GetUsedBytes();
 	return stats;
 }
 
@@ -124,9 +185,10 @@ void GC::Sweep()
 			else
 				allocations = cur;
 
-			stats.memoryUsage -= unreferenced->type->size * unreferenced->count;
+			size_t memsize = sizeof(GCAllocation) + unreferenced->type->size * unreferenced->count;
+			stats.memoryUsage -= memsize;
 			stats.numObjects--;
-			free(unreferenced);
+			GCHeap::Free(unreferenced, memsize);
 		}
 		else
 		{
@@ -136,3 +198,428 @@ void GC::Sweep()
 		}
 	}
 }
+
+/////////////////////////////////////////////////////////////////////////////
+
+void GC::AddObject(UObject* obj)
+{
+	// Objects created while a cycle runs start out black, as nothing has had a chance to reference them yet
+	obj->GCMark = markEpoch;
+	objects.push_back(obj);
+	stats.numUObjects = objects.size();
+}
+
+void GC::SetObjectRoots(std::function<void(std::vector<UObject*>& roots)> nativeRoots, std::function<void(std::vector<UObject*>& objects)> packageObjects)
+{
+	AbortCycle();
+	nativeRootsCallback = std::move(nativeRoots);
+	packageObjectsCallback = std::move(packageObjects);
+}
+
+void GC::SetObjectRecycler(std::function<bool(UObject* obj)> recycler)
+{
+	recyclerCallback = std::move(recycler);
+}
+
+void GC::Step()
+{
+	if (!nativeRootsCallback || !Frame::Callstack.empty())
+		return;
+
+	auto startTime = std::chrono::steady_clock::now();
+	if (fullCycleRequested)
+	{
+		fullCycleRequested = false;
+		auto noDeadline = std::chrono::steady_clock::time_point::max();
+		Continue(noDeadline);
+		BeginCycle();
+		Continue(noDeadline);
+	}
+	else
+	{
+		if (phase == GCPhase::Idle)
+		{
+			if (!IsCycleDue())
+				return;
+			BeginCycle();
+		}
+		Continue(startTime + std::chrono::microseconds((int)(StepBudgetMs * 1000.0)));
+	}
+
+	double stepTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+	cycleTime += stepTime;
+	cycleLongestStep = std::max(cycleLongestStep, stepTime);
+	if (phase == GCPhase::Idle)
+	{
+		stats.lastCycleMs = cycleTime;
+		stats.lastLongestStepMs = cycleLongestStep;
+	}
+}
+
+void GC::Continue(std::chrono::steady_clock::time_point deadline)
+{
+	if (phase == GCPhase::Mark)
+	{
+		if (!MarkObjects(deadline))
+			return;
+		BeginRemark();
+	}
+
+	if (phase == GCPhase::Remark)
+	{
+		if (!MarkObjects(deadline))
+			return;
+		FinishMarking();
+	}
+
+	if (phase == GCPhase::Sweep)
+	{
+		if (!SweepObjects(deadline))
+			return;
+		FinishSweep();
+	}
+}
+
+bool GC::IsCycleDue()
+{
+	// A cycle runs when enough objects were created since the last one, or after a while in any case
+	// to pick up the actors that were destroyed without anything new being spawned
+	size_t growth = objects.size() > objectsAfterLastCycle ? objects.size() - objectsAfterLastCycle : 0;
+	if (growth >= std::max(objectsAfterLastCycle / 4, (size_t)1024))
+		return true;
+	return std::chrono::steady_clock::now() - lastCycleEnd > std::chrono::seconds(60);
+}
+
+void GC::BeginCycle()
+{
+	// Every object starts out white, as its mark is from an earlier cycle
+	markEpoch++;
+	if (markEpoch == 0) // Objects created before the collector ever ran have a zero mark
+		markEpoch = 1;
+
+	cycleRoots.clear();
+	nativeRootsCallback(cycleRoots);
+	if (packageObjectsCallback)
+		packageObjectsCallback(cycleRoots);
+	cycleRootIndex = 0;
+	cycleReached = 0;
+	cycleTime = 0.0;
+	cycleLongestStep = 0.0;
+	phase = GCPhase::Mark;
+	Marking = true;
+	stats.phase = "marking";
+}
+
+void GC::MarkObject(UObject* obj)
+{
+	// White objects turn gray: marked, but waiting on the stack to have their references searched
+	if (obj && obj->GCMark != markEpoch)
+	{
+		obj->GCMark = markEpoch;
+		markStack.push_back(obj);
+		cycleReached++;
+	}
+}
+
+bool GC::MarkObjects(std::chrono::steady_clock::time_point deadline)
+{
+	size_t work = 0;
+	while (true)
+	{
+		if (!markStack.empty())
+		{
+			UObject* obj = markStack.back();
+			markStack.pop_back();
+			work += ScanObject(obj);
+		}
+		else if (cycleRootIndex < cycleRoots.size())
+		{
+			UObject* obj = cycleRoots[cycleRootIndex++];
+			if (phase == GCPhase::Remark && obj)
+			{
+				// Black roots are searched again too, as native stores into them bypass the write barrier
+				if (obj->GCMark != markEpoch)
+					cycleReached++;
+				obj->GCMark = markEpoch;
+				markStack.push_back(obj);
+			}
+			else
+			{
+				MarkObject(obj);
+			}
+			work++;
+		}
+		else
+		{
+			return true;
+		}
+
+		if (work >= WorkPerClockCheck)
+		{
+			work = 0;
+			if (std::chrono::steady_clock::now() >= deadline)
+				return false;
+		}
+	}
+}
+
+size_t GC::ScanObject(UObject* obj)
+{
+	// Pooled actors have already released their property values, and delay loaded objects don't have any yet
+	if (!obj->PropertyData.Data || !obj->PropertyData.Class)
+		return 1;
+
+	// The object turns black once this returns
+	size_t work = 1;
+	GetObjectType(obj->PropertyData.Class).ForEachReference(obj->PropertyData.Data, [&](UObject*& ref)
+	{
+		// Script sees destroyed actors as None, so that is what they become once the collector gets to them
+		if (AnyFlags(ref->Flags, ObjectFlags::EliminateObject))
+		{
+			UActor* actor = dynamic_cast<UActor*>(ref);
+			if (actor && actor->bDeleteMe())
+			{
+				ref = nullptr;
+				return;
+			}
+		}
+		MarkObject(ref);
+		work++;
+	});
+	return work;
+}
+
+void GC::BeginRemark()
+{
+	// Script stores into objects already searched go through the write barrier, but native code stores
+	// into the root objects, mostly the level actors, without it. So those are searched once more, over
+	// as many steps as it takes. This stays sound while native code only stores actors, engine objects,
+	// package objects and objects it just created: the first three were all in the roots of the cycle,
+	// and new objects start out black, so none of them can be white by the time they are stored.
+	cycleRoots.clear();
+	nativeRootsCallback(cycleRoots);
+	cycleRootIndex = 0;
+	phase = GCPhase::Remark;
+	stats.phase = "remarking";
+}
+
+void GC::FinishMarking()
+{
+	Marking = false;
+	cycleRoots.clear();
+	cycleRoots.shrink_to_fit();
+	stats.lastCycleReached = cycleReached;
+
+	phase = GCPhase::Sweep;
+	sweepIndex = 0;
+	sweepLiveCount = 0;
+	sweepSorted = false;
+	garbage.clear();
+	garbageReleaseIndex = 0;
+	garbageDeleteIndex = 0;
+	garbageRecycled = 0;
+	stats.phase = "sweeping";
+}
+
+bool GC::SweepObjects(std::chrono::steady_clock::time_point deadline)
+{
+	// Nothing can reach the white objects anymore, so they are sorted out, unhooked and deleted a slice at a time
+	size_t work = 0;
+	auto outOfTime = [&]()
+	{
+		if (++work < WorkPerClockCheck)
+			return false;
+		work = 0;
+		return std::chrono::steady_clock::now() >= deadline;
+	};
+
+	if (!sweepSorted)
+	{
+		// Objects created meanwhile are added to the end of the list and are already black
+		while (sweepIndex < objects.size())
+		{
+			UObject* obj = objects[sweepIndex++];
+			if (obj->GCMark == markEpoch)
+				objects[sweepLiveCount++] = obj;
+			else
+				garbage.push_back(obj);
+
+			if (outOfTime())
+				return false;
+		}
+		objects.resize(sweepLiveCount);
+		stats.numUObjects = objects.size();
+		sweepSorted = true;
+	}
+
+	// Everything is unhooked before anything is deleted, as the garbage can still point at other garbage
+	while (garbageReleaseIndex < garbage.size())
+	{
+		garbage[garbageReleaseIndex++]->ReleaseNativeReferences();
+		if (outOfTime())
+			return false;
+	}
+
+	while (garbageDeleteIndex < garbage.size())
+	{
+		UObject* obj = garbage[garbageDeleteIndex++];
+		if (recyclerCallback && recyclerCallback(obj))
+		{
+			// Alive again, but nothing refers to it, so all references to it are gone for good
+			obj->GCMark = markEpoch;
+			objects.push_back(obj);
+			garbageRecycled++;
+		}
+		else
+		{
+			obj->PropertyData.DestructValues();
+			delete obj;
+		}
+		if (outOfTime())
+			return false;
+	}
+
+	return true;
+}
+
+void GC::FinishSweep()
+{
+	stats.numUObjects = objects.size();
+	stats.numUObjectsFreed += garbage.size() - garbageRecycled;
+	stats.numCycles++;
+	stats.lastCycleFreed = garbage.size() - garbageRecycled;
+	stats.lastCycleRecycled = garbageRecycled;
+	stats.phase = "idle";
+
+	garbage.clear();
+	garbage.shrink_to_fit();
+	phase = GCPhase::Idle;
+	objectsAfterLastCycle = objects.size();
+	lastCycleEnd = std::chrono::steady_clock::now();
+}
+
+void GC::AbortCycle()
+{
+	if (phase == GCPhase::Sweep)
+	{
+		// The garbage must be gone while the classes of its property values still exist
+		SweepObjects(std::chrono::steady_clock::time_point::max());
+		FinishSweep();
+	}
+	else if (phase == GCPhase::Mark || phase == GCPhase::Remark)
+	{
+		markStack.clear();
+		cycleRoots.clear();
+		cycleRootIndex = 0;
+		Marking = false;
+		phase = GCPhase::Idle;
+		stats.phase = "idle";
+	}
+}
+
+void GC::WriteBarrier(UStruct* type, void* data)
+{
+	if (Marking)
+		GetObjectType(type).ForEachReference(data, [](UObject*& ref) { MarkObject(ref); });
+}
+
+void GC::RemoveReferencesToPackage(Package* package)
+{
+	// The mark stack and the root list can hold objects of the package, and the garbage waiting
+	// to be deleted can have property values of its classes
+	AbortCycle();
+
+	auto removeReferences = [&](UObject* obj)
+	{
+		if (obj && obj->package != package && obj->PropertyData.Data && obj->PropertyData.Class)
+		{
+			GetObjectType(obj->PropertyData.Class).ForEachReference(obj->PropertyData.Data, [&](UObject*& ref)
+			{
+				if (ref->package == package && package->IsExportObject(ref))
+					ref = nullptr;
+			});
+		}
+	};
+
+	for (UObject* obj : objects)
+		removeReferences(obj);
+
+	std::vector<UObject*> packageObjects;
+	if (packageObjectsCallback)
+		packageObjectsCallback(packageObjects);
+	for (UObject* obj : packageObjects)
+		removeReferences(obj);
+
+	// Runtime objects of classes declared in the package, such as the ones of a map, keep their memory until
+	// nothing reaches them anymore, but their property values have to go while the properties still exist
+	for (UObject* obj : objects)
+	{
+		if (obj->PropertyData.Class && obj->PropertyData.Class->package == package)
+		{
+			obj->ReleaseNativeReferences();
+			obj->PropertyData.DestructValues();
+		}
+	}
+
+	for (auto it = objectTypes.begin(); it != objectTypes.end();)
+	{
+		if (it->first->package == package)
+			it = objectTypes.erase(it);
+		else
+			++it;
+	}
+}
+
+const GCObjectType& GC::GetObjectType(UStruct* type)
+{
+	auto it = objectTypes.find(type);
+	if (it != objectTypes.end())
+		return *it->second;
+
+	auto& objectType = objectTypes[type];
+	objectType = std::make_unique<GCObjectType>();
+	for (UProperty* prop : type->Properties)
+		AddReferences(*objectType, prop, prop->DataOffset.DataOffset);
+	return *objectType;
+}
+
+void GC::AddReferences(GCObjectType& type, UProperty* prop, size_t offset)
+{
+	size_t elementSize = prop->ElementSize();
+	for (int i = 0; i < prop->ArrayDimension; i++, offset += elementSize)
+	{
+		if (dynamic_cast<UObjectProperty*>(prop))
+		{
+			// Classes are never collected
+			if (!dynamic_cast<UClassProperty*>(prop))
+				type.references.push_back((uint32_t)offset);
+		}
+		else if (UStructProperty* structprop = dynamic_cast<UStructProperty*>(prop))
+		{
+			if (structprop->Struct)
+			{
+				for (UProperty* member : structprop->Struct->Properties)
+					AddReferences(type, member, offset + member->DataOffset.DataOffset);
+			}
+		}
+		else if (UFixedArrayProperty* fixedprop = dynamic_cast<UFixedArrayProperty*>(prop))
+		{
+			size_t innerSize = fixedprop->Inner->Size();
+			for (int j = 0; j < fixedprop->Count; j++)
+				AddReferences(type, fixedprop->Inner, offset + j * innerSize);
+		}
+		else if (UArrayProperty* arrayprop = dynamic_cast<UArrayProperty*>(prop))
+		{
+			if (dynamic_cast<UObjectProperty*>(arrayprop->Inner) && !dynamic_cast<UClassProperty*>(arrayprop->Inner))
+			{
+				type.arrays.push_back({ (uint32_t)offset, &objectElementType });
+			}
+			else if (UStructProperty* innerstruct = dynamic_cast<UStructProperty*>(arrayprop->Inner))
+			{
+				const GCObjectType& element = GetObjectType(innerstruct->Struct);
+				if (!element.references.empty() || !element.arrays.empty())
+					type.arrays.push_back({ (uint32_t)offset, &element });
+			}
+		}
+	}
+}
@@ -2,6 +2,14 @@
 
 #include <vector>
 #include <list>
+#include <functional>
+#include <chrono>
+#include <cstdint>
+
+class UObject;
+class UStruct;
+class UProperty;
+class Package;
 
 struct GCTypeMember
 {
@@ -26,10 +34,57 @@ struct GCAllocation
 	GCAllocation* allocklistNext;
 };
 
+struct GCObjectArray;
+
+// Where the property data of a class or struct keeps its object references. Generated from the properties.
+struct GCObjectType
+{
+	std::vector<uint32_t> references; // Offsets of UObject pointers, including the ones in structs and static arrays
+	std::vector<GCObjectArray> arrays; // Dynamic arrays with elements holding references
+
+	template<typename Callback>
+	void ForEachReference(void* data, Callback&& callback) const;
+};
+
+struct GCObjectArray
+{
+	uint32_t offset;
+	const GCObjectType* element;
+};
+
+template<typename Callback>
+void GCObjectType::ForEachReference(void* data, Callback&& callback) const
+{
+	uint8_t* d = static_cast<uint8_t*>(data);
+	for (uint32_t offset : references)
+	{
+		UObject*& ref = *reinterpret_cast<UObject**>(d + offset);
+		if (ref)
+			callback(ref);
+	}
+	for (const GCObjectArray& array : arrays)
+	{
+		for (void* element : *reinterpret_cast<std::vector<void*>*>(d + array.offset))
+			array.element->ForEachReference(element, callback);
+	}
+}
+
 struct GCStats
 {
 	size_t numObjects;
 	size_t memoryUsage;
+
+	size_t numUObjects; // Runtime UObjects owned by the collector
+	size_t numUObjectsFreed; // Since startup
+	size_t numCycles;
+	size_t lastCycleReached; // Objects reached by the last finished cycle, including the package objects
+	size_t lastCycleFreed;
+	size_t lastCycleRecycled;
+	double lastCycleMs; // Time spent on the last finished cycle, summed over its steps
+	double lastLongestStepMs; // Longest step of the last finished cycle
+	const char* phase;
+	size_t heapPages; // Pages of the small block allocator
+	size_t heapUsedBytes;
 };
 
 class GCRoot
@@ -51,6 +106,16 @@ private:
 	friend class GC;
 };
 
+// Also owns the UObjects created at runtime, and deletes them once nothing reaches them anymore.
+//
+// The objects referenced from native code, such as the actors of the loaded levels, are the roots. The package
+// objects are never collected, but are searched for references too. A cycle is spread over the frames, each
+// Step only doing as much as fits in its time budget. Marking is tri-color: white objects haven't been reached,
+// gray ones are on the mark stack and black ones have had their references searched. Objects created during a
+// cycle start out black, and the write barrier turns white objects gray when a reference to them is stored, so
+// a black object never points at a white one. Native code stores without the barrier, so the roots are searched
+// once more, again a slice at a time, when the marking runs out of work. The white runtime objects are then
+// freed a slice at a time. References to destroyed actors are set to None along the way.
 class GC
 {
 public:
@@ -58,8 +123,43 @@ public:
 	static void Collect();
 	static GCStats GetStats();
 
+	// Called for every object reference stored by script
+	static void WriteBarrier(UObject* value) { if (Marking && value) MarkObject(value); }
+
+	// Called when a block of property data is copied in one go
+	static void WriteBarrier(UStruct* type, void* data);
+
+	static void AddObject(UObject* obj);
+	static void SetObjectRoots(std::function<void(std::vector<UObject*>& roots)> nativeRoots, std::function<void(std::vector<UObject*>& objects)> packageObjects);
+
+	// Offered every unreachable object before it is deleted. Returns true if it took the object for reuse.
+	static void SetObjectRecycler(std::function<bool(UObject* obj)> recycler);
+
+	// Runs once per frame, outside of any script call
+	static void Step();
+
+	// Sets the references to objects of a package about to be unloaded to None
+	static void RemoveReferencesToPackage(Package* package);
+
+	static const GCObjectType& GetObjectType(UStruct* type);
+
 private:
 	static GCAllocation* MarkData(GCAllocation* marklist, void* data);
 	static GCAllocation* Mark(GCAllocation* allocation);
 	static void Sweep();
+
+	static bool IsCycleDue();
+	static void BeginCycle();
+	static void Continue(std::chrono::steady_clock::time_point deadline);
+	static void MarkObject(UObject* obj);
+	static bool MarkObjects(std::chrono::steady_clock::time_point deadline);
+	static size_t ScanObject(UObject* obj);
+	static void BeginRemark();
+	static void FinishMarking();
+	static bool SweepObjects(std::chrono::steady_clock::time_point deadline);
+	static void FinishSweep();
+	static void AbortCycle();
+	static void AddReferences(GCObjectType& type, UProperty* prop, size_t offset);
+
+	static bool Marking;
 };
@@ -0,0 +1,153 @@
+
+#include "Precomp.h"
+#include "GCHeap.h"
+#include <new>
+
+// Steps of 16 bytes up to 128, then four classes for each doubling
+const uint32_t GCHeap::ClassSizes[NumSizeClasses] =
+{
+	16, 32, 48, 64, 80, 96, 112, 128,
+	160, 192, 224, 256,
+	320, 384, 448, 512,
+	640, 768, 896, 1024,
+	1280, 1536, 1792, 2048,
+	2560, 3072, 3584, 4096,
+	5120, 6144, 7168, 8192
+};
+
+GCHeap::Page* GCHeap::PartialPages[NumSizeClasses];
+size_t GCHeap::PageCount = 0;
+size_t GCHeap::UsedBytes = 0;
+
+void* GCHeap::Alloc(size_t size)
+{
+	int sizeClass = GetSizeClass(size);
+	if (sizeClass < 0)
+	{
+		UsedBytes += size;
+		return ::operator new(size);
+	}
+
+	Page* page = PartialPages[sizeClass];
+	if (!page)
+		page = NewPage(sizeClass);
+
+	void* block = page->FreeList;
+	page->FreeList = *static_cast<void**>(block);
+	page->Used++;
+	if (!page->FreeList)
+		UnlinkPartial(page);
+
+	UsedBytes += ClassSizes[sizeClass];
+	return block;
+}
+
+void GCHeap::Free(void* ptr, size_t size)
+{
+	if (!ptr)
+		return;
+
+	int sizeClass = GetSizeClass(size);
+	if (sizeClass < 0)
+	{
+		UsedBytes -= size;
+		::operator delete(ptr);
+		return;
+	}
+
+	// Pages are aligned to their size, so the header is found from any block in them
+	Page* page = reinterpret_cast<Page*>(reinterpret_cast<uintptr_t>(ptr) & ~(uintptr_t)(PageSize - 1));
+	*static_cast<void**>(ptr) = page->FreeList;
+	page->FreeList = ptr;
+	page->Used--;
+	UsedBytes -= ClassSizes[sizeClass];
+
+	if (page->Used == 0 && PartialPages[sizeClass] != page)
+	{
+		// The page allocations are served from is kept, so a class doesn't keep getting and releasing one page
+		if (page->Partial)
+			UnlinkPartial(page);
+		::operator delete(page, std::align_val_t(PageSize));
+		PageCount--;
+	}
+	else if (!page->Partial)
+	{
+		LinkPartial(page);
+	}
+}
+
+int GCHeap::GetSizeClass(size_t size)
+{
+	if (size > MaxSmallSize)
+		return -1;
+
+	// Maps each 16 byte step to the smallest class that fits it
+	static const struct SizeClassTable
+	{
+		SizeClassTable()
+		{
+			int sizeClass = 0;
+			for (int i = 0; i <= MaxSmallSize / 16; i++)
+			{
+				while (ClassSizes[sizeClass] < (uint32_t)i * 16)
+					sizeClass++;
+				Classes[i] = (uint8_t)sizeClass;
+			}
+		}
+		uint8_t Classes[MaxSmallSize / 16 + 1];
+	} table;
+
+	return table.Classes[(size + 15) / 16];
+}
+
+GCHeap::Page* GCHeap::NewPage(int sizeClass)
+{
+	static_assert(sizeof(Page) <= PageHeaderSize, "Page header does not fit");
+
+	Page* page = static_cast<Page*>(::operator new(PageSize, std::align_val_t(PageSize)));
+	page->Prev = nullptr;
+	page->Next = nullptr;
+	page->FreeList = nullptr;
+	page->Used = 0;
+	page->SizeClass = sizeClass;
+	page->Partial = false;
+
+	// Thread the free list so that the blocks are handed out in address order
+	uint32_t blockSize = ClassSizes[sizeClass];
+	uint8_t* first = reinterpret_cast<uint8_t*>(page) + PageHeaderSize;
+	size_t count = (PageSize - PageHeaderSize) / blockSize;
+	for (size_t i = count; i > 0; i--)
+	{
+		void* block = first + (i - 1) * blockSize;
+		*static_cast<void**>(block) = page->FreeList;
+		page->FreeList = block;
+	}
+
+	PageCount++;
+	LinkPartial(page);
+	return page;
+}
+
+void GCHeap::LinkPartial(Page* page)
+{
+	Page*& head = PartialPages[page->SizeClass];
+	page->Prev = nullptr;
+	page->Next = head;
+	if (head)
+		head->Prev = page;
+	head = page;
+	page->Partial = true;
+}
+
+void GCHeap::UnlinkPartial(Page* page)
+{
+	if (page->Prev)
+		page->Prev->Next = page->Next;
+	else
+		PartialPages[page->SizeClass] = page->Next;
+	if (page->Next)
+		page->Next->Prev = page->Prev;
+	page->Prev = nullptr;
+	page->Next = nullptr;
+	page->Partial = false;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Allocator for the small blocks the engine creates and frees at a high rate, such as object property data.
+//
+// Requests up to MaxSmallSize are rounded up to one of a few size classes, and each class carves its blocks
+// out of pages holding nothing else. A page keeps its own free list, so freeing a block is a pointer push and
+// a page is returned to the system as soon as its last block is freed. Larger requests go to operator new.
+// The caller passes the size back to Free, which is how the size class is found without a block header.
+// Only the game thread may use it.
+class GCHeap
+{
+public:
+	static void* Alloc(size_t size);
+	static void Free(void* ptr, size_t size);
+
+	static size_t GetPageCount() { return PageCount; }
+	static size_t GetPageBytes() { return PageCount * PageSize; }
+	static size_t GetUsedBytes() { return UsedBytes; }
+
+	enum { PageSize = 128 * 1024, MaxSmallSize = 8192 };
+
+private:
+	struct Page
+	{
+		Page* Prev;
+		Page* Next;
+		void* FreeList;
+		uint32_t Used;
+		uint32_t SizeClass;
+		bool Partial;
+	};
+
+	enum { PageHeaderSize = 64, NumSizeClasses = 32 };
+
+	static int GetSizeClass(size_t size);
+	static Page* NewPage(int sizeClass);
+	static void LinkPartial(Page* page);
+	static void UnlinkPartial(Page* page);
+
+	static const uint32_t ClassSizes[NumSizeClasses];
+	static Page* PartialPages[NumSizeClasses];
+	static size_t PageCount;
+	static size_t UsedBytes;
+};
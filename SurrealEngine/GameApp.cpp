@@ -7,13 +7,10 @@
 #include "Engine.h"
 #include "UI/WidgetResourceData.h"
 #include "File.h"
+#include "Trace.h"
 #include <stdexcept>
 #include <zwidget/core/theme.h>
 #include <zwidget/window/window.h>
-#include <iostream>
-#include <filesystem>
-
-namespace fs = std::filesystem;
 
 #if __EMSCRIPTEN__
 #include <emscripten.h>
@@ -25,39 +22,33 @@ void emscripten_game_loop_step() {
 
 int GameApp::main(std::vector<std::string> args)
 {
-
+	if (args.size() <= 1)
 	{
-    	std::string path = "."; // current directory
-
-    	try {
-        	for (const auto & entry : fs::directory_iterator(path)) {
-            	std::cout << entry.path().filename().string() << std::endl;
-        	}
-    	} catch (const fs::filesystem_error& e) {
-        	std::cerr << "Error: " << e.what() << std::endl;
-    	}
+		args.clear();
+		args.push_back("SurrealEngine");
+		args.push_back("UnrealTournament");
+		args.push_back("--url=DM-TempestDEMO.unr");
 	}
 
-	std::cout << "GameApp main" << std::endl;	
-	args.clear();
-	args.push_back("SurrealEngine");
-	args.push_back("UnrealTournament");
-	args.push_back("--url=DM-TempestDEMO.unr");
-
-	std::cout << "DisplayBackend::TryCreateSDL2()" << std::endl;	
-	auto backend = DisplayBackend::TryCreateSDL2();
-	std::cout << "DisplayBackend::Set(std::move(backend))" << std::endl;
-	DisplayBackend::Set(std::move(backend));
-	std::cout << "InitWidgetResources()" << std::endl;
-	InitWidgetResources();
-	std::cout << "WidgetTheme::SetTheme" << std::endl;
-	WidgetTheme::SetTheme(std::make_unique<DarkWidgetTheme>());
-
-	std::cout << "Args" << std::endl;
-
 	CommandLine cmd(args);
 	commandline = &cmd;
 
+	// --trace=engine,package,... records those categories from startup. --trace-echo also prints the events.
+	std::string traceCategories = cmd.GetArg("-t", "--trace");
+	if (!traceCategories.empty())
+		Trace::Enable(Trace::ParseCategories(traceCategories));
+	Trace::SetEcho(cmd.HasArg("", "--trace-echo"));
+
+	// Dedicated servers and headless clients never open a window
+	bool headless = cmd.HasArg("-s", "--server") || cmd.HasArg("-H", "--headless");
+	if (!headless)
+	{
+		auto backend = DisplayBackend::TryCreateSDL2();
+		DisplayBackend::Set(std::move(backend));
+		InitWidgetResources();
+		WidgetTheme::SetTheme(std::make_unique<DarkWidgetTheme>());
+	}
+
 	GameLaunchInfo info = GameFolderSelection::GetLaunchInfo();
 
 #ifdef EMSCRIPTEN
@@ -66,13 +57,15 @@ int GameApp::main(std::vector<std::string> args)
 #else
 	if (!info.gameRootFolder.empty())
 	{
-		std::cout << "Engine" << std::endl;
 		Engine engine(info);
-		std::cout << "Run Engine" << std::endl;
 		engine.Run();
 	}
 
-	DeinitWidgetResources();
+	if (!traceCategories.empty())
+		File::write_all_text("Trace.json", Trace::ToChromeJson());
+
+	if (!headless)
+		DeinitWidgetResources();
 #endif
 	return 0;
 }
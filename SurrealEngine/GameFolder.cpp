@@ -6,8 +6,8 @@
 #include "UE1GameDatabase.h"
 #include "CommandLine.h"
 #include "UI/Launcher/LauncherWindow.h"
+#include "Trace.h"
 #include <filesystem>
-#include <iostream>
 
 GameLaunchInfo GameFolderSelection::GetLaunchInfo()
 {
@@ -54,8 +54,6 @@ GameLaunchInfo GameFolderSelection::GetLaunchInfo()
 
 	int selectedGame = 0;
 
-	std::cout << "Selected game: " << selectedGame << std::endl;
-
 	GameLaunchInfo info;
 	info.engineVersion = 227;					// Engine version (e.g. 226, 227, 436...)
 	info.engineSubVersion = 0;				// Engine sub version displayed as a letter (Note: Isn't always consistent)
@@ -71,13 +69,17 @@ GameLaunchInfo GameFolderSelection::GetLaunchInfo()
 	info.gameName = commandline->GetArg("-g", "--game", info.gameName);
 	info.noEntryMap = commandline->HasArg("-n", "--noentrymap") || info.noEntryMap;
 	info.url = commandline->GetArg("-u", "--url", info.url);
+	info.dedicatedServer = commandline->HasArg("-s", "--server");
+	info.headless = commandline->HasArg("-H", "--headless") || info.dedicatedServer;
+	info.connectAddress = commandline->GetArg("-c", "--connect");
+	info.port = commandline->GetArgInt("-p", "--port", info.port);
 
 	return info;
 }
 
 GameLaunchInfo GameFolderSelection::ExamineFolder(const std::string& path)
 {
-	std::cout << path << std::endl;
+	TRACE_EVENT_TEXT(TraceCategory::File, "ExamineGameFolder", path);
 	
 	GameLaunchInfo info;
 
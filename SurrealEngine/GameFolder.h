@@ -10,6 +10,10 @@ struct GameLaunchInfo
 	std::string gameExecutableName = "";	// Name of the game executable (e.g. "UnrealTournament")
 	std::string gameVersionString = "";		// Version (+ sub version) info as a string (e.g. "469d")
 	std::string url = "";					// The UnrealURL to launch upon startup
+	bool dedicatedServer = false;			// Run as a dedicated server
+	bool headless = false;					// No window, rendering or audio (always true for dedicated servers)
+	std::string connectAddress = "";		// Server to join as a network client (host:port)
+	int port = 0;							// UDP port a server listens on. 0 uses the Port from the [URL] ini section
 };
 
 class GameFolderSelection
@@ -0,0 +1,142 @@
+
+#include "Precomp.h"
+#include "JobSystem.h"
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace
+{
+	thread_local bool InsideJob = false;
+
+	struct ParallelJob
+	{
+		const std::function<void(size_t, size_t)>* Body = nullptr;
+		size_t Count = 0;
+		size_t BatchSize = 1;
+		std::atomic<size_t> Next{ 0 };
+
+		void RunBatches()
+		{
+			while (true)
+			{
+				size_t begin = Next.fetch_add(BatchSize);
+				if (begin >= Count)
+					break;
+				(*Body)(begin, std::min(begin + BatchSize, Count));
+			}
+		}
+	};
+
+	class WorkerPool
+	{
+	public:
+		WorkerPool()
+		{
+			int count = (int)std::thread::hardware_concurrency() - 1;
+			count = std::max(std::min(count, 15), 0);
+			for (int i = 0; i < count; i++)
+				Threads.push_back(std::thread([this]() { WorkerMain(); }));
+		}
+
+		~WorkerPool()
+		{
+			{
+				std::unique_lock lock(Mutex);
+				StopFlag = true;
+			}
+			WorkCondition.notify_all();
+			for (std::thread& thread : Threads)
+				thread.join();
+		}
+
+		void Run(ParallelJob& job)
+		{
+			std::unique_lock submitLock(SubmitMutex);
+
+			{
+				std::unique_lock lock(Mutex);
+				CurrentJob = &job;
+				Generation++;
+			}
+			WorkCondition.notify_all();
+
+			InsideJob = true;
+			job.RunBatches();
+			InsideJob = false;
+
+			std::unique_lock lock(Mutex);
+			DoneCondition.wait(lock, [&]() { return ActiveWorkers == 0; });
+			CurrentJob = nullptr;
+		}
+
+		int GetWorkerCount() const { return (int)Threads.size(); }
+
+	private:
+		void WorkerMain()
+		{
+			InsideJob = true;
+			uint64_t seenGeneration = 0;
+			std::unique_lock lock(Mutex);
+			while (true)
+			{
+				WorkCondition.wait(lock, [&]() { return StopFlag || Generation != seenGeneration; });
+				if (StopFlag)
+					break;
+
+				seenGeneration = Generation;
+				ParallelJob* job = CurrentJob;
+				if (!job)
+					continue;
+
+				ActiveWorkers++;
+				lock.unlock();
+				job->RunBatches();
+				lock.lock();
+				if (--ActiveWorkers == 0)
+					DoneCondition.notify_all();
+			}
+		}
+
+		std::vector<std::thread> Threads;
+		std::mutex SubmitMutex;
+		std::mutex Mutex;
+		std::condition_variable WorkCondition;
+		std::condition_variable DoneCondition;
+		ParallelJob* CurrentJob = nullptr;
+		uint64_t Generation = 0;
+		int ActiveWorkers = 0;
+		bool StopFlag = false;
+	};
+
+	WorkerPool& GetWorkerPool()
+	{
+		static WorkerPool pool;
+		return pool;
+	}
+}
+
+void JobSystem::ParallelFor(size_t count, size_t batchSize, const std::function<void(size_t begin, size_t end)>& body)
+{
+	if (count == 0)
+		return;
+
+	batchSize = std::max(batchSize, (size_t)1);
+	if (count <= batchSize || InsideJob || GetWorkerPool().GetWorkerCount() == 0)
+	{
+		body(0, count);
+		return;
+	}
+
+	ParallelJob job;
+	job.Body = &body;
+	job.Count = count;
+	job.BatchSize = batchSize;
+	GetWorkerPool().Run(job);
+}
+
+int JobSystem::GetThreadCount()
+{
+	return GetWorkerPool().GetWorkerCount() + 1;
+}
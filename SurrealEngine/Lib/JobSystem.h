@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+
+// Small fork/join worker pool for data parallel work.
+//
+// ParallelFor splits [0, count) into batches and runs them on the worker threads and the calling thread.
+// It returns when all batches have completed. Calls made from inside a job run serially on the calling thread.
+// The body must not call into the script VM or modify shared engine state.
+class JobSystem
+{
+public:
+	static void ParallelFor(size_t count, size_t batchSize, const std::function<void(size_t begin, size_t end)>& body);
+
+	// Number of threads participating in a ParallelFor, including the calling thread
+	static int GetThreadCount();
+};
@@ -0,0 +1,113 @@
+
+#include "Precomp.h"
+#include "MemoryStats.h"
+#include "JsonValue.h"
+#include <atomic>
+
+namespace
+{
+	struct CategoryInfo
+	{
+		const char* Subsystem;
+		const char* Type;
+	};
+
+	const CategoryInfo CategoryInfos[(int)MemoryCategory::Count] =
+	{
+		{ "Package", "Texture" },
+		{ "Package", "Sound" },
+		{ "Audio", "SoundSamples" },
+		{ "Package", "Music" },
+		{ "Package", "Mesh" },
+		{ "Package", "Model" },
+		{ "Render", "Lightmap" },
+		{ "Render", "Fogmap" },
+		{ "RenderDevice", "Texture" }
+	};
+
+	struct CategoryCounters
+	{
+		std::atomic<int64_t> Bytes;
+		std::atomic<int64_t> PeakBytes;
+		std::atomic<int64_t> Allocations;
+	};
+
+	CategoryCounters Counters[(int)MemoryCategory::Count];
+}
+
+void MemoryStats::Add(MemoryCategory category, size_t bytes)
+{
+	CategoryCounters& counters = Counters[(int)category];
+	int64_t total = counters.Bytes.fetch_add((int64_t)bytes) + (int64_t)bytes;
+	counters.Allocations++;
+
+	int64_t peak = counters.PeakBytes.load();
+	while (total > peak && !counters.PeakBytes.compare_exchange_weak(peak, total))
+	{
+	}
+}
+
+void MemoryStats::Remove(MemoryCategory category, size_t bytes)
+{
+	CategoryCounters& counters = Counters[(int)category];
+	counters.Bytes -= (int64_t)bytes;
+	counters.Allocations--;
+}
+
+std::vector<MemoryCategoryStats> MemoryStats::GetStats()
+{
+	std::vector<MemoryCategoryStats> stats;
+	for (int i = 0; i < (int)MemoryCategory::Count; i++)
+	{
+		MemoryCategoryStats entry;
+		entry.Category = (MemoryCategory)i;
+		entry.Subsystem = CategoryInfos[i].Subsystem;
+		entry.Type = CategoryInfos[i].Type;
+		entry.Bytes = Counters[i].Bytes.load();
+		entry.PeakBytes = Counters[i].PeakBytes.load();
+		entry.Allocations = Counters[i].Allocations.load();
+		stats.push_back(entry);
+	}
+	return stats;
+}
+
+int64_t MemoryStats::GetTotalBytes()
+{
+	int64_t total = 0;
+	for (const CategoryCounters& counters : Counters)
+		total += counters.Bytes.load();
+	return total;
+}
+
+std::string MemoryStats::ToJson(const std::string& mapName)
+{
+	JsonValue categories = JsonValue::array();
+	for (const MemoryCategoryStats& entry : GetStats())
+	{
+		JsonValue item = JsonValue::object();
+		item.add("subsystem", JsonValue::string(entry.Subsystem));
+		item.add("type", JsonValue::string(entry.Type));
+		item.add("bytes", JsonValue::number((double)entry.Bytes));
+		item.add("peakBytes", JsonValue::number((double)entry.PeakBytes));
+		item.add("allocations", JsonValue::number((double)entry.Allocations));
+		categories.items().push_back(item);
+	}
+
+	JsonValue root = JsonValue::object();
+	root.add("map", JsonValue::string(mapName));
+	root.add("totalBytes", JsonValue::number((double)GetTotalBytes()));
+	root.add("categories", categories);
+	return root.to_json(true);
+}
+
+std::string MemoryStats::FormatBytes(int64_t bytes)
+{
+	char buffer[64];
+	if (bytes >= 1024 * 1024)
+		snprintf(buffer, sizeof(buffer), "%.1f MB", bytes / (1024.0 * 1024.0));
+	else if (bytes >= 1024)
+		snprintf(buffer, sizeof(buffer), "%.1f KB", bytes / 1024.0);
+	else
+		snprintf(buffer, sizeof(buffer), "%d bytes", (int)bytes);
+	return buffer;
+}
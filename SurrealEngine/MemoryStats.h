@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+enum class MemoryCategory
+{
+	Textures,
+	Sounds,
+	SoundSamples,
+	Music,
+	Meshes,
+	Models,
+	Lightmaps,
+	Fogmaps,
+	DeviceTextures,
+	Count
+};
+
+struct MemoryCategoryStats
+{
+	MemoryCategory Category;
+	const char* Subsystem;
+	const char* Type;
+	int64_t Bytes;
+	int64_t PeakBytes;
+	int64_t Allocations;
+};
+
+// Counts the bytes used by assets and caches, grouped by the subsystem owning them
+class MemoryStats
+{
+public:
+	static void Add(MemoryCategory category, size_t bytes);
+	static void Remove(MemoryCategory category, size_t bytes);
+
+	static std::vector<MemoryCategoryStats> GetStats();
+	static int64_t GetTotalBytes();
+
+	static std::string ToJson(const std::string& mapName);
+	static std::string FormatBytes(int64_t bytes);
+
+	template<typename T>
+	static size_t GetVectorBytes(const std::vector<T>& v) { return v.capacity() * sizeof(T); }
+};
+
+// Tracks a single allocation owned by an object and releases it from the stats when destroyed
+class TrackedMemory
+{
+public:
+	TrackedMemory() = default;
+	TrackedMemory(MemoryCategory category, size_t bytes) { Set(category, bytes); }
+	TrackedMemory(TrackedMemory&& other) noexcept : Category(other.Category), Bytes(other.Bytes), Active(other.Active) { other.Active = false; other.Bytes = 0; }
+	~TrackedMemory() { Reset(); }
+
+	TrackedMemory& operator=(TrackedMemory&& other) noexcept
+	{
+		if (this != &other)
+		{
+			Reset();
+			Category = other.Category;
+			Bytes = other.Bytes;
+			Active = other.Active;
+			other.Active = false;
+			other.Bytes = 0;
+		}
+		return *this;
+	}
+
+	void Set(MemoryCategory category, size_t bytes)
+	{
+		Reset();
+		Category = category;
+		Bytes = bytes;
+		Active = true;
+		MemoryStats::Add(Category, Bytes);
+	}
+
+	void Reset()
+	{
+		if (Active)
+		{
+			MemoryStats::Remove(Category, Bytes);
+			Active = false;
+			Bytes = 0;
+		}
+	}
+
+	size_t GetBytes() const { return Bytes; }
+
+private:
+	TrackedMemory(const TrackedMemory&) = delete;
+	TrackedMemory& operator=(const TrackedMemory&) = delete;
+
+	MemoryCategory Category = MemoryCategory::Textures;
+	size_t Bytes = 0;
+	bool Active = false;
+};
@@ -122,7 +122,7 @@ void NActor::DemoPlaySound(UObject* Self, UObject* Sound, uint8_t* Slot, float*
 {
 	UActor* SelfActor = UObject::Cast<UActor>(Self);
 	USound* s = UObject::Cast<USound>(Sound);
-	if (s)
+	if (s && engine->audio)
 	{
 		int slot = Slot ? *Slot : SLOT_Misc;
 		int id = ((((int)(ptrdiff_t)SelfActor) & 0xffffff) << 4) + (slot << 1);
@@ -362,7 +362,7 @@ void NActor::PlayOwnedSound(UObject* Self, UObject* Sound, uint8_t* Slot, float*
 {
 	UActor* SelfActor = UObject::Cast<UActor>(Self);
 	USound* s = UObject::Cast<USound>(Sound);
-	if (s)
+	if (s && engine->audio)
 	{
 		int slot = Slot ? *Slot : SLOT_Misc;
 		int id = ((((int)(ptrdiff_t)SelfActor) & 0xffffff) << 4) + (slot << 1);
@@ -375,7 +375,7 @@ void NActor::PlaySound(UObject* Self, UObject* Sound, uint8_t* Slot, float* Volu
 {
 	UActor* SelfActor = UObject::Cast<UActor>(Self);
 	USound* s = UObject::Cast<USound>(Sound);
-	if (s)
+	if (s && engine->audio)
 	{
 		int slot = Slot ? *Slot : SLOT_Misc;
 		int id = ((((int)(ptrdiff_t)SelfActor) & 0xffffff) << 4) + (slot << 1);
@@ -3,6 +3,7 @@
 #include "NDeusExPlayer.h"
 #include "VM/NativeFunc.h"
 #include "UObject/UActor.h"
+#include "UObject/SaveGame.h"
 #include "Engine.h"
 
 void NDeusExPlayer::RegisterFunctions()
@@ -69,7 +70,8 @@ void NDeusExPlayer::GetDeusExVersion(UObject* Self, std::string& ReturnValue)
 
 void NDeusExPlayer::SaveGame(UObject* Self, int saveIndex, std::string* saveDesc)
 {
-	Exception::Throw("DeusExPlayer.SaveGame not implemented");
+	if (engine->saves)
+		engine->saves->Save(saveIndex, saveDesc ? *saveDesc : std::string());
 }
 
 void NDeusExPlayer::SetBoolFlagFromString(UObject* Self, const std::string& flagNameString, bool bValue, NameString& ReturnValue)
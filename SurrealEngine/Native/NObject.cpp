@@ -6,8 +6,8 @@
 #include "Package/PackageManager.h"
 #include "Engine.h"
 #include "Math/quaternion.h"
+#include "Trace.h"
 #include <cmath>
-#include <iostream>
 
 #ifdef EMSCRIPTEN
 #include <emscripten.h>
@@ -439,10 +439,9 @@ void NObject::DynamicLoadObject(const std::string& ObjectName, UObject* ObjectCl
 			std::string packageName = ObjectName.substr(0, dotpos);
 			std::string objectName = ObjectName.substr(dotpos + 1);
 
-			std::cout << "NObject::DynamicLoadObject" << std::endl;
+			TRACE_EVENT_TEXT(TraceCategory::Package, "DynamicLoadObject", ObjectName);
 			try
 			{
-std::cout << "GP9" << std::endl;				
 				ReturnValue = engine->packages->GetPackage(packageName, 993)->GetUObject(ObjectClass->Name, objectName);
 			}
 			catch (...)
@@ -79,20 +79,20 @@ void NPawn::FindBestInventoryPath(UObject* Self, float& MinWeight, bool bPredict
 
 void NPawn::FindPathTo(UObject* Self, const vec3& aPoint, BitfieldBool* bSinglePath, BitfieldBool* bClearPaths, UObject*& ReturnValue)
 {
-	engine->LogUnimplemented("Pawn.FindPathTo");
-	ReturnValue = nullptr;
+	UPawn* SelfPawn = UObject::Cast<UPawn>(Self);
+	ReturnValue = SelfPawn->XLevel()->Navigation.FindPathTo(SelfPawn, aPoint);
 }
 
 void NPawn::FindPathToward(UObject* Self, UObject* anActor, BitfieldBool* bSinglePath, BitfieldBool* bClearPaths, UObject*& ReturnValue)
 {
-	engine->LogUnimplemented("Pawn.FindPathToward");
-	ReturnValue = nullptr;
+	UPawn* SelfPawn = UObject::Cast<UPawn>(Self);
+	ReturnValue = SelfPawn->XLevel()->Navigation.FindPathToward(SelfPawn, UObject::Cast<UActor>(anActor));
 }
 
 void NPawn::FindRandomDest(UObject* Self, BitfieldBool* bClearPaths, UObject*& ReturnValue)
 {
-	engine->LogUnimplemented("Pawn.FindRandomDest");
-	ReturnValue = nullptr;
+	UPawn* SelfPawn = UObject::Cast<UPawn>(Self);
+	ReturnValue = SelfPawn->XLevel()->Navigation.FindRandomDest(SelfPawn);
 }
 
 void NPawn::FindStairRotation(UObject* Self, float DeltaTime, int& ReturnValue)
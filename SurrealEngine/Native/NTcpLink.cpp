@@ -18,7 +18,7 @@ void NTcpLink::RegisterFunctions()
 
 void NTcpLink::BindPort(UObject* Self, int* Port, BitfieldBool* bUseNextAvailable, int& ReturnValue)
 {
-	ReturnValue = UObject::Cast<UTcpLink>(Self)->BindPort(Port ? *Port : 7777, bUseNextAvailable ? *bUseNextAvailable : false);
+	ReturnValue = UObject::Cast<UTcpLink>(Self)->BindPort(Port ? *Port : 0, bUseNextAvailable ? *bUseNextAvailable : false);
 }
 
 void NTcpLink::Close(UObject* Self, BitfieldBool& ReturnValue)
@@ -51,7 +51,7 @@ void NTcpLink::ReadText(UObject* Self, std::string& Str, int& ReturnValue)
 	ReturnValue = UObject::Cast<UTcpLink>(Self)->ReadText(Str);
 }
 
-void NTcpLink::SendBinary(UObject* Self, int Count, uint8_t B, int& ReturnValue)
+void NTcpLink::SendBinary(UObject* Self, int Count, uint8_t& B, int& ReturnValue)
 {
 	ReturnValue = UObject::Cast<UTcpLink>(Self)->SendBinary(Count, B);
 }
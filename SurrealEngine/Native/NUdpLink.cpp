@@ -14,7 +14,7 @@ void NUdpLink::RegisterFunctions()
 
 void NUdpLink::BindPort(UObject* Self, int* Port, BitfieldBool* bUseNextAvailable, int& ReturnValue)
 {
-	ReturnValue = UObject::Cast<UUdpLink>(Self)->BindPort(Port ? *Port : 7777, bUseNextAvailable ? *bUseNextAvailable : false);
+	ReturnValue = UObject::Cast<UUdpLink>(Self)->BindPort(Port ? *Port : 0, bUseNextAvailable ? *bUseNextAvailable : false);
 }
 
 void NUdpLink::ReadBinary(UObject* Self, IpAddr& Addr, int Count, uint8_t& B, int& ReturnValue)
@@ -27,7 +27,7 @@ void NUdpLink::ReadText(UObject* Self, IpAddr& Addr, std::string& Str, int& Retu
 	ReturnValue = UObject::Cast<UUdpLink>(Self)->ReadText(Addr, Str);
 }
 
-void NUdpLink::SendBinary(UObject* Self, const IpAddr& Addr, int Count, uint8_t B, BitfieldBool& ReturnValue)
+void NUdpLink::SendBinary(UObject* Self, const IpAddr& Addr, int Count, uint8_t& B, BitfieldBool& ReturnValue)
 {
 	ReturnValue = UObject::Cast<UUdpLink>(Self)->SendBinary(Addr, Count, B);
 }
@@ -0,0 +1,131 @@
+
+#include "Precomp.h"
+#include "HostResolver.h"
+#include <algorithm>
+
+#ifdef WIN32
+#include <WinSock2.h>
+#include <WS2tcpip.h>
+typedef unsigned long in_addr_t;
+#else
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <netdb.h>
+#endif
+
+// Failed lookups are retried sooner, as they are often caused by the network not being up yet
+static const std::chrono::seconds ResolvedCacheTime(300);
+static const std::chrono::seconds FailedCacheTime(30);
+
+HostResolver::HostResolver(int maxThreads) : MaxThreads(std::max(maxThreads, 1))
+{
+}
+
+HostResolver::~HostResolver()
+{
+	std::unique_lock<std::mutex> lock(Mutex);
+	StopFlag = true;
+	lock.unlock();
+	Condition.notify_all();
+
+	for (std::thread& thread : Threads)
+		thread.join();
+}
+
+void HostResolver::Resolve(const std::string& host, const void* requester)
+{
+	in_addr_t ipv4_address = inet_addr(host.c_str());
+	if (ipv4_address != INADDR_NONE)
+	{
+		std::unique_lock<std::mutex> lock(Mutex);
+		Finished.push_back({ requester, true, ntohl(ipv4_address) });
+		return;
+	}
+
+	std::unique_lock<std::mutex> lock(Mutex);
+
+	auto it = Cache.find(host);
+	if (it != Cache.end())
+	{
+		if (it->second.Expires > std::chrono::steady_clock::now())
+		{
+			Finished.push_back({ requester, it->second.Succeeded, it->second.Addr });
+			return;
+		}
+		Cache.erase(it);
+	}
+
+	std::vector<const void*>& waiting = Waiting[host];
+	waiting.push_back(requester);
+	if (waiting.size() > 1)
+		return;
+
+	Queue.push_back(host);
+	if (Threads.size() < (size_t)MaxThreads && Threads.size() < Queue.size())
+		Threads.push_back(std::thread([this]() { WorkerMain(); }));
+	lock.unlock();
+	Condition.notify_one();
+}
+
+void HostResolver::Cancel(const void* requester)
+{
+	std::unique_lock<std::mutex> lock(Mutex);
+	for (auto& it : Waiting)
+		it.second.erase(std::remove(it.second.begin(), it.second.end(), requester), it.second.end());
+	Finished.erase(std::remove_if(Finished.begin(), Finished.end(), [=](const Result& result) { return result.Requester == requester; }), Finished.end());
+}
+
+std::vector<HostResolver::Result> HostResolver::FetchResults()
+{
+	std::unique_lock<std::mutex> lock(Mutex);
+	std::vector<Result> results;
+	results.swap(Finished);
+	return results;
+}
+
+void HostResolver::WorkerMain()
+{
+	std::unique_lock<std::mutex> lock(Mutex);
+	while (true)
+	{
+		Condition.wait(lock, [this]() { return StopFlag || !Queue.empty(); });
+		if (StopFlag)
+			break;
+
+		std::string host = std::move(Queue.front());
+		Queue.pop_front();
+
+		lock.unlock();
+		CacheEntry entry;
+		entry.Succeeded = Lookup(host, entry.Addr);
+		entry.Expires = std::chrono::steady_clock::now() + (entry.Succeeded ? ResolvedCacheTime : FailedCacheTime);
+		lock.lock();
+
+		Cache[host] = entry;
+
+		auto it = Waiting.find(host);
+		if (it != Waiting.end())
+		{
+			for (const void* requester : it->second)
+				Finished.push_back({ requester, entry.Succeeded, entry.Addr });
+			Waiting.erase(it);
+		}
+	}
+}
+
+bool HostResolver::Lookup(const std::string& host, uint32_t& addr)
+{
+	// getaddrinfo, unlike gethostbyname, is safe to call from several threads at once
+	addrinfo hints = {};
+	hints.ai_family = AF_INET;
+	hints.ai_socktype = SOCK_STREAM;
+
+	addrinfo* result = nullptr;
+	if (getaddrinfo(host.c_str(), nullptr, &hints, &result) != 0 || !result)
+		return false;
+
+	addr = ntohl(((sockaddr_in*)result->ai_addr)->sin_addr.s_addr);
+	freeaddrinfo(result);
+	return true;
+}
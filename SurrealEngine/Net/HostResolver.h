@@ -0,0 +1,59 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+#include <list>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+
+// Looks up IPv4 addresses for host names on a small pool of worker threads.
+//
+// Results are cached for a while, and lookups of a host that is already being resolved wait for the
+// same answer, so a server browser asking for the same master server from dozens of links costs one query.
+class HostResolver
+{
+public:
+	HostResolver(int maxThreads = 2);
+	~HostResolver();
+
+	struct Result
+	{
+		const void* Requester = nullptr;
+		bool Succeeded = false;
+		uint32_t Addr = 0; // Host byte order
+	};
+
+	// Queues a lookup. Numeric addresses and cached hosts finish without touching the worker threads.
+	void Resolve(const std::string& host, const void* requester);
+
+	// Drops any results still pending for the requester
+	void Cancel(const void* requester);
+
+	// Returns the lookups that finished since the last call
+	std::vector<Result> FetchResults();
+
+private:
+	void WorkerMain();
+	static bool Lookup(const std::string& host, uint32_t& addr);
+
+	struct CacheEntry
+	{
+		bool Succeeded = false;
+		uint32_t Addr = 0;
+		std::chrono::steady_clock::time_point Expires;
+	};
+
+	int MaxThreads = 0;
+	std::vector<std::thread> Threads;
+	std::mutex Mutex;
+	std::condition_variable Condition;
+	bool StopFlag = false;
+
+	std::list<std::string> Queue;
+	std::map<std::string, std::vector<const void*>> Waiting;
+	std::map<std::string, CacheEntry> Cache;
+	std::vector<Result> Finished;
+};
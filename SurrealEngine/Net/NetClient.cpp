@@ -0,0 +1,334 @@
+
+#include "Precomp.h"
+#include "NetClient.h"
+#include "UObject/UActor.h"
+#include "UObject/ULevel.h"
+#include "UObject/UClass.h"
+#include "UObject/UClient.h"
+#include "UObject/UProperty.h"
+#include "UObject/USubsystem.h"
+#include "Engine.h"
+#include <chrono>
+#include <thread>
+
+NetClient::NetClient(USurrealNetworkDevice* settings) : NetDriver(settings)
+{
+}
+
+uint8_t NetClient::GetNetMode() const
+{
+	return NM_Client;
+}
+
+void NetClient::Connect(const std::string& address, const std::vector<std::string>& options)
+{
+	NetAddress serverAddress;
+	if (!NetAddress::Resolve(address, 7777, serverAddress))
+		Exception::Throw("Could not resolve server address " + address);
+	if (!Socket.IsValid() || !Socket.Bind(0))
+		Exception::Throw("Could not create the client socket");
+
+	ServerConnection = std::make_unique<NetConnection>(this, serverAddress);
+
+	NetWriter hello;
+	hello.WriteVarUInt(NetProtocolVersion);
+	hello.WriteVarUInt((uint32_t)options.size());
+	for (const std::string& option : options)
+		hello.WriteString(option);
+	ServerConnection->SendReliable(NetMessage::Hello, hello);
+
+	engine->LogMessage("Connecting to " + serverAddress.ToString());
+
+	using namespace std::chrono_literals;
+	while (!Welcomed)
+	{
+		std::this_thread::sleep_for(10ms);
+		TickDispatch(0.01f);
+		TickFlush(0.01f);
+
+		if (ServerConnection->State == NetConnectionState::Closed)
+			Exception::Throw("Server refused the connection");
+		if (Time - ServerConnection->LastReceiveTime > Settings->InitialConnectTimeout)
+			Exception::Throw("Timed out connecting to " + serverAddress.ToString());
+	}
+}
+
+void NetClient::TickDispatch(float elapsed)
+{
+	Time += elapsed;
+
+	if (!ServerConnection || ServerConnection->State == NetConnectionState::Closed)
+		return;
+
+	uint8_t buffer[2048];
+	NetAddress from;
+	int size;
+	while ((size = Socket.ReceiveFrom(from, buffer, sizeof(buffer))) > 0)
+	{
+		if (from != ServerConnection->Address)
+			continue;
+
+		NetReader reader(buffer, size);
+		if (!ServerConnection->ReceivePacket(reader, Time))
+			continue;
+
+		ProcessPacket(ServerConnection.get(), reader);
+		if (ServerConnection->State == NetConnectionState::Closed)
+			return;
+
+		if (!PendingMap.empty())
+		{
+			std::string map = std::move(PendingMap);
+			PendingMap.clear();
+			LoadServerMap(map);
+		}
+
+		RetryPendingCalls();
+	}
+
+	if (Welcomed && Time - ServerConnection->LastReceiveTime > Settings->ConnectionTimeout)
+		Disconnect("Connection to the server timed out");
+}
+
+void NetClient::TickFlush(float)
+{
+	if (!ServerConnection || ServerConnection->State == NetConnectionState::Closed)
+		return;
+
+	// Function calls queue up between packets, so there is no need to send more often than this
+	if (Time - ServerConnection->LastSendTime < 1.0f / 60.0f)
+		return;
+
+	NetWriter packet;
+	NetSentPacket record;
+	ServerConnection->BeginPacket(packet, record, Time);
+	ServerConnection->SendPacket(packet, std::move(record));
+}
+
+void NetClient::GetObjectRoots(std::vector<UObject*>& roots)
+{
+	if (ServerConnection)
+		ServerConnection->GetObjectRoots(roots);
+}
+
+void NetClient::Shutdown()
+{
+	if (ServerConnection && ServerConnection->State != NetConnectionState::Closed)
+	{
+		NetWriter body;
+		body.WriteString("Client quit");
+		ServerConnection->SendUnreliable(NetMessage::Disconnect, body);
+
+		NetWriter packet;
+		NetSentPacket record;
+		ServerConnection->BeginPacket(packet, record, Time);
+		ServerConnection->SendPacket(packet, std::move(record));
+		ServerConnection->State = NetConnectionState::Closed;
+	}
+}
+
+void NetClient::Disconnect(const std::string& reason)
+{
+	engine->LogMessage("Disconnected: " + reason);
+	ServerConnection->State = NetConnectionState::Closed;
+	ServerConnection->CloseAllChannels();
+	engine->quit = true;
+}
+
+NetConnection* NetClient::GetFunctionConnection(UActor* actor, bool& owned)
+{
+	// Actors the client spawned itself, and those the server doesn't know about, run their functions locally
+	if (!ServerConnection || ServerConnection->State != NetConnectionState::Joined || actor->Role() == ROLE_Authority || !ServerConnection->FindChannel(actor))
+		return nullptr;
+
+	owned = IsOwnedBy(actor, engine->viewport->Actor());
+	return ServerConnection.get();
+}
+
+void NetClient::ProcessMessage(NetConnection* connection, NetMessage type, NetReader& body)
+{
+	if (type == NetMessage::Welcome)
+	{
+		std::string map = body.ReadString();
+		if (!body.HasError())
+			PendingMap = map;
+	}
+	else if (type == NetMessage::ActorUpdate)
+	{
+		if (connection->State == NetConnectionState::Joined && PendingMap.empty())
+			ReceiveActorUpdate(body);
+	}
+	else if (type == NetMessage::ActorClose)
+	{
+		ReceiveActorClose(body);
+	}
+	else if (type == NetMessage::FunctionCall)
+	{
+		size_t start = body.GetPos();
+		if (connection->State == NetConnectionState::Joined && !ReceiveFunctionCall(connection, body))
+		{
+			PendingCall call;
+			call.Time = Time;
+			call.Data.assign(body.GetData() + start, body.GetData() + body.GetPos() + body.GetRemaining());
+			PendingCalls.push_back(std::move(call));
+		}
+	}
+	else if (type == NetMessage::Disconnect)
+	{
+		std::string reason = body.ReadString();
+		if (!Welcomed)
+			engine->LogMessage("Server refused the connection: " + reason);
+		Disconnect(reason);
+	}
+}
+
+void NetClient::RetryPendingCalls()
+{
+	for (size_t i = 0; i < PendingCalls.size();)
+	{
+		NetReader body(PendingCalls[i].Data.data(), PendingCalls[i].Data.size());
+		if (ReceiveFunctionCall(ServerConnection.get(), body) || Time - PendingCalls[i].Time > 5.0f)
+			PendingCalls.erase(PendingCalls.begin() + i);
+		else
+			i++;
+	}
+}
+
+void NetClient::LoadServerMap(const std::string& map)
+{
+	ServerConnection->CloseAllChannels();
+	PendingCalls.clear();
+	engine->viewport->Actor() = nullptr;
+
+	engine->LogMessage("Loading " + map);
+	engine->LoadMap(engine->GetDefaultURL(map));
+	engine->LoginPlayer();
+
+	NetWriter join;
+	join.WriteString(engine->LevelInfo->URL.Map);
+	ServerConnection->SendReliable(NetMessage::Join, join);
+	ServerConnection->State = NetConnectionState::Joined;
+	Welcomed = true;
+}
+
+static bool IsActorClass(UClass* cls)
+{
+	for (UStruct* s = cls; s != nullptr; s = s->BaseStruct)
+	{
+		if (s->Name == "Actor")
+			return true;
+	}
+	return false;
+}
+
+void NetClient::ReceiveActorUpdate(NetReader& body)
+{
+	uint32_t id = body.ReadVarUInt();
+	uint8_t flags = body.ReadUInt8();
+	NetActorChannel* channel = ServerConnection->FindChannel(id);
+
+	// The open info is repeated until the server knows we have the actor
+	if (flags & 1)
+	{
+		UActor* actor = nullptr;
+		if (flags & 4)
+		{
+			actor = UObject::TryCast<UActor>(ServerConnection->ReadObject(body));
+		}
+		else
+		{
+			UClass* cls = UObject::TryCast<UClass>(ServerConnection->ReadObject(body));
+			vec3 location;
+			location.x = body.ReadFloat();
+			location.y = body.ReadFloat();
+			location.z = body.ReadFloat();
+			Rotator rotation;
+			rotation.Pitch = body.ReadVarInt();
+			rotation.Yaw = body.ReadVarInt();
+			rotation.Roll = body.ReadVarInt();
+			uint8_t role = body.ReadUInt8();
+
+			if (!channel && !body.HasError() && cls && IsActorClass(cls))
+			{
+				actor = engine->LevelInfo->Spawn(cls, nullptr, NameString(), &location, &rotation, true);
+				if (actor)
+					actor->Role() = role;
+			}
+		}
+
+		if (body.HasError())
+			return;
+
+		// Keep a channel even if the actor couldn't be created, so that its updates are skipped quietly
+		if (!channel)
+		{
+			channel = ServerConnection->OpenChannel(actor, id);
+			channel->OpenAcked = true;
+		}
+	}
+
+	if (!channel || !channel->Actor || channel->Actor->bDeleteMe())
+		return;
+
+	UActor* actor = channel->Actor;
+	vec3 oldLocation = actor->Location();
+	float oldRadius = actor->CollisionRadius();
+	float oldHeight = actor->CollisionHeight();
+	bool oldCollideActors = actor->bCollideActors();
+
+	const NetClassLayout& layout = Replication.GetClassLayout(actor->Class);
+	while (true)
+	{
+		uint32_t index = body.ReadVarUInt();
+		if (index == 0 || index > layout.Properties.size() || body.HasError())
+			break;
+
+		// The roles are as seen from the server
+		UProperty* prop = layout.Properties[index - 1].Property;
+		void* data = actor->PropertyData.Ptr(prop);
+		if (prop->DataOffset.DataOffset == PropOffsets_Actor.Role.DataOffset)
+			data = &actor->RemoteRole();
+		else if (prop->DataOffset.DataOffset == PropOffsets_Actor.RemoteRole.DataOffset)
+			data = &actor->Role();
+
+		NetReplication::ReadValue(body, prop, data, ServerConnection.get());
+	}
+
+	// Moved directly rather than with SetLocation, as the touch and encroachment logic belongs to the server
+	if (actor->Location() != oldLocation || actor->CollisionRadius() != oldRadius || actor->CollisionHeight() != oldHeight || actor->bCollideActors() != oldCollideActors)
+	{
+		actor->XLevel()->Hash.RemoveFromCollision(actor);
+		actor->XLevel()->Hash.AddToCollision(actor);
+		actor->MarkBspDirty();
+	}
+
+	if ((flags & 2) && engine->viewport->Actor() != actor)
+	{
+		UPlayerPawn* pawn = UObject::TryCast<UPlayerPawn>(actor);
+		if (pawn)
+		{
+			engine->viewport->Actor() = pawn;
+			pawn->Player() = engine->viewport;
+			engine->LogMessage("Possessed " + pawn->Name.ToString());
+		}
+	}
+}
+
+void NetClient::ReceiveActorClose(NetReader& body)
+{
+	NetActorChannel* channel = ServerConnection->FindChannel(body.ReadVarUInt());
+	if (!channel)
+		return;
+
+	UActor* actor = channel->Actor;
+	bool staticActor = channel->StaticActor;
+	ServerConnection->CloseChannel(channel);
+
+	// Actors that are part of the map stay, they just aren't updated anymore
+	if (actor && !staticActor && !actor->bDeleteMe())
+	{
+		if (engine->viewport->Actor() == actor)
+			engine->viewport->Actor() = nullptr;
+		actor->Destroy();
+	}
+}
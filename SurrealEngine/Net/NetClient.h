@@ -0,0 +1,47 @@
+#pragma once
+
+#include "NetDriver.h"
+
+// Connects to a server, loads the map it is running and mirrors the actors it replicates.
+//
+// The client never spawns a player of its own. It gets its pawn through a channel flagged as owned by this connection.
+class NetClient : public NetDriver
+{
+public:
+	NetClient(USurrealNetworkDevice* settings);
+
+	// Sends the hello and keeps receiving until the server's map is loaded
+	void Connect(const std::string& address, const std::vector<std::string>& options);
+
+	bool IsServer() const override { return false; }
+	uint8_t GetNetMode() const override;
+	bool HasLocalPlayer() const override { return false; }
+
+	void TickDispatch(float elapsed) override;
+	void TickFlush(float elapsed) override;
+	void Shutdown() override;
+	void GetObjectRoots(std::vector<UObject*>& roots) override;
+
+protected:
+	NetConnection* GetFunctionConnection(UActor* actor, bool& owned) override;
+	void ProcessMessage(NetConnection* connection, NetMessage type, NetReader& body) override;
+
+private:
+	void LoadServerMap(const std::string& map);
+	void ReceiveActorUpdate(NetReader& body);
+	void ReceiveActorClose(NetReader& body);
+	void RetryPendingCalls();
+	void Disconnect(const std::string& reason);
+
+	// Reliable function calls can arrive before the unreliable open of their channel
+	struct PendingCall
+	{
+		float Time = 0.0f;
+		std::vector<uint8_t> Data;
+	};
+
+	std::unique_ptr<NetConnection> ServerConnection;
+	std::string PendingMap;
+	std::vector<PendingCall> PendingCalls;
+	bool Welcomed = false;
+};
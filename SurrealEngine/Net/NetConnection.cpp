@@ -0,0 +1,373 @@
+
+#include "Precomp.h"
+#include "NetConnection.h"
+#include "NetDriver.h"
+#include "Package/PackageManager.h"
+#include "Package/Package.h"
+#include "UObject/UActor.h"
+#include "UObject/UClient.h"
+#include "Engine.h"
+
+NetConnection::NetConnection(NetDriver* driver, const NetAddress& address) : Driver(driver), Address(address)
+{
+	LastReceiveTime = driver->Time;
+	LastSendTime = driver->Time;
+}
+
+void NetConnection::BeginPacket(NetWriter& packet, NetSentPacket& record, float time)
+{
+	ExpirePackets(time);
+
+	packet.Clear();
+	record = {};
+	record.Sequence = OutSequence;
+	record.Time = time;
+
+	packet.WriteUInt16(OutSequence);
+	packet.WriteUInt8(HasInSequence ? 1 : 0);
+	if (HasInSequence)
+	{
+		packet.WriteUInt16(InSequence);
+		packet.WriteUInt32(InSequenceBits);
+	}
+	record.HeaderSize = packet.Size();
+
+	WriteReliables(packet, record);
+	WriteUnreliables(packet);
+}
+
+void NetConnection::SendPacket(const NetWriter& packet, NetSentPacket&& record)
+{
+	Driver->SendTo(Address, packet);
+
+	Budget -= (float)(packet.Size() + 28); // IP and UDP headers
+	LastSendTime = record.Time;
+	OutSequence++;
+
+	SentPackets.push_back(std::move(record));
+	if (SentPackets.size() > 256)
+	{
+		PacketLost(SentPackets.front());
+		SentPackets.pop_front();
+	}
+}
+
+bool NetConnection::ReceivePacket(NetReader& reader, float time)
+{
+	uint16_t sequence = reader.ReadUInt16();
+	bool hasAck = (reader.ReadUInt8() & 1) != 0;
+	uint16_t ack = 0;
+	uint32_t ackBits = 0;
+	if (hasAck)
+	{
+		ack = reader.ReadUInt16();
+		ackBits = reader.ReadUInt32();
+	}
+
+	if (reader.HasError())
+		return false;
+
+	if (HasInSequence)
+	{
+		if (!IsSequenceNewer(sequence, InSequence))
+			return false;
+
+		int shift = (uint16_t)(sequence - InSequence);
+		if (shift < 32)
+			InSequenceBits = (InSequenceBits << shift) | (1u << (shift - 1));
+		else if (shift == 32)
+			InSequenceBits = 1u << 31;
+		else
+			InSequenceBits = 0;
+	}
+	else
+	{
+		InSequenceBits = 0;
+	}
+	InSequence = sequence;
+	HasInSequence = true;
+	LastReceiveTime = time;
+
+	if (hasAck)
+	{
+		// Everything up to the ack that isn't in the bitfield was lost or arrived out of order
+		while (!SentPackets.empty() && !IsSequenceNewer(SentPackets.front().Sequence, ack))
+		{
+			NetSentPacket& record = SentPackets.front();
+			int distance = (uint16_t)(ack - record.Sequence);
+			if (distance == 0 || (distance <= 32 && (ackBits & (1u << (distance - 1))) != 0))
+				PacketAcked(record, time);
+			else
+				PacketLost(record);
+			SentPackets.pop_front();
+		}
+	}
+
+	return true;
+}
+
+void NetConnection::ExpirePackets(float time)
+{
+	while (!SentPackets.empty() && time - SentPackets.front().Time > 2.0f)
+	{
+		PacketLost(SentPackets.front());
+		SentPackets.pop_front();
+	}
+}
+
+void NetConnection::PacketAcked(NetSentPacket& record, float time)
+{
+	float roundtrip = time - record.Time;
+	Ping = (Ping == 0.0f) ? roundtrip : Ping * 0.9f + roundtrip * 0.1f;
+
+	for (NetSentProperty& sent : record.Properties)
+	{
+		NetActorChannel* channel = FindChannel(sent.Channel);
+		if (!channel || sent.Index >= channel->Properties.size())
+			continue;
+
+		NetPropertyState& state = channel->Properties[sent.Index];
+		state.Acked = std::move(sent.Value);
+		state.HasAcked = true;
+		if (state.HasInFlight && state.InFlightSequence == record.Sequence)
+			state.HasInFlight = false;
+	}
+
+	for (uint32_t id : record.Opens)
+	{
+		NetActorChannel* channel = FindChannel(id);
+		if (channel)
+			channel->OpenAcked = true;
+	}
+
+	for (uint32_t sequence : record.Reliables)
+	{
+		for (NetReliableMessage& message : ReliableOut)
+		{
+			if (message.Sequence == sequence)
+				message.Acked = true;
+		}
+	}
+	while (!ReliableOut.empty() && ReliableOut.front().Acked)
+		ReliableOut.pop_front();
+}
+
+void NetConnection::PacketLost(NetSentPacket& record)
+{
+	// Property values that didn't arrive are sent again if they still differ from the acked value.
+	// Channel opens don't need anything since the open info is included until it is acked.
+	for (NetSentProperty& sent : record.Properties)
+	{
+		NetActorChannel* channel = FindChannel(sent.Channel);
+		if (!channel || sent.Index >= channel->Properties.size())
+			continue;
+
+		NetPropertyState& state = channel->Properties[sent.Index];
+		if (state.HasInFlight && state.InFlightSequence == record.Sequence)
+			state.HasInFlight = false;
+	}
+
+	for (uint32_t sequence : record.Reliables)
+	{
+		for (NetReliableMessage& message : ReliableOut)
+		{
+			if (message.Sequence == sequence && !message.Acked)
+				message.InFlight = false;
+		}
+	}
+}
+
+void NetConnection::SendReliable(NetMessage type, const NetWriter& body)
+{
+	NetReliableMessage message;
+	message.Sequence = NextReliableOut++;
+	message.Data.reserve(body.Size() + 1);
+	message.Data.push_back((uint8_t)type);
+	message.Data.insert(message.Data.end(), body.Data.begin(), body.Data.end());
+	ReliableOut.push_back(std::move(message));
+}
+
+void NetConnection::SendUnreliable(NetMessage type, const NetWriter& body)
+{
+	NetWriter message;
+	WriteMessage(message, type, body);
+	UnreliableOut.push_back(std::move(message.Data));
+}
+
+void NetConnection::WriteReliables(NetWriter& packet, NetSentPacket& record)
+{
+	for (NetReliableMessage& message : ReliableOut)
+	{
+		if (message.InFlight || message.Acked)
+			continue;
+
+		NetWriter body;
+		body.WriteVarUInt(message.Sequence);
+		body.WriteBytes(message.Data.data(), message.Data.size());
+		if (packet.Size() + body.Size() + 6 > NetMaxPacketSize)
+			break;
+
+		WriteMessage(packet, NetMessage::Reliable, body);
+		message.InFlight = true;
+		record.Reliables.push_back(message.Sequence);
+	}
+}
+
+void NetConnection::WriteUnreliables(NetWriter& packet)
+{
+	// Unreliable messages that don't fit into this packet are dropped
+	for (const std::vector<uint8_t>& message : UnreliableOut)
+	{
+		if (packet.Size() + message.size() <= NetMaxPacketSize)
+			packet.WriteBytes(message.data(), message.size());
+	}
+	UnreliableOut.clear();
+}
+
+bool NetConnection::ReadReliable(NetReader& body)
+{
+	uint32_t sequence = body.ReadVarUInt();
+	if (body.HasError() || body.IsEnd())
+		return false;
+
+	// Resent messages we already processed are only acked again
+	if ((int32_t)(sequence - NextReliableIn) < 0)
+		return true;
+
+	if (ReliableIn.size() >= 1024)
+		return false;
+
+	ReliableIn[sequence].assign(body.GetData() + body.GetPos(), body.GetData() + body.GetPos() + body.GetRemaining());
+	return true;
+}
+
+bool NetConnection::PopReliable(std::vector<uint8_t>& message)
+{
+	auto it = ReliableIn.find(NextReliableIn);
+	if (it == ReliableIn.end())
+		return false;
+
+	message = std::move(it->second);
+	ReliableIn.erase(it);
+	NextReliableIn++;
+	return true;
+}
+
+void NetConnection::WriteObject(NetWriter& writer, UObject* obj)
+{
+	// Actors spawned at runtime are referenced through their channel, once the other side has it
+	UActor* actor = UObject::TryCast<UActor>(obj);
+	if (actor && !actor->bStatic() && !actor->bNoDelete())
+	{
+		NetActorChannel* channel = FindChannel(actor);
+		if (channel && channel->OpenAcked)
+		{
+			writer.WriteUInt8(1);
+			writer.WriteVarUInt(channel->Id);
+		}
+		else
+		{
+			writer.WriteUInt8(0);
+		}
+		return;
+	}
+
+	// Everything loaded from a package exists on both sides with the same export index
+	if (obj && obj->package && obj->package->IsExportObject(obj))
+	{
+		writer.WriteUInt8(2);
+		writer.WriteString(obj->package->GetPackageName().ToString());
+		writer.WriteVarUInt(obj->exportIndex);
+		return;
+	}
+
+	writer.WriteUInt8(0);
+}
+
+UObject* NetConnection::ReadObject(NetReader& reader)
+{
+	uint8_t kind = reader.ReadUInt8();
+	if (kind == 1)
+	{
+		NetActorChannel* channel = FindChannel(reader.ReadVarUInt());
+		return channel ? channel->Actor : nullptr;
+	}
+	else if (kind == 2)
+	{
+		NameString packageName = reader.ReadString();
+		uint32_t index = reader.ReadVarUInt();
+		if (reader.HasError() || packageName.ToString().empty())
+			return nullptr;
+
+		try
+		{
+			// Package objects are never collected, so a client doesn't get to make the server load packages.
+			// The client does load them, as the server can refer to classes the map itself didn't need.
+			Package* package = nullptr;
+			if (Driver->IsServer())
+				package = engine->packages->FindLoadedPackage(packageName);
+			else if (engine->packages->PackageExists(packageName, 1000))
+				package = engine->packages->GetPackage(packageName, 1001);
+			if (!package || index >= package->GetExportCount())
+				return nullptr;
+			return package->GetUObject(index + 1);
+		}
+		catch (const std::exception&)
+		{
+			return nullptr;
+		}
+	}
+	return nullptr;
+}
+
+NetActorChannel* NetConnection::FindChannel(uint32_t id)
+{
+	auto it = Channels.find(id);
+	return it != Channels.end() ? it->second.get() : nullptr;
+}
+
+NetActorChannel* NetConnection::FindChannel(UActor* actor)
+{
+	auto it = ActorChannels.find(actor);
+	return it != ActorChannels.end() ? it->second : nullptr;
+}
+
+NetActorChannel* NetConnection::OpenChannel(UActor* actor, uint32_t id)
+{
+	auto channel = std::make_unique<NetActorChannel>();
+	channel->Id = id;
+	channel->Actor = actor;
+	channel->StaticActor = actor && (actor->bStatic() || actor->bNoDelete());
+	channel->LastRelevantTime = Driver->Time;
+
+	NetActorChannel* result = channel.get();
+	Channels[id] = std::move(channel);
+	if (actor)
+		ActorChannels[actor] = result;
+	return result;
+}
+
+void NetConnection::CloseChannel(NetActorChannel* channel)
+{
+	if (channel->Actor)
+	{
+		auto it = ActorChannels.find(channel->Actor);
+		if (it != ActorChannels.end() && it->second == channel)
+			ActorChannels.erase(it);
+	}
+	Channels.erase(channel->Id);
+}
+
+void NetConnection::CloseAllChannels()
+{
+	ActorChannels.clear();
+	Channels.clear();
+}
+
+void NetConnection::GetObjectRoots(std::vector<UObject*>& roots) const
+{
+	if (Player)
+		roots.push_back(Player);
+	for (const auto& it : ActorChannels)
+		roots.push_back(it.first);
+}
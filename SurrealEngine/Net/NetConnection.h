@@ -0,0 +1,143 @@
+#pragma once
+
+#include "NetSocket.h"
+#include "NetPacket.h"
+#include <unordered_map>
+#include <deque>
+#include <map>
+#include <memory>
+
+class UObject;
+class UActor;
+class UNetConnection;
+class NetDriver;
+
+enum class NetConnectionState
+{
+	Pending,	// Waiting for the client to load the map
+	Joined,		// Client has a player and receives actor updates
+	Closed
+};
+
+// What the remote side is known to have for one replicated property
+struct NetPropertyState
+{
+	std::vector<uint8_t> Acked;
+	std::vector<uint8_t> InFlight; // Newest value sent that hasn't been acked or lost yet
+	uint16_t InFlightSequence = 0;
+	bool HasAcked = false;
+	bool HasInFlight = false;
+};
+
+class NetActorChannel
+{
+public:
+	uint32_t Id = 0;
+	UActor* Actor = nullptr;
+	bool StaticActor = false;	// The actor is part of the map on both sides and is found by its export index
+	bool OpenAcked = false;		// The remote side has created or found the actor
+	bool TornOff = false;		// bNetTemporary actors stop updating once the remote side has them
+	float LastUpdateTime = -1.0f;
+	float LastRelevantTime = 0.0f;
+	std::vector<NetPropertyState> Properties;
+};
+
+struct NetSentProperty
+{
+	uint32_t Channel = 0;
+	uint32_t Index = 0;
+	std::vector<uint8_t> Value;
+};
+
+struct NetSentPacket
+{
+	uint16_t Sequence = 0;
+	float Time = 0.0f;
+	size_t HeaderSize = 0;
+	std::vector<NetSentProperty> Properties;
+	std::vector<uint32_t> Opens;
+	std::vector<uint32_t> Reliables;
+};
+
+struct NetReliableMessage
+{
+	uint32_t Sequence = 0;
+	std::vector<uint8_t> Data;
+	bool InFlight = false;
+	bool Acked = false;
+};
+
+// One end of a client/server connection.
+//
+// Every packet starts with its sequence number and acks for the newest packet received from the other side plus a bitfield
+// for the 32 packets before it. Packets arriving out of order are dropped without being acked, so loss and reordering look
+// the same to the sender. The sender keeps a record of what went into each packet: acked property values become the new
+// delta base for their channel, and reliable messages in lost packets are sent again.
+class NetConnection
+{
+public:
+	NetConnection(NetDriver* driver, const NetAddress& address);
+
+	// Writes the packet header followed by the queued reliable and unreliable messages that fit
+	void BeginPacket(NetWriter& packet, NetSentPacket& record, float time);
+	void SendPacket(const NetWriter& packet, NetSentPacket&& record);
+	bool HasPayload(const NetWriter& packet, const NetSentPacket& record) const { return packet.Size() > record.HeaderSize; }
+
+	// Reads the packet header and processes the acks. Returns false if the packet is stale and must be ignored.
+	bool ReceivePacket(NetReader& reader, float time);
+
+	void SendReliable(NetMessage type, const NetWriter& body);
+	void SendUnreliable(NetMessage type, const NetWriter& body);
+	bool ReadReliable(NetReader& body);
+	bool PopReliable(std::vector<uint8_t>& message);
+
+	void WriteObject(NetWriter& writer, UObject* obj);
+	UObject* ReadObject(NetReader& reader);
+
+	NetActorChannel* FindChannel(uint32_t id);
+	NetActorChannel* FindChannel(UActor* actor);
+	NetActorChannel* OpenChannel(UActor* actor, uint32_t id);
+	void CloseChannel(NetActorChannel* channel);
+	void CloseAllChannels();
+
+	void GetObjectRoots(std::vector<UObject*>& roots) const;
+
+	bool HasUnackedReliables() const { return !ReliableOut.empty(); }
+
+	// Client URL options sent in the hello message
+	std::vector<std::string> Options;
+
+	NetDriver* Driver = nullptr;
+	NetAddress Address;
+	NetConnectionState State = NetConnectionState::Pending;
+	bool HelloReceived = false; // Nothing is sent to the address before the client said hello
+	UNetConnection* Player = nullptr;
+
+	float LastReceiveTime = 0.0f;
+	float LastSendTime = 0.0f;
+	float Ping = 0.0f;
+	float Budget = 0.0f;
+
+	uint32_t NextChannelId = 1;
+	std::unordered_map<uint32_t, std::unique_ptr<NetActorChannel>> Channels;
+	std::unordered_map<UActor*, NetActorChannel*> ActorChannels;
+
+private:
+	void WriteReliables(NetWriter& packet, NetSentPacket& record);
+	void WriteUnreliables(NetWriter& packet);
+	void ExpirePackets(float time);
+	void PacketAcked(NetSentPacket& record, float time);
+	void PacketLost(NetSentPacket& record);
+
+	uint16_t OutSequence = 1;
+	uint16_t InSequence = 0;
+	uint32_t InSequenceBits = 0;
+	bool HasInSequence = false;
+	std::deque<NetSentPacket> SentPackets;
+
+	uint32_t NextReliableOut = 0;
+	uint32_t NextReliableIn = 0;
+	std::deque<NetReliableMessage> ReliableOut;
+	std::map<uint32_t, std::vector<uint8_t>> ReliableIn;
+	std::vector<std::vector<uint8_t>> UnreliableOut;
+};
@@ -0,0 +1,199 @@
+
+#include "Precomp.h"
+#include "NetDriver.h"
+#include "UObject/UActor.h"
+#include "UObject/UClass.h"
+#include "UObject/UClient.h"
+#include "UObject/UProperty.h"
+#include "VM/Frame.h"
+#include "VM/ScriptCall.h"
+#include "Engine.h"
+
+NetDriver::NetDriver(USurrealNetworkDevice* settings) : Settings(settings)
+{
+}
+
+void NetDriver::SendTo(const NetAddress& address, const NetWriter& packet)
+{
+	Socket.SendTo(address, packet.Data.data(), packet.Size());
+}
+
+void NetDriver::ProcessPacket(NetConnection* connection, NetReader& reader)
+{
+	while (!reader.IsEnd() && connection->State != NetConnectionState::Closed)
+	{
+		NetMessage type = (NetMessage)reader.ReadUInt8();
+		uint32_t size = reader.ReadVarUInt();
+		if (reader.HasError() || size > reader.GetRemaining())
+			break;
+
+		NetReader body(reader.GetData() + reader.GetPos(), size);
+		reader.Skip(size);
+
+		if (type == NetMessage::Reliable)
+		{
+			if (!connection->ReadReliable(body))
+				break;
+		}
+		else
+		{
+			ProcessMessage(connection, type, body);
+		}
+	}
+
+	std::vector<uint8_t> message;
+	while (connection->State != NetConnectionState::Closed && connection->PopReliable(message))
+	{
+		NetReader body(message.data(), message.size());
+		NetMessage type = (NetMessage)body.ReadUInt8();
+		ProcessMessage(connection, type, body);
+	}
+}
+
+bool NetDriver::ProcessRemoteFunction(UActor* actor, UFunction* func, const std::vector<ExpressionValue>& args)
+{
+	if (actor == ReceivedCallActor && func == ReceivedCallFunction)
+	{
+		ReceivedCallActor = nullptr;
+		ReceivedCallFunction = nullptr;
+		return false;
+	}
+
+	Expression* condition = Replication.GetFunctionCondition(func);
+	if (!condition)
+		return false;
+
+	bool owned = false;
+	NetConnection* connection = GetFunctionConnection(actor, owned);
+	if (!connection)
+		return false;
+
+	SetNetOwner(actor, owned);
+	if (!NetReplication::EvalCondition(condition, actor))
+		return false;
+
+	// The call belongs to the other side, but only the owner of an actor may send calls for it
+	if (!owned)
+		return true;
+
+	NetActorChannel* channel = connection->FindChannel(actor);
+	if (!channel)
+		channel = connection->OpenChannel(actor, connection->NextChannelId++);
+
+	std::unique_ptr<uint64_t[]> parms(new uint64_t[(func->StructSize + 7) / 8]);
+	std::vector<ExpressionValue> parmValues;
+	size_t argindex = 0;
+	for (UField* field = func->Children; field != nullptr; field = field->Next)
+	{
+		UProperty* prop = dynamic_cast<UProperty*>(field);
+		if (prop && AllFlags(prop->PropFlags, PropertyFlags::Parm))
+		{
+			ExpressionValue lvalue = ExpressionValue::Variable(parms.get(), prop);
+			lvalue.ConstructVariable();
+			if (argindex < args.size())
+				lvalue.Store(args[argindex]);
+			argindex++;
+			parmValues.push_back(std::move(lvalue));
+		}
+	}
+
+	NetWriter body;
+	body.WriteVarUInt(channel->Id);
+	body.WriteString(func->Name.ToString());
+	NetReplication::WriteParms(body, func, parms.get(), connection);
+
+	for (ExpressionValue& lvalue : parmValues)
+		lvalue.DestructVariable();
+
+	if (AllFlags(func->FuncFlags, FunctionFlags::NetReliable))
+		connection->SendReliable(NetMessage::FunctionCall, body);
+	else
+		connection->SendUnreliable(NetMessage::FunctionCall, body);
+	return true;
+}
+
+bool NetDriver::ReceiveFunctionCall(NetConnection* connection, NetReader& body)
+{
+	NetActorChannel* channel = connection->FindChannel(body.ReadVarUInt());
+	if (!channel)
+		return false;
+
+	NameString funcName = body.ReadString();
+	UActor* actor = channel->Actor;
+	if (body.HasError() || !actor || actor->bDeleteMe())
+		return true;
+
+	// Only accept calls the other side is allowed to make
+	UFunction* func = FindEventFunction(actor, funcName);
+	if (!func || !AllFlags(func->FuncFlags, FunctionFlags::Net))
+		return true;
+	if (IsServer() && !(connection->Player && IsOwnedBy(actor, connection->Player->Actor())))
+		return true;
+
+	// The replication condition is true on the side that sends the call. If it is true here, as for a client
+	// function arriving at the server, the other side is trying to make a call that only goes the other way.
+	Expression* condition = Replication.GetFunctionCondition(func);
+	if (!condition)
+		return true;
+
+	bool owned = false;
+	GetFunctionConnection(actor, owned);
+	SetNetOwner(actor, owned);
+	if (NetReplication::EvalCondition(condition, actor))
+		return true;
+
+	std::unique_ptr<uint64_t[]> parms(new uint64_t[(func->StructSize + 7) / 8]);
+	std::vector<ExpressionValue> args;
+	for (UField* field = func->Children; field != nullptr; field = field->Next)
+	{
+		UProperty* prop = dynamic_cast<UProperty*>(field);
+		if (prop && AllFlags(prop->PropFlags, PropertyFlags::Parm) && !AllFlags(prop->PropFlags, PropertyFlags::ReturnParm))
+		{
+			ExpressionValue lvalue = ExpressionValue::Variable(parms.get(), prop);
+			lvalue.ConstructVariable();
+			args.push_back(std::move(lvalue));
+		}
+	}
+
+	NetReplication::ReadParms(body, func, parms.get(), connection);
+
+	if (!body.HasError())
+	{
+		ReceivedCallActor = actor;
+		ReceivedCallFunction = func;
+		try
+		{
+			Frame::Call(func, actor, args);
+		}
+		catch (const std::exception& e)
+		{
+			engine->LogMessage("Replicated call to " + func->Name.ToString() + " failed: " + e.what());
+		}
+		ReceivedCallActor = nullptr;
+		ReceivedCallFunction = nullptr;
+	}
+
+	for (ExpressionValue& lvalue : args)
+		lvalue.DestructVariable();
+	return true;
+}
+
+bool NetDriver::IsOwnedBy(UActor* actor, UActor* owner)
+{
+	if (!owner)
+		return false;
+
+	// Limit the depth in case the scripts built an owner loop
+	for (int depth = 0; actor != nullptr && depth < 32; depth++, actor = actor->Owner())
+	{
+		if (actor == owner)
+			return true;
+	}
+	return false;
+}
+
+void NetDriver::SetNetOwner(UActor* actor, bool owned)
+{
+	if (PropOffsets_Actor.bNetOwner.DataOffset != ~(size_t)0)
+		actor->bNetOwner() = owned;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "NetSocket.h"
+#include "NetConnection.h"
+#include "NetReplication.h"
+
+class UObject;
+class UActor;
+class UPlayerPawn;
+class UFunction;
+class ExpressionValue;
+class USurrealNetworkDevice;
+
+// Base class for the server and client ends of a network game.
+//
+// Engine::Run creates a NetServer for --server and a NetClient for --connect. The engine calls TickDispatch before
+// the level tick and TickFlush after it, and Frame::Call hands every function with FunctionFlags::Net to
+// ProcessRemoteFunction so that it can be sent to the other side instead of running locally.
+class NetDriver
+{
+public:
+	NetDriver(USurrealNetworkDevice* settings);
+	virtual ~NetDriver() = default;
+
+	virtual bool IsServer() const = 0;
+	virtual uint8_t GetNetMode() const = 0;
+	virtual bool HasLocalPlayer() const = 0;
+
+	// Receives and processes everything that arrived since the last tick
+	virtual void TickDispatch(float elapsed) = 0;
+
+	// Sends actor updates, function calls and acks
+	virtual void TickFlush(float elapsed) = 0;
+
+	virtual void NotifyMapLoaded() { }
+	virtual void Shutdown() { }
+
+	// Adds the objects the connections refer to, so that the garbage collector keeps them
+	virtual void GetObjectRoots(std::vector<UObject*>& roots) = 0;
+
+	// Returns true if the call was sent to (or is meant for) the other side and must not run locally
+	bool ProcessRemoteFunction(UActor* actor, UFunction* func, const std::vector<ExpressionValue>& args);
+
+	void SendTo(const NetAddress& address, const NetWriter& packet);
+
+	NetReplication Replication;
+	float Time = 0.0f;
+
+protected:
+	// The connection a function call on the actor is sent to, or nullptr if the call runs locally
+	virtual NetConnection* GetFunctionConnection(UActor* actor, bool& owned) = 0;
+
+	virtual void ProcessMessage(NetConnection* connection, NetMessage type, NetReader& body) = 0;
+	void ProcessPacket(NetConnection* connection, NetReader& reader);
+
+	// Returns false if the channel isn't known yet
+	bool ReceiveFunctionCall(NetConnection* connection, NetReader& body);
+
+	static bool IsOwnedBy(UActor* actor, UActor* owner);
+	static void SetNetOwner(UActor* actor, bool owned);
+
+	NetSocket Socket;
+	USurrealNetworkDevice* Settings = nullptr;
+
+private:
+	// Set while a received function call runs so that it doesn't get sent back
+	UActor* ReceivedCallActor = nullptr;
+	UFunction* ReceivedCallFunction = nullptr;
+};
@@ -0,0 +1,161 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Bumped whenever the packet layout or a message changes
+static const uint32_t NetProtocolVersion = 1;
+
+// Stays below the usual path MTU so that packets are never fragmented
+static const size_t NetMaxPacketSize = 1200;
+
+enum class NetMessage : uint8_t
+{
+	Reliable,		// Wraps a message that is resent until acked and processed in order
+	Hello,			// Client asks to join the server
+	Welcome,		// Server tells the client which map to load
+	Join,			// Client finished loading the map and wants a player
+	ActorUpdate,	// Server sends changed properties for an actor channel
+	ActorClose,		// Server closes an actor channel
+	FunctionCall,	// Replicated function call in either direction
+	Disconnect		// Either side is leaving
+};
+
+class NetWriter
+{
+public:
+	void WriteUInt8(uint8_t value) { Data.push_back(value); }
+	void WriteUInt16(uint16_t value) { WriteBytes(&value, sizeof(uint16_t)); }
+	void WriteUInt32(uint32_t value) { WriteBytes(&value, sizeof(uint32_t)); }
+	void WriteInt32(int32_t value) { WriteBytes(&value, sizeof(int32_t)); }
+	void WriteFloat(float value) { WriteBytes(&value, sizeof(float)); }
+
+	void WriteVarUInt(uint32_t value)
+	{
+		while (value >= 0x80)
+		{
+			Data.push_back((uint8_t)(value | 0x80));
+			value >>= 7;
+		}
+		Data.push_back((uint8_t)value);
+	}
+
+	void WriteVarInt(int32_t value)
+	{
+		WriteVarUInt(((uint32_t)value << 1) ^ (uint32_t)(value >> 31));
+	}
+
+	void WriteString(const std::string& value)
+	{
+		WriteVarUInt((uint32_t)value.size());
+		WriteBytes(value.data(), value.size());
+	}
+
+	void WriteBytes(const void* data, size_t size)
+	{
+		const uint8_t* bytes = static_cast<const uint8_t*>(data);
+		Data.insert(Data.end(), bytes, bytes + size);
+	}
+
+	size_t Size() const { return Data.size(); }
+	void Clear() { Data.clear(); }
+
+	std::vector<uint8_t> Data;
+};
+
+class NetReader
+{
+public:
+	NetReader(const void* data, size_t size) : Data(static_cast<const uint8_t*>(data)), Size(size) { }
+
+	uint8_t ReadUInt8() { uint8_t v = 0; ReadBytes(&v, sizeof(uint8_t)); return v; }
+	uint16_t ReadUInt16() { uint16_t v = 0; ReadBytes(&v, sizeof(uint16_t)); return v; }
+	uint32_t ReadUInt32() { uint32_t v = 0; ReadBytes(&v, sizeof(uint32_t)); return v; }
+	int32_t ReadInt32() { int32_t v = 0; ReadBytes(&v, sizeof(int32_t)); return v; }
+	float ReadFloat() { float v = 0.0f; ReadBytes(&v, sizeof(float)); return v; }
+
+	uint32_t ReadVarUInt()
+	{
+		uint32_t value = 0;
+		for (int shift = 0; shift < 35; shift += 7)
+		{
+			uint8_t b = ReadUInt8();
+			value |= (uint32_t)(b & 0x7f) << shift;
+			if ((b & 0x80) == 0)
+				return value;
+		}
+		Error = true;
+		return 0;
+	}
+
+	int32_t ReadVarInt()
+	{
+		uint32_t v = ReadVarUInt();
+		return (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+	}
+
+	std::string ReadString()
+	{
+		uint32_t size = ReadVarUInt();
+		if (size > Size - Pos)
+		{
+			Error = true;
+			return {};
+		}
+		std::string value((const char*)Data + Pos, size);
+		Pos += size;
+		return value;
+	}
+
+	void ReadBytes(void* data, size_t size)
+	{
+		if (size > Size - Pos)
+		{
+			Error = true;
+			Pos = Size;
+			memset(data, 0, size);
+			return;
+		}
+		memcpy(data, Data + Pos, size);
+		Pos += size;
+	}
+
+	void Skip(size_t size)
+	{
+		if (size > Size - Pos)
+		{
+			Error = true;
+			Pos = Size;
+			return;
+		}
+		Pos += size;
+	}
+
+	bool IsEnd() const { return Pos >= Size || Error; }
+	bool HasError() const { return Error; }
+	size_t GetPos() const { return Pos; }
+	size_t GetRemaining() const { return Size - Pos; }
+	const uint8_t* GetData() const { return Data; }
+
+private:
+	const uint8_t* Data = nullptr;
+	size_t Size = 0;
+	size_t Pos = 0;
+	bool Error = false;
+};
+
+// Sequence numbers wrap around, so compare them through the signed distance
+inline bool IsSequenceNewer(uint16_t a, uint16_t b)
+{
+	return (int16_t)(a - b) > 0;
+}
+
+// Every message in a packet is its type followed by the size of its body, which lets the receiver skip messages it can't use
+inline void WriteMessage(NetWriter& packet, NetMessage type, const NetWriter& body)
+{
+	packet.WriteUInt8((uint8_t)type);
+	packet.WriteVarUInt((uint32_t)body.Size());
+	packet.WriteBytes(body.Data.data(), body.Size());
+}
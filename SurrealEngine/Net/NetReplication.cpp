@@ -0,0 +1,247 @@
+
+#include "Precomp.h"
+#include "NetReplication.h"
+#include "NetConnection.h"
+#include "UObject/UActor.h"
+#include "UObject/UClass.h"
+#include "UObject/UProperty.h"
+#include "VM/Bytecode.h"
+#include "VM/ExpressionEvaluator.h"
+
+const NetClassLayout& NetReplication::GetClassLayout(UClass* cls)
+{
+	auto it = Layouts.find(cls);
+	if (it != Layouts.end())
+		return it->second;
+
+	// Walk from the root class so that the base class properties keep the same indices in all subclasses
+	std::vector<UStruct*> chain;
+	for (UStruct* s = cls; s != nullptr; s = s->BaseStruct)
+		chain.push_back(s);
+
+	NetClassLayout layout;
+	for (auto s = chain.rbegin(); s != chain.rend(); ++s)
+	{
+		UStruct* owner = *s;
+		for (UField* child = owner->Children; child != nullptr; child = child->Next)
+		{
+			UProperty* prop = dynamic_cast<UProperty*>(child);
+			if (!prop || !AllFlags(prop->PropFlags, PropertyFlags::Net) || !IsReplicatedType(prop) || !owner->Code)
+				continue;
+
+			Expression* condition = owner->Code->FindExpression(prop->ReplicationOffset);
+			if (condition)
+				layout.Properties.push_back({ prop, condition });
+		}
+	}
+
+	return Layouts.emplace(cls, std::move(layout)).first->second;
+}
+
+Expression* NetReplication::GetFunctionCondition(UFunction* func)
+{
+	auto it = FunctionConditions.find(func);
+	if (it != FunctionConditions.end())
+		return it->second;
+
+	// The replication statement belongs to the class that first declared the function
+	UFunction* declared = nullptr;
+	for (UFunction* f = func; f != nullptr; f = dynamic_cast<UFunction*>(f->BaseField))
+	{
+		if (AllFlags(f->FuncFlags, FunctionFlags::Net))
+			declared = f;
+	}
+
+	Expression* condition = nullptr;
+	if (declared)
+	{
+		UStruct* owner = declared->StructParent;
+		while (owner && !dynamic_cast<UClass*>(owner))
+			owner = owner->StructParent;
+		if (owner && owner->Code)
+			condition = owner->Code->FindExpression(declared->ReplicationOffset);
+	}
+
+	FunctionConditions[func] = condition;
+	return condition;
+}
+
+bool NetReplication::EvalCondition(Expression* condition, UActor* actor)
+{
+	try
+	{
+		return ExpressionEvaluator::Eval(condition, actor, actor, nullptr).Value.ToBool();
+	}
+	catch (const std::exception&)
+	{
+		return false;
+	}
+}
+
+bool NetReplication::IsReplicatedType(UProperty* prop)
+{
+	if (dynamic_cast<UArrayProperty*>(prop) || dynamic_cast<UMapProperty*>(prop) || dynamic_cast<UPointerProperty*>(prop))
+		return false;
+	if (UFixedArrayProperty* fixedArray = dynamic_cast<UFixedArrayProperty*>(prop))
+		return IsReplicatedType(fixedArray->Inner);
+	if (UStructProperty* structProp = dynamic_cast<UStructProperty*>(prop))
+	{
+		if (!structProp->Struct)
+			return false;
+		for (UProperty* member : structProp->Struct->Properties)
+		{
+			if (!IsReplicatedType(member))
+				return false;
+		}
+	}
+	return true;
+}
+
+void NetReplication::WriteValue(NetWriter& writer, UProperty* prop, void* data, NetConnection* connection)
+{
+	if (dynamic_cast<UBoolProperty*>(prop))
+	{
+		WriteElement(writer, prop, data, connection);
+		return;
+	}
+
+	size_t elementSize = prop->ElementSize();
+	for (int i = 0; i < prop->ArrayDimension; i++)
+		WriteElement(writer, prop, static_cast<uint8_t*>(data) + i * elementSize, connection);
+}
+
+void NetReplication::ReadValue(NetReader& reader, UProperty* prop, void* data, NetConnection* connection)
+{
+	if (dynamic_cast<UBoolProperty*>(prop))
+	{
+		ReadElement(reader, prop, data, connection);
+		return;
+	}
+
+	size_t elementSize = prop->ElementSize();
+	for (int i = 0; i < prop->ArrayDimension; i++)
+		ReadElement(reader, prop, static_cast<uint8_t*>(data) + i * elementSize, connection);
+}
+
+void NetReplication::WriteElement(NetWriter& writer, UProperty* prop, void* data, NetConnection* connection)
+{
+	if (UBoolProperty* boolProp = dynamic_cast<UBoolProperty*>(prop))
+	{
+		writer.WriteUInt8(boolProp->GetBool(data) ? 1 : 0);
+	}
+	else if (dynamic_cast<UByteProperty*>(prop))
+	{
+		writer.WriteUInt8(*static_cast<uint8_t*>(data));
+	}
+	else if (dynamic_cast<UIntProperty*>(prop))
+	{
+		writer.WriteVarInt(*static_cast<int32_t*>(data));
+	}
+	else if (dynamic_cast<UFloatProperty*>(prop))
+	{
+		writer.WriteFloat(*static_cast<float*>(data));
+	}
+	else if (dynamic_cast<UNameProperty*>(prop))
+	{
+		writer.WriteString(static_cast<NameString*>(data)->ToString());
+	}
+	else if (dynamic_cast<UStrProperty*>(prop) || dynamic_cast<UStringProperty*>(prop))
+	{
+		writer.WriteString(*static_cast<std::string*>(data));
+	}
+	else if (dynamic_cast<UObjectProperty*>(prop))
+	{
+		connection->WriteObject(writer, *static_cast<UObject**>(data));
+	}
+	else if (UStructProperty* structProp = dynamic_cast<UStructProperty*>(prop))
+	{
+		for (UProperty* member : structProp->Struct->Properties)
+			WriteValue(writer, member, static_cast<uint8_t*>(data) + member->DataOffset.DataOffset, connection);
+	}
+	else if (UFixedArrayProperty* fixedArray = dynamic_cast<UFixedArrayProperty*>(prop))
+	{
+		size_t innerSize = fixedArray->Inner->Size();
+		for (int i = 0; i < fixedArray->Count; i++)
+			WriteValue(writer, fixedArray->Inner, static_cast<uint8_t*>(data) + i * innerSize, connection);
+	}
+}
+
+void NetReplication::ReadElement(NetReader& reader, UProperty* prop, void* data, NetConnection* connection)
+{
+	if (UBoolProperty* boolProp = dynamic_cast<UBoolProperty*>(prop))
+	{
+		boolProp->SetBool(data, reader.ReadUInt8() != 0);
+	}
+	else if (dynamic_cast<UByteProperty*>(prop))
+	{
+		*static_cast<uint8_t*>(data) = reader.ReadUInt8();
+	}
+	else if (dynamic_cast<UIntProperty*>(prop))
+	{
+		*static_cast<int32_t*>(data) = reader.ReadVarInt();
+	}
+	else if (dynamic_cast<UFloatProperty*>(prop))
+	{
+		*static_cast<float*>(data) = reader.ReadFloat();
+	}
+	else if (dynamic_cast<UNameProperty*>(prop))
+	{
+		*static_cast<NameString*>(data) = NameString(reader.ReadString());
+	}
+	else if (dynamic_cast<UStrProperty*>(prop) || dynamic_cast<UStringProperty*>(prop))
+	{
+		*static_cast<std::string*>(data) = reader.ReadString();
+	}
+	else if (UObjectProperty* objProp = dynamic_cast<UObjectProperty*>(prop))
+	{
+		UObject* obj = connection->ReadObject(reader);
+
+		// Never store an object the property can't hold, even if the remote side sent one
+		if (obj && dynamic_cast<UClassProperty*>(prop))
+		{
+			if (!dynamic_cast<UClass*>(obj))
+				obj = nullptr;
+		}
+		else if (obj && objProp->ObjectClass)
+		{
+			bool isA = false;
+			for (UStruct* cls = obj->Class; cls != nullptr && !isA; cls = cls->BaseStruct)
+				isA = cls == objProp->ObjectClass;
+			if (!isA)
+				obj = nullptr;
+		}
+
+		*static_cast<UObject**>(data) = obj;
+	}
+	else if (UStructProperty* structProp = dynamic_cast<UStructProperty*>(prop))
+	{
+		for (UProperty* member : structProp->Struct->Properties)
+			ReadValue(reader, member, static_cast<uint8_t*>(data) + member->DataOffset.DataOffset, connection);
+	}
+	else if (UFixedArrayProperty* fixedArray = dynamic_cast<UFixedArrayProperty*>(prop))
+	{
+		size_t innerSize = fixedArray->Inner->Size();
+		for (int i = 0; i < fixedArray->Count; i++)
+			ReadValue(reader, fixedArray->Inner, static_cast<uint8_t*>(data) + i * innerSize, connection);
+	}
+}
+
+void NetReplication::WriteParms(NetWriter& writer, UFunction* func, void* parms, NetConnection* connection)
+{
+	for (UField* field = func->Children; field != nullptr; field = field->Next)
+	{
+		UProperty* prop = dynamic_cast<UProperty*>(field);
+		if (prop && AllFlags(prop->PropFlags, PropertyFlags::Parm) && !AllFlags(prop->PropFlags, PropertyFlags::ReturnParm) && IsReplicatedType(prop))
+			WriteValue(writer, prop, static_cast<uint8_t*>(parms) + prop->DataOffset.DataOffset, connection);
+	}
+}
+
+void NetReplication::ReadParms(NetReader& reader, UFunction* func, void* parms, NetConnection* connection)
+{
+	for (UField* field = func->Children; field != nullptr; field = field->Next)
+	{
+		UProperty* prop = dynamic_cast<UProperty*>(field);
+		if (prop && AllFlags(prop->PropFlags, PropertyFlags::Parm) && !AllFlags(prop->PropFlags, PropertyFlags::ReturnParm) && IsReplicatedType(prop))
+			ReadValue(reader, prop, static_cast<uint8_t*>(parms) + prop->DataOffset.DataOffset, connection);
+	}
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "NetPacket.h"
+#include <unordered_map>
+
+class UObject;
+class UActor;
+class UClass;
+class UFunction;
+class UProperty;
+class Expression;
+class NetConnection;
+
+struct NetRepProperty
+{
+	UProperty* Property = nullptr;
+	Expression* Condition = nullptr;
+};
+
+// The replicated properties of a class in a fixed order that both sides agree on
+struct NetClassLayout
+{
+	std::vector<NetRepProperty> Properties;
+};
+
+// Finds the replication conditions in the class bytecode and converts property values to and from the wire format
+class NetReplication
+{
+public:
+	const NetClassLayout& GetClassLayout(UClass* cls);
+	Expression* GetFunctionCondition(UFunction* func);
+
+	static bool EvalCondition(Expression* condition, UActor* actor);
+
+	static bool IsReplicatedType(UProperty* prop);
+	static void WriteValue(NetWriter& writer, UProperty* prop, void* data, NetConnection* connection);
+	static void ReadValue(NetReader& reader, UProperty* prop, void* data, NetConnection* connection);
+
+	static void WriteParms(NetWriter& writer, UFunction* func, void* parms, NetConnection* connection);
+	static void ReadParms(NetReader& reader, UFunction* func, void* parms, NetConnection* connection);
+
+private:
+	static void WriteElement(NetWriter& writer, UProperty* prop, void* data, NetConnection* connection);
+	static void ReadElement(NetReader& reader, UProperty* prop, void* data, NetConnection* connection);
+
+	std::unordered_map<UClass*, NetClassLayout> Layouts;
+	std::unordered_map<UFunction*, Expression*> FunctionConditions;
+};
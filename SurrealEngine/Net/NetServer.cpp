@@ -0,0 +1,556 @@
+
+#include "Precomp.h"
+#include "NetServer.h"
+#include "Package/PackageManager.h"
+#include "UObject/UActor.h"
+#include "UObject/ULevel.h"
+#include "UObject/UClass.h"
+#include "UObject/UClient.h"
+#include "UObject/USubsystem.h"
+#include "Engine.h"
+#include <algorithm>
+
+static void SetNetFlag(UActor* actor, const PropertyDataOffset& offset, bool value)
+{
+	// Older games don't have all the flags
+	if (offset.DataOffset != ~(size_t)0)
+		actor->BoolValue(offset) = value;
+}
+
+static bool ReadHello(NetReader& body, uint32_t& version, std::vector<std::string>& options)
+{
+	version = body.ReadVarUInt();
+	uint32_t count = body.ReadVarUInt();
+	if (body.HasError() || count > 64)
+		return false;
+
+	options.clear();
+	for (uint32_t i = 0; i < count && !body.HasError(); i++)
+		options.push_back(body.ReadString());
+	return !body.HasError();
+}
+
+// The hello is the first reliable message a client sends, so it is always the first message of its packets until acked
+static bool IsHelloPacket(const uint8_t* data, size_t size)
+{
+	NetReader reader(data, size);
+	reader.ReadUInt16();
+	if (reader.ReadUInt8() & 1)
+	{
+		reader.ReadUInt16();
+		reader.ReadUInt32();
+	}
+
+	NetMessage type = (NetMessage)reader.ReadUInt8();
+	uint32_t messageSize = reader.ReadVarUInt();
+	if (reader.HasError() || type != NetMessage::Reliable || messageSize > reader.GetRemaining())
+		return false;
+
+	NetReader message(reader.GetData() + reader.GetPos(), messageSize);
+	uint32_t sequence = message.ReadVarUInt();
+	NetMessage messageType = (NetMessage)message.ReadUInt8();
+	if (message.HasError() || sequence != 0 || messageType != NetMessage::Hello)
+		return false;
+
+	uint32_t version;
+	std::vector<std::string> options;
+	return ReadHello(message, version, options);
+}
+
+NetServer::NetServer(USurrealNetworkDevice* settings) : NetDriver(settings)
+{
+}
+
+bool NetServer::Listen(int port)
+{
+	return Socket.IsValid() && Socket.Bind(port);
+}
+
+uint8_t NetServer::GetNetMode() const
+{
+	return NM_DedicatedServer;
+}
+
+NetConnection* NetServer::FindConnection(const NetAddress& address)
+{
+	for (auto& connection : Connections)
+	{
+		if (connection->Address == address && connection->State != NetConnectionState::Closed)
+			return connection.get();
+	}
+	return nullptr;
+}
+
+void NetServer::TickDispatch(float elapsed)
+{
+	Time += elapsed;
+
+	uint8_t buffer[2048];
+	NetAddress from;
+	int size;
+	while ((size = Socket.ReceiveFrom(from, buffer, sizeof(buffer))) > 0)
+	{
+		NetConnection* connection = FindConnection(from);
+		if (!connection)
+		{
+			// Anyone can send a datagram with a spoofed address. Unknown addresses get no reply and no
+			// connection until they sent a valid hello, and only while there is room for another client.
+			if (!IsHelloPacket(buffer, size) || !CanAcceptConnection())
+				continue;
+
+			Connections.push_back(std::make_unique<NetConnection>(this, from));
+			connection = Connections.back().get();
+		}
+
+		NetReader reader(buffer, size);
+		if (connection->ReceivePacket(reader, Time))
+			ProcessPacket(connection, reader);
+	}
+
+	for (auto& connection : Connections)
+	{
+		float timeout = connection->Player ? Settings->ConnectionTimeout : Settings->InitialConnectTimeout;
+		if (connection->State != NetConnectionState::Closed && Time - connection->LastReceiveTime > timeout)
+			CloseConnection(connection.get(), "Connection timed out");
+	}
+}
+
+void NetServer::TickFlush(float elapsed)
+{
+	for (auto& connection : Connections)
+	{
+		if (connection->State == NetConnectionState::Joined)
+		{
+			ReplicateActors(connection.get(), elapsed);
+		}
+		else if (connection->State == NetConnectionState::Pending && connection->HelloReceived)
+		{
+			NetWriter packet;
+			NetSentPacket record;
+			connection->BeginPacket(packet, record, Time);
+			connection->SendPacket(packet, std::move(record));
+		}
+	}
+
+	Connections.erase(std::remove_if(Connections.begin(), Connections.end(), [](const auto& connection) { return connection->State == NetConnectionState::Closed; }), Connections.end());
+}
+
+bool NetServer::CanAcceptConnection() const
+{
+	int total = 0;
+	int pending = 0;
+	for (auto& connection : Connections)
+	{
+		if (connection->State == NetConnectionState::Closed)
+			continue;
+		total++;
+		if (!connection->Player)
+			pending++;
+	}
+	return total < Settings->MaxConnections && pending < Settings->MaxPendingConnections;
+}
+
+void NetServer::GetObjectRoots(std::vector<UObject*>& roots)
+{
+	for (auto& connection : Connections)
+		connection->GetObjectRoots(roots);
+}
+
+void NetServer::NotifyMapLoaded()
+{
+	// The old level is gone, including the player pawns. Clients join again once they loaded the new map.
+	for (auto& connection : Connections)
+	{
+		if (connection->State == NetConnectionState::Closed)
+			continue;
+
+		connection->CloseAllChannels();
+		if (connection->Player)
+			connection->Player->Actor() = nullptr;
+		connection->State = NetConnectionState::Pending;
+		SendWelcome(connection.get());
+	}
+}
+
+void NetServer::Shutdown()
+{
+	for (auto& connection : Connections)
+	{
+		if (connection->State == NetConnectionState::Closed)
+			continue;
+
+		NetWriter body;
+		body.WriteString("Server is shutting down");
+		connection->SendUnreliable(NetMessage::Disconnect, body);
+
+		NetWriter packet;
+		NetSentPacket record;
+		connection->BeginPacket(packet, record, Time);
+		connection->SendPacket(packet, std::move(record));
+	}
+	Connections.clear();
+}
+
+void NetServer::ProcessMessage(NetConnection* connection, NetMessage type, NetReader& body)
+{
+	if (type == NetMessage::Hello)
+	{
+		uint32_t version;
+		std::vector<std::string> options;
+		if (connection->HelloReceived || !ReadHello(body, version, options))
+			return;
+
+		if (version != NetProtocolVersion)
+		{
+			CloseConnection(connection, "Client uses protocol version " + std::to_string(version) + ", server uses " + std::to_string(NetProtocolVersion));
+			return;
+		}
+
+		engine->LogMessage("Client connected from " + connection->Address.ToString());
+		connection->HelloReceived = true;
+		connection->Options = std::move(options);
+		SendWelcome(connection);
+	}
+	else if (type == NetMessage::Join)
+	{
+		// Ignore joins for a map that has been replaced since the client started loading it
+		std::string map = body.ReadString();
+		if (!body.HasError() && connection->State == NetConnectionState::Pending && map == engine->LevelInfo->URL.Map)
+			LoginConnection(connection);
+	}
+	else if (type == NetMessage::FunctionCall)
+	{
+		if (connection->State == NetConnectionState::Joined)
+			ReceiveFunctionCall(connection, body);
+	}
+	else if (type == NetMessage::Disconnect)
+	{
+		CloseConnection(connection, "Client disconnected");
+	}
+}
+
+void NetServer::SendWelcome(NetConnection* connection)
+{
+	NetWriter body;
+	body.WriteString(engine->LevelInfo->URL.Map);
+	connection->SendReliable(NetMessage::Welcome, body);
+}
+
+void NetServer::LoginConnection(NetConnection* connection)
+{
+	UnrealURL url = engine->LevelInfo->URL;
+	for (const std::string& option : connection->Options)
+		url.AddOrReplaceOption(option);
+
+	if (!connection->Player)
+		connection->Player = UObject::Cast<UNetConnection>(engine->packages->NewObject("netconnection", "Engine", "NetConnection"));
+
+	try
+	{
+		engine->SpawnPlayActor(url, connection->Player);
+	}
+	catch (const std::exception& e)
+	{
+		CloseConnection(connection, e.what());
+		return;
+	}
+
+	connection->State = NetConnectionState::Joined;
+	connection->Budget = 0.0f;
+	engine->LogMessage(connection->Address.ToString() + " joined the game");
+}
+
+void NetServer::CloseConnection(NetConnection* connection, const std::string& reason)
+{
+	if (connection->State == NetConnectionState::Closed)
+		return;
+
+	NetWriter body;
+	body.WriteString(reason);
+	connection->SendUnreliable(NetMessage::Disconnect, body);
+
+	NetWriter packet;
+	NetSentPacket record;
+	connection->BeginPacket(packet, record, Time);
+	connection->SendPacket(packet, std::move(record));
+
+	connection->State = NetConnectionState::Closed;
+	connection->CloseAllChannels();
+
+	if (connection->Player)
+	{
+		UPlayerPawn* pawn = connection->Player->Actor();
+		connection->Player->Actor() = nullptr;
+		if (pawn && !pawn->bDeleteMe())
+		{
+			pawn->Destroy();
+			pawn->Player() = nullptr;
+		}
+	}
+
+	engine->LogMessage("Closed connection to " + connection->Address.ToString() + ": " + reason);
+}
+
+NetConnection* NetServer::GetFunctionConnection(UActor* actor, bool& owned)
+{
+	// Calls go to the client whose player pawn is at the top of the owner chain
+	UActor* top = actor;
+	for (int depth = 0; top->Owner() && depth < 32; depth++)
+		top = top->Owner();
+
+	UPlayerPawn* pawn = UObject::TryCast<UPlayerPawn>(top);
+	UNetConnection* player = pawn ? UObject::TryCast<UNetConnection>(pawn->Player()) : nullptr;
+	if (!player)
+		return nullptr;
+
+	for (auto& connection : Connections)
+	{
+		if (connection->Player == player && connection->State == NetConnectionState::Joined)
+		{
+			owned = true;
+			return connection.get();
+		}
+	}
+	return nullptr;
+}
+
+void NetServer::ReplicateActors(NetConnection* connection, float elapsed)
+{
+	float maxClientRate = (float)Settings->MaxClientRate;
+	connection->Budget = std::min(connection->Budget + maxClientRate * elapsed, maxClientRate * 0.25f);
+
+	UPlayerPawn* viewer = connection->Player->Actor();
+
+	// Close the channels of actors that were destroyed
+	std::vector<NetActorChannel*> closed;
+	for (auto& it : connection->Channels)
+	{
+		NetActorChannel* channel = it.second.get();
+		if (channel->Actor && channel->Actor->bDeleteMe())
+			closed.push_back(channel);
+	}
+	for (NetActorChannel* channel : closed)
+	{
+		if (!channel->TornOff)
+			SendActorClose(connection, channel);
+		connection->CloseChannel(channel);
+	}
+
+	struct Candidate
+	{
+		UActor* Actor;
+		NetActorChannel* Channel;
+		float Priority;
+	};
+	std::vector<Candidate> candidates;
+
+	if (viewer && !viewer->bDeleteMe())
+	{
+		for (UActor* actor : engine->Level->Actors)
+		{
+			if (!actor || actor->bDeleteMe() || actor->RemoteRole() == ROLE_None)
+				continue;
+
+			NetActorChannel* channel = connection->FindChannel(actor);
+			if (channel && channel->TornOff)
+				continue;
+
+			if (channel && channel->OpenAcked && actor->bNetTemporary())
+			{
+				channel->TornOff = true;
+				continue;
+			}
+
+			float sinceUpdate = (channel && channel->LastUpdateTime >= 0.0f) ? Time - channel->LastUpdateTime : 1.0f;
+			if (channel && channel->OpenAcked && sinceUpdate * actor->NetUpdateFrequency() < 1.0f)
+				continue;
+
+			if (IsRelevant(actor, viewer))
+			{
+				if (channel)
+					channel->LastRelevantTime = Time;
+			}
+			else if (!channel)
+			{
+				continue;
+			}
+			else if (Time - channel->LastRelevantTime > Settings->RelevantTimeout)
+			{
+				SendActorClose(connection, channel);
+				connection->CloseChannel(channel);
+				continue;
+			}
+
+			float priority = actor->NetPriority() * std::max(sinceUpdate, 0.01f);
+			if (IsOwnedBy(actor, viewer))
+				priority *= 4.0f;
+			candidates.push_back({ actor, channel, priority });
+		}
+
+		std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) { return a.Priority > b.Priority; });
+	}
+
+	// Fill packets in priority order until the budget runs out. Whatever didn't fit gains priority for the next tick.
+	NetWriter packet;
+	NetSentPacket record;
+	connection->BeginPacket(packet, record, Time);
+	bool sent = false;
+	for (const Candidate& candidate : candidates)
+	{
+		if (connection->Budget <= 0.0f)
+			break;
+
+		NetActorChannel* channel = candidate.Channel;
+		if (!channel)
+			channel = connection->OpenChannel(candidate.Actor, connection->NextChannelId++);
+
+		if (!WriteActorUpdate(packet, record, connection, channel, viewer))
+		{
+			if (!connection->HasPayload(packet, record))
+				continue;
+
+			connection->SendPacket(packet, std::move(record));
+			sent = true;
+			connection->BeginPacket(packet, record, Time);
+			if (connection->Budget <= 0.0f || !WriteActorUpdate(packet, record, connection, channel, viewer))
+				continue;
+		}
+		channel->LastUpdateTime = Time;
+	}
+
+	if (!sent || connection->HasPayload(packet, record))
+		connection->SendPacket(packet, std::move(record));
+}
+
+bool NetServer::IsRelevant(UActor* actor, UPlayerPawn* viewer)
+{
+	if (actor == viewer || actor->bAlwaysRelevant() || IsOwnedBy(actor, viewer))
+		return true;
+
+	if (actor->bHidden() && !actor->bBlockPlayers() && !actor->AmbientSound())
+		return false;
+
+	vec3 eye = viewer->Location();
+	eye.z += viewer->EyeHeight();
+	return !engine->Level->TraceRayAnyHit(eye, actor->Location(), viewer, false, true, true);
+}
+
+bool NetServer::WriteActorUpdate(NetWriter& packet, NetSentPacket& record, NetConnection* connection, NetActorChannel* channel, UPlayerPawn* viewer)
+{
+	UActor* actor = channel->Actor;
+	const NetClassLayout& layout = Replication.GetClassLayout(actor->Class);
+
+	if (channel->Properties.size() != layout.Properties.size())
+	{
+		channel->Properties.resize(layout.Properties.size());
+
+		// A spawned actor starts out with the class defaults on the client, so only the differences have to be sent
+		if (!channel->StaticActor)
+		{
+			UObject* defaults = actor->Class->GetDefaultObject();
+			for (size_t i = 0; i < layout.Properties.size(); i++)
+			{
+				UProperty* prop = layout.Properties[i].Property;
+				NetWriter value;
+				NetReplication::WriteValue(value, prop, defaults->PropertyData.Ptr(prop), connection);
+				channel->Properties[i].Acked = std::move(value.Data);
+				channel->Properties[i].HasAcked = true;
+			}
+		}
+	}
+
+	// The conditions are evaluated as seen from this connection
+	bool owned = IsOwnedBy(actor, viewer);
+	uint8_t remoteRole = actor->RemoteRole();
+	if (!owned && remoteRole == ROLE_AutonomousProxy)
+		actor->RemoteRole() = ROLE_SimulatedProxy;
+	SetNetOwner(actor, owned);
+	SetNetFlag(actor, PropOffsets_Actor.bNetInitial, !channel->OpenAcked);
+	SetNetFlag(actor, PropOffsets_Actor.bSimulatedPawn, UObject::TryCast<UPawn>(actor) && actor->RemoteRole() == ROLE_SimulatedProxy);
+
+	bool open = !channel->OpenAcked;
+	NetWriter body;
+	body.WriteVarUInt(channel->Id);
+	body.WriteUInt8((open ? 1 : 0) | (actor == viewer ? 2 : 0) | (channel->StaticActor ? 4 : 0));
+	if (open)
+	{
+		if (channel->StaticActor)
+		{
+			connection->WriteObject(body, actor);
+		}
+		else
+		{
+			connection->WriteObject(body, actor->Class);
+			body.WriteFloat(actor->Location().x);
+			body.WriteFloat(actor->Location().y);
+			body.WriteFloat(actor->Location().z);
+			body.WriteVarInt(actor->Rotation().Pitch);
+			body.WriteVarInt(actor->Rotation().Yaw);
+			body.WriteVarInt(actor->Rotation().Roll);
+			body.WriteUInt8(actor->RemoteRole());
+		}
+	}
+
+	// Leave room for the message header and the property list terminator
+	size_t available = NetMaxPacketSize - std::min(packet.Size() + 8, NetMaxPacketSize);
+	if (body.Size() > available)
+	{
+		actor->RemoteRole() = remoteRole;
+		return false;
+	}
+
+	std::vector<std::pair<Expression*, bool>> conditions;
+	bool changed = false;
+	for (size_t i = 0; i < layout.Properties.size(); i++)
+	{
+		const NetRepProperty& rep = layout.Properties[i];
+
+		// Many properties share the same condition
+		auto it = std::find_if(conditions.begin(), conditions.end(), [&](const auto& c) { return c.first == rep.Condition; });
+		if (it == conditions.end())
+		{
+			conditions.push_back({ rep.Condition, NetReplication::EvalCondition(rep.Condition, actor) });
+			it = conditions.end() - 1;
+		}
+		if (!it->second)
+			continue;
+
+		NetWriter value;
+		NetReplication::WriteValue(value, rep.Property, actor->PropertyData.Ptr(rep.Property), connection);
+
+		NetPropertyState& state = channel->Properties[i];
+		if ((state.HasAcked && state.Acked == value.Data) || (state.HasInFlight && state.InFlight == value.Data))
+			continue;
+
+		// Properties that don't fit are sent with a later packet
+		if (body.Size() + value.Size() + 5 > available)
+			continue;
+
+		body.WriteVarUInt((uint32_t)i + 1);
+		body.WriteBytes(value.Data.data(), value.Size());
+
+		state.InFlight = value.Data;
+		state.InFlightSequence = record.Sequence;
+		state.HasInFlight = true;
+		record.Properties.push_back({ channel->Id, (uint32_t)i, std::move(value.Data) });
+		changed = true;
+	}
+	body.WriteVarUInt(0);
+
+	actor->RemoteRole() = remoteRole;
+
+	if (changed || open)
+	{
+		WriteMessage(packet, NetMessage::ActorUpdate, body);
+		if (open)
+			record.Opens.push_back(channel->Id);
+	}
+	return true;
+}
+
+void NetServer::SendActorClose(NetConnection* connection, NetActorChannel* channel)
+{
+	NetWriter body;
+	body.WriteVarUInt(channel->Id);
+	connection->SendReliable(NetMessage::ActorClose, body);
+}
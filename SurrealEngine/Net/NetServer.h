@@ -0,0 +1,43 @@
+#pragma once
+
+#include "NetDriver.h"
+
+// Accepts clients and replicates the level to them.
+//
+// Each tick every joined connection gets the actors relevant to its player sorted by priority. Updates are written
+// until the connection runs out of bandwidth budget, and actors that didn't fit gain priority until they are sent.
+class NetServer : public NetDriver
+{
+public:
+	NetServer(USurrealNetworkDevice* settings);
+
+	bool Listen(int port);
+
+	bool IsServer() const override { return true; }
+	uint8_t GetNetMode() const override;
+	bool HasLocalPlayer() const override { return false; }
+
+	void TickDispatch(float elapsed) override;
+	void TickFlush(float elapsed) override;
+	void NotifyMapLoaded() override;
+	void Shutdown() override;
+	void GetObjectRoots(std::vector<UObject*>& roots) override;
+
+protected:
+	NetConnection* GetFunctionConnection(UActor* actor, bool& owned) override;
+	void ProcessMessage(NetConnection* connection, NetMessage type, NetReader& body) override;
+
+private:
+	NetConnection* FindConnection(const NetAddress& address);
+	bool CanAcceptConnection() const;
+	void SendWelcome(NetConnection* connection);
+	void LoginConnection(NetConnection* connection);
+	void CloseConnection(NetConnection* connection, const std::string& reason);
+
+	void ReplicateActors(NetConnection* connection, float elapsed);
+	bool IsRelevant(UActor* actor, UPlayerPawn* viewer);
+	bool WriteActorUpdate(NetWriter& packet, NetSentPacket& record, NetConnection* connection, NetActorChannel* channel, UPlayerPawn* viewer);
+	void SendActorClose(NetConnection* connection, NetActorChannel* channel);
+
+	std::vector<std::unique_ptr<NetConnection>> Connections;
+};
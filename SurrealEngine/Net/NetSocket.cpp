@@ -0,0 +1,134 @@
+
+#include "Precomp.h"
+#include "NetSocket.h"
+
+#ifdef WIN32
+#include <WinSock2.h>
+typedef unsigned long in_addr_t;
+typedef int socklen_t;
+#else
+#include <sys/socket.h>
+#include <sys/ioctl.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <unistd.h>
+#include <cstring>
+static int closesocket(int fd) { return close(fd); }
+#endif
+
+static const uintptr_t InvalidHandle = ~(uintptr_t)0;
+
+bool NetAddress::Resolve(const std::string& host, int defaultPort, NetAddress& result)
+{
+	std::string hostname = host;
+	int port = defaultPort;
+	size_t portStart = host.find(':');
+	if (portStart != std::string::npos)
+	{
+		hostname = host.substr(0, portStart);
+		port = std::atoi(host.substr(portStart + 1).c_str());
+	}
+
+	if (port <= 0 || port > 0xffff)
+		return false;
+
+	in_addr_t ipv4_address = inet_addr(hostname.c_str());
+	if (ipv4_address == INADDR_NONE)
+	{
+		hostent* entry = gethostbyname(hostname.c_str());
+		if (!entry || entry->h_addrtype != AF_INET)
+			return false;
+		ipv4_address = *((in_addr_t*)entry->h_addr_list[0]);
+	}
+
+	result.Addr = ntohl(ipv4_address);
+	result.Port = (uint16_t)port;
+	return true;
+}
+
+std::string NetAddress::ToString() const
+{
+	return
+		std::to_string((Addr & 0xff000000) >> 24) + "." +
+		std::to_string((Addr & 0x00ff0000) >> 16) + "." +
+		std::to_string((Addr & 0x0000ff00) >> 8) + "." +
+		std::to_string(Addr & 0x000000ff) + ":" +
+		std::to_string(Port);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+NetSocket::NetSocket()
+{
+	Handle = (uintptr_t)socket(AF_INET, SOCK_DGRAM, 0);
+	if (Handle != InvalidHandle)
+	{
+#ifdef WIN32
+		u_long nonblocking = 1;
+		ioctlsocket((SOCKET)Handle, FIONBIO, &nonblocking);
+#else
+		int nonblocking = 1;
+		ioctl((int)Handle, FIONBIO, &nonblocking);
+#endif
+	}
+}
+
+NetSocket::~NetSocket()
+{
+	if (Handle != InvalidHandle)
+		closesocket(Handle);
+}
+
+bool NetSocket::IsValid() const
+{
+	return Handle != InvalidHandle;
+}
+
+bool NetSocket::Bind(int port)
+{
+	if (Handle == InvalidHandle)
+		return false;
+
+	sockaddr_in addr;
+	memset(&addr, 0, sizeof(sockaddr_in));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = INADDR_ANY;
+	addr.sin_port = htons(port);
+	return bind(Handle, (const sockaddr*)&addr, sizeof(sockaddr_in)) == 0;
+}
+
+int NetSocket::GetLocalPort() const
+{
+	sockaddr_in addr;
+	memset(&addr, 0, sizeof(sockaddr_in));
+	socklen_t size = sizeof(sockaddr_in);
+	if (getsockname(Handle, (sockaddr*)&addr, &size) != 0)
+		return 0;
+	return ntohs(addr.sin_port);
+}
+
+bool NetSocket::SendTo(const NetAddress& address, const void* data, size_t size)
+{
+	sockaddr_in addr;
+	memset(&addr, 0, sizeof(sockaddr_in));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(address.Addr);
+	addr.sin_port = htons(address.Port);
+	int result = sendto(Handle, (const char*)data, (int)size, 0, (const sockaddr*)&addr, sizeof(sockaddr_in));
+	return result == (int)size;
+}
+
+int NetSocket::ReceiveFrom(NetAddress& address, void* data, size_t size)
+{
+	sockaddr_in addr;
+	memset(&addr, 0, sizeof(sockaddr_in));
+	socklen_t addrlen = sizeof(sockaddr_in);
+	int result = recvfrom(Handle, (char*)data, (int)size, 0, (sockaddr*)&addr, &addrlen);
+	if (result <= 0)
+		return 0;
+
+	address.Addr = ntohl(addr.sin_addr.s_addr);
+	address.Port = ntohs(addr.sin_port);
+	return result;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// IPv4 address with the address and port in host byte order
+struct NetAddress
+{
+	uint32_t Addr = 0;
+	uint16_t Port = 0;
+
+	static bool Resolve(const std::string& host, int defaultPort, NetAddress& result);
+	std::string ToString() const;
+
+	bool operator==(const NetAddress& other) const { return Addr == other.Addr && Port == other.Port; }
+	bool operator!=(const NetAddress& other) const { return Addr != other.Addr || Port != other.Port; }
+	bool operator<(const NetAddress& other) const { return Addr != other.Addr ? Addr < other.Addr : Port < other.Port; }
+};
+
+// Non-blocking UDP socket
+class NetSocket
+{
+public:
+	NetSocket();
+	~NetSocket();
+
+	bool IsValid() const;
+	bool Bind(int port);
+	int GetLocalPort() const;
+
+	bool SendTo(const NetAddress& address, const void* data, size_t size);
+
+	// Returns the size of the received datagram, or 0 when nothing is pending
+	int ReceiveFrom(NetAddress& address, void* data, size_t size);
+
+private:
+	uintptr_t Handle;
+
+	NetSocket(const NetSocket&) = delete;
+	NetSocket& operator=(const NetSocket&) = delete;
+};
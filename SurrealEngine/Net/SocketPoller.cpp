@@ -0,0 +1,126 @@
+
+#include "Precomp.h"
+#include "SocketPoller.h"
+#include "UObject/UInternetLink.h"
+#include <algorithm>
+
+#ifdef WIN32
+#include <WinSock2.h>
+static int PollSockets(pollfd* fds, size_t count) { return WSAPoll(fds, (ULONG)count, 0); }
+#else
+#include <poll.h>
+static int PollSockets(pollfd* fds, size_t count) { return poll(fds, (nfds_t)count, 0); }
+#endif
+
+void SocketPoller::AddLink(UInternetLink* link)
+{
+	Links.push_back(link);
+}
+
+void SocketPoller::RemoveLink(UInternetLink* link)
+{
+	Links.erase(std::remove(Links.begin(), Links.end(), link), Links.end());
+	for (PolledLink& polled : Polled)
+	{
+		if (polled.Link == link)
+			polled.Link = nullptr;
+	}
+	Resolver.Cancel(link);
+}
+
+void SocketPoller::CloseLinks(ULevel* level)
+{
+	for (UInternetLink* link : Links)
+	{
+		if (link->XLevel() == level)
+		{
+			link->CloseSocket();
+			Resolver.Cancel(link);
+		}
+	}
+}
+
+void SocketPoller::GetObjectRoots(std::vector<UObject*>& roots) const
+{
+	roots.insert(roots.end(), Links.begin(), Links.end());
+}
+
+void SocketPoller::Resolve(UInternetLink* link, const std::string& host)
+{
+	Resolver.Resolve(host, link);
+}
+
+void SocketPoller::Poll()
+{
+	DispatchResolved();
+
+	std::vector<pollfd> fds;
+	bool anyAlways = false;
+	Polled.clear();
+	for (size_t i = 0; i < Links.size();)
+	{
+		UInternetLink* link = Links[i];
+		if (link->bDeleteMe())
+		{
+			// Destroyed actors are never ticked again, so this is the last chance to release the socket
+			link->CloseSocket();
+			Resolver.Cancel(link);
+			Links.erase(Links.begin() + i);
+			continue;
+		}
+		i++;
+
+		int events = link->GetPollEvents();
+		if (events == 0 || link->handle == invalid_socket_value)
+			continue;
+
+		pollfd fd = {};
+		fd.fd = link->handle;
+		fd.events = ((events & LinkPoll_Read) ? POLLIN : 0) | ((events & LinkPoll_Write) ? POLLOUT : 0);
+		fds.push_back(fd);
+		Polled.push_back({ link, (uintptr_t)link->handle, events });
+		if (events & LinkPoll_Always)
+			anyAlways = true;
+	}
+
+	if (fds.empty())
+		return;
+
+	if (PollSockets(fds.data(), fds.size()) <= 0)
+	{
+		if (!anyAlways)
+			return;
+		for (pollfd& fd : fds)
+			fd.revents = 0;
+	}
+
+	// Events can destroy links, close their sockets or spawn new ones, so check each link is still the one polled
+	for (size_t i = 0; i < fds.size(); i++)
+	{
+		UInternetLink* link = Polled[i].Link;
+		if (!link || link->bDeleteMe() || (uintptr_t)link->handle != Polled[i].Handle)
+			continue;
+
+		int events = Polled[i].Events & LinkPoll_Always;
+		if (fds[i].revents & POLLIN)
+			events |= LinkPoll_Read;
+		if (fds[i].revents & POLLOUT)
+			events |= LinkPoll_Write;
+		if (fds[i].revents & (POLLERR | POLLHUP))
+			events |= LinkPoll_Error;
+
+		if (events != 0)
+			link->OnSocketEvents(events);
+	}
+	Polled.clear();
+}
+
+void SocketPoller::DispatchResolved()
+{
+	for (const HostResolver::Result& result : Resolver.FetchResults())
+	{
+		UInternetLink* link = (UInternetLink*)result.Requester;
+		if (std::find(Links.begin(), Links.end(), link) != Links.end() && !link->bDeleteMe())
+			link->OnResolved(result.Succeeded, result.Addr);
+	}
+}
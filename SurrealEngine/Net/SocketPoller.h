@@ -0,0 +1,42 @@
+#pragma once
+
+#include "HostResolver.h"
+
+class UObject;
+class UInternetLink;
+class ULevel;
+
+// Services the sockets of all InternetLink actors from the game thread.
+//
+// Once per tick a single poll call finds the links with socket activity, and only those links get to
+// read, write, accept or finish connecting. Host name lookups run on the resolver's threads, but their
+// results are delivered from here too, so scripts only ever see link events on the game thread.
+class SocketPoller
+{
+public:
+	void AddLink(UInternetLink* link);
+	void RemoveLink(UInternetLink* link);
+
+	// Closes the links of a level that is being unloaded
+	void CloseLinks(ULevel* level);
+
+	void Resolve(UInternetLink* link, const std::string& host);
+
+	void Poll();
+
+	void GetObjectRoots(std::vector<UObject*>& roots) const;
+
+private:
+	void DispatchResolved();
+
+	struct PolledLink
+	{
+		UInternetLink* Link;
+		uintptr_t Handle;
+		int Events;
+	};
+
+	std::vector<UInternetLink*> Links;
+	std::vector<PolledLink> Polled;
+	HostResolver Resolver;
+};
@@ -18,6 +18,8 @@
 #include "UObject/UInternetLink.h"
 #include "UObject/USubsystem.h"
 #include "File.h"
+#include "Trace.h"
+#include "GC/GC.h"
 
 Package::Package(PackageManager* packageManager, const NameString& name, const std::string& filename) : Packages(packageManager), Name(name), Filename(filename)
 {
@@ -198,6 +200,9 @@ UObject* Package::NewObject(const NameString& objname, UClass* objclass, ObjectF
 				obj->SetObject("Class", obj->Class);
 				obj->SetName("Name", obj->Name);
 				obj->SetInt("ObjectFlags", (int)obj->Flags);
+
+				// Objects created at runtime are owned by the garbage collector
+				GC::AddObject(obj);
 			}
 			return obj;
 		}
@@ -230,7 +235,6 @@ void Package::LoadExportObject(int index)
 	{
 		UClass* objbase = UObject::Cast<UClass>(GetUObject(entry->ObjBase));
 		if (!objbase && objname != "Object") {
-std::cout << "GP26" << std::endl;			
 			objbase = UObject::Cast<UClass>(Packages->GetPackage("Core", 993)->GetUObject("Class", "Object"));
 		}
 		auto obj = std::make_unique<UClass>(objname, objbase, ExportTable[index].ObjFlags);
@@ -296,6 +300,20 @@ UObject* Package::GetUObject(int objref)
 	}
 }
 
+bool Package::IsExportObject(const UObject* obj) const
+{
+	return obj->exportIndex < Objects.size() && Objects[obj->exportIndex].get() == obj;
+}
+
+void Package::GetLoadedObjects(std::vector<UObject*>& objects) const
+{
+	for (const auto& obj : Objects)
+	{
+		if (obj && !obj->DelayLoad)
+			objects.push_back(obj.get());
+	}
+}
+
 UObject* Package::GetUObject(const NameString& className, const NameString& objectName, const NameString& groupName)
 {
 	return GetUObject(FindObjectReference(className, objectName, groupName));
@@ -483,7 +501,7 @@ void Package::ReadTables()
 
 std::unique_ptr<ObjectStream> Package::OpenObjectStream(int index, const NameString& name, UClass* base)
 {
-	std::cout << "OpenObjectStream: " << name.ToString() << std::endl;
+	TRACE_EVENT_TEXT(TraceCategory::Package, "OpenObjectStream", name.ToString());
 	const auto& entry = ExportTable[index];
 	if (entry.ObjSize > 0)
 	{
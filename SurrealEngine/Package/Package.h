@@ -63,6 +63,11 @@ public:
 
 	std::string GetExportName(int objref);
 
+	// True for objects loaded from this package, as opposed to objects created at runtime
+	bool IsExportObject(const UObject* obj) const;
+	void GetLoadedObjects(std::vector<UObject*>& objects) const;
+	size_t GetExportCount() const { return ExportTable.size(); }
+
 	template<class T> std::vector<T*> GetAllObjects()
 	{
 		std::vector<T*> objects;
@@ -5,6 +5,8 @@
 #include "PackageStream.h"
 #include "IniFile.h"
 #include "File.h"
+#include "Trace.h"
+#include "GC/GC.h"
 #include "UObject/UObject.h"
 #include "UObject/UClass.h"
 #include "VM/NativeFunc.h"
@@ -36,7 +38,6 @@
 #include "Native/NParticleIterator.h"
 #include "Native/NScriptedPawn.h"
 #include "Native/NPlayerPawnExt.h"
-#include <iostream>
 
 PackageManager::PackageManager(const GameLaunchInfo& launchInfo) : launchInfo(launchInfo)
 {
@@ -55,9 +56,7 @@ PackageManager::PackageManager(const GameLaunchInfo& launchInfo) : launchInfo(la
 
 Package* PackageManager::GetPackage(const NameString& name, int debugIndex)
 {
-	#ifdef DEBUG_INDEXING_ENABLED
-	std::cout << "Debug Index: " << debugIndex << std::endl;
-	#endif
+	TRACE_EVENT_TEXT(TraceCategory::Package, "GetPackage", name.ToString() + " #" + std::to_string(debugIndex));
 
 	auto& package = packages[name];
 	if (package)
@@ -76,11 +75,15 @@ Package* PackageManager::GetPackage(const NameString& name, int debugIndex)
 	return package.get();
 }
 
+Package* PackageManager::FindLoadedPackage(const NameString& name) const
+{
+	auto it = packages.find(name);
+	return it != packages.end() ? it->second.get() : nullptr;
+}
+
 bool PackageManager::PackageExists(const NameString& name, int debugIndex)
 {
-	#ifdef DEBUG_INDEXING_ENABLED
-	std::cout << "Debug Index: " << debugIndex << std::endl;
-	#endif
+	TRACE_EVENT_TEXT(TraceCategory::Package, "PackageExists", name.ToString() + " #" + std::to_string(debugIndex));
 
 	auto& package = packages[name];
 	if (package)
@@ -99,7 +102,7 @@ bool PackageManager::PackageExists(const NameString& name, int debugIndex)
 
 Package* PackageManager::GetPackageFromPath(const std::string& path)
 {
-	std::cout << "GetPackageFromPath" << std::endl;
+	TRACE_EVENT_TEXT(TraceCategory::Package, "GetPackageFromPath", path);
 
 	auto absolute_path = FilePath::relative_to_absolute_from_system(FilePath::combine(launchInfo.gameRootFolder, "System"), path);
 
@@ -134,10 +137,17 @@ void PackageManager::UnloadPackage(const NameString& name)
 				break;
 			}
 		}
+		GC::RemoveReferencesToPackage(it->second.get());
 		packages.erase(it);
 	}
 }
 
+void PackageManager::GetLoadedObjects(std::vector<UObject*>& objects) const
+{
+	for (const auto& it : packages)
+		it.second->GetLoadedObjects(objects);
+}
+
 void PackageManager::ScanForMaps()
 {
 	for (auto& mapFolderPath : mapFolders)
@@ -240,7 +250,6 @@ void PackageManager::DelayLoadNow()
 
 UObject* PackageManager::NewObject(const NameString& name, const NameString& package, const NameString& className)
 {
-std::cout << "GP24" << std::endl;	
 	Package* pkg = GetPackage(package, 989);
 	UClass* cls = UObject::Cast<UClass>(pkg->GetUObject("Class", className));
 	if (!cls)
@@ -250,7 +259,6 @@ std::cout << "GP24" << std::endl;
 
 UObject* PackageManager::NewObject(const NameString& name, UClass* cls)
 {
-std::cout << "GP23" << std::endl;	
 	// To do: package needs to be grabbed from outer, or the "transient package" if it is None, a virtual package for runtime objects
 	return GetPackage("Engine", 988)->NewObject(name, cls, ObjectFlags::NoFlags, true);
 }
@@ -34,10 +34,12 @@ public:
 
 	bool PackageExists(const NameString& name, int debugIndex);
 	Package *GetPackage(const NameString& name, int debugIndex);
+	Package *FindLoadedPackage(const NameString& name) const; // Returns null rather than loading the package
 	Package *GetPackageFromPath(const std::string& path);
 	std::vector<NameString> GetPackageNames() const;
 
 	void UnloadPackage(const NameString& name);
+	void GetLoadedObjects(std::vector<UObject*>& objects) const;
 
 	std::shared_ptr<PackageStream> GetStream(Package* package);
 
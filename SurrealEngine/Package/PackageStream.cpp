@@ -130,7 +130,6 @@ std::string PackageStream::ReadString()
 
 Package* PackageStream::GetPackage() const
 {
-std::cout << "GP22" << std::endl;	
 	return package;
 }
 
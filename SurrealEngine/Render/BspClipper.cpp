@@ -9,7 +9,8 @@
 
 BspClipper::BspClipper()
 {
-	Viewport.resize(ViewportHeight);
+	TileCoverage.resize(TilesX * TilesY);
+	GroupFullTiles.resize(GroupsX * GroupsY);
 }
 
 BspClipper::~BspClipper()
@@ -21,14 +22,8 @@ void BspClipper::Setup(const mat4& world_to_projection)
 	WorldToProjection = world_to_projection;
 	FrustumClip = FrustumPlanes(world_to_projection);
 
-	ClipSpan left = { (int16_t)0x8000, 0 };
-	ClipSpan right = { (int16_t)ViewportWidth, (int16_t)0x7fff };
-	for (auto& line : Viewport)
-	{
-		line.clear();
-		line.push_back(left);
-		line.push_back(right);
-	}
+	std::fill(TileCoverage.begin(), TileCoverage.end(), 0);
+	std::fill(GroupFullTiles.begin(), GroupFullTiles.end(), 0);
 }
 
 bool BspClipper::CheckSurface(const vec3* vertices, uint32_t count, bool solid)
@@ -127,91 +122,60 @@ bool BspClipper::IsAABBVisible(const BBox& bbox)
 	int x1 = clamp((int)max2d.x, 0, ViewportWidth);
 	if (x0 >= x1)
 		return false;
-	for (int y = topY; y < bottomY; y++)
-	{
-		if (IsVisible(y, x0, x1))
-			return true;
-	}
-	return false;
-}
 
-bool BspClipper::IsVisible(int16_t y, int16_t x0, int16_t x1)
-{
-	auto& line = Viewport[y];
-	for (size_t pos = 0; pos < line.size(); pos++)
+	int tileY0 = topY / TileSize;
+	int tileY1 = (bottomY - 1) / TileSize;
+	int tileX0 = x0 / TileSize;
+	int tileX1 = (x1 - 1) / TileSize;
+	for (int tileY = tileY0; tileY <= tileY1; tileY++)
 	{
-		int16_t left = line[pos].x1;
-		if (left >= x1)
-			break;
-		int16_t right = line[pos + 1].x0;
-
-		left = std::max(left, x0);
-		right = std::min(right, x1);
-		if (left < right)
+		// Pixel rows of this tile row covered by the box
+		int row0 = std::max(topY - tileY * TileSize, 0);
+		int row1 = std::min(bottomY - tileY * TileSize, TileSize);
+		uint64_t rowsMask = (row1 - row0 == 8) ? ~0ULL : (((1ULL << ((row1 - row0) * 8)) - 1) << (row0 * 8));
+
+		const uint64_t* coverage = &TileCoverage[tileY * TilesX];
+		int tileX = tileX0;
+		while (tileX <= tileX1)
 		{
-			return true;
+			tileX = SkipFullTiles(tileY, tileX, tileX1);
+			if (tileX > tileX1)
+				break;
+
+			int col0 = std::max(x0 - tileX * TileSize, 0);
+			int col1 = std::min(x1 - tileX * TileSize, TileSize);
+			uint64_t colsMask = ((0xffULL >> (8 - (col1 - col0))) << col0) * 0x0101010101010101ULL;
+			if ((rowsMask & colsMask & ~coverage[tileX]) != 0)
+				return true;
+			tileX++;
 		}
 	}
 	return false;
 }
 
-bool BspClipper::DrawSpan(int16_t y, int16_t x0, int16_t x1, bool solid)
+int BspClipper::SkipFullTiles(int tileY, int tileX, int lastTileX) const
 {
-	if (x1 <= x0)
-		return false;
-
-	if (!solid)
-		return IsVisible(y, x0, x1);
-
-	numDrawSpans++;
-
-	auto& line = Viewport[y];
-
-	bool visible = false;
-	for (size_t pos = 0; pos < line.size(); pos++)
+	// Use the tile group bits to skip over fully covered tiles eight at a time
+	while (tileX <= lastTileX)
 	{
-		ClipSpan& span = line[pos];
-		ClipSpan& nextspan = line[pos + 1];
-
-		int16_t left = span.x1;
-		if (left >= x1)
-			break;
-		int16_t right = nextspan.x0;
-
-		left = std::max(left, x0);
-		right = std::min(right, x1);
-		if (left < right)
+		int groupX = tileX / 8;
+		uint32_t groupRow = (uint32_t)(GroupFullTiles[(tileY / 8) * GroupsX + groupX] >> ((tileY % 8) * 8)) & 0xff;
+		uint32_t notFull = ~groupRow & (0xffu << (tileX % 8)) & 0xff;
+		if (notFull != 0)
 		{
-			visible = true;
-			if (left == span.x1)
-			{
-				span.x1 = right;
-				if (span.x1 == nextspan.x0)
-				{
-					span.x1 = nextspan.x1;
-					line.erase(line.begin() + pos + 1);
-				}
-			}
-			else if (right == nextspan.x0)
-			{
-				nextspan.x0 = left;
-				if (span.x1 == nextspan.x0)
-				{
-					span.x1 = nextspan.x1;
-					line.erase(line.begin() + pos + 1);
-				}
-			}
-			else
-			{
-				pos++;
-				ClipSpan span;
-				span.x0 = left;
-				span.x1 = right;
-				line.insert(line.begin() + pos, span);
-			}
+			int first = 0;
+			while ((notFull & (1u << first)) == 0)
+				first++;
+			return groupX * 8 + first;
 		}
+		tileX = groupX * 8 + 8;
 	}
-	return visible;
+	return tileX;
+}
+
+void BspClipper::MarkTileFull(int tileX, int tileY)
+{
+	GroupFullTiles[(tileY / 8) * GroupsX + tileX / 8] |= 1ULL << ((tileY % 8) * 8 + tileX % 8);
 }
 
 bool BspClipper::DrawTriangle(const vec4* const* vert, bool solid, bool ccw)
@@ -495,99 +459,134 @@ int BspClipper::ClipEdge(const vec4* const* verts)
 
 bool BspClipper::DrawClippedTriangle(const vec4* const* vertices, bool solid)
 {
-	// Sort vertices by Y position
+	const vec4& v0 = *vertices[0];
+	const vec4& v1 = *vertices[1];
+	const vec4& v2 = *vertices[2];
 
-	const vec4* sortedVertices[3];
-	SortVertices(vertices, sortedVertices);
+	float area = (v1.x - v0.x) * (v2.y - v0.y) - (v2.x - v0.x) * (v1.y - v0.y);
+	if (area == 0.0f)
+		return false;
 
-	int16_t clipleft = 0;
-	int16_t clipright = ViewportWidth;
-	int16_t cliptop = 0;
-	int16_t clipbottom = ViewportHeight;
+	// Pixel centers inside the triangle are covered
+	int x0 = clamp((int)(std::min(std::min(v0.x, v1.x), v2.x) - 0.5f), 0, ViewportWidth);
+	int x1 = clamp((int)(std::max(std::max(v0.x, v1.x), v2.x) + 0.5f) + 1, 0, ViewportWidth);
+	int y0 = clamp((int)(std::min(std::min(v0.y, v1.y), v2.y) - 0.5f), 0, ViewportHeight);
+	int y1 = clamp((int)(std::max(std::max(v0.y, v1.y), v2.y) + 0.5f) + 1, 0, ViewportHeight);
+	if (x0 >= x1 || y0 >= y1)
+		return false;
 
-	int16_t topY = (int16_t)(sortedVertices[0]->y + 0.5f);
-	int16_t midY = (int16_t)(sortedVertices[1]->y + 0.5f);
-	int16_t bottomY = (int16_t)(sortedVertices[2]->y + 0.5f);
+	// Edge functions, oriented so that the inside of the triangle is positive
+	float orientation = area > 0.0f ? 1.0f : -1.0f;
+	Edge edges[3];
+	for (int i = 0; i < 3; i++)
+	{
+		const vec4& a = *vertices[i];
+		const vec4& b = *vertices[(i + 1) % 3];
+		edges[i].A = (a.y - b.y) * orientation;
+		edges[i].B = (b.x - a.x) * orientation;
+		edges[i].X0 = a.x;
+		edges[i].Y0 = a.y;
+	}
 
-	topY = std::max(topY, cliptop);
-	midY = std::min(midY, clipbottom);
-	bottomY = std::min(bottomY, clipbottom);
+	int tileX0 = x0 / TileSize;
+	int tileX1 = (x1 - 1) / TileSize;
+	int tileY0 = y0 / TileSize;
+	int tileY1 = (y1 - 1) / TileSize;
 
-	if (topY >= bottomY)
-		return false;
+	bool visible = false;
+	for (int tileY = tileY0; tileY <= tileY1; tileY++)
+	{
+		uint64_t* coverage = &TileCoverage[tileY * TilesX];
+		int tileX = tileX0;
+		while (tileX <= tileX1)
+		{
+			tileX = SkipFullTiles(tileY, tileX, tileX1);
+			if (tileX > tileX1)
+				break;
 
-	// Find start/end X positions for each line covered by the triangle:
+			uint64_t triangleMask = GetTileCoverage(edges, tileX, tileY);
+			uint64_t visibleMask = triangleMask & ~coverage[tileX];
+			if (visibleMask != 0)
+			{
+				visible = true;
+				if (!solid)
+					return true;
+
+				numDrawSpans++;
+				coverage[tileX] |= triangleMask;
+				if (coverage[tileX] == ~0ULL)
+					MarkTileFull(tileX, tileY);
+			}
+			tileX++;
+		}
+	}
+	return visible;
+}
 
-	int16_t y = topY;
+uint64_t BspClipper::GetTileCoverage(const Edge* edges, int tileX, int tileY) const
+{
+	float px = tileX * TileSize + 0.5f;
+	float py = tileY * TileSize + 0.5f;
+	const float last = (float)(TileSize - 1);
 
-	float longDX = sortedVertices[2]->x - sortedVertices[0]->x;
-	float longDY = sortedVertices[2]->y - sortedVertices[0]->y;
-	float longStep = longDX / longDY;
-	float longPos = sortedVertices[0]->x + longStep * (y + 0.5f - sortedVertices[0]->y) + 0.5f;
+	// The edge functions are linear, so the smallest and largest values over the tile are found at its corners
+	float start[3];
+	bool full = true;
+	for (int i = 0; i < 3; i++)
+	{
+		const Edge& e = edges[i];
+		start[i] = e.A * (px - e.X0) + e.B * (py - e.Y0);
+		float minValue = start[i] + std::min(e.A * last, 0.0f) + std::min(e.B * last, 0.0f);
+		float maxValue = start[i] + std::max(e.A * last, 0.0f) + std::max(e.B * last, 0.0f);
+		if (maxValue < 0.0f)
+			return 0;
+		full = full && minValue >= 0.0f;
+	}
+	if (full)
+		return ~0ULL;
 
-	bool result = false;
+	uint64_t mask = 0;
+#ifndef NO_SSE
+	__m128 offsetsLeft = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+	__m128 offsetsRight = _mm_setr_ps(4.0f, 5.0f, 6.0f, 7.0f);
+	__m128 left[3], right[3], stepY[3];
+	for (int i = 0; i < 3; i++)
+	{
+		__m128 a = _mm_set1_ps(edges[i].A);
+		__m128 s = _mm_set1_ps(start[i]);
+		left[i] = _mm_add_ps(s, _mm_mul_ps(a, offsetsLeft));
+		right[i] = _mm_add_ps(s, _mm_mul_ps(a, offsetsRight));
+		stepY[i] = _mm_set1_ps(edges[i].B);
+	}
 
-	if (y < midY)
+	__m128 zero = _mm_setzero_ps();
+	for (int y = 0; y < TileSize; y++)
 	{
-		float shortDX = sortedVertices[1]->x - sortedVertices[0]->x;
-		float shortDY = sortedVertices[1]->y - sortedVertices[0]->y;
-		float shortStep = shortDX / shortDY;
-		float shortPos = sortedVertices[0]->x + shortStep * (y + 0.5f - sortedVertices[0]->y) + 0.5f;
+		__m128 insideLeft = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(left[0], zero), _mm_cmpge_ps(left[1], zero)), _mm_cmpge_ps(left[2], zero));
+		__m128 insideRight = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(right[0], zero), _mm_cmpge_ps(right[1], zero)), _mm_cmpge_ps(right[2], zero));
+		uint64_t bits = (uint64_t)(_mm_movemask_ps(insideLeft) | (_mm_movemask_ps(insideRight) << 4));
+		mask |= bits << (y * 8);
 
-		while (y < midY)
+		for (int i = 0; i < 3; i++)
 		{
-			int16_t x0 = (int16_t)shortPos;
-			int16_t x1 = (int16_t)longPos;
-			if (x1 < x0) std::swap(x0, x1);
-			x0 = clamp(x0, clipleft, clipright);
-			x1 = clamp(x1, clipleft, clipright);
-
-			result |= DrawSpan(y, x0, x1, solid);
-
-			shortPos += shortStep;
-			longPos += longStep;
-			y++;
+			left[i] = _mm_add_ps(left[i], stepY[i]);
+			right[i] = _mm_add_ps(right[i], stepY[i]);
 		}
 	}
-
-	if (y < bottomY)
+#else
+	for (int y = 0; y < TileSize; y++)
 	{
-		float shortDX = sortedVertices[2]->x - sortedVertices[1]->x;
-		float shortDY = sortedVertices[2]->y - sortedVertices[1]->y;
-		float shortStep = shortDX / shortDY;
-		float shortPos = sortedVertices[1]->x + shortStep * (y + 0.5f - sortedVertices[1]->y) + 0.5f;
-
-		while (y < bottomY)
+		for (int x = 0; x < TileSize; x++)
 		{
-			int16_t x0 = (int16_t)shortPos;
-			int16_t x1 = (int16_t)longPos;
-			if (x1 < x0) std::swap(x0, x1);
-			x0 = clamp(x0, clipleft, clipright);
-			x1 = clamp(x1, clipleft, clipright);
-
-			result |= DrawSpan(y, x0, x1, solid);
-
-			shortPos += shortStep;
-			longPos += longStep;
-			y++;
+			bool inside = true;
+			for (int i = 0; i < 3; i++)
+				inside = inside && (start[i] + edges[i].A * x + edges[i].B * y) >= 0.0f;
+			if (inside)
+				mask |= 1ULL << (y * 8 + x);
 		}
 	}
-
-	return result;
-}
-
-void BspClipper::SortVertices(const vec4* const* vertices, const vec4** sortedVertices)
-{
-	sortedVertices[0] = vertices[0];
-	sortedVertices[1] = vertices[1];
-	sortedVertices[2] = vertices[2];
-
-	if (sortedVertices[1]->y < sortedVertices[0]->y)
-		std::swap(sortedVertices[0], sortedVertices[1]);
-	if (sortedVertices[2]->y < sortedVertices[0]->y)
-		std::swap(sortedVertices[0], sortedVertices[2]);
-	if (sortedVertices[2]->y < sortedVertices[1]->y)
-		std::swap(sortedVertices[1], sortedVertices[2]);
+#endif
+	return mask;
 }
 
 bool BspClipper::IsDegenerate(const vec4* const* vert)
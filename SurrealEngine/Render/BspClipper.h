@@ -5,13 +5,6 @@
 
 class BBox;
 
-class ClipSpan
-{
-public:
-	int16_t x0;
-	int16_t x1;
-};
-
 class BspClipper
 {
 public:
@@ -23,31 +16,46 @@ public:
 	bool CheckSurface(const vec3* vertices, uint32_t count, bool solid);
 	bool IsAABBVisible(const BBox& bbox);
 
-	int numDrawSpans;
+	int numDrawSpans; // Tiles written by solid triangles
 	int numSurfs;
 	int numTris;
 
 private:
-	bool IsVisible(int16_t y, int16_t x0, int16_t x1);
+	struct Edge
+	{
+		float A, B; // Change per pixel in x and y
+		float X0, Y0; // Point on the edge
+	};
 
 	bool DrawTriangle(const vec4* const* vert, bool solid, bool ccw);
 	int ClipEdge(const vec4* const* verts);
 
 	bool DrawClippedTriangle(const vec4* const* vertices, bool solid);
-	bool DrawSpan(int16_t y, int16_t x0, int16_t x1, bool solid);
+	uint64_t GetTileCoverage(const Edge* edges, int tileX, int tileY) const;
+	void MarkTileFull(int tileX, int tileY);
+	int SkipFullTiles(int tileY, int tileX, int lastTileX) const;
 
 	static bool IsDegenerate(const vec4* const* vert);
 	static bool IsFrontfacing(const vec4* const* vert);
-	static void SortVertices(const vec4* const* vertices, const vec4** sortedVertices);
 
-	std::vector<std::vector<ClipSpan>> Viewport;
+	static const int ViewportWidth = 2048;
+	static const int ViewportHeight = 1080;
+
+	// The occlusion buffer is split into 8x8 pixel tiles, with one coverage bit per pixel.
+	// Groups of 8x8 tiles keep a bit per tile that is set once the tile is fully covered.
+	static const int TileSize = 8;
+	static const int TilesX = ViewportWidth / TileSize;
+	static const int TilesY = (ViewportHeight + TileSize - 1) / TileSize;
+	static const int GroupsX = (TilesX + 7) / 8;
+	static const int GroupsY = (TilesY + 7) / 8;
+
+	std::vector<uint64_t> TileCoverage;
+	std::vector<uint64_t> GroupFullTiles;
+
 	FrustumPlanes FrustumClip;
 	mat4 WorldToProjection;
 
 	enum { max_additional_vertices = 16 };
 	float weightsbuffer[max_additional_vertices * 3 * 2];
 	float* weights = nullptr;
-
-	const int ViewportWidth = 2048;
-	const int ViewportHeight = 1080;
 };
@@ -0,0 +1,143 @@
+
+#include "Precomp.h"
+#include "LightGrid.h"
+#include "UObject/UActor.h"
+
+void LightGrid::Build(const std::vector<UActor*>& lights)
+{
+	Clear();
+
+	std::vector<LightEntry> entries;
+	vec3 boundsMin = vec3(0.0f), boundsMax = vec3(0.0f);
+	for (UActor* light : lights)
+	{
+		if (!light)
+			continue;
+
+		LightEntry entry;
+		entry.Light = light;
+		entry.Location = light->Location();
+		entry.Radius = light->WorldLightRadius();
+		entry.Cylinder = light->LightEffect() == LE_Cylinder;
+
+		vec3 lmin = entry.Location - entry.Radius;
+		vec3 lmax = entry.Location + entry.Radius;
+		if (entries.empty())
+		{
+			boundsMin = lmin;
+			boundsMax = lmax;
+		}
+		else
+		{
+			boundsMin = vec3(std::min(boundsMin.x, lmin.x), std::min(boundsMin.y, lmin.y), std::min(boundsMin.z, lmin.z));
+			boundsMax = vec3(std::max(boundsMax.x, lmax.x), std::max(boundsMax.y, lmax.y), std::max(boundsMax.z, lmax.z));
+		}
+		entries.push_back(entry);
+	}
+
+	// Keep the grid at 64 cells or less along each axis. Lights moving outside the bounds end up in the border cells.
+	vec3 extents = boundsMax - boundsMin;
+	CellSize = std::max(std::max(std::max(extents.x, extents.y), extents.z) / 64.0f, 256.0f);
+	Origin = boundsMin;
+	Size.x = std::max((int)std::ceil(extents.x / CellSize), 1);
+	Size.y = std::max((int)std::ceil(extents.y / CellSize), 1);
+	Size.z = std::max((int)std::ceil(extents.z / CellSize), 1);
+
+	size_t count = (size_t)Size.x * Size.y * Size.z;
+	Cells.resize(count);
+	Serials.assign(count, NextSerial++);
+
+	for (LightEntry& entry : entries)
+	{
+		Insert(entry);
+		if (!entry.Light->bStatic())
+			MovableLights.push_back(entry);
+	}
+}
+
+void LightGrid::Update()
+{
+	for (LightEntry& entry : MovableLights)
+	{
+		UActor* light = entry.Light;
+		bool cylinder = light->LightEffect() == LE_Cylinder;
+		if (light->Location() != entry.Location || light->WorldLightRadius() != entry.Radius || cylinder != entry.Cylinder)
+		{
+			Remove(entry);
+			entry.Location = light->Location();
+			entry.Radius = light->WorldLightRadius();
+			entry.Cylinder = cylinder;
+			Insert(entry);
+		}
+	}
+}
+
+void LightGrid::Clear()
+{
+	Cells.clear();
+	Serials.clear();
+	MovableLights.clear();
+	Size = ivec3(0);
+}
+
+int LightGrid::GetCell(const vec3& location) const
+{
+	if (Cells.empty())
+		return -1;
+	ivec3 pos = GetCellPos(location);
+	return pos.x + (pos.y + pos.z * Size.y) * Size.x;
+}
+
+ivec3 LightGrid::GetCellPos(const vec3& location) const
+{
+	vec3 pos = (location - Origin) / CellSize;
+	return ivec3(
+		clamp((int)std::floor(pos.x), 0, Size.x - 1),
+		clamp((int)std::floor(pos.y), 0, Size.y - 1),
+		clamp((int)std::floor(pos.z), 0, Size.z - 1));
+}
+
+void LightGrid::Insert(LightEntry& entry)
+{
+	entry.Min = GetCellPos(entry.Location - entry.Radius);
+	entry.Max = GetCellPos(entry.Location + entry.Radius);
+	if (entry.Cylinder) // Cylinder lights have infinite Z axis range
+	{
+		entry.Min.z = 0;
+		entry.Max.z = Size.z - 1;
+	}
+
+	for (int z = entry.Min.z; z <= entry.Max.z; z++)
+	{
+		for (int y = entry.Min.y; y <= entry.Max.y; y++)
+		{
+			for (int x = entry.Min.x; x <= entry.Max.x; x++)
+			{
+				int cell = x + (y + z * Size.y) * Size.x;
+				Cells[cell].push_back(entry.Light);
+				Serials[cell] = NextSerial;
+			}
+		}
+	}
+	NextSerial++;
+}
+
+void LightGrid::Remove(const LightEntry& entry)
+{
+	for (int z = entry.Min.z; z <= entry.Max.z; z++)
+	{
+		for (int y = entry.Min.y; y <= entry.Max.y; y++)
+		{
+			for (int x = entry.Min.x; x <= entry.Max.x; x++)
+			{
+				int cell = x + (y + z * Size.y) * Size.x;
+				auto& list = Cells[cell];
+				auto it = std::find(list.begin(), list.end(), entry.Light);
+				if (it != list.end())
+					list.erase(it);
+				Serials[cell] = NextSerial;
+			}
+		}
+	}
+	NextSerial++;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "Math/vec.h"
+#include <vector>
+
+class UActor;
+
+// Uniform grid over the level holding the lights that can reach each cell.
+//
+// The lights are inserted when the map loads. Non-static lights are checked once per frame and moved to their new
+// cells if they moved or changed radius. Every cell has a serial that changes whenever its light list changes, which
+// lets actors keep their light lists until they move or a light near them changes.
+class LightGrid
+{
+public:
+	void Build(const std::vector<UActor*>& lights);
+	void Update();
+	void Clear();
+
+	int GetCell(const vec3& location) const;
+	const std::vector<UActor*>& GetLights(int cell) const { return Cells[cell]; }
+	uint32_t GetCellSerial(int cell) const { return Serials[cell]; }
+
+private:
+	struct LightEntry
+	{
+		UActor* Light = nullptr;
+		vec3 Location = vec3(0.0f);
+		float Radius = 0.0f;
+		bool Cylinder = false;
+		ivec3 Min = ivec3(0);
+		ivec3 Max = ivec3(-1);
+	};
+
+	void Insert(LightEntry& entry);
+	void Remove(const LightEntry& entry);
+	ivec3 GetCellPos(const vec3& location) const;
+
+	vec3 Origin = vec3(0.0f);
+	float CellSize = 1.0f;
+	ivec3 Size = ivec3(0);
+	std::vector<std::vector<UActor*>> Cells;
+	std::vector<uint32_t> Serials;
+	std::vector<LightEntry> MovableLights;
+	uint32_t NextSerial = 1;
+};
@@ -6,6 +6,8 @@
 #include "Window/Window.h"
 #include "VM/ScriptCall.h"
 #include "Engine.h"
+#include "FrameProfiler.h"
+#include "GC/GC.h"
 #include <iostream>
 
 void RenderSubsystem::ResetCanvas()
@@ -66,6 +68,9 @@ void RenderSubsystem::PostRender()
 	CallEvent(engine->viewport->Actor(), EventName::PostRender, { ExpressionValue::ObjectValue(engine->canvas) });
 	CallEvent(engine->console, EventName::PostRender, { ExpressionValue::ObjectValue(engine->canvas) });
 	DrawTimedemoStats();
+	DrawMemoryStats();
+	DrawGCStats();
+	DrawFrameStats();
 	
 	if (ShowCollisionDebug)
 		DrawCollisionDebug();
@@ -172,45 +177,45 @@ void RenderSubsystem::DrawText(UFont* font, vec4 color, float orgX, float orgY,
 	if (center)
 		centerX = std::round((engine->canvas->SizeX() - GetTextSize(font, text).x) * 0.5f);
 
-	for (char c : text)
-	{
-		// To do: word wrap
-		// To do: SpaceX and SpaceY also affects DrawText
+	// To do: word wrap
+	// To do: SpaceX and SpaceY also affects DrawText
+	const TextLayout& layout = GetTextLayout(font, text, TextLayoutMode::Lines);
 
-		if (c == '\n')
+	// Find where each line starts. A newline moves down by the tallest character seen since the last one.
+	Canvas.LineOrigins.clear();
+	for (size_t i = 0; i < layout.Lines.size(); i++)
+	{
+		const TextLayoutLine& line = layout.Lines[i];
+		if (i > 0)
 		{
 			curX = 0;
 			curY += curYL;
 			curYL = 0;
 		}
-		else
-		{
-			//std::cout << c << std::endl;
-			FontGlyph glyph = font->GetGlyph(c);
-
-			FTextureInfo texinfo;
-			texinfo.CacheID = (uint64_t)(ptrdiff_t)glyph.Texture;
-			texinfo.Texture = glyph.Texture;
-			texinfo.Format = texinfo.Texture->ActualFormat;
-			texinfo.Mips = glyph.Texture->Mipmaps.data();
-			texinfo.NumMips = (int)glyph.Texture->Mipmaps.size();
-			texinfo.USize = glyph.Texture->USize();
-			texinfo.VSize = glyph.Texture->VSize();
-			if (glyph.Texture->Palette())
-				texinfo.Palette = (FColor*)glyph.Texture->Palette()->Colors.data();
-
-			int width = glyph.USize;
-			int height = glyph.VSize;
-			float StartU = (float)glyph.StartU;
-			float StartV = (float)glyph.StartV;
-			float USize = (float)glyph.USize;
-			float VSize = (float)glyph.VSize;
-
-			Device->DrawTile(&Canvas.Frame, texinfo, (orgX + curX + centerX) * Canvas.uiscale, (float)(orgY + curY) * Canvas.uiscale, (float)width * Canvas.uiscale, (float)height * Canvas.uiscale, StartU, StartV, USize, VSize, 1.0f, color, vec4(0.0f), PF_Highlighted | PF_NoSmooth | PF_Masked);
+		Canvas.LineOrigins.push_back({ curX, curY });
+		curX += line.Width + line.Count * spaceX;
+		if (line.Count > 0)
+			curYL = std::max(curYL, line.Height + spaceY);
+	}
 
-			curX += width + spaceX;
-			curYL = std::max(curYL, (float)glyph.VSize + spaceY);
+	for (const TextLayoutPage& page : layout.Pages)
+	{
+		Canvas.Tiles.clear();
+		for (const TextLayoutGlyph& glyph : page.Glyphs)
+		{
+			const vec2& origin = Canvas.LineOrigins[glyph.Line];
+			FTileRect tile;
+			tile.X = (orgX + origin.x + glyph.X + glyph.Index * spaceX + centerX) * Canvas.uiscale;
+			tile.Y = (float)(orgY + origin.y) * Canvas.uiscale;
+			tile.XL = glyph.USize * Canvas.uiscale;
+			tile.YL = glyph.VSize * Canvas.uiscale;
+			tile.U = glyph.StartU;
+			tile.V = glyph.StartV;
+			tile.UL = glyph.USize;
+			tile.VL = glyph.VSize;
+			Canvas.Tiles.push_back(tile);
 		}
+		Device->DrawTiles(&Canvas.Frame, const_cast<FTextureInfo&>(page.TexInfo), Canvas.Tiles.data(), (int)Canvas.Tiles.size(), 1.0f, color, vec4(0.0f), PF_Highlighted | PF_NoSmooth | PF_Masked);
 	}
 
 	curY += curYL;
@@ -225,37 +230,68 @@ void RenderSubsystem::DrawText(UFont* font, vec4 color, float orgX, float orgY,
 
 void RenderSubsystem::DrawTextClipped(UFont* font, vec4 color, float orgX, float orgY, float curX, float curY, const std::string& text, uint32_t flags, bool checkHotKey, float clipX, float clipY, bool center)
 {
-	FontGlyph uglyph = font->GetGlyph('_');
-	int uwidth = uglyph.USize;
-	int uheight = uglyph.VSize;
-	float uStartU = (float)uglyph.StartU;
-	float uStartV = (float)uglyph.StartV;
-	float uUSize = (float)uglyph.USize;
-	float uVSize = (float)uglyph.VSize;
-
 	Rectf clipBox = Rectf::xywh(orgX, orgY, clipX, clipY);
 
 	float centerX = 0;
 	if (center)
 		centerX = std::round((clipX - GetTextSize(font, text).x) * 0.5f);
 
-	bool foundAmpersand = false;
-	int maxY = 0;
-	for (char c : text)
+	// Characters are dropped from the first one that doesn't fit inside clipX
+	const TextLayout& layout = GetTextLayout(font, text, checkHotKey ? TextLayoutMode::HotKeys : TextLayoutMode::Flat);
+	for (const TextLayoutPage& page : layout.Pages)
 	{
-		if (checkHotKey && c == '&' && !foundAmpersand)
+		Canvas.Tiles.clear();
+		for (const TextLayoutGlyph& glyph : page.Glyphs)
 		{
-			foundAmpersand = true;
+			if (curX + glyph.ClipRight > (int)clipX)
+				break;
+
+			Rectf dest = Rectf::xywh(orgX + curX + glyph.X + (glyph.Underline ? 0.0f : centerX), orgY + curY, glyph.USize, glyph.VSize);
+			Rectf src = Rectf::xywh(glyph.StartU, glyph.StartV, glyph.USize, glyph.VSize);
+			FTileRect tile;
+			if (ClipTile(dest, src, clipBox, tile))
+				Canvas.Tiles.push_back(tile);
 		}
-		else if (foundAmpersand && c != '&')
-		{
-			foundAmpersand = false;
+		Device->DrawTiles(&Canvas.Frame, const_cast<FTextureInfo&>(page.TexInfo), Canvas.Tiles.data(), (int)Canvas.Tiles.size(), 1.0f, color, vec4(0.0f), PF_Highlighted | PF_NoSmooth | PF_Masked);
+	}
+}
 
-			FontGlyph glyph = font->GetGlyph(c);
-			if (curX + glyph.USize > (int)clipX)
+const TextLayout& RenderSubsystem::GetTextLayout(UFont* font, const std::string& text, TextLayoutMode mode)
+{
+	auto& layouts = Canvas.TextLayouts[(int)mode][font];
+	auto it = layouts.find(text);
+	if (it != layouts.end())
+		return it->second;
+
+	// Strings built every frame (timers, scores) would otherwise grow the cache forever
+	if (Canvas.TextLayoutCount >= 4096)
+	{
+		for (auto& fontLayouts : Canvas.TextLayouts)
+			fontLayouts.clear();
+		Canvas.TextLayoutCount = 0;
+	}
+	Canvas.TextLayoutCount++;
+
+	TextLayout& layout = Canvas.TextLayouts[(int)mode][font][text];
+	layout.Lines.push_back({});
+
+	auto addGlyph = [&](const FontGlyph& glyph, float x, float clipRight, bool underline)
+	{
+		TextLayoutPage* page = nullptr;
+		for (TextLayoutPage& p : layout.Pages)
+		{
+			if (p.TexInfo.Texture == glyph.Texture)
+			{
+				page = &p;
 				break;
+			}
+		}
+		if (!page)
+		{
+			layout.Pages.push_back({});
+			page = &layout.Pages.back();
 
-			FTextureInfo texinfo;
+			FTextureInfo& texinfo = page->TexInfo;
 			texinfo.CacheID = (uint64_t)(ptrdiff_t)glyph.Texture;
 			texinfo.Texture = glyph.Texture;
 			texinfo.Format = texinfo.Texture->ActualFormat;
@@ -265,64 +301,78 @@ void RenderSubsystem::DrawTextClipped(UFont* font, vec4 color, float orgX, float
 			texinfo.VSize = glyph.Texture->VSize();
 			if (glyph.Texture->Palette())
 				texinfo.Palette = (FColor*)glyph.Texture->Palette()->Colors.data();
+		}
 
-			Rectf dest = Rectf::xywh(orgX + curX + centerX, orgY + curY, (float)glyph.USize, (float)glyph.VSize);
-			Rectf src = Rectf::xywh((float)glyph.StartU, (float)glyph.StartV, (float)glyph.USize, (float)glyph.VSize);
-			DrawTile(texinfo, dest, src, clipBox, 1.0f, color, vec4(0.0f), PF_Highlighted | PF_NoSmooth | PF_Masked);
+		TextLayoutGlyph g;
+		g.X = x;
+		g.ClipRight = clipRight;
+		g.USize = (float)glyph.USize;
+		g.VSize = (float)glyph.VSize;
+		g.StartU = (float)glyph.StartU;
+		g.StartV = (float)glyph.StartV;
+		g.Line = (int)layout.Lines.size() - 1;
+		g.Index = layout.Lines.back().Count;
+		g.Underline = underline;
+		page->Glyphs.push_back(g);
+	};
+
+	auto advance = [&](const FontGlyph& glyph)
+	{
+		TextLayoutLine& line = layout.Lines.back();
+		line.Width += glyph.USize;
+		line.Height = std::max(line.Height, (float)glyph.VSize);
+		line.Count++;
 
-			texinfo.CacheID = (uint64_t)(ptrdiff_t)uglyph.Texture;
-			texinfo.Texture = uglyph.Texture;
+		layout.Size.x += glyph.USize;
+		layout.Size.y = std::max(layout.Size.y, glyph.VSize);
+		layout.CharExtents.push_back({ layout.Size.x, glyph.VSize });
+	};
 
-			dest = Rectf::xywh(orgX + curX + (glyph.USize - uwidth) / 2, orgY + curY, (float)uwidth, (float)uheight);
-			src = Rectf::xywh(uStartU, uStartV, uUSize, uVSize);
-			DrawTile(texinfo, dest, src, clipBox, 1.0f, color, vec4(0.0f), PF_Highlighted | PF_NoSmooth | PF_Masked);
+	FontGlyph uglyph = font->GetGlyph('_');
+	bool foundAmpersand = false;
+	for (char c : text)
+	{
+		if (mode == TextLayoutMode::Lines && c == '\n')
+		{
+			layout.Lines.push_back({});
+		}
+		else if (mode == TextLayoutMode::HotKeys && c == '&' && !foundAmpersand)
+		{
+			foundAmpersand = true;
+		}
+		else if (foundAmpersand && c != '&')
+		{
+			foundAmpersand = false;
 
-			curX += glyph.USize;
-			maxY = std::max(maxY, glyph.VSize);
+			FontGlyph glyph = font->GetGlyph(c);
+			float x = layout.Lines.back().Width;
+			addGlyph(glyph, x, x + glyph.USize, false);
+			addGlyph(uglyph, x + (glyph.USize - uglyph.USize) / 2, x + glyph.USize, true);
+			advance(glyph);
 		}
 		else
 		{
 			foundAmpersand = false;
 
 			FontGlyph glyph = font->GetGlyph(c);
-			if (curX + glyph.USize > (int)clipX)
-				break;
-
-			FTextureInfo texinfo;
-			texinfo.CacheID = (uint64_t)(ptrdiff_t)glyph.Texture;
-			texinfo.Texture = glyph.Texture;
-			texinfo.Format = texinfo.Texture->ActualFormat;
-			texinfo.Mips = glyph.Texture->Mipmaps.data();
-			texinfo.NumMips = (int)glyph.Texture->Mipmaps.size();
-			texinfo.USize = glyph.Texture->USize();
-			texinfo.VSize = glyph.Texture->VSize();
-			if (glyph.Texture->Palette())
-				texinfo.Palette = (FColor*)glyph.Texture->Palette()->Colors.data();
-
-			Rectf dest = Rectf::xywh(orgX + curX + centerX, orgY + curY, (float)glyph.USize, (float)glyph.VSize);
-			Rectf src = Rectf::xywh((float)glyph.StartU, (float)glyph.StartV, (float)glyph.USize, (float)glyph.VSize);
-			DrawTile(texinfo, dest, src, clipBox, 1.0f, color, vec4(0.0f), PF_Highlighted | PF_NoSmooth | PF_Masked);
-
-			curX += glyph.USize;
-			maxY = std::max(maxY, glyph.VSize);
+			float x = layout.Lines.back().Width;
+			addGlyph(glyph, x, x + glyph.USize, false);
+			advance(glyph);
 		}
 	}
+	return layout;
 }
 
-void RenderSubsystem::DrawTile(FTextureInfo& texinfo, const Rectf& dest, const Rectf& src, const Rectf& clipBox, float Z, vec4 color, vec4 fog, uint32_t flags)
+bool RenderSubsystem::ClipTile(const Rectf& dest, const Rectf& src, const Rectf& clipBox, FTileRect& tile)
 {
 	if (dest.left > dest.right || dest.top > dest.bottom)
-		return;
+		return false;
 
-	if (dest.left >= clipBox.left && dest.top >= clipBox.top && dest.right <= clipBox.right && dest.bottom <= clipBox.bottom)
-	{
-		Device->DrawTile(&Canvas.Frame, texinfo, dest.left * Canvas.uiscale, dest.top * Canvas.uiscale, (dest.right - dest.left) * Canvas.uiscale, (dest.bottom - dest.top) * Canvas.uiscale, src.left, src.top, src.right - src.left, src.bottom - src.top, Z, color, fog, flags);
-	}
-	else
-	{
-		Rectf d = dest;
-		Rectf s = src;
+	Rectf d = dest;
+	Rectf s = src;
 
+	if (d.left < clipBox.left || d.top < clipBox.top || d.right > clipBox.right || d.bottom > clipBox.bottom)
+	{
 		float scaleX = (s.right - s.left) / (d.right - d.left);
 		float scaleY = (s.bottom - s.top) / (d.bottom - d.top);
 
@@ -347,35 +397,43 @@ void RenderSubsystem::DrawTile(FTextureInfo& texinfo, const Rectf& dest, const R
 			d.bottom = clipBox.bottom;
 		}
 
-		if (d.left < d.right && d.top < d.bottom)
-			Device->DrawTile(&Canvas.Frame, texinfo, d.left * Canvas.uiscale, d.top * Canvas.uiscale, (d.right - d.left) * Canvas.uiscale, (d.bottom - d.top) * Canvas.uiscale, s.left, s.top, s.right - s.left, s.bottom - s.top, Z, color, fog, flags);
+		if (d.left >= d.right || d.top >= d.bottom)
+			return false;
 	}
+
+	tile.X = d.left * Canvas.uiscale;
+	tile.Y = d.top * Canvas.uiscale;
+	tile.XL = (d.right - d.left) * Canvas.uiscale;
+	tile.YL = (d.bottom - d.top) * Canvas.uiscale;
+	tile.U = s.left;
+	tile.V = s.top;
+	tile.UL = s.right - s.left;
+	tile.VL = s.bottom - s.top;
+	return true;
+}
+
+void RenderSubsystem::DrawTile(FTextureInfo& texinfo, const Rectf& dest, const Rectf& src, const Rectf& clipBox, float Z, vec4 color, vec4 fog, uint32_t flags)
+{
+	FTileRect tile;
+	if (ClipTile(dest, src, clipBox, tile))
+		Device->DrawTile(&Canvas.Frame, texinfo, tile.X, tile.Y, tile.XL, tile.YL, tile.U, tile.V, tile.UL, tile.VL, Z, color, fog, flags);
 }
 
 ivec2 RenderSubsystem::GetTextSize(UFont* font, const std::string& text)
 {
-	int x = 0;
-	int y = 0;
-	for (char c : text)
-	{
-		FontGlyph glyph = font->GetGlyph(c);
-		x += glyph.USize;
-		y = std::max(y, glyph.VSize);
-	}
-	return { x, y };
+	return GetTextLayout(font, text, TextLayoutMode::Flat).Size;
 }
 
 ivec2 RenderSubsystem::GetTextClippedSize(UFont* font, const std::string& text, float clipX)
 {
 	int x = 0;
 	int y = 0;
-	for (char c : text)
+	for (const ivec2& extent : GetTextLayout(font, text, TextLayoutMode::Flat).CharExtents)
 	{
-		FontGlyph glyph = font->GetGlyph(c);
-		if (x + glyph.USize > (int)clipX)
+		if (extent.x > (int)clipX)
 			break;
-		x += glyph.USize;
-		y = std::max(y, glyph.VSize);
+		x = extent.x;
+		y = std::max(y, extent.y);
 	}
 	return { x, y };
 }
@@ -394,7 +452,7 @@ void RenderSubsystem::DrawTimedemoStats()
 	{
 		std::vector<std::string> lines;
 		lines.push_back(std::to_string(Canvas.fps) + " FPS");
-		lines.push_back(std::to_string(engine->Level->Actors.size()) + " actors");
+		lines.push_back(std::to_string(engine->Level->Actors.GetLiveCount()) + " actors");
 
 		/*size_t numCollisionActors = 0;
 		for (auto& it : engine->Level->Hash.CollisionActors)
@@ -405,6 +463,11 @@ void RenderSubsystem::DrawTimedemoStats()
 		lines.push_back(std::to_string(Scene.Actors.size()) + " visible actors");
 		lines.push_back(std::to_string(Scene.Coronas.size()) + " visible coronas");
 
+		lines.push_back(std::to_string(Scene.Clipper.numDrawSpans) + " occlusion tiles");
+		lines.push_back(std::to_string(Scene.Clipper.numSurfs) + " checked surfaces");
+		lines.push_back(std::to_string(Scene.Clipper.numTris) + " checked triangles");
+		lines.push_back(std::to_string(Visibility.CacheHits) + " cached views");
+
 		UFont* font = engine->canvas->SmallFont();
 		if (font)
 		{
@@ -436,7 +499,7 @@ void RenderSubsystem::DrawTimedemoStats()
 	{
 		std::vector<std::string> lines;
 		lines.push_back(std::to_string(Canvas.fps) + " FPS");
-		lines.push_back(std::to_string(engine->Level->Actors.size()) + " actors");
+		lines.push_back(std::to_string(engine->Level->Actors.GetLiveCount()) + " actors");
 
 		/*size_t numCollisionActors = 0;
 		for (auto& it : engine->Level->Hash.CollisionActors)
@@ -447,9 +510,10 @@ void RenderSubsystem::DrawTimedemoStats()
 		lines.push_back(std::to_string(Scene.Actors.size()) + " visible actors");
 		lines.push_back(std::to_string(Scene.Coronas.size()) + " visible coronas");
 
-		lines.push_back(std::to_string(Scene.Clipper.numDrawSpans) + " spans");
+		lines.push_back(std::to_string(Scene.Clipper.numDrawSpans) + " occlusion tiles");
 		lines.push_back(std::to_string(Scene.Clipper.numSurfs) + " checked surfaces");
 		lines.push_back(std::to_string(Scene.Clipper.numTris) + " checked triangles");
+		lines.push_back(std::to_string(Visibility.CacheHits) + " cached views");
 
 		UFont* font = engine->canvas->MedFont();
 		if (font)
@@ -466,6 +530,181 @@ void RenderSubsystem::DrawTimedemoStats()
 	}
 }
 
+void RenderSubsystem::DrawMemoryStats()
+{
+	if (!ShowMemoryStats)
+		return;
+
+	std::vector<std::string> lines;
+	lines.push_back("Memory: " + MemoryStats::FormatBytes(MemoryStats::GetTotalBytes()));
+	for (const MemoryCategoryStats& stats : MemoryStats::GetStats())
+	{
+		lines.push_back(std::string(stats.Subsystem) + " " + stats.Type + ": " + MemoryStats::FormatBytes(stats.Bytes) + " (" + std::to_string(stats.Allocations) + ", peak " + MemoryStats::FormatBytes(stats.PeakBytes) + ")");
+	}
+
+	UFont* font = engine->canvas->SmallFont();
+	if (font)
+	{
+		float curY = 64;
+		for (const std::string& text : lines)
+		{
+			float curX = 16.0f;
+			float curYL = 0.0f;
+			DrawText(font, vec4(1.0f), 0.0f, 0.0f, curX, curY, curYL, false, text, PF_NoSmooth | PF_Masked, false);
+			curY += curYL;
+		}
+	}
+}
+
+void RenderSubsystem::DrawGCStats()
+{
+	if (!ShowGCStats)
+		return;
+
+	GCStats stats = GC::GetStats();
+
+	std::vector<std::string> lines;
+	lines.push_back(std::to_string(stats.numUObjects) + " runtime objects, " + stats.phase);
+	lines.push_back(std::to_string(stats.numUObjectsFreed) + " freed in " + std::to_string(stats.numCycles) + " cycles");
+	lines.push_back(std::to_string(stats.lastCycleReached) + " reached by last cycle");
+	lines.push_back(std::to_string(stats.lastCycleFreed) + " freed by last cycle, " + std::to_string(stats.lastCycleRecycled) + " pooled");
+	lines.push_back(std::to_string((int)(stats.lastCycleMs * 1000.0)) + " us last cycle");
+	lines.push_back(std::to_string((int)(stats.lastLongestStepMs * 1000.0)) + " us longest step of last cycle");
+	lines.push_back(std::to_string(stats.heapPages) + " heap pages, " + MemoryStats::FormatBytes(stats.heapUsedBytes) + " used");
+
+	UFont* font = engine->canvas->SmallFont();
+	if (font)
+	{
+		float curY = 64;
+		for (const std::string& text : lines)
+		{
+			float curX = 16.0f;
+			float curYL = 0.0f;
+			DrawText(font, vec4(1.0f), 0.0f, 0.0f, curX, curY, curYL, false, text, PF_NoSmooth | PF_Masked, false);
+			curY += curYL;
+		}
+	}
+}
+
+void RenderSubsystem::DrawFrameStats()
+{
+	if (!FrameProfiler::IsOverlayEnabled())
+		return;
+
+	static const vec4 zoneColors[(int)ProfileZone::Count] =
+	{
+		vec4(0.5f, 0.5f, 0.5f, 1.0f), // Other
+		vec4(1.0f, 1.0f, 1.0f, 1.0f), // Input
+		vec4(0.0f, 0.8f, 0.8f, 1.0f), // Network
+		vec4(0.2f, 0.4f, 1.0f, 1.0f), // LevelTick
+		vec4(1.0f, 0.8f, 0.0f, 1.0f), // Script
+		vec4(1.0f, 0.4f, 0.0f, 1.0f), // Physics
+		vec4(1.0f, 0.0f, 1.0f, 1.0f), // Travel
+		vec4(0.0f, 0.9f, 0.2f, 1.0f), // Render
+		vec4(0.6f, 0.3f, 1.0f, 1.0f), // Audio
+		vec4(1.0f, 0.1f, 0.1f, 1.0f), // Present
+		vec4(0.4f, 0.2f, 0.0f, 1.0f) // GC
+	};
+
+	if (FrameStats.Mip.Data.empty())
+	{
+		FrameStats.Mip.Width = 1;
+		FrameStats.Mip.Height = 1;
+		FrameStats.Mip.Data = { 255, 255, 255, 255 };
+		FrameStats.TexInfo.CacheID = (uint64_t)(ptrdiff_t)&FrameStats.Mip;
+		FrameStats.TexInfo.Format = TextureFormat::BGRA8;
+		FrameStats.TexInfo.Mips = &FrameStats.Mip;
+		FrameStats.TexInfo.NumMips = 1;
+	}
+
+	float sizeX = engine->ViewportWidth / (float)Canvas.uiscale;
+	float sizeY = engine->ViewportHeight / (float)Canvas.uiscale;
+	Rectf clipBox = Rectf::xywh(0.0f, 0.0f, sizeX, sizeY);
+	Rectf src = Rectf::xywh(0.0f, 0.0f, 1.0f, 1.0f);
+	uint32_t flags = PF_NoSmooth;
+
+	// Stacked bar per frame, newest to the right. The graph is 33 ms tall with a line at 16.7 ms.
+	const float graphHeight = 100.0f;
+	const float pixelsPerMicrosecond = graphHeight / 33333.0f;
+	float graphX = 16.0f;
+	float graphBottom = sizeY - 16.0f;
+	float graphWidth = (float)FrameProfiler::HistorySize;
+
+	DrawTile(FrameStats.TexInfo, Rectf::xywh(graphX, graphBottom - graphHeight, graphWidth, 1.0f), src, clipBox, 0.0f, vec4(0.6f, 0.0f, 0.0f, 1.0f), vec4(0.0f), flags);
+	DrawTile(FrameStats.TexInfo, Rectf::xywh(graphX, graphBottom - graphHeight * 0.5f, graphWidth, 1.0f), src, clipBox, 0.0f, vec4(0.0f, 0.6f, 0.0f, 1.0f), vec4(0.0f), flags);
+
+	for (int framesAgo = 0; framesAgo < FrameProfiler::HistorySize; framesAgo++)
+	{
+		const ProfiledFrame* frame = FrameProfiler::GetFrame(framesAgo);
+		if (!frame)
+			break;
+
+		float x = graphX + graphWidth - 1.0f - framesAgo;
+		float y = graphBottom;
+		for (int zone = 0; zone < (int)ProfileZone::Count; zone++)
+		{
+			float height = std::min(frame->Self[zone] * pixelsPerMicrosecond, y - (graphBottom - graphHeight));
+			if (height <= 0.0f)
+				continue;
+			y -= height;
+			DrawTile(FrameStats.TexInfo, Rectf::xywh(x, y, 1.0f, height), src, clipBox, 0.0f, zoneColors[zone], vec4(0.0f), flags);
+		}
+	}
+
+	// Averages of the last second or so, with the total time spent inside each zone including the zones it called
+	int frameCount = 0;
+	uint32_t maxFrameTime = 0;
+	uint64_t frameTime = 0;
+	uint64_t inclusive[(int)ProfileZone::Count] = {};
+	uint64_t calls[(int)ProfileZone::Count] = {};
+	for (int framesAgo = 0; framesAgo < 60; framesAgo++)
+	{
+		const ProfiledFrame* frame = FrameProfiler::GetFrame(framesAgo);
+		if (!frame)
+			break;
+
+		frameCount++;
+		frameTime += frame->Duration;
+		maxFrameTime = std::max(maxFrameTime, frame->Duration);
+		for (int zone = 0; zone < (int)ProfileZone::Count; zone++)
+		{
+			inclusive[zone] += frame->Inclusive[zone];
+			calls[zone] += frame->Calls[zone];
+		}
+	}
+
+	UFont* font = engine->canvas->SmallFont();
+	if (!font || frameCount == 0)
+		return;
+
+	auto formatMs = [](double microseconds)
+	{
+		std::string text = std::to_string(microseconds / 1000.0);
+		return text.substr(0, text.find('.') + 3) + " ms";
+	};
+
+	float curY = graphBottom - graphHeight - 20.0f;
+	auto drawLine = [&](const vec4& color, const std::string& text)
+	{
+		float curX = graphX + 12.0f;
+		float curYL = 0.0f;
+		DrawText(font, vec4(1.0f), 0.0f, 0.0f, curX, curY, curYL, false, text, PF_NoSmooth | PF_Masked, false);
+		DrawTile(FrameStats.TexInfo, Rectf::xywh(graphX, curY + 1.0f, 8.0f, std::max(curYL - 2.0f, 1.0f)), src, clipBox, 0.0f, color, vec4(0.0f), flags);
+		curY -= curYL;
+	};
+
+	for (int zone = (int)ProfileZone::Count - 1; zone > 0; zone--)
+	{
+		if (calls[zone] == 0)
+			continue;
+		std::string text = FrameProfiler::GetZoneName((ProfileZone)zone);
+		text += " " + formatMs(inclusive[zone] / (double)frameCount);
+		text += " (" + std::to_string(calls[zone] / frameCount) + " calls)";
+		drawLine(zoneColors[zone], text);
+	}
+	drawLine(zoneColors[0], "Frame " + formatMs(frameTime / (double)frameCount) + " (max " + formatMs(maxFrameTime) + ")");
+}
+
 void RenderSubsystem::DrawCollisionDebug()
 {
 	std::vector<std::string> lines;
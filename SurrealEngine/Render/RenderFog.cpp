@@ -38,6 +38,7 @@ FTextureInfo RenderSubsystem::GetSurfaceFogmap(BspSurface& surface, const FSurfa
 		fogtexture = std::make_unique<LightmapTexture>();
 		fogtexture->Format = TextureFormat::RGBA32_F;
 		fogtexture->Mip = std::move(fogmip);
+		fogtexture->Memory.Set(MemoryCategory::Fogmaps, MemoryStats::GetVectorBytes(fogtexture->Mip.Data));
 #else // Low quality lightmaps like UE1 got them
 		UnrealMipmap fogmip;
 		fogmip.Width = lmindex.UClamp;
@@ -47,6 +48,7 @@ FTextureInfo RenderSubsystem::GetSurfaceFogmap(BspSurface& surface, const FSurfa
 		fogtexture = std::make_unique<LightmapTexture>();
 		fogtexture->Format = TextureFormat::BGRA8_LM;
 		fogtexture->Mip = std::move(fogmip);
+		fogtexture->Memory.Set(MemoryCategory::Fogmaps, MemoryStats::GetVectorBytes(fogtexture->Mip.Data));
 #endif
 	}
 
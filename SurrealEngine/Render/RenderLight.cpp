@@ -4,6 +4,7 @@
 #include "RenderDevice/RenderDevice.h"
 #include "Engine.h"
 #include "Math/hsb.h"
+#include "Lib/JobSystem.h"
 
 FTextureInfo RenderSubsystem::GetBrushLightmap(UActor* actor, const Poly& poly, UZoneInfo* zoneActor, UModel* model, const mat4& objectToWorld)
 {
@@ -11,9 +12,7 @@ FTextureInfo RenderSubsystem::GetBrushLightmap(UActor* actor, const Poly& poly,
 	if (lightmapIndex < 0)
 		return {};
 
-	uint32_t ambientID = (((uint32_t)zoneActor->AmbientHue()) << 16) | (((uint32_t)zoneActor->AmbientSaturation()) << 8) | (uint32_t)zoneActor->AmbientBrightness();
-
-	uint64_t cacheID = (((uint64_t)model->LightMap[lightmapIndex].LMCacheID) << 32) | (((uint64_t)ambientID) << 8) | 1;
+	uint64_t cacheID = GetLightmapCacheID(model, lightmapIndex, zoneActor);
 
 	auto level = engine->Level;
 	auto& lmtexture = Light.lmtextures[cacheID];
@@ -30,7 +29,7 @@ FTextureInfo RenderSubsystem::GetBrushLightmap(UActor* actor, const Poly& poly,
 		Light.Builder.Setup(model, mapCoords, lightmapIndex, zoneActor);
 		Light.Builder.AddStaticLights(model, lightmapIndex);
 
-		lmtexture = CreateLightmapTexture();
+		lmtexture = CreateLightmapTexture(Light.Builder);
 	}
 
 	const LightMapIndex& lmindex = model->LightMap[lightmapIndex];
@@ -53,9 +52,7 @@ FTextureInfo RenderSubsystem::GetSurfaceLightmap(BspSurface& surface, const FSur
 	if (surface.LightMap < 0)
 		return {};
 
-	uint32_t ambientID = (((uint32_t)zoneActor->AmbientHue()) << 16) | (((uint32_t)zoneActor->AmbientSaturation()) << 8) | (uint32_t)zoneActor->AmbientBrightness();
-
-	uint64_t cacheID = (((uint64_t)model->LightMap[surface.LightMap].LMCacheID) << 32) | (((uint64_t)ambientID) << 8) | 1;
+	uint64_t cacheID = GetLightmapCacheID(model, surface.LightMap, zoneActor);
 
 	auto level = engine->Level;
 	auto& lmtexture = Light.lmtextures[cacheID];
@@ -70,7 +67,7 @@ FTextureInfo RenderSubsystem::GetSurfaceLightmap(BspSurface& surface, const FSur
 		Light.Builder.Setup(model, mapCoords, surface.LightMap, zoneActor);
 		Light.Builder.AddStaticLights(model, surface.LightMap);
 
-		lmtexture = CreateLightmapTexture();
+		lmtexture = CreateLightmapTexture(Light.Builder);
 	}
 
 	const LightMapIndex& lmindex = model->LightMap[surface.LightMap];
@@ -88,17 +85,76 @@ FTextureInfo RenderSubsystem::GetSurfaceLightmap(BspSurface& surface, const FSur
 	return texinfo;
 }
 
-std::unique_ptr<LightmapTexture> RenderSubsystem::CreateLightmapTexture()
+uint64_t RenderSubsystem::GetLightmapCacheID(UModel* model, int lightMap, UZoneInfo* zoneActor)
+{
+	uint32_t ambientID = (((uint32_t)zoneActor->AmbientHue()) << 16) | (((uint32_t)zoneActor->AmbientSaturation()) << 8) | (uint32_t)zoneActor->AmbientBrightness();
+	return (((uint64_t)model->LightMap[lightMap].LMCacheID) << 32) | (((uint64_t)ambientID) << 8) | 1;
+}
+
+void RenderSubsystem::PrepareSurfaceLightmaps()
+{
+	// Find the visible surfaces that don't have a lightmap yet
+	UModel* model = engine->Level->Model;
+	Light.Requests.clear();
+	for (const auto* nodes : { &Scene.OpaqueNodes, &Scene.TranslucentNodes })
+	{
+		for (const DrawNodeInfo& nodeInfo : *nodes)
+		{
+			BspSurface& surface = model->Surfaces[nodeInfo.Node->Surf];
+			if ((nodeInfo.PolyFlags & PF_Unlit) || surface.LightMap < 0)
+				continue;
+
+			// Same zone lookup as DrawNodeSurface
+			UZoneInfo* zoneActor = !model->Zones.empty() ? static_cast<UZoneInfo*>(model->Zones[nodeInfo.Node->Zone1].ZoneActor) : nullptr;
+			if (!zoneActor)
+				zoneActor = engine->LevelInfo;
+
+			uint64_t cacheID = GetLightmapCacheID(model, surface.LightMap, zoneActor);
+			if (Light.lmtextures.find(cacheID) == Light.lmtextures.end())
+			{
+				Light.lmtextures[cacheID] = nullptr;
+				Light.Requests.push_back({ cacheID, &surface, zoneActor, nullptr });
+			}
+		}
+	}
+
+	// Build them on the worker threads. Each batch gets its own builder.
+	JobSystem::ParallelFor(Light.Requests.size(), 4, [&](size_t begin, size_t end)
+		{
+			LightmapBuilder builder;
+			for (size_t i = begin; i < end; i++)
+			{
+				LightmapRequest& request = Light.Requests[i];
+				BspSurface& surface = *request.Surface;
+
+				Coords mapCoords;
+				mapCoords.Origin = model->Points[surface.pBase];
+				mapCoords.XAxis = model->Vectors[surface.vTextureU];
+				mapCoords.YAxis = model->Vectors[surface.vTextureV];
+				mapCoords.ZAxis = model->Vectors[surface.vNormal];
+
+				builder.Setup(model, mapCoords, surface.LightMap, request.ZoneActor);
+				builder.AddStaticLights(model, surface.LightMap);
+				request.Texture = CreateLightmapTexture(builder);
+			}
+		});
+
+	for (LightmapRequest& request : Light.Requests)
+		Light.lmtextures[request.CacheID] = std::move(request.Texture);
+	Light.Requests.clear();
+}
+
+std::unique_ptr<LightmapTexture> RenderSubsystem::CreateLightmapTexture(const LightmapBuilder& builder)
 {
 #if 1 // Float high quality lightmaps
 
 	UnrealMipmap lmmip;
-	lmmip.Width = Light.Builder.Width();
-	lmmip.Height = Light.Builder.Height();
+	lmmip.Width = builder.Width();
+	lmmip.Height = builder.Height();
 	lmmip.Data.resize((size_t)lmmip.Width * lmmip.Height * sizeof(vec4));
 
 	vec4* dest = (vec4*)lmmip.Data.data();
-	const vec3* src = Light.Builder.Pixels();
+	const vec3* src = builder.Pixels();
 	int count = lmmip.Width * lmmip.Height;
 	for (int i = 0; i < count; i++)
 	{
@@ -108,17 +164,18 @@ std::unique_ptr<LightmapTexture> RenderSubsystem::CreateLightmapTexture()
 	auto lmtexture = std::make_unique<LightmapTexture>();
 	lmtexture->Format = TextureFormat::RGBA32_F;
 	lmtexture->Mip = std::move(lmmip);
+	lmtexture->Memory.Set(MemoryCategory::Lightmaps, MemoryStats::GetVectorBytes(lmtexture->Mip.Data));
 	return lmtexture;
 
 #else // Low quality lightmaps like UE1 got them
 
 	UnrealMipmap lmmip;
-	lmmip.Width = Light.Builder.Width();
-	lmmip.Height = Light.Builder.Height();
+	lmmip.Width = builder.Width();
+	lmmip.Height = builder.Height();
 	lmmip.Data.resize((size_t)lmmip.Width * lmmip.Height * 4);
 
 	uint32_t* dest = (uint32_t*)lmmip.Data.data();
-	const vec3* src = Light.Builder.Pixels();
+	const vec3* src = builder.Pixels();
 	int count = lmmip.Width * lmmip.Height;
 	for (int i = 0; i < count; i++)
 	{
@@ -133,6 +190,7 @@ std::unique_ptr<LightmapTexture> RenderSubsystem::CreateLightmapTexture()
 	auto lmtexture = std::make_unique<LightmapTexture>();
 	lmtexture->Format = TextureFormat::BGRA8_LM;
 	lmtexture->Mip = std::move(lmmip);
+	lmtexture->Memory.Set(MemoryCategory::Lightmaps, MemoryStats::GetVectorBytes(lmtexture->Mip.Data));
 	return lmtexture;
 
 #endif
@@ -140,21 +198,29 @@ std::unique_ptr<LightmapTexture> RenderSubsystem::CreateLightmapTexture()
 
 void RenderSubsystem::UpdateActorLightList(UActor* actor)
 {
+	// Small movements don't change which lights reach the actor enough to be noticed
+	const float moveThreshold = 8.0f;
+
 	vec3 location = actor->Location();
+	int cell = Light.Grid.GetCell(location);
+	uint32_t serial = cell >= 0 ? Light.Grid.GetCellSerial(cell) : 0;
 
-	if (!actor->LightInfo.NeedsUpdate && actor->LightInfo.Location == location)
+	vec3 delta = location - actor->LightInfo.Location;
+	if (!actor->LightInfo.NeedsUpdate && dot(delta, delta) < moveThreshold * moveThreshold && actor->LightInfo.GridCell == cell && actor->LightInfo.GridSerial == serial)
 		return;
 
 	actor->LightInfo.NeedsUpdate = false;
 	actor->LightInfo.Location = location;
+	actor->LightInfo.GridCell = cell;
+	actor->LightInfo.GridSerial = serial;
 	actor->LightInfo.LightList.clear();
 
-	if (actor->bUnlit())
+	if (actor->bUnlit() || cell < 0)
 		return;
 
-	for (UActor* light : Light.Lights)
+	for (UActor* light : Light.Grid.GetLights(cell))
 	{
-		if (light && !light->bCorona() && !light->bSpecialLit())
+		if (!light->bCorona() && !light->bSpecialLit())
 		{
 			float radius = light->WorldLightRadius();
 			vec3 L = light->Location() - location;
@@ -164,7 +230,7 @@ void RenderSubsystem::UpdateActorLightList(UActor* actor)
 			}
 			if (dot(L, L) < radius * radius && !engine->Level->TraceRayAnyHit(light->Location(), location, nullptr, false, true, true))
 			{
-				actor->LightInfo.LightList.push_back(light);
+				actor->LightInfo.LightList.push_back(engine->Level->Actors.GetHandle(light));
 			}
 		}
 	}
@@ -184,8 +250,12 @@ vec3 RenderSubsystem::GetVertexLight(UActor* actor, const vec3& location, const
 
 		vec3 color = hsbtorgb(zoneActor->AmbientHue(), zoneActor->AmbientSaturation(), zoneActor->AmbientBrightness());
 
-		for (UActor* light : actor->LightInfo.LightList)
+		for (const ActorHandle& handle : actor->LightInfo.LightList)
 		{
+			UActor* light = engine->Level->Actors.Resolve(handle);
+			if (!light)
+				continue;
+
 			float attenuation = LightEffect::VertexLight(light, location, normal);
 			vec3 lightcolor = hsbtorgb(light->LightHue(), light->LightSaturation(), light->LightBrightness());
 			color += lightcolor * attenuation;
@@ -3,6 +3,150 @@
 #include "RenderSubsystem.h"
 #include "RenderDevice/RenderDevice.h"
 #include "Engine.h"
+#include "Lib/JobSystem.h"
+
+#ifndef NO_SSE
+#include <immintrin.h>
+#endif
+
+namespace
+{
+	struct MeshFrameBlend
+	{
+		const vec3* Frame0;
+		const vec3* Frame1;
+		const vec3* Frame2; // Only used if T1 isn't zero
+		float T0;
+		float T1;
+	};
+
+	// Blends the animation frames of count vertices and transforms them with a column major matrix.
+	// Positions get the translation column added and normals are normalized.
+	template<bool IsNormal>
+	void BlendMeshVertices(const MeshFrameBlend& blend, int count, const float* m, int stride, vec3* out)
+	{
+		static_assert(sizeof(vec3) == sizeof(float) * 3, "vec3 must be tightly packed");
+
+		int i = 0;
+#ifndef NO_SSE
+		// Four vertices are loaded as three registers and deinterleaved so each lane is one vertex
+		const __m128 m00 = _mm_set1_ps(m[0]), m01 = _mm_set1_ps(m[1]), m02 = _mm_set1_ps(m[2]);
+		const __m128 m10 = _mm_set1_ps(m[stride]), m11 = _mm_set1_ps(m[stride + 1]), m12 = _mm_set1_ps(m[stride + 2]);
+		const __m128 m20 = _mm_set1_ps(m[stride * 2]), m21 = _mm_set1_ps(m[stride * 2 + 1]), m22 = _mm_set1_ps(m[stride * 2 + 2]);
+		const __m128 m30 = IsNormal ? _mm_setzero_ps() : _mm_set1_ps(m[12]);
+		const __m128 m31 = IsNormal ? _mm_setzero_ps() : _mm_set1_ps(m[13]);
+		const __m128 m32 = IsNormal ? _mm_setzero_ps() : _mm_set1_ps(m[14]);
+		const __m128 s0 = _mm_set1_ps(1.0f - blend.T0), u0 = _mm_set1_ps(blend.T0);
+		const __m128 s1 = _mm_set1_ps(1.0f - blend.T1), u1 = _mm_set1_ps(blend.T1);
+
+		auto load = [](const vec3* src, __m128& x, __m128& y, __m128& z)
+		{
+			__m128 a = _mm_loadu_ps(&src->x); // x0 y0 z0 x1
+			__m128 b = _mm_loadu_ps(&src->x + 4); // y1 z1 x2 y2
+			__m128 c = _mm_loadu_ps(&src->x + 8); // z2 x3 y3 z3
+			__m128 t = _mm_shuffle_ps(b, c, _MM_SHUFFLE(1, 1, 2, 2));
+			x = _mm_shuffle_ps(a, t, _MM_SHUFFLE(2, 0, 3, 0));
+			y = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1)), _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 2, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0));
+			z = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2)), c, _MM_SHUFFLE(3, 0, 2, 0));
+		};
+
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128 x, y, z, x1, y1, z1;
+			load(blend.Frame0 + i, x, y, z);
+			load(blend.Frame1 + i, x1, y1, z1);
+			x = _mm_add_ps(_mm_mul_ps(x, s0), _mm_mul_ps(x1, u0));
+			y = _mm_add_ps(_mm_mul_ps(y, s0), _mm_mul_ps(y1, u0));
+			z = _mm_add_ps(_mm_mul_ps(z, s0), _mm_mul_ps(z1, u0));
+			if (blend.T1 != 0.0f)
+			{
+				load(blend.Frame2 + i, x1, y1, z1);
+				x = _mm_add_ps(_mm_mul_ps(x, s1), _mm_mul_ps(x1, u1));
+				y = _mm_add_ps(_mm_mul_ps(y, s1), _mm_mul_ps(y1, u1));
+				z = _mm_add_ps(_mm_mul_ps(z, s1), _mm_mul_ps(z1, u1));
+			}
+
+			__m128 rx = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(m00, x), _mm_mul_ps(m10, y)), _mm_mul_ps(m20, z)), m30);
+			__m128 ry = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(m01, x), _mm_mul_ps(m11, y)), _mm_mul_ps(m21, z)), m31);
+			__m128 rz = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(m02, x), _mm_mul_ps(m12, y)), _mm_mul_ps(m22, z)), m32);
+
+			if (IsNormal)
+			{
+				__m128 len = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(rx, rx), _mm_mul_ps(ry, ry)), _mm_mul_ps(rz, rz)));
+				rx = _mm_div_ps(rx, len);
+				ry = _mm_div_ps(ry, len);
+				rz = _mm_div_ps(rz, len);
+			}
+
+			float* dst = &out[i].x;
+			_mm_storeu_ps(dst, _mm_shuffle_ps(_mm_shuffle_ps(rx, ry, _MM_SHUFFLE(0, 0, 0, 0)), _mm_shuffle_ps(rz, rx, _MM_SHUFFLE(1, 1, 0, 0)), _MM_SHUFFLE(2, 0, 2, 0)));
+			_mm_storeu_ps(dst + 4, _mm_shuffle_ps(_mm_shuffle_ps(ry, rz, _MM_SHUFFLE(1, 1, 1, 1)), _mm_shuffle_ps(rx, ry, _MM_SHUFFLE(2, 2, 2, 2)), _MM_SHUFFLE(2, 0, 2, 0)));
+			_mm_storeu_ps(dst + 8, _mm_shuffle_ps(_mm_shuffle_ps(rz, rx, _MM_SHUFFLE(3, 3, 2, 2)), _mm_shuffle_ps(ry, rz, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0)));
+		}
+#endif
+
+		for (; i < count; i++)
+		{
+			vec3 v = mix(blend.Frame0[i], blend.Frame1[i], blend.T0);
+			if (blend.T1 != 0.0f)
+				v = mix(v, blend.Frame2[i], blend.T1);
+
+			vec3 r;
+			r.x = m[0] * v.x + m[stride] * v.y + m[stride * 2] * v.z;
+			r.y = m[1] * v.x + m[stride + 1] * v.y + m[stride * 2 + 1] * v.z;
+			r.z = m[2] * v.x + m[stride + 2] * v.y + m[stride * 2 + 2] * v.z;
+			if (IsNormal)
+			{
+				r = normalize(r);
+			}
+			else
+			{
+				r.x += m[12];
+				r.y += m[13];
+				r.z += m[14];
+			}
+			out[i] = r;
+		}
+	}
+
+	mat4 GetMeshToWorld(UActor* actor, UMesh* mesh)
+	{
+		mat4 objectToWorld = mat4::translate(actor->Location() + actor->PrePivot()) * Coords::Rotation(actor->Rotation()).ToMatrix() * mat4::scale(actor->DrawScale());
+		return objectToWorld * mesh->meshToObject;
+	}
+}
+
+void RenderSubsystem::PrepareActorMeshes()
+{
+	// Animating, transforming and lighting the vertices only reads the actor, its mesh, the light grid and the static world.
+	// That makes it safe to do for all visible LOD meshes on the worker threads. They are then drawn in the sorted order.
+	Mesh.PreparedActors.clear();
+	Mesh.NextPrepared = 0;
+	for (UActor* actor : Scene.Actors)
+	{
+		UMesh* mesh = actor->Mesh();
+		if ((EDrawType)actor->DrawType() == DT_Mesh && mesh && dynamic_cast<ULodMesh*>(mesh) && !dynamic_cast<USkeletalMesh*>(mesh))
+			Mesh.PreparedActors.push_back(actor);
+	}
+
+	if (Mesh.Prepared.size() < Mesh.PreparedActors.size())
+		Mesh.Prepared.resize(Mesh.PreparedActors.size());
+
+	JobSystem::ParallelFor(Mesh.PreparedActors.size(), 4, [&](size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; i++)
+			{
+				UActor* actor = Mesh.PreparedActors[i];
+				ULodMesh* mesh = static_cast<ULodMesh*>(actor->Mesh());
+
+				UpdateActorLightList(actor);
+
+				mat4 meshToWorld = GetMeshToWorld(actor, mesh);
+				mat3 meshNormalToWorld = mat3::transpose(mat3(meshToWorld));
+				PrepareLodMesh(actor, mesh, meshToWorld, meshNormalToWorld, Mesh.Prepared[i]);
+			}
+		});
+}
 
 void RenderSubsystem::DrawMesh(FSceneNode* frame, UActor* actor, bool wireframe)
 {
@@ -12,8 +156,7 @@ void RenderSubsystem::DrawMesh(FSceneNode* frame, UActor* actor, bool wireframe)
 
 	UpdateActorLightList(actor);
 
-	mat4 objectToWorld = mat4::translate(actor->Location() + actor->PrePivot()) * Coords::Rotation(actor->Rotation()).ToMatrix() * mat4::scale(actor->DrawScale());
-	mat4 meshToWorld = objectToWorld * mesh->meshToObject;
+	mat4 meshToWorld = GetMeshToWorld(actor, mesh);
 	mat3 meshNormalToWorld = mat3::transpose(mat3(meshToWorld));
 
 	if (dynamic_cast<USkeletalMesh*>(mesh))
@@ -139,6 +282,29 @@ void RenderSubsystem::DrawMesh(FSceneNode* frame, UActor* actor, UMesh* mesh, co
 
 void RenderSubsystem::DrawLodMesh(FSceneNode* frame, UActor* actor, ULodMesh* mesh, const mat4& ObjectToWorld, const mat3& ObjectNormalToWorld)
 {
+	const LodMeshVertices* verts;
+	if (Mesh.NextPrepared < Mesh.PreparedActors.size() && Mesh.PreparedActors[Mesh.NextPrepared] == actor)
+	{
+		verts = &Mesh.Prepared[Mesh.NextPrepared++];
+	}
+	else
+	{
+		PrepareLodMesh(actor, mesh, ObjectToWorld, ObjectNormalToWorld, Mesh.Vertices);
+		verts = &Mesh.Vertices;
+	}
+
+	if (!verts->Valid)
+		return;
+
+	SetupLodMeshTextures(actor, mesh);
+	DrawLodMeshFace(frame, actor, mesh, *verts, mesh->Faces, mesh->SpecialVerts);
+	DrawLodMeshFace(frame, actor, mesh, *verts, mesh->SpecialFaces, 0);
+}
+
+void RenderSubsystem::PrepareLodMesh(UActor* actor, ULodMesh* mesh, const mat4& ObjectToWorld, const mat3& ObjectNormalToWorld, LodMeshVertices& out)
+{
+	out.Valid = false;
+
 	MeshAnimSeq* seq = mesh->GetSequence(actor->AnimSequence());
 	float animFrame = actor->AnimFrame() * seq->NumFrames;
 
@@ -166,9 +332,40 @@ void RenderSubsystem::DrawLodMesh(FSceneNode* frame, UActor* actor, ULodMesh* me
 		vertexOffsets[2] = seq->StartFrame * mesh->FrameVerts;
 	}
 
-	SetupLodMeshTextures(actor, mesh);
-	DrawLodMeshFace(frame, actor, mesh, mesh->Faces, ObjectToWorld, ObjectNormalToWorld, mesh->SpecialVerts, vertexOffsets, t0, t1);
-	DrawLodMeshFace(frame, actor, mesh, mesh->SpecialFaces, ObjectToWorld, ObjectNormalToWorld, 0, vertexOffsets, t0, t1);
+	// Faces share their vertices with the neighbours, so all vertices of the frame are animated and transformed in one pass
+	size_t numVerts = mesh->FrameVerts;
+	for (int i = 0; i < (t1 != 0.0f ? 3 : 2); i++)
+	{
+		if (vertexOffsets[i] < 0 || (size_t)vertexOffsets[i] + numVerts > mesh->Verts.size() || (size_t)vertexOffsets[i] + numVerts > mesh->Normals.size())
+		{
+			// Out of bounds. Something is wrong with the mesh. Aborting render to prevent a crash.
+			return;
+		}
+	}
+
+	out.Positions.resize(numVerts);
+	out.Normals.resize(numVerts);
+	out.Lights.resize(numVerts);
+
+	MeshFrameBlend blend;
+	blend.T0 = t0;
+	blend.T1 = t1;
+	blend.Frame0 = mesh->Verts.data() + vertexOffsets[0];
+	blend.Frame1 = mesh->Verts.data() + vertexOffsets[1];
+	blend.Frame2 = mesh->Verts.data() + vertexOffsets[2];
+	BlendMeshVertices<false>(blend, (int)numVerts, ObjectToWorld.matrix, 4, out.Positions.data());
+
+	blend.Frame0 = mesh->Normals.data() + vertexOffsets[0];
+	blend.Frame1 = mesh->Normals.data() + vertexOffsets[1];
+	blend.Frame2 = mesh->Normals.data() + vertexOffsets[2];
+	BlendMeshVertices<true>(blend, (int)numVerts, ObjectNormalToWorld.matrix, 3, out.Normals.data());
+
+	// Lighting only depends on the vertex, so it is shared by all faces using it
+	bool unlit = actor->bUnlit() || actor->Region().ZoneNumber == 0;
+	for (size_t i = 0; i < numVerts; i++)
+		out.Lights[i] = GetVertexLight(actor, out.Positions[i], out.Normals[i], unlit);
+
+	out.Valid = true;
 }
 
 void RenderSubsystem::SetupMeshTextures(UActor* actor, UMesh* mesh)
@@ -291,7 +488,7 @@ void RenderSubsystem::SetupLodMeshTextures(UActor* actor, ULodMesh* mesh)
 	}
 }
 
-void RenderSubsystem::DrawLodMeshFace(FSceneNode* frame, UActor* actor, ULodMesh* mesh, const std::vector<MeshFace>& faces, const mat4& ObjectToWorld, const mat3& ObjectNormalToWorld, int baseVertexOffset, const int* vertexOffsets, float t0, float t1)
+void RenderSubsystem::DrawLodMeshFace(FSceneNode* frame, UActor* actor, ULodMesh* mesh, const LodMeshVertices& verts, const std::vector<MeshFace>& faces, int baseVertexOffset)
 {
 	uint32_t polyFlags = 0;
 	switch (actor->Style())
@@ -338,35 +535,22 @@ void RenderSubsystem::DrawLodMeshFace(FSceneNode* frame, UActor* actor, ULodMesh
 		float uscale = (texinfo.Texture ? texinfo.Texture->Mipmaps.front().Width : 256) * (1.0f / 255.0f);
 		float vscale = (texinfo.Texture ? texinfo.Texture->Mipmaps.front().Height : 256) * (1.0f / 255.0f);
 
+		size_t indices[3];
 		vec3 normals[3];
 		for (int i = 0; i < 3; i++)
 		{
 			const MeshWedge& wedge = mesh->Wedges[face.Indices[i]];
 
-			if ((size_t)wedge.Vertex + baseVertexOffset + vertexOffsets[0] >= mesh->Verts.size() ||
-				(size_t)wedge.Vertex + baseVertexOffset + vertexOffsets[1] >= mesh->Verts.size())
+			indices[i] = (size_t)wedge.Vertex + baseVertexOffset;
+			if (indices[i] >= verts.Positions.size())
 			{
 				// Out of bounds. Something is wrong with the mesh. Aborting render to prevent a crash.
 				return;
 			}
 
-			const vec3& v0 = mesh->Verts[(size_t)wedge.Vertex + baseVertexOffset + vertexOffsets[0]];
-			const vec3& v1 = mesh->Verts[(size_t)wedge.Vertex + baseVertexOffset + vertexOffsets[1]];
-			const vec3& n0 = mesh->Normals[(size_t)wedge.Vertex + baseVertexOffset + vertexOffsets[0]];
-			const vec3& n1 = mesh->Normals[(size_t)wedge.Vertex + baseVertexOffset + vertexOffsets[1]];
-			vec3 vertex = mix(v0, v1, t0);
-			vec3 normal = mix(n0, n1, t0);
-			if (t1 != 0.0f)
-			{
-				const vec3& v2 = mesh->Verts[(size_t)wedge.Vertex + baseVertexOffset + vertexOffsets[2]];
-				const vec3& n2 = mesh->Normals[(size_t)wedge.Vertex + baseVertexOffset + vertexOffsets[2]];
-				vertex = mix(vertex, v2, t1);
-				normal = mix(normal, n2, t1);
-			}
-
-			vertices[i].Point = (ObjectToWorld * vec4(vertex, 1.0f)).xyz();
+			vertices[i].Point = verts.Positions[indices[i]];
 			vertices[i].UV = { wedge.U * uscale, wedge.V * vscale };
-			normals[i] = normalize(ObjectNormalToWorld * normal);
+			normals[i] = verts.Normals[indices[i]];
 		}
 
 		if (renderflags & PF_Environment)
@@ -381,9 +565,7 @@ void RenderSubsystem::DrawLodMeshFace(FSceneNode* frame, UActor* actor, ULodMesh
 		}
 
 		for (int i = 0; i < 3; i++)
-		{
-			vertices[i].Light = GetVertexLight(actor, vertices[i].Point, normals[i], !!(polyFlags & PF_Unlit));
-		}
+			vertices[i].Light = verts.Lights[indices[i]];
 
 		Device->DrawGouraudPolygon(frame, texinfo, vertices, 3, renderflags);
 	}
@@ -5,8 +5,9 @@
 #include "Window/Window.h"
 #include "VM/ScriptCall.h"
 #include "Engine.h"
+#include "Lib/JobSystem.h"
+#include "Trace.h"
 
-#include <iostream>
 
 void RenderSubsystem::DrawScene()
 {
@@ -14,25 +15,40 @@ void RenderSubsystem::DrawScene()
 	Scene.Clipper.numSurfs = 0;
 	Scene.Clipper.numTris = 0;
 
-	// Make sure all actors are at the right location in the BSP
+	Light.Grid.Update();
+
+	// Make sure all actors that moved are at the right location in the BSP. Static actors are only placed once.
+	// The tree walks run on the worker threads. Linking the actors into the nodes is done here in actor order.
+	Scene.BspDirtyActors.clear();
 	for (UActor* actor : engine->Level->Actors)
 	{
-		if (actor)
-			actor->UpdateBspInfo();
+		if (actor && actor->IsBspDirty())
+			Scene.BspDirtyActors.push_back(actor);
 	}
 
-	// To do: use the zone specified in the surface with the PF_FakeBackdrop PolyFlags
-	UZoneInfo* skyZone = nullptr;
-	for (const auto& zone : engine->Level->Model->Zones)
-	{
-		UZoneInfo* zoneInfo = UObject::TryCast<UZoneInfo>(zone.ZoneActor);
-		if (zoneInfo && zoneInfo->SkyZone())
+	const auto& actors = Scene.BspDirtyActors;
+	Scene.BspPlacements.resize(actors.size());
+	JobSystem::ParallelFor(actors.size(), 64, [&](size_t begin, size_t end)
 		{
-			skyZone = zoneInfo->SkyZone();
-			break;
-		}
+			for (size_t i = begin; i < end; i++)
+			{
+				UActor* actor = actors[i];
+				ActorBspPlacement& placement = Scene.BspPlacements[i];
+				placement.Extents = actor->GetBspExtents();
+				placement.Moved = actor->NeedsBspUpdate(placement.Extents);
+				if (placement.Moved)
+					placement.Node = actor->FindBspNode(actor->Location(), placement.Extents);
+			}
+		});
+	for (size_t i = 0; i < actors.size(); i++)
+	{
+		const ActorBspPlacement& placement = Scene.BspPlacements[i];
+		if (placement.Moved)
+			actors[i]->SetBspNode(placement.Node, actors[i]->Location(), placement.Extents);
+		actors[i]->BspInfo.Dirty = false;
 	}
 
+	UZoneInfo* skyZone = FindSkyZone();
 	if (skyZone)
 	{
 		mat4 skyToView = Coords::ViewToRenderDev().ToMatrix() * Coords::Rotation(engine->CameraRotation).Inverse().ToMatrix() * Coords::Rotation(skyZone->Rotation()).ToMatrix() * Coords::Location(skyZone->Location()).ToMatrix();
@@ -47,20 +63,29 @@ void RenderSubsystem::DrawScene()
 
 void RenderSubsystem::DrawFrame(const vec3& location, const mat4& worldToView)
 {
-	std::cout << "DrawFrame location x: " << location.x << " y: " << location.y << " z: " << location.z << std::endl;
+	TRACE_SCOPE(TraceCategory::Render, "DrawFrame");
 
 	SetupSceneFrame(worldToView);
 	Scene.Clipper.Setup(Scene.Frame.Projection * Scene.Frame.WorldToView * Scene.Frame.ObjectToWorld);
 	Scene.ViewLocation = vec4(location, 1.0f);
 	Scene.ViewZone = FindZoneAt(location);
 	Scene.ViewZoneMask = Scene.ViewZone ? 1ULL << Scene.ViewZone : -1;
+	Scene.ViewZonePVS = (Scene.ViewZone && Scene.ViewZone < (int)Visibility.ZonePVS.size()) ? Visibility.ZonePVS[Scene.ViewZone] : -1;
 	Scene.ViewRotation = Coords::Rotation(engine->CameraRotation);
 	Scene.OpaqueNodes.clear();
 	Scene.TranslucentNodes.clear();
+	Scene.VisitedNodes.clear();
+	Scene.OccluderNodes.clear();
 	Scene.Actors.clear();
 	Scene.Coronas.clear(); // To do: don't do this - make them fade out instead if they don't get refreshed
 	Scene.FrameCounter++;
-	ProcessNode(&engine->Level->Model->Nodes[0]);
+	if (!RestoreCachedVisibility())
+	{
+		ProcessNode(&engine->Level->Model->Nodes[0]);
+		StoreCachedVisibility();
+	}
+
+	PrepareSurfaceLightmaps();
 
 	Device->SetSceneNode(&Scene.Frame);
 	for (const DrawNodeInfo& nodeInfo : Scene.OpaqueNodes)
@@ -81,6 +106,8 @@ void RenderSubsystem::DrawActors()
 		}
 	);
 
+	PrepareActorMeshes();
+
 	for (UActor* actor : Scene.Actors)
 	{
 		EDrawType dt = (EDrawType)actor->DrawType();
@@ -97,6 +124,7 @@ void RenderSubsystem::DrawActors()
 			DrawBrush(&Scene.Frame, actor);
 		}
 	}
+	Mesh.PreparedActors.clear();
 }
 
 void RenderSubsystem::DrawNodeSurface(const DrawNodeInfo& nodeInfo)
@@ -147,21 +175,14 @@ void RenderSubsystem::DrawNodeSurface(const DrawNodeInfo& nodeInfo)
 		UpdateTextureInfo(macrotex, surface, tex, ZoneUPanSpeed, ZoneVPanSpeed);
 	}
 
-	int numverts = node->NumVertices;
-	vec3* points = GetTempVertexBuffer(numverts);
-
-	BspVert* v = &model->Vertices[node->VertPool];
-	for (int j = 0; j < numverts; j++)
-	{
-		points[j] = model->Points[v[j].Vertex];
-	}
-
 	FSurfaceFacet facet;
 	facet.MapCoords.Origin = Base;
 	facet.MapCoords.XAxis = UVec;
 	facet.MapCoords.YAxis = VVec;
-	facet.Vertices = points;
-	facet.VertexCount = numverts;
+	facet.Vertices = const_cast<vec3*>(GetNodeVertices(node));
+	facet.VertexCount = node->NumVertices;
+	if (!Scene.StaticGeometry.SurfaceStart.empty())
+		facet.StaticSurface = (int)(node - model->Nodes.data());
 
 	FTextureInfo lightmap;
 	FTextureInfo fogmap;
@@ -185,6 +206,45 @@ void RenderSubsystem::DrawNodeSurface(const DrawNodeInfo& nodeInfo)
 	Device->DrawComplexSurface(&Scene.Frame, surfaceinfo, facet);
 }
 
+void RenderSubsystem::BuildStaticGeometry()
+{
+	// The polygons of every BSP node, in node order, so the renderer doesn't have to gather them each frame
+	UModel* model = engine->Level->Model;
+	FStaticGeometry& geometry = Scene.StaticGeometry;
+	geometry.Vertices.clear();
+	geometry.SurfaceStart.clear();
+	geometry.SurfaceStart.reserve(model->Nodes.size() + 1);
+	for (BspNode& node : model->Nodes)
+	{
+		geometry.SurfaceStart.push_back((uint32_t)geometry.Vertices.size());
+		BspVert* v = &model->Vertices[node.VertPool];
+		for (int j = 0; j < node.NumVertices; j++)
+		{
+			geometry.Vertices.push_back(model->Points[v[j].Vertex]);
+		}
+	}
+	geometry.SurfaceStart.push_back((uint32_t)geometry.Vertices.size());
+
+	Device->SetStaticGeometry(&geometry);
+}
+
+const vec3* RenderSubsystem::GetNodeVertices(BspNode* node)
+{
+	UModel* model = engine->Level->Model;
+	size_t index = node - model->Nodes.data();
+	if (index + 1 < Scene.StaticGeometry.SurfaceStart.size())
+		return Scene.StaticGeometry.Vertices.data() + Scene.StaticGeometry.SurfaceStart[index];
+
+	int numverts = node->NumVertices;
+	vec3* points = GetTempVertexBuffer(numverts);
+	BspVert* v = &model->Vertices[node->VertPool];
+	for (int j = 0; j < numverts; j++)
+	{
+		points[j] = model->Points[v[j].Vertex];
+	}
+	return points;
+}
+
 int RenderSubsystem::FindZoneAt(const vec3& location)
 {
 	return FindZoneAt(vec4(location, 1.0f), &engine->Level->Model->Nodes.front(), engine->Level->Model->Nodes.data());
@@ -224,6 +284,42 @@ void RenderSubsystem::ProcessNode(BspNode* node)
 		return;
 	}
 
+	Scene.VisitedNodes.push_back({ node, Scene.OccluderNodes.size() });
+	ProcessNodeActors(node);
+
+	// Decide which side the plane the camera is
+	vec4 plane = { node->PlaneX, node->PlaneY, node->PlaneZ, -node->PlaneW };
+	bool swapFrontAndBack = dot(Scene.ViewLocation, plane) < 0.0f;
+	int back = node->Back;
+	int front = node->Front;
+	if (swapFrontAndBack)
+		std::swap(front, back);
+
+	// Recursively divide front space (toward the viewer)
+	if (front >= 0)
+	{
+		ProcessNode(&engine->Level->Model->Nodes[front]);
+	}
+
+	// Draw surfaces on this plane
+	BspNode* polynode = node;
+	while (true)
+	{
+		ProcessNodeSurface(polynode);
+
+		if (polynode->Plane < 0) break;
+		polynode = &engine->Level->Model->Nodes[polynode->Plane];
+	}
+
+	// Possibly divide back space (away from the viewer)
+	if (back >= 0)
+	{
+		ProcessNode(&engine->Level->Model->Nodes[back]);
+	}
+}
+
+void RenderSubsystem::ProcessNodeActors(BspNode* node)
+{
 	// Add bsp node actors to the visible set
 	for (UActor* actor = node->ActorList; actor != nullptr; actor = actor->BspInfo.Next)
 	{
@@ -267,36 +363,6 @@ void RenderSubsystem::ProcessNode(BspNode* node)
 			}
 		}
 	}
-
-	// Decide which side the plane the camera is
-	vec4 plane = { node->PlaneX, node->PlaneY, node->PlaneZ, -node->PlaneW };
-	bool swapFrontAndBack = dot(Scene.ViewLocation, plane) < 0.0f;
-	int back = node->Back;
-	int front = node->Front;
-	if (swapFrontAndBack)
-		std::swap(front, back);
-
-	// Recursively divide front space (toward the viewer)
-	if (front >= 0)
-	{
-		ProcessNode(&engine->Level->Model->Nodes[front]);
-	}
-
-	// Draw surfaces on this plane
-	BspNode* polynode = node;
-	while (true)
-	{
-		ProcessNodeSurface(polynode);
-
-		if (polynode->Plane < 0) break;
-		polynode = &engine->Level->Model->Nodes[polynode->Plane];
-	}
-
-	// Possibly divide back space (away from the viewer)
-	if (back >= 0)
-	{
-		ProcessNode(&engine->Level->Model->Nodes[back]);
-	}
 }
 
 void RenderSubsystem::ProcessNodeSurface(BspNode* node)
@@ -308,12 +374,7 @@ void RenderSubsystem::ProcessNodeSurface(BspNode* node)
 	const BspSurface& surface = model->Surfaces[node->Surf];
 
 	int numverts = node->NumVertices;
-	vec3* points = GetTempVertexBuffer(numverts);
-	BspVert* v = &model->Vertices[node->VertPool];
-	for (int j = 0; j < numverts; j++)
-	{
-		points[j] = model->Points[v[j].Vertex];
-	}
+	const vec3* points = GetNodeVertices(node);
 
 	uint32_t PolyFlags = surface.PolyFlags;
 	UTexture* texture = surface.Material;
@@ -326,13 +387,17 @@ void RenderSubsystem::ProcessNodeSurface(BspNode* node)
 	if (!Scene.Clipper.CheckSurface(points, numverts, opaqueSurface))
 		return;
 
+	if (opaqueSurface)
+		Scene.OccluderNodes.push_back(node);
+
 	if (surface.Material)
 		PolyFlags |= surface.Material->PolyFlags();
 
+	// Zones outside the PVS can only be reached through portals that are hidden by something else
 	if (PolyFlags & PF_Portal)
 	{
-		Scene.ViewZoneMask |= 1ULL << node->Zone0;
-		Scene.ViewZoneMask |= 1ULL << node->Zone1;
+		Scene.ViewZoneMask |= (1ULL << node->Zone0) & Scene.ViewZonePVS;
+		Scene.ViewZoneMask |= (1ULL << node->Zone1) & Scene.ViewZonePVS;
 	}
 
 	if (PolyFlags & PF_FakeBackdrop)
@@ -6,6 +6,7 @@
 #include "UObject/USubsystem.h"
 #include "VM/ScriptCall.h"
 #include "Engine.h"
+#include "FrameProfiler.h"
 
 RenderSubsystem::RenderSubsystem(RenderDevice* renderdevice) : Device(renderdevice)
 {
@@ -13,6 +14,7 @@ RenderSubsystem::RenderSubsystem(RenderDevice* renderdevice) : Device(renderdevi
 
 void RenderSubsystem::DrawGame(float levelTimeElapsed)
 {
+	PROFILE_ZONE(ProfileZone::Render);
 	FrameCounter++;
 	LevelTimeElapsed = levelTimeElapsed;
 	AutoUV += levelTimeElapsed * 64.0f;
@@ -44,6 +46,7 @@ void RenderSubsystem::DrawGame(float levelTimeElapsed)
 
 	PostRender();
 
+	PROFILE_ZONE(ProfileZone::Present);
 	Device->Unlock(true);
 }
 
@@ -123,4 +126,8 @@ void RenderSubsystem::OnMapLoaded()
 		lightset.insert(light);
 	for (UActor* light : lightset)
 		Light.Lights.push_back(light);
+	Light.Grid.Build(Light.Lights);
+
+	BuildZoneVisibility();
+	BuildStaticGeometry();
 }
@@ -8,6 +8,8 @@
 #include "RenderDevice/RenderDevice.h"
 #include "BspClipper.h"
 #include "Lightmap/LightmapBuilder.h"
+#include "LightGrid.h"
+#include <unordered_map>
 
 class RenderDevice;
 
@@ -17,10 +19,81 @@ struct DrawNodeInfo
 	uint32_t PolyFlags;
 };
 
+struct VisitedNodeInfo
+{
+	BspNode* Node;
+	size_t Occluders; // Opaque surfaces clipped before the node's actors were culled
+};
+
+// Animated world space vertices of a LOD mesh with their lighting
+struct LodMeshVertices
+{
+	std::vector<vec3> Positions;
+	std::vector<vec3> Normals;
+	std::vector<vec3> Lights;
+	bool Valid = false;
+};
+
+struct ActorBspPlacement
+{
+	BspNode* Node;
+	vec3 Extents;
+	bool Moved;
+};
+
 struct LightmapTexture
 {
 	TextureFormat Format;
 	UnrealMipmap Mip;
+	TrackedMemory Memory;
+};
+
+// Glyph quads of a string, measured once and replayed every time the string is drawn
+struct TextLayoutGlyph
+{
+	float X; // Offset from the start of the line
+	float ClipRight; // Right edge of the character the glyph belongs to
+	float USize, VSize;
+	float StartU, StartV;
+	int Line;
+	int Index; // Character index in the line, for the extra spacing of DrawText
+	bool Underline; // Hotkey underline. These ignore the center offset.
+};
+
+struct TextLayoutPage
+{
+	FTextureInfo TexInfo;
+	std::vector<TextLayoutGlyph> Glyphs;
+};
+
+struct TextLayoutLine
+{
+	float Width = 0.0f;
+	float Height = 0.0f;
+	int Count = 0;
+};
+
+struct TextLayout
+{
+	ivec2 Size = ivec2(0);
+	std::vector<TextLayoutLine> Lines;
+	std::vector<TextLayoutPage> Pages;
+	std::vector<ivec2> CharExtents; // Right edge and height of each character, for GetTextClippedSize
+};
+
+enum class TextLayoutMode
+{
+	Lines, // DrawText: newlines start a new line
+	Flat, // Measuring: every character is a glyph
+	HotKeys // DrawTextClipped with checkHotKey: an ampersand underlines the next character
+};
+
+struct LightmapRequest
+{
+	uint64_t CacheID;
+	BspSurface* Surface;
+	UZoneInfo* ZoneActor;
+	std::unique_ptr<LightmapTexture> Texture;
 };
 
 class RenderSubsystem
@@ -46,6 +119,8 @@ public:
 
 	bool ShowTimedemoStats = false;
 	bool ShowRenderStats = false;
+	bool ShowMemoryStats = false;
+	bool ShowGCStats = false;
 	bool ShowCollisionDebug = false;
 
 private:
@@ -54,14 +129,24 @@ private:
 	int FindZoneAt(const vec3& location);
 	int FindZoneAt(const vec4& location, BspNode* node, BspNode* nodes);
 	void ProcessNode(BspNode* node);
+	void ProcessNodeActors(BspNode* node);
 	void ProcessNodeSurface(BspNode* node);
 	void DrawNodeSurface(const DrawNodeInfo& nodeInfo);
+	void BuildStaticGeometry();
+	const vec3* GetNodeVertices(BspNode* node);
 	void DrawActors();
 	void SetupSceneFrame(const mat4& worldToView);
 
+	void BuildZoneVisibility();
+	UZoneInfo* FindSkyZone();
+	bool RestoreCachedVisibility();
+	void StoreCachedVisibility();
+
 	FTextureInfo GetBrushLightmap(UActor* actor, const Poly& poly, UZoneInfo* zoneActor, UModel* model, const mat4& objectToWorld);
 	FTextureInfo GetSurfaceLightmap(BspSurface& surface, const FSurfaceFacet& facet, UZoneInfo* zoneActor, UModel* model);
-	std::unique_ptr<LightmapTexture> CreateLightmapTexture();
+	static uint64_t GetLightmapCacheID(UModel* model, int lightMap, UZoneInfo* zoneActor);
+	void PrepareSurfaceLightmaps();
+	std::unique_ptr<LightmapTexture> CreateLightmapTexture(const LightmapBuilder& builder);
 	void UpdateActorLightList(UActor* actor);
 	vec3 GetVertexLight(UActor* actor, const vec3& location, const vec3& normal, bool unlit);
 
@@ -75,13 +160,20 @@ private:
 	void RenderOverlays();
 	void PostRender();
 	void DrawTimedemoStats();
+	void DrawMemoryStats();
+	void DrawGCStats();
+	void DrawFrameStats();
 	void DrawCollisionDebug();
 	void DrawTile(FTextureInfo& texinfo, const Rectf& dest, const Rectf& src, const Rectf& clipBox, float Z, vec4 color, vec4 fog, uint32_t flags);
+	bool ClipTile(const Rectf& dest, const Rectf& src, const Rectf& clipBox, FTileRect& tile);
+	const TextLayout& GetTextLayout(UFont* font, const std::string& text, TextLayoutMode mode);
 
 	void DrawMesh(FSceneNode* frame, UActor* actor, bool wireframe = false);
 	void DrawMesh(FSceneNode* frame, UActor* actor, UMesh* mesh, const mat4& ObjectToWorld, const mat3& ObjectNormalToWorld);
 	void DrawLodMesh(FSceneNode* frame, UActor* actor, ULodMesh* mesh, const mat4& ObjectToWorld, const mat3& ObjectNormalToWorld);
-	void DrawLodMeshFace(FSceneNode* frame, UActor* actor, ULodMesh* mesh, const std::vector<MeshFace>& faces, const mat4& ObjectToWorld, const mat3& ObjectNormalToWorld, int baseVertexOffset, const int* vertexOffsets, float t0, float t1);
+	void DrawLodMeshFace(FSceneNode* frame, UActor* actor, ULodMesh* mesh, const LodMeshVertices& verts, const std::vector<MeshFace>& faces, int baseVertexOffset);
+	void PrepareLodMesh(UActor* actor, ULodMesh* mesh, const mat4& ObjectToWorld, const mat3& ObjectNormalToWorld, LodMeshVertices& out);
+	void PrepareActorMeshes();
 	void DrawSkeletalMesh(FSceneNode* frame, UActor* actor, USkeletalMesh* mesh, const mat4& ObjectToWorld, const mat3& ObjectNormalToWorld);
 	void SetupMeshTextures(UActor* actor, UMesh* mesh);
 	void SetupLodMeshTextures(UActor* actor, ULodMesh* mesh);
@@ -106,12 +198,25 @@ private:
 		int framesDrawn = 0;
 		uint64_t startFPSTime = 0;
 		FSceneNode Frame;
+
+		std::unordered_map<UFont*, std::unordered_map<std::string, TextLayout>> TextLayouts[3];
+		size_t TextLayoutCount = 0;
+		std::vector<FTileRect> Tiles;
+		std::vector<vec2> LineOrigins;
 	} Canvas;
 
 	struct
 	{
 		std::vector<UTexture*> textures;
 		UTexture* envmap = nullptr;
+
+		// Vertices of LOD meshes drawn outside DrawActors
+		LodMeshVertices Vertices;
+
+		// Vertices prepared by the worker threads for the visible LOD mesh actors, in draw order
+		std::vector<UActor*> PreparedActors;
+		std::vector<LodMeshVertices> Prepared;
+		size_t NextPrepared = 0;
 	} Mesh;
 
 	struct
@@ -122,22 +227,61 @@ private:
 		Coords ViewRotation;
 		int ViewZone = 0;
 		uint64_t ViewZoneMask = 0;
+		uint64_t ViewZonePVS = 0;
+		std::vector<VisitedNodeInfo> VisitedNodes;
+		std::vector<BspNode*> OccluderNodes;
 		std::vector<DrawNodeInfo> OpaqueNodes;
 		std::vector<DrawNodeInfo> TranslucentNodes;
 		std::vector<UActor*> Coronas;
 		std::vector<UActor*> Actors;
 		int FrameCounter = 0;
+		FStaticGeometry StaticGeometry;
+		std::vector<UActor*> BspDirtyActors;
+		std::vector<ActorBspPlacement> BspPlacements;
 	} Scene;
 
+	struct VisibilityCacheEntry
+	{
+		UModel* Model = nullptr;
+		mat4 WorldToView;
+		mat4 Projection;
+		int LastUsed = 0;
+		uint64_t ViewZoneMask = 0;
+		std::vector<VisitedNodeInfo> VisitedNodes;
+		std::vector<BspNode*> OccluderNodes;
+		std::vector<DrawNodeInfo> OpaqueNodes;
+		std::vector<DrawNodeInfo> TranslucentNodes;
+	};
+
+	struct
+	{
+		// Zones that can possibly be seen through the portals from each zone
+		std::vector<uint64_t> ZonePVS;
+		UZoneInfo* SkyZone = nullptr;
+
+		// Node traversal results for the last views drawn (the sky zone and the main view)
+		VisibilityCacheEntry Cache[2];
+		int CacheHits = 0;
+	} Visibility;
+
 	struct
 	{
 		std::map<uint64_t, std::unique_ptr<LightmapTexture>> lmtextures;
 		std::map<uint64_t, std::pair<int, std::unique_ptr<LightmapTexture>>> fogtextures;
 		std::vector<UActor*> Lights;
+		LightGrid Grid;
 		LightmapBuilder Builder;
+		std::vector<LightmapRequest> Requests;
 		int FogFrameCounter = 0;
 	} Light;
 
+	struct
+	{
+		// Solid white texture for the frame time graph
+		UnrealMipmap Mip;
+		FTextureInfo TexInfo;
+	} FrameStats;
+
 	std::vector<vec3> VertexBuffer;
 
 	vec3* GetTempVertexBuffer(size_t count)
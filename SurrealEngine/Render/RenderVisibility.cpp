@@ -0,0 +1,253 @@
+
+#include "Precomp.h"
+#include "RenderSubsystem.h"
+#include "Engine.h"
+#include <cstring>
+
+namespace
+{
+	struct ZonePortal
+	{
+		int Zone0 = 0; // Back side of the plane
+		int Zone1 = 0; // Front side of the plane
+		vec4 Plane;
+		std::vector<vec3> Points;
+	};
+
+	struct ZonePortalSet
+	{
+		std::vector<ZonePortal> Portals;
+		std::vector<std::vector<int>> ZonePortals;
+	};
+
+	struct PortalStep
+	{
+		int Portal;
+		vec4 Plane; // Facing into the zone the portal leads to
+	};
+
+	class ZonePortalFlow
+	{
+	public:
+		ZonePortalFlow(const ZonePortalSet& set, int budget) : Set(set), Budget(budget) { }
+
+		uint64_t Run(int zone)
+		{
+			Visible = 0;
+			Path.clear();
+			Visit(zone);
+			return Visible;
+		}
+
+		bool Overflow() const { return Budget < 0; }
+
+	private:
+		void Visit(int zone)
+		{
+			Visible |= 1ULL << zone;
+			if (--Budget < 0)
+				return;
+
+			for (int index : Set.ZonePortals[zone])
+			{
+				const ZonePortal& portal = Set.Portals[index];
+
+				bool inPath = false;
+				for (const PortalStep& step : Path)
+					inPath = inPath || step.Portal == index;
+				if (inPath)
+					continue;
+
+				int target = (portal.Zone0 == zone) ? portal.Zone1 : portal.Zone0;
+				vec4 plane = (portal.Zone0 == zone) ? portal.Plane : -portal.Plane;
+
+				// A sight line through every portal on the path must cross them in order. That means the new portal must
+				// reach in front of all the earlier portals and the earlier ones must reach behind the new one.
+				bool passable = true;
+				for (const PortalStep& step : Path)
+				{
+					if (!HasPointInFront(portal.Points, step.Plane) || !HasPointInFront(Set.Portals[step.Portal].Points, -plane))
+					{
+						passable = false;
+						break;
+					}
+				}
+				if (!passable)
+					continue;
+
+				Path.push_back({ index, plane });
+				Visit(target);
+				Path.pop_back();
+
+				if (Budget < 0)
+					return;
+			}
+		}
+
+		static bool HasPointInFront(const std::vector<vec3>& points, const vec4& plane)
+		{
+			const float epsilon = 1.0f;
+			for (const vec3& p : points)
+			{
+				if (dot(vec4(p, 1.0f), plane) > -epsilon)
+					return true;
+			}
+			return false;
+		}
+
+		const ZonePortalSet& Set;
+		int Budget;
+		uint64_t Visible = 0;
+		std::vector<PortalStep> Path;
+	};
+}
+
+void RenderSubsystem::BuildZoneVisibility()
+{
+	UModel* model = engine->Level->Model;
+	int numZones = std::min((int)model->Zones.size(), 64);
+
+	// Gather the portal polygons. The BSP splits a portal into many nodes, so the fragments are merged back together per surface.
+	ZonePortalSet set;
+	set.ZonePortals.resize(numZones);
+	std::map<std::pair<int, int>, int> portalIndex;
+	for (BspNode& node : model->Nodes)
+	{
+		if (node.NumVertices <= 0 || node.Surf < 0 || node.Zone0 == node.Zone1 || node.Zone0 >= numZones || node.Zone1 >= numZones)
+			continue;
+
+		const BspSurface& surface = model->Surfaces[node.Surf];
+		uint32_t PolyFlags = surface.PolyFlags;
+		if (surface.Material)
+			PolyFlags |= surface.Material->PolyFlags();
+		if ((PolyFlags & PF_Portal) == 0)
+			continue;
+
+		auto key = std::make_pair(node.Surf, node.Zone0 * 64 + node.Zone1);
+		auto it = portalIndex.find(key);
+		if (it == portalIndex.end())
+		{
+			it = portalIndex.insert({ key, (int)set.Portals.size() }).first;
+
+			ZonePortal portal;
+			portal.Zone0 = node.Zone0;
+			portal.Zone1 = node.Zone1;
+			portal.Plane = { node.PlaneX, node.PlaneY, node.PlaneZ, -node.PlaneW };
+			set.Portals.push_back(std::move(portal));
+			set.ZonePortals[node.Zone0].push_back(it->second);
+			set.ZonePortals[node.Zone1].push_back(it->second);
+		}
+
+		ZonePortal& portal = set.Portals[it->second];
+		BspVert* v = &model->Vertices[node.VertPool];
+		for (int i = 0; i < node.NumVertices; i++)
+			portal.Points.push_back(model->Points[v[i].Vertex]);
+	}
+
+	// Walk the portal chains from every zone. Levels with many portals can explode combinatorially,
+	// so zones that run out of budget fall back to everything connected to them.
+	Visibility.ZonePVS.assign(numZones, ~0ULL);
+	for (int zone = 0; zone < numZones; zone++)
+	{
+		ZonePortalFlow flow(set, 20000);
+		uint64_t visible = flow.Run(zone);
+		if (flow.Overflow())
+		{
+			visible = 1ULL << zone;
+			std::vector<int> stack = { zone };
+			while (!stack.empty())
+			{
+				int current = stack.back();
+				stack.pop_back();
+				for (int index : set.ZonePortals[current])
+				{
+					const ZonePortal& portal = set.Portals[index];
+					int target = (portal.Zone0 == current) ? portal.Zone1 : portal.Zone0;
+					if ((visible & (1ULL << target)) == 0)
+					{
+						visible |= 1ULL << target;
+						stack.push_back(target);
+					}
+				}
+			}
+		}
+		Visibility.ZonePVS[zone] = visible;
+	}
+
+	Visibility.SkyZone = nullptr;
+	for (VisibilityCacheEntry& entry : Visibility.Cache)
+		entry = {};
+}
+
+UZoneInfo* RenderSubsystem::FindSkyZone()
+{
+	// SkyZoneInfo actors attach themselves to the zones in BeginPlay, so keep looking until one shows up
+	// To do: use the zone specified in the surface with the PF_FakeBackdrop PolyFlags
+	if (!Visibility.SkyZone)
+	{
+		for (const auto& zone : engine->Level->Model->Zones)
+		{
+			UZoneInfo* zoneInfo = UObject::TryCast<UZoneInfo>(zone.ZoneActor);
+			if (zoneInfo && zoneInfo->SkyZone())
+			{
+				Visibility.SkyZone = zoneInfo->SkyZone();
+				break;
+			}
+		}
+	}
+	return Visibility.SkyZone;
+}
+
+bool RenderSubsystem::RestoreCachedVisibility()
+{
+	// The node traversal only depends on the view and the static level geometry.
+	// An unchanged view gives the same nodes and surfaces, so only the actors have to be gathered again.
+	// The actors of a node were culled against the surfaces clipped before it, so those are clipped again
+	// in the same order first. This skips the node bounds tests and the surfaces that hide nothing.
+	UModel* model = engine->Level->Model;
+	for (VisibilityCacheEntry& entry : Visibility.Cache)
+	{
+		if (entry.Model == model &&
+			std::memcmp(entry.WorldToView.matrix, Scene.Frame.WorldToView.matrix, sizeof(mat4)) == 0 &&
+			std::memcmp(entry.Projection.matrix, Scene.Frame.Projection.matrix, sizeof(mat4)) == 0)
+		{
+			entry.LastUsed = FrameCounter;
+			Scene.ViewZoneMask = entry.ViewZoneMask;
+			Scene.OpaqueNodes = entry.OpaqueNodes;
+			Scene.TranslucentNodes = entry.TranslucentNodes;
+			size_t occluders = 0;
+			for (const VisitedNodeInfo& visited : entry.VisitedNodes)
+			{
+				for (; occluders < visited.Occluders; occluders++)
+				{
+					BspNode* node = entry.OccluderNodes[occluders];
+					Scene.Clipper.CheckSurface(GetNodeVertices(node), node->NumVertices, true);
+				}
+				ProcessNodeActors(visited.Node);
+			}
+			Visibility.CacheHits++;
+			return true;
+		}
+	}
+	return false;
+}
+
+void RenderSubsystem::StoreCachedVisibility()
+{
+	VisibilityCacheEntry* entry = &Visibility.Cache[0];
+	for (VisibilityCacheEntry& e : Visibility.Cache)
+	{
+		if (e.LastUsed < entry->LastUsed)
+			entry = &e;
+	}
+
+	entry->Model = engine->Level->Model;
+	entry->WorldToView = Scene.Frame.WorldToView;
+	entry->Projection = Scene.Frame.Projection;
+	entry->LastUsed = FrameCounter;
+	entry->ViewZoneMask = Scene.ViewZoneMask;
+	entry->VisitedNodes = Scene.VisitedNodes;
+	entry->OccluderNodes = Scene.OccluderNodes;
+	entry->OpaqueNodes = Scene.OpaqueNodes;
+	entry->TranslucentNodes = Scene.TranslucentNodes;
+}
@@ -13,4 +13,20 @@ public:
 	GLVertexArray* va;
 	GLIndexBuffer* ib;
 	GLShader* shader;
-};
\ No newline at end of file
+};
+
+// Render state shared by every triangle in a draw batch. Consecutive draws with the same state are merged into one glDrawArrays call.
+struct GLDrawBatchState
+{
+	GLShader* Shader = nullptr;
+	GLuint Texture = 0;
+	uint32_t BlendFlags = 0; // PF_Translucent and PF_Modulated
+	bool DepthTest = true;
+	bool ScreenSpace = false; // Viewport covers the whole framebuffer instead of the scene node
+
+	bool operator==(const GLDrawBatchState& other) const
+	{
+		return Shader == other.Shader && Texture == other.Texture && BlendFlags == other.BlendFlags && DepthTest == other.DepthTest && ScreenSpace == other.ScreenSpace;
+	}
+	bool operator!=(const GLDrawBatchState& other) const { return !(*this == other); }
+};
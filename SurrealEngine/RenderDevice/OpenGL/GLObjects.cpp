@@ -144,6 +144,47 @@ void GLIndexBuffer::LoadIndicesData(const std::vector<unsigned int>& indices)
 
 //=================================================
 
+GLStreamVertexBuffer::GLStreamVertexBuffer(size_t capacity) : capacity(capacity)
+{
+	glGenBuffers(1, &vertexBufferID);
+	Bind();
+	glBufferData(GL_ARRAY_BUFFER, capacity, nullptr, GL_STREAM_DRAW);
+}
+
+GLStreamVertexBuffer::~GLStreamVertexBuffer()
+{
+	glDeleteBuffers(1, &vertexBufferID);
+}
+
+void GLStreamVertexBuffer::Bind()
+{
+	glBindBuffer(GL_ARRAY_BUFFER, vertexBufferID);
+}
+
+void GLStreamVertexBuffer::Unbind()
+{
+	glBindBuffer(GL_ARRAY_BUFFER, NULL);
+}
+
+size_t GLStreamVertexBuffer::Upload(const void* data, size_t size, size_t alignment)
+{
+	Bind();
+
+	size_t offset = (writePos + alignment - 1) / alignment * alignment;
+	if (offset + size > capacity)
+	{
+		// Orphan the old storage. Draws still in flight keep reading from it.
+		glBufferData(GL_ARRAY_BUFFER, capacity, nullptr, GL_STREAM_DRAW);
+		offset = 0;
+	}
+
+	glBufferSubData(GL_ARRAY_BUFFER, offset, size, data);
+	writePos = offset + size;
+	return offset;
+}
+
+//=================================================
+
 GLFrameBuffer::GLFrameBuffer(OpenGLRenderDevice* renderDevice) : renderDevice(renderDevice)
 {
 	glGenFramebuffers(1, &FramebufferID);
@@ -58,6 +58,30 @@ private:
 	std::vector<unsigned int> indices;
 };
 
+// Vertex buffer that is written to once per draw batch and used as a ring.
+// WebGL has no buffer mapping, so each batch is uploaded with glBufferSubData into the next free range.
+// When the end is reached the storage is orphaned, letting the driver hand out fresh memory instead of
+// waiting for the GPU to finish reading the previous frame's batches.
+class GLStreamVertexBuffer
+{
+public:
+	GLStreamVertexBuffer(size_t capacity);
+	~GLStreamVertexBuffer();
+
+	void Bind();
+	void Unbind();
+
+	// Copies the data into the buffer and returns the byte offset it was placed at
+	size_t Upload(const void* data, size_t size, size_t alignment);
+
+	size_t GetCapacity() const { return capacity; }
+
+private:
+	GLuint vertexBufferID;
+	size_t capacity;
+	size_t writePos = 0;
+};
+
 class GLFrameBuffer
 {
 public:
@@ -1,4 +1,5 @@
 #include "GLShader.h"
+#include "Trace.h"
 
 #include <stdexcept>
 #include <iostream>
@@ -29,17 +30,13 @@ void GLShader::Compile(
 		int debug_index
 	)
 {
-	std::cout << "GLShader::Compile " << debug_index << std::endl;
+	TRACE_SCOPE(TraceCategory::RenderDevice, "CompileShader");
 	GLuint VertexShaderID, FragmentShaderID, GeometryShaderID;
 
-	std::cout << "69GLShader::Compile " << debug_index << std::endl;
 	VertexShaderID = glCreateShader(GL_VERTEX_SHADER);
-	std::cout << "1GLShader::Compile " << debug_index << std::endl;
 	auto vc = vertexCode.c_str();
 	glShaderSource(VertexShaderID, 1, &vc, NULL);
-	std::cout << "2GLShader::Compile " << debug_index << std::endl;
 	glCompileShader(VertexShaderID);
-	std::cout << "3GLShader::Compile " << debug_index << std::endl;
 	CheckCompileErrors(VertexShaderID, "Vertex", 1);
 
 	FragmentShaderID = glCreateShader(GL_FRAGMENT_SHADER);
@@ -64,6 +61,11 @@ void GLShader::Compile(
 	glLinkProgram(ProgramID);
 	CheckLinkErrors();
 
+	VertexLocation = glGetAttribLocation(ProgramID, "vertex");
+	UVLocation = glGetAttribLocation(ProgramID, "uvIn");
+	TextureLocation = glGetUniformLocation(ProgramID, "texture");
+	ObjectToProjectionLocation = glGetUniformLocation(ProgramID, "objectToProjectionMatrix");
+
 	// Shaders can be freely deleted now
 	glDeleteShader(VertexShaderID);
 	glDeleteShader(FragmentShaderID);
@@ -93,8 +95,6 @@ void GLShader::SetUniformSampler2D(const std::string& uniformName, const int GLT
 
 void GLShader::CheckCompileErrors(GLuint Object, const std::string ObjectType, int debug_index) const
 {
-	std::cout << "CheckCompileErrors Debug Index: " << debug_index << std::endl;
-
 	GLint success;
 	GLchar infoLog[1024];
 
@@ -107,9 +107,6 @@ void GLShader::CheckCompileErrors(GLuint Object, const std::string ObjectType, i
 
 		throw std::runtime_error("Error while compiling " + ObjectType + " shader: " + infoLog);
 	}
-	else {
-		std::cout << "Success shader compile" << std::endl;
-	}
 }
 
 void GLShader::CheckLinkErrors() const
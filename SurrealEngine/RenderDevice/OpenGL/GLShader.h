@@ -29,6 +29,12 @@ public:
 	void SetUniformSampler2D(const std::string& uniformName, const int GLTextureSlot);
 
 	GLuint ProgramID;
+
+	// Locations looked up once after linking. -1 if the shader doesn't use them.
+	GLint VertexLocation = -1;
+	GLint UVLocation = -1;
+	GLint TextureLocation = -1;
+	GLint ObjectToProjectionLocation = -1;
 	
 private:
 	void CheckCompileErrors(GLuint Object, const std::string ObjectType, int debug_index) const;
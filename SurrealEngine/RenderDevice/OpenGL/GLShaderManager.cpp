@@ -1,9 +1,8 @@
 #include "GLShaderManager.h"
 
-#include <iostream>
-
 #include "Shaders/GLDrawTileShaders.h"
 #include "Shaders/GLDraw3DShaders.h"
+#include "Trace.h"
 
 GLShaderManager::GLShaderManager()
 {
@@ -23,7 +22,7 @@ void GLShaderManager::LoadShaderCode(
 	int debug_index
 )
 {
-	std::cout << "LoadShaderCode " << debug_index << std::endl;
+	TRACE_EVENT_TEXT(TraceCategory::RenderDevice, "LoadShaderCode", std::to_string(debug_index));
 
 	auto shader = new GLShader();
 	shader->Compile(vertexShaderCode, fragmentShaderCode, "", 0);
@@ -0,0 +1,406 @@
+#include "GLTextureUploader.h"
+
+#include "UObject/UTexture.h"
+
+#include <map>
+#include <memory>
+#include <cstring>
+
+GLTextureUploader* GLTextureUploader::GetUploader(TextureFormat format)
+{
+	static std::map<TextureFormat, std::unique_ptr<GLTextureUploader>> Uploaders;
+	if (Uploaders.empty())
+	{
+		// Original.
+		Uploaders[TextureFormat::P8].reset(new GLTextureUploader_P8());
+		Uploaders[TextureFormat::BGRA8_LM].reset(new GLTextureUploader_BGRA8_LM());
+		Uploaders[TextureFormat::R5G6B5].reset(new GLTextureUploader_R5G6B5());
+		Uploaders[TextureFormat::RGB8].reset(new GLTextureUploader_RGB8());
+		Uploaders[TextureFormat::BGRA8].reset(new GLTextureUploader_BGRA8());
+
+		// S3TC is an extension on every GL version and frequently missing in WebGL
+		if (GLEW_EXT_texture_compression_s3tc)
+		{
+			Uploaders[TextureFormat::BC1].reset(new GLTextureUploader_4x4Block(GL_COMPRESSED_RGBA_S3TC_DXT1_EXT, 8));
+			Uploaders[TextureFormat::BC1_PA].reset(new GLTextureUploader_4x4Block(GL_COMPRESSED_RGBA_S3TC_DXT1_EXT, 8));
+			Uploaders[TextureFormat::BC2].reset(new GLTextureUploader_4x4Block(GL_COMPRESSED_RGBA_S3TC_DXT3_EXT, 16));
+			Uploaders[TextureFormat::BC3].reset(new GLTextureUploader_4x4Block(GL_COMPRESSED_RGBA_S3TC_DXT5_EXT, 16));
+		}
+		else
+		{
+			Uploaders[TextureFormat::BC1].reset(new GLTextureUploader_BCDecode(TextureFormat::BC1));
+			Uploaders[TextureFormat::BC1_PA].reset(new GLTextureUploader_BCDecode(TextureFormat::BC1_PA));
+			Uploaders[TextureFormat::BC2].reset(new GLTextureUploader_BCDecode(TextureFormat::BC2));
+			Uploaders[TextureFormat::BC3].reset(new GLTextureUploader_BCDecode(TextureFormat::BC3));
+		}
+
+		// RGTC is not available in WebGL 2, always decode those.
+		Uploaders[TextureFormat::BC4].reset(new GLTextureUploader_BCDecode(TextureFormat::BC4));
+		Uploaders[TextureFormat::BC5].reset(new GLTextureUploader_BCDecode(TextureFormat::BC5));
+
+		// Normalized RGBA.
+		Uploaders[TextureFormat::R8].reset(new GLTextureUploader_R8());
+		Uploaders[TextureFormat::RG8].reset(new GLTextureUploader_RG8());
+		Uploaders[TextureFormat::RGBA8_].reset(new GLTextureUploader_RGBA8_());
+		Uploaders[TextureFormat::RGBA16].reset(new GLTextureUploader_RGBA16());
+	}
+
+	auto it = Uploaders.find(format);
+	if (it != Uploaders.end())
+		return it->second.get();
+	else
+		return nullptr;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void GLTextureUploader_P8::UploadRect(void* d, UnrealMipmap* mip, int x, int y, int w, int h, FColor* palette, bool masked)
+{
+	int pitch = mip->Width;
+	uint8_t* src = mip->Data.data() + x + y * pitch;
+	FColor* Ptr = (FColor*)d;
+	if (masked)
+	{
+		FColor translucent(0, 0, 0, 0);
+		for (int i = 0; i < h; i++)
+		{
+			for (int j = 0; j < w; j++)
+			{
+				int idx = src[j];
+				*Ptr++ = (idx != 0) ? palette[idx] : translucent;
+			}
+			src += pitch;
+		}
+	}
+	else
+	{
+		for (int i = 0; i < h; i++)
+		{
+			for (int j = 0; j < w; j++)
+			{
+				int idx = src[j];
+				*Ptr++ = palette[idx];
+			}
+			src += pitch;
+		}
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void GLTextureUploader_BGRA8_LM::UploadRect(void* dst, UnrealMipmap* mip, int x, int y, int w, int h, FColor* palette, bool masked)
+{
+	int pitch = mip->Width;
+	FColor* src = ((FColor*)mip->Data.data()) + x + y * pitch;
+	auto Ptr = (FColor*)dst;
+	for (int i = 0; i < h; i++)
+	{
+		for (int j = 0; j < w; j++)
+		{
+			FColor Src = src[j];
+			Ptr->R = Src.B << 1;
+			Ptr->G = Src.G << 1;
+			Ptr->B = Src.R << 1;
+			Ptr->A = Src.A << 1;
+			Ptr++;
+		}
+		src += pitch;
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void GLTextureUploader_BGRA8::UploadRect(void* dst, UnrealMipmap* mip, int x, int y, int w, int h, FColor* palette, bool masked)
+{
+	int pitch = mip->Width;
+	FColor* src = ((FColor*)mip->Data.data()) + x + y * pitch;
+	auto Ptr = (FColor*)dst;
+	for (int i = 0; i < h; i++)
+	{
+		for (int j = 0; j < w; j++)
+		{
+			FColor Src = src[j];
+			Ptr->R = Src.B;
+			Ptr->G = Src.G;
+			Ptr->B = Src.R;
+			Ptr->A = Src.A;
+			Ptr++;
+		}
+		src += pitch;
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void GLTextureUploader_RGBA8_::UploadRect(void* d, UnrealMipmap* mip, int x, int y, int w, int h, FColor* palette, bool masked)
+{
+	int pitch = mip->Width * 4;
+	int size = w * 4;
+	uint8_t* src = mip->Data.data() + x * 4 + y * pitch;
+	uint8_t* dst = (uint8_t*)d;
+	for (int i = 0; i < h; i++)
+	{
+		memcpy(dst, src, size);
+		dst += size;
+		src += pitch;
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void GLTextureUploader_RGB8::UploadRect(void* dst, UnrealMipmap* mip, int x, int y, int w, int h, FColor* palette, bool masked)
+{
+	int pitch = mip->Width * 3;
+	uint8_t* src = mip->Data.data() + x * 3 + y * pitch;
+	auto Ptr = (FColor*)dst;
+	for (int i = 0; i < h; i++)
+	{
+		for (int j = 0; j < w; j++)
+		{
+			*Ptr++ = FColor(src[j * 3], src[j * 3 + 1], src[j * 3 + 2], 255);
+		}
+		src += pitch;
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void GLTextureUploader_R5G6B5::UploadRect(void* dst, UnrealMipmap* mip, int x, int y, int w, int h, FColor* palette, bool masked)
+{
+	int pitch = mip->Width;
+	uint16_t* src = ((uint16_t*)mip->Data.data()) + x + y * pitch;
+	auto Ptr = (FColor*)dst;
+	for (int i = 0; i < h; i++)
+	{
+		for (int j = 0; j < w; j++)
+		{
+			uint32_t c = src[j];
+			uint32_t r = (c >> 11) & 0x1f;
+			uint32_t g = (c >> 5) & 0x3f;
+			uint32_t b = c & 0x1f;
+			*Ptr++ = FColor((r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2), 255);
+		}
+		src += pitch;
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void GLTextureUploader_R8::UploadRect(void* dst, UnrealMipmap* mip, int x, int y, int w, int h, FColor* palette, bool masked)
+{
+	int pitch = mip->Width;
+	uint8_t* src = mip->Data.data() + x + y * pitch;
+	auto Ptr = (FColor*)dst;
+	for (int i = 0; i < h; i++)
+	{
+		for (int j = 0; j < w; j++)
+		{
+			*Ptr++ = FColor(src[j], 0, 0, 255);
+		}
+		src += pitch;
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void GLTextureUploader_RG8::UploadRect(void* dst, UnrealMipmap* mip, int x, int y, int w, int h, FColor* palette, bool masked)
+{
+	int pitch = mip->Width * 2;
+	uint8_t* src = mip->Data.data() + x * 2 + y * pitch;
+	auto Ptr = (FColor*)dst;
+	for (int i = 0; i < h; i++)
+	{
+		for (int j = 0; j < w; j++)
+		{
+			*Ptr++ = FColor(src[j * 2], src[j * 2 + 1], 0, 255);
+		}
+		src += pitch;
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void GLTextureUploader_RGBA16::UploadRect(void* dst, UnrealMipmap* mip, int x, int y, int w, int h, FColor* palette, bool masked)
+{
+	int pitch = mip->Width * 4;
+	uint16_t* src = ((uint16_t*)mip->Data.data()) + x * 4 + y * pitch;
+	auto Ptr = (FColor*)dst;
+	for (int i = 0; i < h; i++)
+	{
+		for (int j = 0; j < w; j++)
+		{
+			*Ptr++ = FColor(src[j * 4] >> 8, src[j * 4 + 1] >> 8, src[j * 4 + 2] >> 8, src[j * 4 + 3] >> 8);
+		}
+		src += pitch;
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+int GLTextureUploader_4x4Block::GetUploadSize(int x, int y, int w, int h)
+{
+	int x0 = x / 4;
+	int y0 = y / 4;
+	int x1 = (x + w + 3) / 4;
+	int y1 = (y + h + 3) / 4;
+	return (x1 - x0) * (y1 - y0) * BytesPerBlock;
+}
+
+void GLTextureUploader_4x4Block::UploadRect(void* d, UnrealMipmap* mip, int x, int y, int w, int h, FColor* palette, bool masked)
+{
+	int x0 = x / 4;
+	int y0 = y / 4;
+	int x1 = (x + w + 3) / 4;
+	int y1 = (y + h + 3) / 4;
+
+	int pitch = (mip->Width + 3) / 4 * BytesPerBlock;
+	int size = (x1 - x0) * BytesPerBlock;
+	uint8_t* src = mip->Data.data() + x0 * BytesPerBlock + y0 * pitch;
+	uint8_t* dst = (uint8_t*)d;
+	for (int i = y0; i < y1; i++)
+	{
+		memcpy(dst, src, size);
+		dst += size;
+		src += pitch;
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+static void DecodeColorBlock(const uint8_t* src, FColor* pixels, bool allowPunchThrough)
+{
+	uint32_t c0 = src[0] | (src[1] << 8);
+	uint32_t c1 = src[2] | (src[3] << 8);
+	uint32_t indices = src[4] | (src[5] << 8) | (src[6] << 16) | ((uint32_t)src[7] << 24);
+
+	FColor colors[4];
+	for (int i = 0; i < 2; i++)
+	{
+		uint32_t c = i == 0 ? c0 : c1;
+		uint32_t r = (c >> 11) & 0x1f;
+		uint32_t g = (c >> 5) & 0x3f;
+		uint32_t b = c & 0x1f;
+		colors[i] = FColor((r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2), 255);
+	}
+
+	if (c0 > c1 || !allowPunchThrough)
+	{
+		colors[2] = FColor((2 * colors[0].R + colors[1].R) / 3, (2 * colors[0].G + colors[1].G) / 3, (2 * colors[0].B + colors[1].B) / 3, 255);
+		colors[3] = FColor((colors[0].R + 2 * colors[1].R) / 3, (colors[0].G + 2 * colors[1].G) / 3, (colors[0].B + 2 * colors[1].B) / 3, 255);
+	}
+	else
+	{
+		colors[2] = FColor((colors[0].R + colors[1].R) / 2, (colors[0].G + colors[1].G) / 2, (colors[0].B + colors[1].B) / 2, 255);
+		colors[3] = FColor(0, 0, 0, 0);
+	}
+
+	for (int i = 0; i < 16; i++)
+	{
+		pixels[i] = colors[(indices >> (i * 2)) & 3];
+	}
+}
+
+static void DecodeAlphaBlock(const uint8_t* src, uint8_t* values, int stride)
+{
+	uint32_t a0 = src[0];
+	uint32_t a1 = src[1];
+
+	uint8_t alphas[8];
+	alphas[0] = a0;
+	alphas[1] = a1;
+	if (a0 > a1)
+	{
+		for (int i = 1; i < 7; i++)
+			alphas[i + 1] = ((7 - i) * a0 + i * a1) / 7;
+	}
+	else
+	{
+		for (int i = 1; i < 5; i++)
+			alphas[i + 1] = ((5 - i) * a0 + i * a1) / 5;
+		alphas[6] = 0;
+		alphas[7] = 255;
+	}
+
+	uint64_t indices = 0;
+	for (int i = 0; i < 6; i++)
+		indices |= (uint64_t)src[2 + i] << (i * 8);
+
+	for (int i = 0; i < 16; i++)
+	{
+		values[i * stride] = alphas[(indices >> (i * 3)) & 7];
+	}
+}
+
+GLTextureUploader_BCDecode::GLTextureUploader_BCDecode(TextureFormat format) : SourceFormat(format)
+{
+	BytesPerBlock = (format == TextureFormat::BC1 || format == TextureFormat::BC1_PA || format == TextureFormat::BC4) ? 8 : 16;
+}
+
+void GLTextureUploader_BCDecode::DecodeBlock(const uint8_t* src, FColor* pixels)
+{
+	switch (SourceFormat)
+	{
+	case TextureFormat::BC1:
+	case TextureFormat::BC1_PA:
+		DecodeColorBlock(src, pixels, true);
+		break;
+	case TextureFormat::BC2:
+		DecodeColorBlock(src + 8, pixels, false);
+		for (int i = 0; i < 16; i++)
+		{
+			uint32_t a = (src[i / 2] >> ((i & 1) * 4)) & 0xf;
+			pixels[i].A = (a << 4) | a;
+		}
+		break;
+	case TextureFormat::BC3:
+		DecodeColorBlock(src + 8, pixels, false);
+		DecodeAlphaBlock(src, &pixels[0].A, sizeof(FColor));
+		break;
+	case TextureFormat::BC4:
+		for (int i = 0; i < 16; i++)
+			pixels[i] = FColor(0, 0, 0, 255);
+		DecodeAlphaBlock(src, &pixels[0].R, sizeof(FColor));
+		break;
+	case TextureFormat::BC5:
+		for (int i = 0; i < 16; i++)
+			pixels[i] = FColor(0, 0, 0, 255);
+		DecodeAlphaBlock(src, &pixels[0].R, sizeof(FColor));
+		DecodeAlphaBlock(src + 8, &pixels[0].G, sizeof(FColor));
+		break;
+	default:
+		break;
+	}
+}
+
+void GLTextureUploader_BCDecode::UploadRect(void* d, UnrealMipmap* mip, int x, int y, int w, int h, FColor* palette, bool masked)
+{
+	int x0 = x / 4;
+	int y0 = y / 4;
+	int x1 = (x + w + 3) / 4;
+	int y1 = (y + h + 3) / 4;
+
+	int pitch = (mip->Width + 3) / 4 * BytesPerBlock;
+	FColor* dst = (FColor*)d;
+	FColor pixels[16];
+	for (int by = y0; by < y1; by++)
+	{
+		const uint8_t* src = mip->Data.data() + x0 * BytesPerBlock + by * pitch;
+		for (int bx = x0; bx < x1; bx++, src += BytesPerBlock)
+		{
+			DecodeBlock(src, pixels);
+
+			// Only copy the part of the block that is inside the rect
+			int px0 = std::max(bx * 4, x);
+			int py0 = std::max(by * 4, y);
+			int px1 = std::min(bx * 4 + 4, x + w);
+			int py1 = std::min(by * 4 + 4, y + h);
+			for (int py = py0; py < py1; py++)
+			{
+				for (int px = px0; px < px1; px++)
+				{
+					dst[(px - x) + (py - y) * w] = pixels[(px - bx * 4) + (py - by * 4) * 4];
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include "RenderDevice/RenderDevice.h"
+#include <GL/glew.h>
+
+// Converts texture data from the package format into something glTexImage2D accepts.
+//
+// Everything that isn't block compressed is converted to RGBA8 since that is the only format guaranteed on every
+// GL/WebGL target. BC1-3 are uploaded as is when S3TC is available and decoded on the CPU otherwise.
+class GLTextureUploader
+{
+public:
+	GLTextureUploader(GLenum internalFormat, GLenum format, GLenum type) : InternalFormat(internalFormat), Format(format), Type(type) { }
+	virtual ~GLTextureUploader() = default;
+
+	virtual int GetUploadSize(int x, int y, int w, int h) = 0;
+	virtual void UploadRect(void* dst, UnrealMipmap* mip, int x, int y, int w, int h, FColor* palette, bool masked) = 0;
+
+	// Compressed uploads must start on a block boundary and cover whole blocks
+	virtual bool IsCompressed() const { return false; }
+
+	GLenum GetInternalFormat() const { return InternalFormat; }
+	GLenum GetFormat() const { return Format; }
+	GLenum GetType() const { return Type; }
+
+	static GLTextureUploader* GetUploader(TextureFormat format);
+
+private:
+	GLenum InternalFormat;
+	GLenum Format;
+	GLenum Type;
+};
+
+class GLTextureUploader_RGBA8 : public GLTextureUploader
+{
+public:
+	GLTextureUploader_RGBA8() : GLTextureUploader(GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE) { }
+
+	int GetUploadSize(int x, int y, int w, int h) override { return w * h * 4; }
+};
+
+class GLTextureUploader_P8 : public GLTextureUploader_RGBA8
+{
+public:
+	void UploadRect(void* dst, UnrealMipmap* mip, int x, int y, int w, int h, FColor* palette, bool masked) override;
+};
+
+class GLTextureUploader_BGRA8_LM : public GLTextureUploader_RGBA8
+{
+public:
+	void UploadRect(void* dst, UnrealMipmap* mip, int x, int y, int w, int h, FColor* palette, bool masked) override;
+};
+
+class GLTextureUploader_BGRA8 : public GLTextureUploader_RGBA8
+{
+public:
+	void UploadRect(void* dst, UnrealMipmap* mip, int x, int y, int w, int h, FColor* palette, bool masked) override;
+};
+
+class GLTextureUploader_RGBA8_ : public GLTextureUploader_RGBA8
+{
+public:
+	void UploadRect(void* dst, UnrealMipmap* mip, int x, int y, int w, int h, FColor* palette, bool masked) override;
+};
+
+class GLTextureUploader_RGB8 : public GLTextureUploader_RGBA8
+{
+public:
+	void UploadRect(void* dst, UnrealMipmap* mip, int x, int y, int w, int h, FColor* palette, bool masked) override;
+};
+
+class GLTextureUploader_R5G6B5 : public GLTextureUploader_RGBA8
+{
+public:
+	void UploadRect(void* dst, UnrealMipmap* mip, int x, int y, int w, int h, FColor* palette, bool masked) override;
+};
+
+class GLTextureUploader_R8 : public GLTextureUploader_RGBA8
+{
+public:
+	void UploadRect(void* dst, UnrealMipmap* mip, int x, int y, int w, int h, FColor* palette, bool masked) override;
+};
+
+class GLTextureUploader_RG8 : public GLTextureUploader_RGBA8
+{
+public:
+	void UploadRect(void* dst, UnrealMipmap* mip, int x, int y, int w, int h, FColor* palette, bool masked) override;
+};
+
+class GLTextureUploader_RGBA16 : public GLTextureUploader_RGBA8
+{
+public:
+	void UploadRect(void* dst, UnrealMipmap* mip, int x, int y, int w, int h, FColor* palette, bool masked) override;
+};
+
+// Copies BC blocks unchanged for glCompressedTexImage2D
+class GLTextureUploader_4x4Block : public GLTextureUploader
+{
+public:
+	GLTextureUploader_4x4Block(GLenum internalFormat, int bytesPerBlock) : GLTextureUploader(internalFormat, 0, 0), BytesPerBlock(bytesPerBlock) { }
+
+	int GetUploadSize(int x, int y, int w, int h) override;
+	void UploadRect(void* dst, UnrealMipmap* mip, int x, int y, int w, int h, FColor* palette, bool masked) override;
+	bool IsCompressed() const override { return true; }
+
+private:
+	int BytesPerBlock;
+};
+
+// Decodes BC1-5 blocks to RGBA8 for drivers without S3TC (most WebGL implementations on mobile)
+class GLTextureUploader_BCDecode : public GLTextureUploader_RGBA8
+{
+public:
+	GLTextureUploader_BCDecode(TextureFormat format);
+
+	void UploadRect(void* dst, UnrealMipmap* mip, int x, int y, int w, int h, FColor* palette, bool masked) override;
+
+private:
+	void DecodeBlock(const uint8_t* src, FColor* pixels);
+
+	TextureFormat SourceFormat;
+	int BytesPerBlock;
+};
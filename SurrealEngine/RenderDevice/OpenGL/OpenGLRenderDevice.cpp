@@ -1,7 +1,9 @@
 #include "OpenGLRenderDevice.h"
 #include "Window/Window.h"
 
-#include "GLTexture.h"
+#include "GLTextureUploader.h"
+#include "MemoryStats.h"
+#include "Trace.h"
 
 #include <stdexcept>
 
@@ -12,11 +14,21 @@
 const int framebufferWidth = 1920;
 const int framebufferHeight = 1080;
 
-std::map<uint64_t, GLuint> texturesCache;
+struct GLCachedTexture
+{
+	GLuint Texture = 0;
+	GLTextureUploader* Uploader = nullptr;
+	int Width = 0;
+	int Height = 0;
+	int NumMips = 0;
+	TrackedMemory Memory;
+};
+
+std::map<uint64_t, GLCachedTexture> texturesCache;
 
 void clearTexturesCache() {
 	for (auto iter = std::cbegin(texturesCache); iter != std::cend(texturesCache); ++iter) {
-		glDeleteTextures(1, &iter->second);
+		glDeleteTextures(1, &iter->second.Texture);
 	}
 	texturesCache.clear();
 }
@@ -27,200 +39,20 @@ float RFX2 = 0.0f;
 float RFY2 = 0.0f;
 mat4 objectToProjection;
 
-GLuint TextureFormatToGL(TextureFormat format)
-{
-	switch (format)
-	{
-	// P8 is the Eight-bit Palettized format where the actual texture is 32 bit RGBA
-	// but it is stored as indexes of a palette instead, saving on disk space
-	case TextureFormat::P8:
-		return GL_RGBA32I;
-
-	// Compressed texture formats DXT1/3/5
-	// An OpenGL 3.3 capable card should already support these at this point.
-	case TextureFormat::BC1:
-		return GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
-	case TextureFormat::BC2:
-		return GL_COMPRESSED_RGBA_S3TC_DXT3_EXT;
-	case TextureFormat::BC3:
-		return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
-
-	case TextureFormat::R1:
-		return 0; // No GL equivalent
-
-	case TextureFormat::R8:
-		return GL_R8;
-
-	case TextureFormat::R16:
-		return GL_R16;
-	case TextureFormat::R16_F:
-		return GL_R16F;
-	case TextureFormat::R16_I:
-		return GL_R16I;
-	case TextureFormat::R16_S:
-		return GL_R16_SNORM;
-	case TextureFormat::R16_UI:
-		return GL_R16UI;
-
-	case TextureFormat::R32:
-	case TextureFormat::R32_I:
-	case TextureFormat::R32_S:
-		return GL_R32I;
-	case TextureFormat::R32_F:
-		return GL_R32F;
-	case TextureFormat::R32_UI:
-		return GL_R32UI;
-
-	case TextureFormat::BGR8:
-		return GL_BGR;
-
-	case TextureFormat::RGB16_:
-		return GL_RGB16;
-	case TextureFormat::RGB16_F:
-		return GL_RGB16F;
-	case TextureFormat::RGB16_I:
-		return GL_RGB16I;
-	case TextureFormat::RGB16_S:
-		return GL_RGB16_SNORM;
-	case TextureFormat::RGB16_UI:
-		return GL_RGB16UI;
-
-	case TextureFormat::RGBA8_:
-		return GL_RGBA8;
-	case TextureFormat::RGBA8_S:
-		return GL_RGBA8_SNORM;
-	case TextureFormat::RGBA8_I:
-		return GL_RGBA8I;
-	case TextureFormat::RGBA8_UI:
-		return GL_RGBA8UI;
-
-	case TextureFormat::RGB9E5:
-		return GL_RGB9_E5;
-
-	case TextureFormat::RGB10A2:
-	case TextureFormat::RGB10A2_I:
-	case TextureFormat::RGB10A2_LM:
-	case TextureFormat::RGB10A2_S:
-		return GL_RGB10_A2; // No GL equivalent for the variants???
-	case TextureFormat::RGB10A2_UI:
-		return GL_RGB10_A2UI;
-
-	case TextureFormat::RGBA16:
-		return GL_RGBA16;
-	case TextureFormat::RGBA16_S:
-		return GL_RGBA16_SNORM;
-	case TextureFormat::RGBA16_F:
-		return GL_RGBA16F;
-	case TextureFormat::RGBA16_UI:
-		return GL_RGBA16UI;
-	case TextureFormat::RGBA16_I:
-		return GL_RGBA16I;
-
-	case TextureFormat::RGBA32:
-	case TextureFormat::RGBA32_I:
-		return GL_RGBA32I;
-	case TextureFormat::RGBA32_F:
-		return GL_RGBA32F;
-	case TextureFormat::RGBA32_UI:
-		return GL_RGBA32UI;
-
-	case TextureFormat::RGBA64_F:
-		return 0; // No GL equivalent
-
-	case TextureFormat::ARGB8:
-	case TextureFormat::ABGR8:
-		return 0; // No GL equivalent
-
-	case TextureFormat::BGRA8_LM:
-	case TextureFormat::BGRA8:
-		return GL_BGRA;
-
-	case TextureFormat::B5G6R5:
-		return 0; // GL has GL_RGB565, which is in different order
-	case TextureFormat::R5G6B5:
-		return GL_RGB565;
-
-	case TextureFormat::RG16:
-		return GL_RG16;
-	case TextureFormat::RG16_F:
-		return GL_RG16F;
-	case TextureFormat::RG16_S:
-		return GL_RG16_SNORM;
-	case TextureFormat::RG16_I:
-		return GL_RG16I;
-	case TextureFormat::RG16_UI:
-		return GL_RG16UI;
-
-	case TextureFormat::RG32:
-	case TextureFormat::RG32_I:
-	case TextureFormat::RG32_S:
-		return GL_RG32I;
-	case TextureFormat::RG32_F:
-		return GL_RG32F;
-	case TextureFormat::RG32_UI:
-		return GL_RG32UI;
-
-	case TextureFormat::R11G11B10_F:
-		return GL_R11F_G11F_B10F;
-	}
-
-	return 0;
-}
-
-std::vector<FColor> P8_Convert(FTextureInfo *info, size_t mipmapLevel)
-{
-	std::vector<FColor> result;
-
-	UnrealMipmap *mipmap = &info->Texture->Mipmaps[mipmapLevel];
-	size_t mipmapWidth = mipmap->Width;
-	size_t mipmapHeight = mipmap->Height;
-
-	FColor *palette = info->Palette;
-
-	result.resize(mipmapWidth * mipmapHeight);
-
-	if (info->Texture->bMasked())
-	{
-		FColor transparent(0, 0, 0, 0);
-
-		for (size_t y = 0; y < mipmapHeight; y++)
-		{
-			for (size_t x = 0; x < mipmapWidth; x++)
-			{
-				uint8_t index = mipmap->Data[x + y * mipmapWidth];
-				result[x + y * mipmapWidth] = index == 0 ? transparent : palette[index];
-			}
-		}
-	}
-	else
-	{
-		for (size_t y = 0; y < mipmapHeight; y++)
-		{
-			for (size_t x = 0; x < mipmapWidth; x++)
-			{
-				uint8_t index = mipmap->Data[x + y * mipmapWidth];
-				result[x + y * mipmapWidth] = palette[index];
-			}
-		}
-	}
-
-	return result;
-}
-
 OpenGLRenderDevice::OpenGLRenderDevice(GameWindow *InWindow)
 {	
 	glEnable(GL_BLEND);
 	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);  
 
-	std::cout << "OpenGLRenderDevice::OpenGLRenderDevice(GameWindow* InWindow)" << std::endl;
 	Viewport = InWindow;
 
 	Framebuffers.reset(new GLFrameBufferManager(this));
 	Textures.reset(new GLTextureManager());
 	Shaders.reset(new GLShaderManager());
 
-	glGenBuffers(1, &vbo);
-	glBindBuffer(GL_ARRAY_BUFFER, vbo);
+	StreamBuffer.reset(new GLStreamVertexBuffer(4 * 1024 * 1024));
+	MaxBatchVertices = StreamBuffer->GetCapacity() / sizeof(Vertex) / 3 * 3;
+	BatchVertices.reserve(MaxBatchVertices);
 }
 
 OpenGLRenderDevice::~OpenGLRenderDevice()
@@ -229,6 +61,7 @@ OpenGLRenderDevice::~OpenGLRenderDevice()
 	initializeAndBindFramebufferTexture();
 
 	Textures->ClearTextures();
+	StreamBuffer.reset();
 	Framebuffers.reset();
 	Shaders.reset();
 }
@@ -236,8 +69,9 @@ OpenGLRenderDevice::~OpenGLRenderDevice()
 void OpenGLRenderDevice::Flush(bool AllowPrecache)
 {
 	// Flush all OpenGL resources
-	std::cout << "OpenGLRenderDevice::Flush(bool AllowPrecache)" << std::endl;
+	TRACE_EVENT(TraceCategory::RenderDevice, "Flush");
 
+	flushBatch();
 	clearTexturesCache();
 	clearFbo();
 	initializeAndBindFramebufferTexture();
@@ -245,7 +79,7 @@ void OpenGLRenderDevice::Flush(bool AllowPrecache)
 
 bool OpenGLRenderDevice::Exec(std::string Cmd, OutputDevice &Ar)
 {
-	std::cout << "OpenGLRenderDevice::Exec" << std::endl;
+	TRACE_EVENT(TraceCategory::RenderDevice, "Exec");
 	return false;
 }
 
@@ -256,94 +90,185 @@ void OpenGLRenderDevice::Lock(vec4 FlashScale, vec4 FlashFog, vec4 ScreenClear)
 	renderingStartDate = now_ms.time_since_epoch();	
 
 	glBindFramebuffer(GL_FRAMEBUFFER, fbo);
-	std::cout << "OpenGLRenderDevice::Lock(vec4 FlashScale, vec4 FlashFog, vec4 ScreenClear)" << std::endl;
+	TRACE_EVENT(TraceCategory::RenderDevice, "Lock");
 	glEnable(GL_DEPTH_TEST);
 	
 	glClearColor(0.2f, 0.35f, 0.3f, 1.0f);
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);	
 }
 
-void OpenGLRenderDevice::bindTexture(FTextureInfo *texture) {
-	GLuint textureBinding;
+GLuint OpenGLRenderDevice::bindTexture(FTextureInfo *texture) {
+	glActiveTexture(GL_TEXTURE0);
 
-	auto textureWidth = texture->Mips[0].Width;
-	auto textureHeight = texture->Mips[0].Height;
+	auto it = texturesCache.find(texture->CacheID);
+	if (it == texturesCache.end()) {
+		GLCachedTexture& cached = texturesCache[texture->CacheID];
+		glGenTextures(1, &cached.Texture);
+		glBindTexture(GL_TEXTURE_2D, cached.Texture);
+		uploadTexture(cached, texture);
+		return cached.Texture;
+	}
 
-	if (texturesCache.find(texture->CacheID) == texturesCache.end()) {
-		SDL_Surface *surface = SDL_CreateRGBSurfaceWithFormat(
-			0,
-			textureWidth,
-			textureHeight,
-			32,
-			SDL_PIXELFORMAT_RGBA32
-		);
+	GLCachedTexture& cached = it->second;
 
-		glGenTextures(1, &textureBinding);
-		glBindTexture(GL_TEXTURE_2D, textureBinding);
-		texturesCache[texture->CacheID] = textureBinding;
+	// Procedural textures keep their GL texture and only get new contents
+	if (texture->bRealtimeChanged) {
+		if (BatchState.Texture == cached.Texture)
+			flushBatch();
+		glBindTexture(GL_TEXTURE_2D, cached.Texture);
+		uploadTexture(cached, texture);
+		texture->bRealtimeChanged = false;
+	}
+	else {
+		glBindTexture(GL_TEXTURE_2D, cached.Texture);
+	}
+	return cached.Texture;
+}
+
+void OpenGLRenderDevice::uploadTexture(GLCachedTexture& cached, FTextureInfo *texture) {
+	if (texture->Texture)
+		texture->Texture->LoadMipmapData();
+
+	GLTextureUploader* uploader = GLTextureUploader::GetUploader(texture->Format);
+	if (!uploader || texture->NumMips < 1 || texture->Mips[0].Data.empty())
+		return;
+
+	// Stop at the first missing level. GL_TEXTURE_MAX_LEVEL keeps the texture complete if the chain is cut short.
+	int numMips = 0;
+	while (numMips < texture->NumMips && !texture->Mips[numMips].Data.empty())
+		numMips++;
+
+	bool masked = texture->Texture && texture->Texture->bMasked();
+	bool recreate = cached.Uploader != uploader || cached.Width != texture->Mips[0].Width || cached.Height != texture->Mips[0].Height || cached.NumMips != numMips;
+
+	size_t totalBytes = 0;
+	for (int level = 0; level < numMips; level++) {
+		UnrealMipmap* mip = &texture->Mips[level];
+		size_t size = uploader->GetUploadSize(0, 0, mip->Width, mip->Height);
+		if (StagingBuffer.size() < size)
+			StagingBuffer.resize(size);
+		uploader->UploadRect(StagingBuffer.data(), mip, 0, 0, mip->Width, mip->Height, texture->Palette, masked);
+		totalBytes += size;
+
+		if (uploader->IsCompressed()) {
+			if (recreate)
+				glCompressedTexImage2D(GL_TEXTURE_2D, level, uploader->GetInternalFormat(), mip->Width, mip->Height, 0, (GLsizei)size, StagingBuffer.data());
+			else
+				glCompressedTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, mip->Width, mip->Height, uploader->GetInternalFormat(), (GLsizei)size, StagingBuffer.data());
+		}
+		else {
+			if (recreate)
+				glTexImage2D(GL_TEXTURE_2D, level, uploader->GetInternalFormat(), mip->Width, mip->Height, 0, uploader->GetFormat(), uploader->GetType(), StagingBuffer.data());
+			else
+				glTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, mip->Width, mip->Height, uploader->GetFormat(), uploader->GetType(), StagingBuffer.data());
+		}
+	}
 
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	if (recreate) {
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, numMips - 1);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, numMips > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
-		generateMipMap(texture, surface);
+		cached.Uploader = uploader;
+		cached.Width = texture->Mips[0].Width;
+		cached.Height = texture->Mips[0].Height;
+		cached.NumMips = numMips;
+		cached.Memory.Set(MemoryCategory::DeviceTextures, totalBytes);
+	}
 
-		auto palleteMode = GL_RGBA;
+	// Keep the staging buffer from holding on to the memory of one huge texture
+	if (StagingBuffer.size() > 16 * 1024 * 1024)
+		StagingBuffer = {};
 
-		glTexImage2D(
-			GL_TEXTURE_2D, 
-			0, 
-			palleteMode, 
-			surface->w, 
-			surface->h, 
-			0, 
-			palleteMode, 
-			GL_UNSIGNED_BYTE, 
-			surface->pixels
-		);
+	if (texture->Texture && !texture->bRealtimeChanged)
+		texture->Texture->ReleaseMipmapData();
+}
+
+uint32_t OpenGLRenderDevice::getBlendFlags(uint32_t PolyFlags)
+{
+	return PolyFlags & (PF_Translucent | PF_Modulated);
+}
+
+Vertex* OpenGLRenderDevice::allocBatchVertices(const GLDrawBatchState& state, size_t count)
+{
+	if (state != BatchState || BatchVertices.size() + count > MaxBatchVertices)
+	{
+		flushBatch();
+		BatchState = state;
 	}
-	else {
-		textureBinding = texturesCache[texture->CacheID];
-		glBindTexture(GL_TEXTURE_2D, textureBinding);
+
+	size_t pos = BatchVertices.size();
+	BatchVertices.resize(pos + count);
+	return BatchVertices.data() + pos;
+}
+
+void OpenGLRenderDevice::drawTriangleFan(const GLDrawBatchState& state, const std::vector<Vertex>& fanVertices)
+{
+	if (fanVertices.size() < 3)
+		return;
+
+	// Fans can't be merged into a single draw call, so they are turned into triangle lists
+	size_t triangleCount = fanVertices.size() - 2;
+	Vertex* dest = allocBatchVertices(state, triangleCount * 3);
+	for (size_t i = 0; i < triangleCount; i++)
+	{
+		*(dest++) = fanVertices[0];
+		*(dest++) = fanVertices[i + 1];
+		*(dest++) = fanVertices[i + 2];
 	}
-	glActiveTexture(GL_TEXTURE0);	
 }
 
-void OpenGLRenderDevice::drawVerticesForTexture(FTextureInfo *Texture, std::vector<Vertex> *verticesVector) {
+void OpenGLRenderDevice::flushBatch()
+{
+	if (BatchVertices.empty())
+		return;
 
-	GLuint shader_program = Shaders->shaders[DrawComplexSurfaceShader]->ProgramID;
-	glUseProgram(shader_program);
+	const GLDrawBatchState& state = BatchState;
+	GLShader* shader = state.Shader;
 
-	GLint pos = glGetAttribLocation(shader_program, "vertex");		
-	GLint uvSlot = glGetAttribLocation(shader_program, "uvIn");
-	GLint textureSlot = glGetUniformLocation(shader_program, "texture");
+	if (state.ScreenSpace)
+		glViewport(0, 0, framebufferWidth, framebufferHeight);
+	else
+		glViewport(SceneViewport[0], SceneViewport[1], SceneViewport[2], SceneViewport[3]);
 
-	Vertex *vertices = verticesVector->data();
-	GLsizei verticesSize = sizeof(Vertex) * verticesVector->size();
-	
-	glBufferData(GL_ARRAY_BUFFER, verticesSize, vertices, GL_STATIC_DRAW);
+	if (state.DepthTest)
+		glEnable(GL_DEPTH_TEST);
+	else
+		glDisable(GL_DEPTH_TEST);
+
+	if (state.BlendFlags & PF_Translucent)
+		glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_COLOR);
+	else if (state.BlendFlags & PF_Modulated)
+		glBlendFunc(GL_DST_COLOR, GL_SRC_COLOR);
+	else
+		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-	glVertexAttribPointer(pos, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), 0);
-	glEnableVertexAttribArray(pos);
+	glUseProgram(shader->ProgramID);
+	if (shader->ObjectToProjectionLocation != -1)
+		glUniformMatrix4fv(shader->ObjectToProjectionLocation, 1, GL_FALSE, (const GLfloat *)&objectToProjection);
 
-	auto projectionMatrixUniform = glGetUniformLocation(shader_program, "objectToProjectionMatrix");
-	glUniformMatrix4fv(projectionMatrixUniform, 1, GL_FALSE, (const GLfloat *)&objectToProjection);
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, state.Texture);
+	glUniform1i(shader->TextureLocation, 0);
+
+	size_t offset = StreamBuffer->Upload(BatchVertices.data(), sizeof(Vertex) * BatchVertices.size(), sizeof(GLfloat));
 
-	glVertexAttribPointer(uvSlot, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (GLvoid *)(sizeof(Vertex::Position)));
-	glEnableVertexAttribArray(uvSlot);
+	glVertexAttribPointer(shader->VertexLocation, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (GLvoid *)offset);
+	glEnableVertexAttribArray(shader->VertexLocation);
 
-	bindTexture(Texture);
+	glVertexAttribPointer(shader->UVLocation, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (GLvoid *)(offset + sizeof(Vertex::Position)));
+	glEnableVertexAttribArray(shader->UVLocation);
 
-	glUniform1i(textureSlot, 0);
+	glDrawArrays(GL_TRIANGLES, 0, (GLsizei)BatchVertices.size());
 
-	glDrawArrays(
-		GL_TRIANGLE_FAN,
-		0,
-		verticesVector->size()
-	);
+	BatchVertices.clear();
 }
 
 void OpenGLRenderDevice::Unlock(bool Blit)
 {
-	std::cout << "OpenGLRenderDevice::Unlock(bool Blit)" << Blit << std::endl;
+	TRACE_EVENT(TraceCategory::RenderDevice, "Unlock");
+
+	flushBatch();
 
 	if (Blit)
 	{
@@ -357,8 +282,7 @@ void OpenGLRenderDevice::Unlock(bool Blit)
 		std::chrono::milliseconds duration = renderingEndDate - renderingStartDate;
     	double fps = 1000.0 / duration.count();
 
-    	std::cout << "Rendering duration: " << duration.count() << " ms" << std::endl;
-    	std::cout << "FPS: " << fps << std::endl;
+    	TRACE_EVENT_TEXT(TraceCategory::RenderDevice, "FrameTime", std::to_string(duration.count()) + " ms, " + std::to_string((int)fps) + " fps");
 	}
 }
 
@@ -375,74 +299,6 @@ Vertex Vertexxx(GLfloat x, GLfloat y, GLfloat z)
 	return vertex;
 }
 
-void OpenGLRenderDevice::generateMipMap(FTextureInfo *Texture, SDL_Surface *surface)
-{
-	auto textureWidth = Texture->Mips[0].Width;
-	auto textureHeight = Texture->Mips[0].Height;	
-	auto miplevel = 0;
-	{
-		UnrealMipmap* mipmap = &Texture->Mips[0];
-		uint8_t *mipmapData = mipmap->Data.data();
-
-		if (!mipmap || !mipmapData) {
-			std::cout << "mipmap or mipmapData is nullptr" << std::endl;
-			return;			
-		} 
-
-		GLuint textureFormat = TextureFormatToGL(Texture->Format);
-
-		if (textureFormat >= GL_COMPRESSED_RGBA_S3TC_DXT1_EXT && textureFormat <= GL_COMPRESSED_RGBA_S3TC_DXT5_EXT)
-		{
-			glCompressedTexImage2D(
-				GL_TEXTURE_2D, 
-				miplevel, 
-				textureFormat, 
-				mipmap->Width, 
-				mipmap->Height, 
-				0, 
-				0, 
-				mipmapData
-			);
-		}
-		else
-		{
-			if (Texture->Format == TextureFormat::P8)
-			{
-				// Convert P8 to RGBA32
-				auto converted_data = P8_Convert(Texture, miplevel);
-				mipmapData = (uint8_t *)converted_data.data();
-
-				int cursor = 0;
-				for (auto i = 0; i < textureWidth * textureHeight * 4; i += 4)
-				{
-
-					auto surfacePixels = (Uint8 *)surface->pixels;
-
-					auto pixels = mipmapData;
-
-					auto redComponent = pixels[i];
-					auto greenComponent = pixels[i + 1];
-					auto blueComponent = pixels[i + 2];
-					auto alphaComponent = pixels[i + 3];
-
-					surfacePixels[cursor] = redComponent;
-					surfacePixels[cursor + 1] = greenComponent;
-					surfacePixels[cursor + 2] = blueComponent;
-					surfacePixels[cursor + 3] = alphaComponent;
-
-
-					cursor += 4;
-				}
-			}
-		}
-	}	
-}
-
-void OpenGLRenderDevice::generateMipMap(FSurfaceInfo &Surface, SDL_Surface *surface)
-{
-	generateMipMap(Surface.Texture, surface);
-}
-
 inline float GetUMult(const FTextureInfo& Info) { return 1.0f / (Info.UScale * Info.USize); }
 inline float GetVMult(const FTextureInfo& Info) { return 1.0f / (Info.VScale * Info.VSize); }
 
@@ -508,9 +364,14 @@ void populateVertexVector(
 }
 
 void OpenGLRenderDevice::drawComplexSurfaceToTexture(FSurfaceInfo &Surface, FSurfaceFacet &Facet) {
-	std::vector<Vertex> verticesVector;
-	populateVertexVector(&verticesVector, Facet, Surface);
-	drawVerticesForTexture(Surface.Texture, &verticesVector);	
+	FanVertices.clear();
+	populateVertexVector(&FanVertices, Facet, Surface);
+
+	GLDrawBatchState state;
+	state.Shader = Shaders->shaders[DrawComplexSurfaceShader];
+	state.Texture = bindTexture(Surface.Texture);
+	state.BlendFlags = getBlendFlags(Surface.PolyFlags);
+	drawTriangleFan(state, FanVertices);
 }
 
 void OpenGLRenderDevice::initializeAndBindFramebufferTexture() {
@@ -547,22 +408,14 @@ void OpenGLRenderDevice::clearFbo() {
 }
 
 void OpenGLRenderDevice::drawFramebufferTextureOnScreen() {
-
-	GLuint shader_program = Shaders->shaders[DrawComplexSurfaceShader]->ProgramID;
-	glUseProgram(shader_program);
-
-	GLint pos = glGetAttribLocation(shader_program, "vertex");		
-	GLint uvSlot = glGetAttribLocation(shader_program, "uvIn");
-	GLint textureSlot = glGetUniformLocation(shader_program, "texture");
-
+	flushBatch();
 	glBindFramebuffer(GL_FRAMEBUFFER, 0);
-	glDisable(GL_DEPTH_TEST);
 
 	const GLfloat Z_COORD = 0.89f;
 
 	const GLfloat ASPECT_RATIO = 16.0f / 9.0f;
 
-	std::vector<Vertex> verticesVector = {
+	const Vertex vertices[] = {
 		{{-0.5f * ASPECT_RATIO,  0.5f, Z_COORD}, {0.0f, 0.0f}},
 		{{ 0.5f * ASPECT_RATIO, -0.5f, Z_COORD}, {1.0f, 1.0f}},
 		{{-0.5f * ASPECT_RATIO, -0.5f, Z_COORD}, {0.0f, 1.0f}},
@@ -572,40 +425,16 @@ void OpenGLRenderDevice::drawFramebufferTextureOnScreen() {
 		{{ 0.5f * ASPECT_RATIO, -0.5f, Z_COORD}, {1.0f, 1.0f}}
 	};
 
-	Vertex *vertices = verticesVector.data();
-
-	GLsizei verticesSize = sizeof(Vertex) * verticesVector.size();
-
-	glBufferData(GL_ARRAY_BUFFER, verticesSize, vertices, GL_STATIC_DRAW);
-
-	glVertexAttribPointer(pos, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), 0);
-	glEnableVertexAttribArray(pos);
-
-	auto projectionMatrixUniform = glGetUniformLocation(shader_program, "objectToProjectionMatrix");
-	glUniformMatrix4fv(projectionMatrixUniform, 1, GL_FALSE, (const GLfloat *)&objectToProjection);
-
-	glActiveTexture(GL_TEXTURE0);
-
-	glVertexAttribPointer(uvSlot, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (GLvoid *)(sizeof(Vertex::Position)));
-	glEnableVertexAttribArray(uvSlot);
-
-
-	glActiveTexture(GL_TEXTURE0);
-
-	glBindTexture(GL_TEXTURE_2D, fboTexture);
-
-	glUniform1i(textureSlot, 0);
-
-	glDrawArrays(
-		GL_TRIANGLE_FAN,
-		0,
-		verticesVector.size()
-	);
+	GLDrawBatchState state;
+	state.Shader = Shaders->shaders[DrawComplexSurfaceShader];
+	state.Texture = fboTexture;
+	state.DepthTest = false;
+	std::copy(std::begin(vertices), std::end(vertices), allocBatchVertices(state, 6));
+	flushBatch();
 }
 
 void OpenGLRenderDevice::DrawComplexSurface(FSceneNode *Frame, FSurfaceInfo &Surface, FSurfaceFacet &Facet)
 {
-	//std::cout << "DrawComplexSurface(FSceneNode *Frame, FSurfaceInfo &Surface, FSurfaceFacet &Facet)" << std::endl;
 	drawComplexSurfaceToTexture(Surface, Facet);
 }
 
@@ -617,41 +446,14 @@ void OpenGLRenderDevice::DrawGouraudPolygon(
 	uint32_t PolyFlags
 )
 {
-	GLuint shader_program = Shaders->shaders[DrawComplexSurfaceShader]->ProgramID;
-	glUseProgram(shader_program);
-
-	GLint pos = glGetAttribLocation(shader_program, "vertex");		
-	GLint uvSlot = glGetAttribLocation(shader_program, "uvIn");
-	GLint textureSlot = glGetUniformLocation(shader_program, "texture");
-
-	std::vector<Vertex> verticesVector;
-	populateVertexBuffer(&verticesVector, Info, Pts, NumPts);
-
-	Vertex *vertices = verticesVector.data();
-
-	GLsizei verticesSize = sizeof(Vertex) * verticesVector.size();
+	FanVertices.clear();
+	populateVertexBuffer(&FanVertices, Info, Pts, NumPts);
 
-	GLuint vbo;
-
-	glBufferData(GL_ARRAY_BUFFER, verticesSize, vertices, GL_STATIC_DRAW);
-
-	glVertexAttribPointer(pos, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), 0);
-	glEnableVertexAttribArray(pos);
-
-	auto projectionMatrixUniform = glGetUniformLocation(shader_program, "objectToProjectionMatrix");
-	glUniformMatrix4fv(projectionMatrixUniform, 1, GL_FALSE, (const GLfloat *)&objectToProjection);
-
-	glVertexAttribPointer(uvSlot, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (GLvoid *)(sizeof(Vertex::Position)));
-	glEnableVertexAttribArray(uvSlot);
-
-	bindTexture(&Info);
-	glUniform1i(textureSlot, 0);
-
-	glDrawArrays(
-		GL_TRIANGLE_FAN,
-		0,
-		verticesVector.size()
-	);
+	GLDrawBatchState state;
+	state.Shader = Shaders->shaders[DrawComplexSurfaceShader];
+	state.Texture = bindTexture(&Info);
+	state.BlendFlags = getBlendFlags(PolyFlags);
+	drawTriangleFan(state, FanVertices);
 }
 
 void OpenGLRenderDevice::DrawTile(FSceneNode *Frame, FTextureInfo &Info,
@@ -659,7 +461,6 @@ void OpenGLRenderDevice::DrawTile(FSceneNode *Frame, FTextureInfo &Info,
 								  float U, float V, float UL, float VL, float Z,
 								  vec4 Color, vec4 Fog, uint32_t PolyFlags)
 {
-    glDisable(GL_DEPTH_TEST);
     auto width = Info.Mips[0].Width;
     auto height = Info.Mips[0].Height;
 
@@ -674,76 +475,46 @@ void OpenGLRenderDevice::DrawTile(FSceneNode *Frame, FTextureInfo &Info,
     GLfloat ndcYL = (YL / framebufferHeight) * 2.0f;
 
     // Adjust the vertex positions for vertical flip and Y-axis inversion
-    Vertex vertices[] = {
-        {{ndcX, ndcY + ndcYL, Z}, {u, v + vl}}, // bottom-left
-        {{ndcX + ndcXL, ndcY + ndcYL, Z}, {u + ul, v + vl}}, // bottom-right
-        {{ndcX + ndcXL, ndcY, Z}, {u + ul, v}}, // top-right
-        {{ndcX, ndcY, Z}, {u, v}} // top-left
-    };
-    GLint verticesCount = 4;
-
-    GLuint indices[] = {
-        0, 1, 2,
-        2, 3, 0};
-    GLsizei indicesCount = 6;
-
-    glViewport(0, 0, framebufferWidth, framebufferHeight);
-
-    GLuint vbo, indexBuffer;
-
-    GLsizei verticesSize = sizeof(Vertex) * verticesCount;
-    GLsizei indicesSize = sizeof(GLuint) * indicesCount;
-
-    glBufferData(GL_ARRAY_BUFFER, verticesSize, vertices, GL_STATIC_DRAW);
-
-    glGenBuffers(1, &indexBuffer);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indicesSize, indices, GL_STATIC_DRAW);
-
-    auto shader_program = Shaders->shaders[DrawTileShader];
-    auto shaderProgramID = shader_program->ProgramID;
-    glUseProgram(shaderProgramID);
-    auto pos = glGetAttribLocation(shaderProgramID, "vertex");
-
-    glVertexAttribPointer(pos, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), 0);
-    glEnableVertexAttribArray(pos);
-
-    GLint uvSlot = glGetAttribLocation(shaderProgramID, "uvIn");
-    glVertexAttribPointer(uvSlot, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (GLvoid *)(sizeof(Vertex::Position)));
-    glEnableVertexAttribArray(uvSlot);
-
-    bindTexture(&Info);
-
-    GLint textureSlot = glGetUniformLocation(shaderProgramID, "texture");
-    glUniform1i(textureSlot, 0);
-
-    glDrawElements(
-        GL_TRIANGLES,
-        indicesCount,
-        GL_UNSIGNED_INT,
-        0);
-
-    glDeleteBuffers(1, &indexBuffer);
+    Vertex bottomLeft = {{ndcX, ndcY + ndcYL, Z}, {u, v + vl}};
+    Vertex bottomRight = {{ndcX + ndcXL, ndcY + ndcYL, Z}, {u + ul, v + vl}};
+    Vertex topRight = {{ndcX + ndcXL, ndcY, Z}, {u + ul, v}};
+    Vertex topLeft = {{ndcX, ndcY, Z}, {u, v}};
+
+    GLDrawBatchState state;
+    state.Shader = Shaders->shaders[DrawTileShader];
+    state.Texture = bindTexture(&Info);
+    state.BlendFlags = getBlendFlags(PolyFlags);
+    state.DepthTest = false;
+    state.ScreenSpace = true;
+
+    Vertex* vertices = allocBatchVertices(state, 6);
+    vertices[0] = bottomLeft;
+    vertices[1] = bottomRight;
+    vertices[2] = topRight;
+    vertices[3] = topRight;
+    vertices[4] = topLeft;
+    vertices[5] = bottomLeft;
 }
 
 void OpenGLRenderDevice::Draw3DLine(FSceneNode *Frame, vec4 Color, vec3 P1, vec3 P2)
 {
-	std::cout << "OpenGLRenderDevice::Draw3DLine(FSceneNode* Frame, vec4 Color, vec3 P1, vec3 P2)" << std::endl;
+	TRACE_EVENT(TraceCategory::RenderDevice, "Draw3DLine");
 }
 
 void OpenGLRenderDevice::Draw2DLine(FSceneNode *Frame, vec4 Color, vec3 P1, vec3 P2)
 {
-	std::cout << "OpenGLRenderDevice::Draw2DLine" << std::endl;
+	TRACE_EVENT(TraceCategory::RenderDevice, "Draw2DLine");
 }
 
 void OpenGLRenderDevice::Draw2DPoint(FSceneNode *Frame, vec4 Color, float X1, float Y1, float X2, float Y2, float Z)
 {
-	std::cout << "OpenGLRenderDevice::Draw2DPoint" << std::endl;
+	TRACE_EVENT(TraceCategory::RenderDevice, "Draw2DPoint");
 }
 
 void OpenGLRenderDevice::ClearZ(FSceneNode *Frame)
 {
-	std::cout << "OpenGLRenderDevice::ClearZ" << std::endl;
+	TRACE_EVENT(TraceCategory::RenderDevice, "ClearZ");
+	flushBatch();
 	glClear(GL_DEPTH_BUFFER_BIT);	
 }
 
@@ -751,7 +522,6 @@ void OpenGLRenderDevice::ReadPixels(FColor *Pixels)
 {
 	// MEMORY LEAK?
 	return;
-	std::cout << "OpenGLRenderDevice::ReadPixels(FColor* Pixels)" << std::endl;
 	auto readPixels = Framebuffers->SceneFrameBuffer->ReadPixelData();
 
 	memcpy(Pixels, readPixels.data(), readPixels.size());
@@ -759,19 +529,24 @@ void OpenGLRenderDevice::ReadPixels(FColor *Pixels)
 
 void OpenGLRenderDevice::EndFlash()
 {
-	// std::cout << "OpenGLRenderDevice::EndFlash()" << std::endl;
 }
 
 void OpenGLRenderDevice::SetSceneNode(FSceneNode *Frame)
 {
-	//std::cout << "SetSceneNode(FSceneNode *Frame)" << std::endl;
+	// Pending draws use the previous viewport and projection
+	flushBatch();
+
 	CurrentFrame = Frame;
 	Aspect = Frame->FY / Frame->FX;
 	RProjZ = (float)std::tan(radians(Frame->FovAngle) * 0.5);
 	RFX2 = 2.0f * RProjZ / Frame->FX;
 	RFY2 = 2.0f * RProjZ * Aspect / Frame->FY;
 
-	glViewport((float)Frame->XB, (float)Frame->YB, (float)Frame->X, (float)Frame->Y);
+	SceneViewport[0] = Frame->XB;
+	SceneViewport[1] = Frame->YB;
+	SceneViewport[2] = Frame->X;
+	SceneViewport[3] = Frame->Y;
+	glViewport(SceneViewport[0], SceneViewport[1], SceneViewport[2], SceneViewport[3]);
 
 	objectToProjection = mat4::frustum(-RProjZ, RProjZ, -Aspect * RProjZ, Aspect * RProjZ, 1.0f, 32768.0f, handedness::left, clipzrange::zero_positive_w);
 	objectToProjection = objectToProjection * Frame->WorldToView * Frame->ObjectToWorld;
@@ -779,18 +554,55 @@ void OpenGLRenderDevice::SetSceneNode(FSceneNode *Frame)
 
 void OpenGLRenderDevice::PrecacheTexture(FTextureInfo &Info, uint32_t PolyFlags)
 {
-	std::cout << "OpenGLRenderDevice::PrecacheTexture" << std::endl;
+	TRACE_EVENT(TraceCategory::RenderDevice, "PrecacheTexture");
 	// TODO: Handle PolyFlags too
 	Textures->GetTexture(&Info);
 }
 
 bool OpenGLRenderDevice::SupportsTextureFormat(TextureFormat Format)
 {
-	std::cout << "OpenGLRenderDevice::SupportsTextureFormat" << std::endl;
-	return GLTexture::TextureFormatToGL(Format);
+	return GLTextureUploader::GetUploader(Format) != nullptr;
 }
 
 void OpenGLRenderDevice::UpdateTextureRect(FTextureInfo &Info, int U, int V, int UL, int VL)
 {
-	std::cout << "OpenGLRenderDevice::UpdateTextureRect" << std::endl;
+	auto it = texturesCache.find(Info.CacheID);
+	if (it == texturesCache.end())
+		return;
+
+	GLCachedTexture& cached = it->second;
+	if (Info.Texture)
+		Info.Texture->LoadMipmapData();
+
+	GLTextureUploader* uploader = GLTextureUploader::GetUploader(Info.Format);
+	if (!uploader || uploader != cached.Uploader || Info.NumMips < 1 || U < 0 || V < 0 || UL <= 0 || VL <= 0 || U + UL > Info.Mips[0].Width || V + VL > Info.Mips[0].Height || Info.Mips[0].Data.empty())
+		return;
+
+	// Draws already in the batch must see the old contents
+	if (BatchState.Texture == cached.Texture)
+		flushBatch();
+
+	if (uploader->IsCompressed())
+	{
+		int x1 = std::min((U + UL + 3) / 4 * 4, Info.Mips[0].Width);
+		int y1 = std::min((V + VL + 3) / 4 * 4, Info.Mips[0].Height);
+		U = U / 4 * 4;
+		V = V / 4 * 4;
+		UL = x1 - U;
+		VL = y1 - V;
+	}
+
+	size_t size = uploader->GetUploadSize(U, V, UL, VL);
+	if (StagingBuffer.size() < size)
+		StagingBuffer.resize(size);
+	uploader->UploadRect(StagingBuffer.data(), &Info.Mips[0], U, V, UL, VL, Info.Palette, Info.Texture && Info.Texture->bMasked());
+
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, cached.Texture);
+	if (uploader->IsCompressed())
+		glCompressedTexSubImage2D(GL_TEXTURE_2D, 0, U, V, UL, VL, uploader->GetInternalFormat(), (GLsizei)size, StagingBuffer.data());
+	else
+		glTexSubImage2D(GL_TEXTURE_2D, 0, U, V, UL, VL, uploader->GetFormat(), uploader->GetType(), StagingBuffer.data());
+
+	Info.bRealtimeChanged = false;
 }
@@ -15,6 +15,8 @@
 
 #include "UObject/ULevel.h"
 
+struct GLCachedTexture;
+
 typedef struct
 {
 	GLfloat Position[3];
@@ -31,7 +33,7 @@ public:
 
 	void Flush(bool AllowPrecache) override; // free all resources
 
-	void bindTexture(FTextureInfo *texture);
+	GLuint bindTexture(FTextureInfo *texture);
 
 	void DrawTile(
 		FSceneNode* Frame, 
@@ -75,15 +77,15 @@ private:
 
 	std::chrono::milliseconds renderingStartDate;
 
-	GLuint vbo;
     GLuint fbo;
 	GLuint fboDepthBufferTexture;
     GLuint fboTexture;
 
-	void drawVerticesForTexture(FTextureInfo *Texture, std::vector<Vertex> *verticesVector);
-	void generateMipMap(FTextureInfo *Texture, SDL_Surface *surface);
-	void generateMipMap(FSurfaceInfo &Surface, SDL_Surface *surface);
-	SDL_Surface *createOrGetCachedSurface(FTextureInfo *Texture);
+	void drawTriangleFan(const GLDrawBatchState& state, const std::vector<Vertex>& fanVertices);
+	Vertex* allocBatchVertices(const GLDrawBatchState& state, size_t count);
+	void flushBatch();
+	static uint32_t getBlendFlags(uint32_t PolyFlags);
+	void uploadTexture(GLCachedTexture& cached, FTextureInfo *texture);
 
 	void initializeAndBindFramebufferTexture();
 	void clearFbo();
@@ -98,4 +100,14 @@ private:
 	std::unique_ptr<GLTextureManager> Textures;
 	std::unique_ptr<GLShaderManager> Shaders;
 	std::deque<GLDrawCommand> CommandBuffer;
+
+	std::unique_ptr<GLStreamVertexBuffer> StreamBuffer;
+	GLDrawBatchState BatchState;
+	std::vector<Vertex> BatchVertices;
+	std::vector<Vertex> FanVertices;
+	size_t MaxBatchVertices = 0;
+
+	// Texture data is converted into this before it is handed to GL
+	std::vector<uint8_t> StagingBuffer;
+	GLint SceneViewport[4] = {};
 };
\ No newline at end of file
@@ -38,6 +38,14 @@ struct FSurfaceFacet
 	Coords MapCoords;
 	vec3* Vertices;
 	uint32_t VertexCount;
+	int StaticSurface = -1; // Index into the static geometry if the vertices are part of it
+};
+
+// World geometry that doesn't change while the map is loaded. Devices can keep it resident and skip resubmitting the vertices every frame.
+struct FStaticGeometry
+{
+	std::vector<vec3> Vertices;
+	std::vector<uint32_t> SurfaceStart; // First vertex of each surface, with an extra entry at the end
 };
 
 struct FColor
@@ -69,6 +77,12 @@ struct FTextureInfo
 	FColor* Palette = nullptr;
 };
 
+struct FTileRect
+{
+	float X, Y, XL, YL;
+	float U, V, UL, VL;
+};
+
 struct FSurfaceInfo
 {
 	uint32_t PolyFlags = 0;
@@ -100,6 +114,11 @@ public:
 	virtual void DrawComplexSurface(FSceneNode* Frame, FSurfaceInfo& Surface, FSurfaceFacet& Facet) = 0;
 	virtual void DrawGouraudPolygon(FSceneNode* Frame, FTextureInfo& Info, const GouraudVertex* Pts, int NumPts, uint32_t PolyFlags) = 0;
 	virtual void DrawTile(FSceneNode* Frame, FTextureInfo& Info, float X, float Y, float XL, float YL, float U, float V, float UL, float VL, float Z, vec4 Color, vec4 Fog, uint32_t PolyFlags) = 0;
+	virtual void DrawTiles(FSceneNode* Frame, FTextureInfo& Info, const FTileRect* Tiles, int NumTiles, float Z, vec4 Color, vec4 Fog, uint32_t PolyFlags)
+	{
+		for (int i = 0; i < NumTiles; i++)
+			DrawTile(Frame, Info, Tiles[i].X, Tiles[i].Y, Tiles[i].XL, Tiles[i].YL, Tiles[i].U, Tiles[i].V, Tiles[i].UL, Tiles[i].VL, Z, Color, Fog, PolyFlags);
+	}
 	virtual void Draw3DLine(FSceneNode* Frame, vec4 Color, vec3 P1, vec3 P2) = 0;
 	virtual void Draw2DLine(FSceneNode* Frame, vec4 Color, vec3 P1, vec3 P2) = 0;
 	virtual void Draw2DPoint(FSceneNode* Frame, vec4 Color, float X1, float Y1, float X2, float Y2, float Z) = 0;
@@ -110,6 +129,7 @@ public:
 	virtual void PrecacheTexture(FTextureInfo& Info, uint32_t PolyFlags) = 0;
 	virtual bool SupportsTextureFormat(TextureFormat Format) = 0;
 	virtual void UpdateTextureRect(FTextureInfo& Info, int U, int V, int UL, int VL) = 0;
+	virtual void SetStaticGeometry(const FStaticGeometry* Geometry) { }
 
 	bool ParseCommand(std::string* cmd, const std::string& keyword) { return false; }
 
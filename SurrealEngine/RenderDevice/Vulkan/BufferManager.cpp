@@ -18,9 +18,21 @@ BufferManager::~BufferManager()
 	if (UploadData) { UploadBuffer->Unmap(); UploadData = nullptr; }
 }
 
+void BufferManager::SetStaticVertexCount(int count)
+{
+	if (count == StaticVertexCount)
+		return;
+
+	if (SceneVertices) { SceneVertexBuffer->Unmap(); SceneVertices = nullptr; }
+	SceneVertexBuffer.reset();
+
+	StaticVertexCount = count;
+	CreateSceneVertexBuffer();
+}
+
 void BufferManager::CreateSceneVertexBuffer()
 {
-	size_t size = sizeof(SceneVertex) * SceneVertexBufferSize;
+	size_t size = sizeof(SceneVertex) * (SceneVertexBufferSize + StaticVertexCount);
 
 	SceneVertexBuffer = BufferBuilder()
 		.Usage(
@@ -25,10 +25,18 @@ public:
 
 	static const int UploadBufferSize = 64 * 1024 * 1024;
 
+	// Static world geometry is stored after the streamed vertices
+	void SetStaticVertexCount(int count);
+	int GetStaticVertexStart() const { return SceneVertexBufferSize; }
+	int GetStaticVertexCount() const { return StaticVertexCount; }
+
+	static const int MaxStaticVertexCount = 4 * 1024 * 1024;
+
 private:
 	void CreateSceneVertexBuffer();
 	void CreateSceneIndexBuffer();
 	void CreateUploadBuffer();
 
 	VulkanRenderDevice* renderer = nullptr;
+	int StaticVertexCount = 0;
 };
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <zvulkan/vulkanobjects.h>
+#include "MemoryStats.h"
 
 class CachedTexture
 {
@@ -10,4 +11,7 @@ public:
 
 	int BindlessIndex[4] = { -1, -1, -1, -1 };
 	int RealtimeChangeCount = 0;
+	int LastUsedFrame = 0;
+
+	TrackedMemory Memory;
 };
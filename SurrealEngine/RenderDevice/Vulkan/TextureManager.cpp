@@ -5,6 +5,7 @@
 #include "CachedTexture.h"
 #include <zvulkan/vulkanbuilders.h>
 #include "UObject/UTexture.h"
+#include <algorithm>
 
 TextureManager::TextureManager(VulkanRenderDevice* renderer) : renderer(renderer)
 {
@@ -41,9 +42,10 @@ CachedTexture* TextureManager::GetTexture(FTextureInfo* info, bool masked)
 	{
 		/*if (info->Texture)
 			info->Texture->RealtimeChangeCount = tex->RealtimeChangeCount;*/
-		info->bRealtimeChanged = 0;
 		renderer->Uploads->UploadTexture(tex.get(), *info, masked);
+		info->bRealtimeChanged = 0;
 	}
+	tex->LastUsedFrame = FrameNumber;
 	return tex.get();
 }
 
@@ -55,6 +57,67 @@ void TextureManager::ClearCache()
 	}
 }
 
+bool TextureManager::EvictLeastRecentlyUsed()
+{
+	struct EvictCandidate
+	{
+		int Cache;
+		uint64_t CacheID;
+		int LastUsedFrame;
+		size_t Bytes;
+	};
+
+	size_t totalBytes = 0;
+	std::vector<EvictCandidate> candidates;
+	for (int i = 0; i < 2; i++)
+	{
+		for (auto& it : TextureCache[i])
+		{
+			CachedTexture* tex = it.second.get();
+			if (!tex)
+				continue;
+
+			totalBytes += tex->Memory.GetBytes();
+			if (tex->LastUsedFrame != FrameNumber)
+				candidates.push_back({ i, it.first, tex->LastUsedFrame, tex->Memory.GetBytes() });
+		}
+	}
+
+	FrameNumber++;
+
+	if (totalBytes <= MemoryBudget || candidates.empty())
+		return false;
+
+	// Evict down to a lower watermark so that we don't end up evicting something every frame
+	size_t target = MemoryBudget / 4 * 3;
+
+	std::sort(candidates.begin(), candidates.end(), [](const EvictCandidate& a, const EvictCandidate& b) { return a.LastUsedFrame < b.LastUsedFrame; });
+	for (const EvictCandidate& candidate : candidates)
+	{
+		if (totalBytes <= target)
+			break;
+		TextureCache[candidate.Cache].erase(candidate.CacheID);
+		totalBytes -= candidate.Bytes;
+		Evictions++;
+	}
+	return true;
+}
+
+void TextureManager::ResetBindlessIndices()
+{
+	for (auto& cache : TextureCache)
+	{
+		for (auto& it : cache)
+		{
+			if (it.second)
+			{
+				for (int& index : it.second->BindlessIndex)
+					index = -1;
+			}
+		}
+	}
+}
+
 void TextureManager::CreateNullTexture()
 {
 	auto cmdbuffer = renderer->Commands->GetTransferCommands();
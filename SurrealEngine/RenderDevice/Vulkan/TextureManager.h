@@ -19,6 +19,14 @@ public:
 
 	void ClearCache();
 
+	// Destroys the least recently used textures when the cache exceeds MemoryBudget.
+	// Must only be called when the GPU is idle. Returns true if any texture was destroyed.
+	bool EvictLeastRecentlyUsed();
+	void ResetBindlessIndices();
+
+	size_t MemoryBudget = (size_t)768 * 1024 * 1024;
+	int Evictions = 0;
+
 	std::unique_ptr<VulkanImage> NullTexture;
 	std::unique_ptr<VulkanImageView> NullTextureView;
 
@@ -35,4 +43,5 @@ private:
 
 	VulkanRenderDevice* renderer = nullptr;
 	std::unordered_map<uint64_t, std::unique_ptr<CachedTexture>> TextureCache[2];
+	int FrameNumber = 0;
 };
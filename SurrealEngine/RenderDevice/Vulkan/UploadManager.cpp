@@ -21,6 +21,9 @@ bool UploadManager::SupportsTextureFormat(TextureFormat Format) const
 
 void UploadManager::UploadTexture(CachedTexture* tex, const FTextureInfo& Info, bool masked)
 {
+	if (Info.Texture)
+		Info.Texture->LoadMipmapData();
+
 	int width = Info.USize;
 	int height = Info.VSize;
 	int mipcount = Info.NumMips;
@@ -52,16 +55,32 @@ void UploadManager::UploadTexture(CachedTexture* tex, const FTextureInfo& Info,
 			.Image(tex->image.get(), format)
 			.DebugName("CachedTexture.ImageView")
 			.Create(renderer->Device.get());
+
+		size_t bytes = 4;
+		if (uploader)
+		{
+			bytes = 0;
+			for (int level = 0; level < mipcount; level++)
+				bytes += uploader->GetUploadSize(0, 0, Info.Mips[level].Width, Info.Mips[level].Height);
+		}
+		tex->Memory.Set(MemoryCategory::DeviceTextures, bytes);
 	}
 
 	if (uploader)
 		UploadData(tex->image->image, Info, masked, uploader);
 	else
 		UploadWhite(tex->image->image);
+
+	// The pixels are in the upload buffer now. Static textures don't need to keep a CPU copy.
+	if (Info.Texture && !Info.bRealtimeChanged)
+		Info.Texture->ReleaseMipmapData();
 }
 
 void UploadManager::UploadTextureRect(CachedTexture* tex, const FTextureInfo& Info, int x, int y, int w, int h)
 {
+	if (Info.Texture)
+		Info.Texture->LoadMipmapData();
+
 	TextureUploader* uploader = TextureUploader::GetUploader(Info.Format);
 	if (!uploader || Info.NumMips < 1 || x < 0 || y < 0 || w <= 0 || h <= 0 || x + w > Info.Mips[0].Width || y + h > Info.Mips[0].Height || Info.Mips[0].Data.empty())
 		return;
@@ -12,6 +12,7 @@
 #include "UObject/UTexture.h"
 #include "Window/Window.h"
 #include <set>
+#include <cstring>
 
 void VulkanPrintLog(const char* typestr, const std::string& msg)
 {
@@ -116,6 +117,7 @@ void VulkanRenderDevice::SubmitAndWait(bool present, int presentWidth, int prese
 	Batch.SceneIndexStart = 0;
 	SceneVertexPos = 0;
 	SceneIndexPos = 0;
+	SubmitSerial++;
 }
 
 void VulkanRenderDevice::Flush(bool AllowPrecache)
@@ -386,6 +388,12 @@ void VulkanRenderDevice::Unlock(bool Blit)
 	BlitSceneToPostprocess();
 	SubmitAndWait(Blit, Viewport->GetPixelWidth(), Viewport->GetPixelHeight());
 
+	if (Textures->EvictLeastRecentlyUsed())
+	{
+		DescriptorSets->ClearCache();
+		Textures->ResetBindlessIndices();
+	}
+
 	IsLocked = false;
 }
 
@@ -428,112 +436,175 @@ void VulkanRenderDevice::DrawComplexSurface(FSceneNode* Frame, FSurfaceInfo& Sur
 	float UDot = dot(Facet.MapCoords.XAxis, Facet.MapCoords.Origin);
 	float VDot = dot(Facet.MapCoords.YAxis, Facet.MapCoords.Origin);
 
-	float UPan = tex ? UDot + Surface.Texture->Pan.x : 0.0f;
-	float VPan = tex ? VDot + Surface.Texture->Pan.y : 0.0f;
-	float UMult = tex ? GetUMult(*Surface.Texture) : 0.0f;
-	float VMult = tex ? GetVMult(*Surface.Texture) : 0.0f;
-	float LMUPan = lightmap ? UDot + Surface.LightMap->Pan.x - 0.5f * Surface.LightMap->UScale : 0.0f;
-	float LMVPan = lightmap ? VDot + Surface.LightMap->Pan.y - 0.5f * Surface.LightMap->VScale : 0.0f;
-	float LMUMult = lightmap ? GetUMult(*Surface.LightMap) : 0.0f;
-	float LMVMult = lightmap ? GetVMult(*Surface.LightMap) : 0.0f;
-	float MacroUPan = macrotex ? UDot + Surface.MacroTexture->Pan.x : 0.0f;
-	float MacroVPan = macrotex ? VDot + Surface.MacroTexture->Pan.y : 0.0f;
-	float MacroUMult = macrotex ? GetUMult(*Surface.MacroTexture) : 0.0f;
-	float MacroVMult = macrotex ? GetVMult(*Surface.MacroTexture) : 0.0f;
-	float DetailUPan = detailtex ? UDot + Surface.DetailTexture->Pan.x : 0.0f;
-	float DetailVPan = detailtex ? VDot + Surface.DetailTexture->Pan.y : 0.0f;
-	float DetailUMult = detailtex ? GetUMult(*Surface.DetailTexture) : 0.0f;
-	float DetailVMult = detailtex ? GetVMult(*Surface.DetailTexture) : 0.0f;
-
-	uint32_t flags = 0;
-	if (lightmap) flags |= 1;
-	if (macrotex) flags |= 2;
-	if (detailtex && !fogmap) flags |= 4;
-	if (fogmap) flags |= 8;
+	SurfaceVertexParams params = {};
+	params.UPan = tex ? UDot + Surface.Texture->Pan.x : 0.0f;
+	params.VPan = tex ? VDot + Surface.Texture->Pan.y : 0.0f;
+	params.UMult = tex ? GetUMult(*Surface.Texture) : 0.0f;
+	params.VMult = tex ? GetVMult(*Surface.Texture) : 0.0f;
+	params.LMUPan = lightmap ? UDot + Surface.LightMap->Pan.x - 0.5f * Surface.LightMap->UScale : 0.0f;
+	params.LMVPan = lightmap ? VDot + Surface.LightMap->Pan.y - 0.5f * Surface.LightMap->VScale : 0.0f;
+	params.LMUMult = lightmap ? GetUMult(*Surface.LightMap) : 0.0f;
+	params.LMVMult = lightmap ? GetVMult(*Surface.LightMap) : 0.0f;
+	params.MacroUPan = macrotex ? UDot + Surface.MacroTexture->Pan.x : 0.0f;
+	params.MacroVPan = macrotex ? VDot + Surface.MacroTexture->Pan.y : 0.0f;
+	params.MacroUMult = macrotex ? GetUMult(*Surface.MacroTexture) : 0.0f;
+	params.MacroVMult = macrotex ? GetVMult(*Surface.MacroTexture) : 0.0f;
+	params.DetailUPan = detailtex ? UDot + Surface.DetailTexture->Pan.x : 0.0f;
+	params.DetailVPan = detailtex ? VDot + Surface.DetailTexture->Pan.y : 0.0f;
+	params.DetailUMult = detailtex ? GetUMult(*Surface.DetailTexture) : 0.0f;
+	params.DetailVMult = detailtex ? GetVMult(*Surface.DetailTexture) : 0.0f;
+
+	if (lightmap) params.Flags |= 1;
+	if (macrotex) params.Flags |= 2;
+	if (detailtex && !fogmap) params.Flags |= 4;
+	if (fogmap) params.Flags |= 8;
 
 	if (fogmap) // if Surface.FogMap exists, use instead of detail texture
 	{
 		detailtex = fogmap;
-		DetailUPan = UDot + Surface.FogMap->Pan.x - 0.5f * Surface.FogMap->UScale;
-		DetailVPan = VDot + Surface.FogMap->Pan.y - 0.5f * Surface.FogMap->VScale;
-		DetailUMult = GetUMult(*Surface.FogMap);
-		DetailVMult = GetVMult(*Surface.FogMap);
+		params.DetailUPan = UDot + Surface.FogMap->Pan.x - 0.5f * Surface.FogMap->UScale;
+		params.DetailVPan = VDot + Surface.FogMap->Pan.y - 0.5f * Surface.FogMap->VScale;
+		params.DetailUMult = GetUMult(*Surface.FogMap);
+		params.DetailVMult = GetVMult(*Surface.FogMap);
 	}
 
 	SetPipeline(RenderPasses->getPipeline(Surface.PolyFlags, UsesBindless));
 
-	ivec4 textureBinds;
 	if (UsesBindless)
 	{
-		textureBinds.x = DescriptorSets->GetTextureArrayIndex(Surface.PolyFlags, tex);
-		textureBinds.y = DescriptorSets->GetTextureArrayIndex(0, macrotex);
-		textureBinds.z = DescriptorSets->GetTextureArrayIndex(0, detailtex);
-		textureBinds.w = DescriptorSets->GetTextureArrayIndex(0, lightmap);
+		params.TextureBinds.x = DescriptorSets->GetTextureArrayIndex(Surface.PolyFlags, tex);
+		params.TextureBinds.y = DescriptorSets->GetTextureArrayIndex(0, macrotex);
+		params.TextureBinds.z = DescriptorSets->GetTextureArrayIndex(0, detailtex);
+		params.TextureBinds.w = DescriptorSets->GetTextureArrayIndex(0, lightmap);
 
 		SetDescriptorSet(DescriptorSets->GetBindlessDescriptorSet(), true);
 	}
 	else
 	{
-		textureBinds.x = 0;
-		textureBinds.y = 0;
-		textureBinds.z = 0;
-		textureBinds.w = 0;
-
 		SetDescriptorSet(DescriptorSets->GetTextureDescriptorSet(Surface.PolyFlags, tex, lightmap, macrotex, detailtex), false);
 	}
 
-	uint32_t vpos = SceneVertexPos;
-	uint32_t ipos = SceneIndexPos;
+	uint32_t vcount = Facet.VertexCount;
+	uint32_t vstart;
+
+	// Static surfaces already have their vertices in the buffer. Only rewrite them if the texture parameters changed (panning,
+	// new lightmap or texture cache flush), and only if no earlier draw in this submit still needs the old vertices.
+	ResidentSurface* resident = nullptr;
+	if (Facet.StaticSurface >= 0 && (size_t)Facet.StaticSurface < ResidentSurfaces.size() && ResidentSurfaces[Facet.StaticSurface].Count == vcount)
+		resident = &ResidentSurfaces[Facet.StaticSurface];
+
+	if (resident && resident->Valid && std::memcmp(&resident->Params, &params, sizeof(SurfaceVertexParams)) == 0)
+	{
+		vstart = resident->Start;
+		resident->UsedSerial = SubmitSerial;
+		Stats.ResidentSurfaces++;
+	}
+	else if (resident && resident->UsedSerial != SubmitSerial)
+	{
+		WriteSurfaceVertices(Buffers->SceneVertices + resident->Start, Facet, params);
+		resident->Params = params;
+		resident->Valid = true;
+		resident->UsedSerial = SubmitSerial;
+		vstart = resident->Start;
+	}
+	else
+	{
+		vstart = SceneVertexPos;
+		WriteSurfaceVertices(Buffers->SceneVertices + vstart, Facet, params);
+		SceneVertexPos += vcount;
+	}
 
-	SceneVertex* vptr = Buffers->SceneVertices + vpos;
-	uint32_t* iptr = Buffers->SceneIndexes + ipos;
+	uint32_t* iptr = Buffers->SceneIndexes + SceneIndexPos;
+	for (uint32_t i = vstart + 2; i < vstart + vcount; i++)
+	{
+		*(iptr++) = vstart;
+		*(iptr++) = i - 1;
+		*(iptr++) = i;
+	}
+	SceneIndexPos += (vcount - 2) * 3;
 
-	uint32_t istart = ipos;
-	uint32_t icount = 0;
+	Stats.ComplexSurfaces++;
+}
 
+void VulkanRenderDevice::WriteSurfaceVertices(SceneVertex* vptr, const FSurfaceFacet& Facet, const SurfaceVertexParams& params)
+{
 	auto pts = Facet.Vertices;
 	uint32_t vcount = Facet.VertexCount;
-
 	for (uint32_t i = 0; i < vcount; i++)
 	{
 		vec3 point = pts[i];
 		float u = dot(Facet.MapCoords.XAxis, point);
 		float v = dot(Facet.MapCoords.YAxis, point);
 
-		vptr->Flags = flags;
+		vptr->Flags = params.Flags;
 		vptr->Position.x = point.x;
 		vptr->Position.y = point.y;
 		vptr->Position.z = point.z;
-		vptr->TexCoord.s = (u - UPan) * UMult;
-		vptr->TexCoord.t = (v - VPan) * VMult;
-		vptr->TexCoord2.s = (u - LMUPan) * LMUMult;
-		vptr->TexCoord2.t = (v - LMVPan) * LMVMult;
-		vptr->TexCoord3.s = (u - MacroUPan) * MacroUMult;
-		vptr->TexCoord3.t = (v - MacroVPan) * MacroVMult;
-		vptr->TexCoord4.s = (u - DetailUPan) * DetailUMult;
-		vptr->TexCoord4.t = (v - DetailVPan) * DetailVMult;
+		vptr->TexCoord.s = (u - params.UPan) * params.UMult;
+		vptr->TexCoord.t = (v - params.VPan) * params.VMult;
+		vptr->TexCoord2.s = (u - params.LMUPan) * params.LMUMult;
+		vptr->TexCoord2.t = (v - params.LMVPan) * params.LMVMult;
+		vptr->TexCoord3.s = (u - params.MacroUPan) * params.MacroUMult;
+		vptr->TexCoord3.t = (v - params.MacroVPan) * params.MacroVMult;
+		vptr->TexCoord4.s = (u - params.DetailUPan) * params.DetailUMult;
+		vptr->TexCoord4.t = (v - params.DetailVPan) * params.DetailVMult;
 		vptr->Color.r = 1.0f;
 		vptr->Color.g = 1.0f;
 		vptr->Color.b = 1.0f;
 		vptr->Color.a = 1.0f;
-		vptr->TextureBinds = textureBinds;
+		vptr->TextureBinds = params.TextureBinds;
 		vptr++;
 	}
+}
 
-	for (uint32_t i = vpos + 2; i < vpos + vcount; i++)
+void VulkanRenderDevice::SetStaticGeometry(const FStaticGeometry* Geometry)
+{
+	// The vertex buffer is about to be replaced so everything using it has to finish first
+	if (IsLocked)
 	{
-		*(iptr++) = vpos;
-		*(iptr++) = i - 1;
-		*(iptr++) = i;
+		DrawBatch(Commands->GetDrawCommands());
+		RenderPasses->EndScene(Commands->GetDrawCommands());
+		SubmitAndWait(false, 0, 0);
 	}
 
-	vpos += vcount;
-	icount += (vcount - 2) * 3;
+	ResidentSurfaces.clear();
+	int count = Geometry ? (int)Geometry->Vertices.size() : 0;
+	if (count > BufferManager::MaxStaticVertexCount)
+		count = 0;
+	Buffers->SetStaticVertexCount(count);
 
-	Stats.ComplexSurfaces++;
+	if (count > 0)
+	{
+		uint32_t base = Buffers->GetStaticVertexStart();
+		size_t numSurfaces = Geometry->SurfaceStart.size() - 1;
+		ResidentSurfaces.resize(numSurfaces);
+		for (size_t i = 0; i < numSurfaces; i++)
+		{
+			ResidentSurface& surface = ResidentSurfaces[i];
+			surface.Start = base + Geometry->SurfaceStart[i];
+			surface.Count = Geometry->SurfaceStart[i + 1] - Geometry->SurfaceStart[i];
+		}
+
+		SceneVertex* vptr = Buffers->SceneVertices + base;
+		for (const vec3& point : Geometry->Vertices)
+		{
+			*vptr = {};
+			vptr->Position = point;
+			vptr->Color = vec4(1.0f);
+			vptr++;
+		}
+	}
+
+	if (IsLocked)
+	{
+		auto cmdbuffer = Commands->GetDrawCommands();
+		RenderPasses->BeginScene(cmdbuffer, vec4(0.0f, 0.0f, 0.0f, 1.0f));
 
-	SceneVertexPos = vpos;
-	SceneIndexPos = ipos + icount;
+		VkBuffer vertexBuffers[] = { Buffers->SceneVertexBuffer->buffer };
+		VkDeviceSize offsets[] = { 0 };
+		cmdbuffer->bindVertexBuffers(0, 1, vertexBuffers, offsets);
+		cmdbuffer->bindIndexBuffer(Buffers->SceneIndexBuffer->buffer, 0, VK_INDEX_TYPE_UINT32);
+	}
 }
 
 void VulkanRenderDevice::DrawGouraudPolygon(FSceneNode* Frame, FTextureInfo& Info, const GouraudVertex* Pts, int NumPts, uint32_t PolyFlags)
@@ -638,6 +709,12 @@ void VulkanRenderDevice::DrawGouraudPolygon(FSceneNode* Frame, FTextureInfo& Inf
 }
 
 void VulkanRenderDevice::DrawTile(FSceneNode* Frame, FTextureInfo& Info, float X, float Y, float XL, float YL, float U, float V, float UL, float VL, float Z, vec4 Color, vec4 Fog, uint32_t PolyFlags)
+{
+	FTileRect tile = { X, Y, XL, YL, U, V, UL, VL };
+	DrawTiles(Frame, Info, &tile, 1, Z, Color, Fog, PolyFlags);
+}
+
+void VulkanRenderDevice::DrawTiles(FSceneNode* Frame, FTextureInfo& Info, const FTileRect* Tiles, int NumTiles, float Z, vec4 Color, vec4 Fog, uint32_t PolyFlags)
 {
 	if ((PolyFlags & (PF_Modulated)) == PF_Modulated && Info.Format == TextureFormat::P8)
 		PolyFlags = PF_Modulated;
@@ -679,8 +756,6 @@ void VulkanRenderDevice::DrawTile(FSceneNode* Frame, FTextureInfo& Info, float X
 	float UMult = tex ? GetUMult(Info) : 0.0f;
 	float VMult = tex ? GetVMult(Info) : 0.0f;
 
-	SceneVertex* v = &Buffers->SceneVertices[SceneVertexPos];
-
 	float r, g, b, a;
 	if (PolyFlags & PF_Modulated)
 	{
@@ -696,28 +771,33 @@ void VulkanRenderDevice::DrawTile(FSceneNode* Frame, FTextureInfo& Info, float X
 	}
 	a = 1.0f;
 
-	v[0] = { 0, vec3(RFX2 * Z * (X - Frame->FX2),      RFY2 * Z * (Y - Frame->FY2),      Z), vec2(U * UMult,        V * VMult),        vec2(0.0f, 0.0f), vec2(0.0f, 0.0f), vec2(0.0f, 0.0f), vec4(r, g, b, a), textureBinds };
-	v[1] = { 0, vec3(RFX2 * Z * (X + XL - Frame->FX2), RFY2 * Z * (Y - Frame->FY2),      Z), vec2((U + UL) * UMult, V * VMult),        vec2(0.0f, 0.0f), vec2(0.0f, 0.0f), vec2(0.0f, 0.0f), vec4(r, g, b, a), textureBinds };
-	v[2] = { 0, vec3(RFX2 * Z * (X + XL - Frame->FX2), RFY2 * Z * (Y + YL - Frame->FY2), Z), vec2((U + UL) * UMult, (V + VL) * VMult), vec2(0.0f, 0.0f), vec2(0.0f, 0.0f), vec2(0.0f, 0.0f), vec4(r, g, b, a), textureBinds };
-	v[3] = { 0, vec3(RFX2 * Z * (X - Frame->FX2),      RFY2 * Z * (Y + YL - Frame->FY2), Z), vec2(U * UMult,        (V + VL) * VMult), vec2(0.0f, 0.0f), vec2(0.0f, 0.0f), vec2(0.0f, 0.0f), vec4(r, g, b, a), textureBinds };
+	// All tiles share the pipeline and texture, so they end up in the same draw call
+	SceneVertex* v = &Buffers->SceneVertices[SceneVertexPos];
+	uint32_t* iptr = Buffers->SceneIndexes + SceneIndexPos;
+	for (int i = 0; i < NumTiles; i++)
+	{
+		float X = Tiles[i].X, Y = Tiles[i].Y, XL = Tiles[i].XL, YL = Tiles[i].YL;
+		float U = Tiles[i].U, V = Tiles[i].V, UL = Tiles[i].UL, VL = Tiles[i].VL;
 
-	uint32_t vstart = SceneVertexPos;
-	uint32_t vcount = 4;
-	uint32_t istart = SceneIndexPos;
-	uint32_t icount = (vcount - 2) * 3;
+		v[0] = { 0, vec3(RFX2 * Z * (X - Frame->FX2),      RFY2 * Z * (Y - Frame->FY2),      Z), vec2(U * UMult,        V * VMult),        vec2(0.0f, 0.0f), vec2(0.0f, 0.0f), vec2(0.0f, 0.0f), vec4(r, g, b, a), textureBinds };
+		v[1] = { 0, vec3(RFX2 * Z * (X + XL - Frame->FX2), RFY2 * Z * (Y - Frame->FY2),      Z), vec2((U + UL) * UMult, V * VMult),        vec2(0.0f, 0.0f), vec2(0.0f, 0.0f), vec2(0.0f, 0.0f), vec4(r, g, b, a), textureBinds };
+		v[2] = { 0, vec3(RFX2 * Z * (X + XL - Frame->FX2), RFY2 * Z * (Y + YL - Frame->FY2), Z), vec2((U + UL) * UMult, (V + VL) * VMult), vec2(0.0f, 0.0f), vec2(0.0f, 0.0f), vec2(0.0f, 0.0f), vec4(r, g, b, a), textureBinds };
+		v[3] = { 0, vec3(RFX2 * Z * (X - Frame->FX2),      RFY2 * Z * (Y + YL - Frame->FY2), Z), vec2(U * UMult,        (V + VL) * VMult), vec2(0.0f, 0.0f), vec2(0.0f, 0.0f), vec2(0.0f, 0.0f), vec4(r, g, b, a), textureBinds };
+		v += 4;
 
-	uint32_t* iptr = Buffers->SceneIndexes + istart;
-	for (uint32_t i = vstart + 2; i < vstart + vcount; i++)
-	{
+		uint32_t vstart = SceneVertexPos;
 		*(iptr++) = vstart;
-		*(iptr++) = i - 1;
-		*(iptr++) = i;
-	}
+		*(iptr++) = vstart + 1;
+		*(iptr++) = vstart + 2;
+		*(iptr++) = vstart;
+		*(iptr++) = vstart + 2;
+		*(iptr++) = vstart + 3;
 
-	SceneVertexPos += vcount;
-	SceneIndexPos += icount;
+		SceneVertexPos += 4;
+		SceneIndexPos += 6;
+	}
 
-	Stats.Tiles++;
+	Stats.Tiles += NumTiles;
 }
 
 void VulkanRenderDevice::Draw3DLine(FSceneNode* Frame, vec4 Color, vec3 P1, vec3 P2)
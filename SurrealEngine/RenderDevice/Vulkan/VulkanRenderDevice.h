@@ -30,6 +30,7 @@ public:
 	void DrawComplexSurface(FSceneNode* Frame, FSurfaceInfo& Surface, FSurfaceFacet& Facet) override;
 	void DrawGouraudPolygon(FSceneNode* Frame, FTextureInfo& Info, const GouraudVertex* Pts, int NumPts, uint32_t PolyFlags) override;
 	void DrawTile(FSceneNode* Frame, FTextureInfo& Info, float X, float Y, float XL, float YL, float U, float V, float UL, float VL, float Z, vec4 Color, vec4 Fog, uint32_t PolyFlags) override;
+	void DrawTiles(FSceneNode* Frame, FTextureInfo& Info, const FTileRect* Tiles, int NumTiles, float Z, vec4 Color, vec4 Fog, uint32_t PolyFlags) override;
 	void Draw3DLine(FSceneNode* Frame, vec4 Color, vec3 P1, vec3 P2) override;
 	void Draw2DLine(FSceneNode* Frame, vec4 Color, vec3 P1, vec3 P2) override;
 	void Draw2DPoint(FSceneNode* Frame, vec4 Color, float X1, float Y1, float X2, float Y2, float Z) override;
@@ -40,6 +41,7 @@ public:
 	void PrecacheTexture(FTextureInfo& Info, uint32_t PolyFlags) override;
 	bool SupportsTextureFormat(TextureFormat Format) override;
 	void UpdateTextureRect(FTextureInfo& Info, int U, int V, int UL, int VL) override;
+	void SetStaticGeometry(const FStaticGeometry* Geometry) override;
 
 	std::shared_ptr<VulkanDevice> Device;
 
@@ -68,6 +70,7 @@ public:
 	struct
 	{
 		int ComplexSurfaces = 0;
+		int ResidentSurfaces = 0;
 		int GouraudPolygons = 0;
 		int Tiles = 0;
 		int DrawCalls = 0;
@@ -112,6 +115,32 @@ private:
 
 	uint32_t SceneVertexPos = 0;
 	uint32_t SceneIndexPos = 0;
+
+	// Everything in a complex surface vertex that isn't the position
+	struct SurfaceVertexParams
+	{
+		uint32_t Flags;
+		float UPan, VPan, UMult, VMult;
+		float LMUPan, LMVPan, LMUMult, LMVMult;
+		float MacroUPan, MacroVPan, MacroUMult, MacroVMult;
+		float DetailUPan, DetailVPan, DetailUMult, DetailVMult;
+		ivec4 TextureBinds;
+	};
+
+	// A static geometry surface kept in the vertex buffer. It is only rewritten when its texture parameters change.
+	struct ResidentSurface
+	{
+		uint32_t Start = 0;
+		uint32_t Count = 0;
+		bool Valid = false;
+		uint64_t UsedSerial = 0;
+		SurfaceVertexParams Params;
+	};
+
+	static void WriteSurfaceVertices(SceneVertex* vptr, const FSurfaceFacet& Facet, const SurfaceVertexParams& params);
+
+	std::vector<ResidentSurface> ResidentSurfaces;
+	uint64_t SubmitSerial = 1;
 };
 
 inline void VulkanRenderDevice::SetPipeline(VulkanPipeline* pipeline)
@@ -0,0 +1,276 @@
+
+#include "Precomp.h"
+#include "Trace.h"
+#include <chrono>
+#include <mutex>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+
+std::atomic<uint32_t> Trace::EnabledCategories = { 0 };
+std::atomic<bool> Trace::Echo = { false };
+
+namespace
+{
+	struct CategoryName
+	{
+		TraceCategory Category;
+		const char* Name;
+	};
+
+	const CategoryName CategoryNames[] =
+	{
+		{ TraceCategory::Engine, "Engine" },
+		{ TraceCategory::Package, "Package" },
+		{ TraceCategory::File, "File" },
+		{ TraceCategory::Render, "Render" },
+		{ TraceCategory::RenderDevice, "RenderDevice" },
+		{ TraceCategory::Audio, "Audio" },
+		{ TraceCategory::VM, "VM" },
+		{ TraceCategory::UI, "UI" }
+	};
+
+	const char* GetCategoryName(TraceCategory category)
+	{
+		for (const CategoryName& entry : CategoryNames)
+		{
+			if (entry.Category == category)
+				return entry.Name;
+		}
+		return "Unknown";
+	}
+
+	struct TraceEvent
+	{
+		const char* Name;
+		uint64_t Timestamp;
+		uint64_t Duration;
+		TraceCategory Category;
+		char Phase;
+		char Text[51];
+	};
+
+	// Only the owning thread writes to a buffer. Readers copy the events and then drop the ones the writer may have lapped meanwhile.
+	struct TraceBuffer
+	{
+		enum { Capacity = 16384 };
+
+		TraceEvent Events[Capacity];
+		std::atomic<uint64_t> Head = { 0 };
+		std::atomic<uint64_t> Tail = { 0 }; // Events before this were cleared
+		std::atomic<bool> InUse = { true };
+		uint32_t ThreadId = 0;
+	};
+
+	std::mutex BuffersMutex;
+	std::vector<std::unique_ptr<TraceBuffer>> Buffers;
+
+	const std::chrono::steady_clock::time_point StartTime = std::chrono::steady_clock::now();
+
+	struct ThreadBuffer
+	{
+		~ThreadBuffer()
+		{
+			if (Buffer)
+				Buffer->InUse = false;
+		}
+
+		TraceBuffer* Buffer = nullptr;
+	};
+	thread_local ThreadBuffer CurrentThread;
+
+	TraceBuffer* GetThreadBuffer()
+	{
+		if (!CurrentThread.Buffer)
+		{
+			std::unique_lock<std::mutex> lock(BuffersMutex);
+
+			// Reuse the buffers of threads that exited, so short lived threads don't add up
+			for (auto& buffer : Buffers)
+			{
+				bool inUse = false;
+				if (buffer->InUse.compare_exchange_strong(inUse, true))
+				{
+					CurrentThread.Buffer = buffer.get();
+					break;
+				}
+			}
+
+			if (!CurrentThread.Buffer)
+			{
+				Buffers.push_back(std::make_unique<TraceBuffer>());
+				Buffers.back()->ThreadId = (uint32_t)Buffers.size();
+				CurrentThread.Buffer = Buffers.back().get();
+			}
+		}
+		return CurrentThread.Buffer;
+	}
+
+	void Record(TraceCategory category, const char* name, char phase, uint64_t timestamp, uint64_t duration, const char* text, size_t textLength, bool echo)
+	{
+		TraceBuffer* buffer = GetThreadBuffer();
+		uint64_t head = buffer->Head.load(std::memory_order_relaxed);
+
+		TraceEvent& event = buffer->Events[head % TraceBuffer::Capacity];
+		event.Name = name;
+		event.Timestamp = timestamp;
+		event.Duration = duration;
+		event.Category = category;
+		event.Phase = phase;
+		textLength = std::min(textLength, sizeof(event.Text) - 1);
+		memcpy(event.Text, text, textLength);
+		event.Text[textLength] = 0;
+
+		buffer->Head.store(head + 1, std::memory_order_release);
+
+		if (echo)
+			printf("[%s] %s %s\n", GetCategoryName(category), name, event.Text);
+	}
+
+	void WriteJsonString(std::string& json, const char* text)
+	{
+		json.push_back('"');
+		for (const char* c = text; *c; c++)
+		{
+			if (*c == '"' || *c == '\\')
+			{
+				json.push_back('\\');
+				json.push_back(*c);
+			}
+			else if ((unsigned char)*c < 32)
+			{
+				char escape[8];
+				snprintf(escape, sizeof(escape), "\\u%04x", (unsigned char)*c);
+				json += escape;
+			}
+			else
+			{
+				json.push_back(*c);
+			}
+		}
+		json.push_back('"');
+	}
+}
+
+void Trace::Enable(uint32_t categories)
+{
+	EnabledCategories.fetch_or(categories);
+}
+
+void Trace::Disable(uint32_t categories)
+{
+	EnabledCategories.fetch_and(~categories);
+}
+
+uint32_t Trace::ParseCategories(const std::string& names)
+{
+	uint32_t categories = 0;
+	size_t pos = 0;
+	while (pos <= names.size())
+	{
+		size_t end = names.find(',', pos);
+		if (end == std::string::npos)
+			end = names.size();
+
+		std::string name = names.substr(pos, end - pos);
+		for (char& c : name) c = std::tolower(c);
+
+		if (name == "all")
+			categories |= (uint32_t)TraceCategory::All;
+
+		for (const CategoryName& entry : CategoryNames)
+		{
+			std::string entryName = entry.Name;
+			for (char& c : entryName) c = std::tolower(c);
+			if (name == entryName)
+				categories |= (uint32_t)entry.Category;
+		}
+
+		pos = end + 1;
+	}
+	return categories;
+}
+
+uint64_t Trace::GetMicroseconds()
+{
+	return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - StartTime).count();
+}
+
+void Trace::Instant(TraceCategory category, const char* name)
+{
+	Record(category, name, 'i', GetMicroseconds(), 0, "", 0, Echo);
+}
+
+void Trace::Instant(TraceCategory category, const char* name, const std::string& text)
+{
+	Record(category, name, 'i', GetMicroseconds(), 0, text.data(), text.size(), Echo);
+}
+
+void Trace::Complete(TraceCategory category, const char* name, uint64_t startMicroseconds)
+{
+	// Scopes are too frequent to be worth echoing
+	Record(category, name, 'X', startMicroseconds, GetMicroseconds() - startMicroseconds, "", 0, false);
+}
+
+std::string Trace::ToChromeJson()
+{
+	std::string json = "{\"traceEvents\":[";
+	bool first = true;
+
+	std::unique_lock<std::mutex> lock(BuffersMutex);
+	std::vector<TraceEvent> events;
+	for (auto& buffer : Buffers)
+	{
+		uint64_t head = buffer->Head.load(std::memory_order_acquire);
+		uint64_t start = std::max(head > TraceBuffer::Capacity ? head - TraceBuffer::Capacity : 0, buffer->Tail.load());
+
+		events.clear();
+		for (uint64_t i = start; i < head; i++)
+			events.push_back(buffer->Events[i % TraceBuffer::Capacity]);
+
+		// The slot after the newest published event can be mid-write
+		uint64_t headAfter = buffer->Head.load(std::memory_order_acquire);
+		uint64_t firstValid = headAfter >= TraceBuffer::Capacity ? headAfter - TraceBuffer::Capacity + 1 : 0;
+
+		for (uint64_t i = start; i < head; i++)
+		{
+			if (i < firstValid)
+				continue;
+
+			const TraceEvent& event = events[i - start];
+			json += first ? "\n" : ",\n";
+			first = false;
+
+			json += "{\"name\":";
+			WriteJsonString(json, event.Name);
+			json += ",\"cat\":\"";
+			json += GetCategoryName(event.Category);
+			json += "\",\"ph\":\"";
+			json.push_back(event.Phase);
+			json += "\",\"ts\":" + std::to_string(event.Timestamp);
+			if (event.Phase == 'X')
+				json += ",\"dur\":" + std::to_string(event.Duration);
+			else
+				json += ",\"s\":\"t\"";
+			json += ",\"pid\":1,\"tid\":" + std::to_string(buffer->ThreadId);
+			if (event.Text[0])
+			{
+				json += ",\"args\":{\"text\":";
+				WriteJsonString(json, event.Text);
+				json += "}";
+			}
+			json += "}";
+		}
+	}
+
+	json += "\n]}\n";
+	return json;
+}
+
+void Trace::Clear()
+{
+	// Only the owning threads may write to their buffers, so skip past the old events rather than resetting them
+	std::unique_lock<std::mutex> lock(BuffersMutex);
+	for (auto& buffer : Buffers)
+		buffer->Tail = buffer->Head.load();
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <atomic>
+
+enum class TraceCategory : uint32_t
+{
+	Engine = 1 << 0,
+	Package = 1 << 1,
+	File = 1 << 2,
+	Render = 1 << 3,
+	RenderDevice = 1 << 4,
+	Audio = 1 << 5,
+	VM = 1 << 6,
+	UI = 1 << 7,
+	All = 0xffffffff
+};
+
+// Categories left out of this mask compile to nothing
+#ifndef SURREAL_TRACE_CATEGORIES
+#define SURREAL_TRACE_CATEGORIES 0xffffffff
+#endif
+
+// Timeline of engine events that can be exported as Chrome trace JSON (chrome://tracing or ui.perfetto.dev).
+//
+// Every thread records into its own ring buffer, so recording never takes a lock. When a category is
+// disabled, the TRACE macros cost a single relaxed load and don't evaluate their arguments.
+class Trace
+{
+public:
+	static bool IsEnabled(TraceCategory category) { return (EnabledCategories.load(std::memory_order_relaxed) & (uint32_t)category) != 0; }
+
+	static void Enable(uint32_t categories);
+	static void Disable(uint32_t categories);
+	static uint32_t GetEnabled() { return EnabledCategories.load(std::memory_order_relaxed); }
+
+	// Also print the recorded events to stdout, as the engine's debug prints used to
+	static void SetEcho(bool value) { Echo = value; }
+
+	static uint32_t ParseCategories(const std::string& names);
+
+	static void Instant(TraceCategory category, const char* name);
+	static void Instant(TraceCategory category, const char* name, const std::string& text);
+	static void Complete(TraceCategory category, const char* name, uint64_t startMicroseconds);
+
+	static uint64_t GetMicroseconds();
+
+	// Collects the events from all threads. Only the newest events of each thread are still in its buffer.
+	static std::string ToChromeJson();
+	static void Clear();
+
+private:
+	static std::atomic<uint32_t> EnabledCategories;
+	static std::atomic<bool> Echo;
+};
+
+class TraceScope
+{
+public:
+	TraceScope(TraceCategory category, const char* name) : Category(category), Name(name)
+	{
+		if (Trace::IsEnabled(category))
+		{
+			Active = true;
+			Start = Trace::GetMicroseconds();
+		}
+	}
+
+	~TraceScope()
+	{
+		if (Active)
+			Trace::Complete(Category, Name, Start);
+	}
+
+private:
+	TraceScope(const TraceScope&) = delete;
+	TraceScope& operator=(const TraceScope&) = delete;
+
+	TraceCategory Category;
+	const char* Name;
+	uint64_t Start = 0;
+	bool Active = false;
+};
+
+#define TRACE_ENABLED(category) ((((uint32_t)(category)) & (SURREAL_TRACE_CATEGORIES)) != 0 && Trace::IsEnabled(category))
+#define TRACE_EVENT(category, name) do { if (TRACE_ENABLED(category)) Trace::Instant(category, name); } while (0)
+#define TRACE_EVENT_TEXT(category, name, text) do { if (TRACE_ENABLED(category)) Trace::Instant(category, name, text); } while (0)
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_SCOPE(category, name) TraceScope TRACE_CONCAT(traceScope, __LINE__)((((uint32_t)(category)) & (SURREAL_TRACE_CATEGORIES)) != 0 ? (category) : (TraceCategory)0, name)
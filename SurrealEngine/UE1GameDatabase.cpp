@@ -2,8 +2,8 @@
 
 #include "File.h"
 #include "TinySHA1/TinySHA1.hpp"
+#include "Trace.h"
 #include <filesystem>
-#include <iostream>
 
 std::pair<KnownUE1Games, std::string> FindUE1GameInPath(const std::string& ue1_game_root_folder_path)
 {
@@ -21,14 +21,12 @@ std::pair<KnownUE1Games, std::string> FindUE1GameInPath(const std::string& ue1_g
 	{
 		std::string executable_path = FilePath::combine(ue1_game_system_path, executable_name);
 
-		std::cout << "executable_path: " << executable_path << std::endl;
+		TRACE_EVENT_TEXT(TraceCategory::File, "FindGameExecutable", executable_path);
 
 		// return std::make_pair(KnownUE1Games::UT99_469d, executable_name);
 
 		if (File::try_open_existing(executable_path))
 		{
-			std::cout << "File::try_open_existing(executable_path)" << std::endl;
-			
 			// Such executable exists, let's try to take SHA1Sum of it
 			auto bytes = File::read_all_bytes(executable_path, 1);
 
@@ -46,7 +44,7 @@ std::pair<KnownUE1Games, std::string> FindUE1GameInPath(const std::string& ue1_g
 			auto it = SHA1Database.find(sha1sum);
 
 			if (it == SHA1Database.end()) {
-				std::cout << "std::make_pair(KnownUE1Games::UE1_GAME_NOT_FOUND, "")" << std::endl;
+				TRACE_EVENT(TraceCategory::File, "UnknownGameExecutable");
 				return std::make_pair(KnownUE1Games::UE1_GAME_NOT_FOUND, "");
 			}
 
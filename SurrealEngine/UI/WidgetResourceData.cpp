@@ -3,7 +3,7 @@
 #include "File.h"
 #include <miniz.h>
 #include "Exception.h"
-#include <iostream>
+#include "Trace.h"
 
 static mz_zip_archive widgetResources;
 
@@ -12,14 +12,11 @@ void InitWidgetResources()
 	#ifdef EMSCRIPTEN
 		auto path = std::string("SurrealEngine.pk3");
 	#else
-		auto executablePath = OS::executable_path();
-		std::cout << "executablePath: " << executablePath << std::endl;	
 		auto path = FilePath::combine(OS::executable_path(), "SurrealEngine.pk3");
 	#endif
 
-	std::cout << "path: " << path << std::endl;
 	mz_bool result = mz_zip_reader_init_file(&widgetResources, path.c_str(), 0);
-	std::cout << "result: " << result << std::endl;
+	TRACE_EVENT_TEXT(TraceCategory::UI, "OpenWidgetResources", path);
 
 	if (!result) {
 		Exception::Throw("Could not open SurrealEngine.pk3");
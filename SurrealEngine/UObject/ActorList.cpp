@@ -0,0 +1,98 @@
+
+#include "Precomp.h"
+#include "ActorList.h"
+#include "UActor.h"
+
+void ActorList::Add(UActor* actor)
+{
+	// Map files can have empty entries in their actor list
+	if (!actor)
+	{
+		Dense.push_back(nullptr);
+		Holes++;
+		return;
+	}
+
+	if (actor->LevelListInfo.Slot < Slots.size() && Slots[actor->LevelListInfo.Slot].Actor == actor)
+		return;
+
+	uint32_t slot;
+	if (!FreeSlots.empty())
+	{
+		slot = FreeSlots.back();
+		FreeSlots.pop_back();
+	}
+	else
+	{
+		slot = (uint32_t)Slots.size();
+		Slots.push_back({});
+	}
+	Slots[slot].Actor = actor;
+
+	actor->LevelListInfo.Slot = slot;
+	actor->LevelListInfo.Index = (uint32_t)Dense.size();
+	Dense.push_back(actor);
+}
+
+void ActorList::Remove(UActor* actor)
+{
+	uint32_t slot = actor->LevelListInfo.Slot;
+	if (slot >= Slots.size() || Slots[slot].Actor != actor)
+		return;
+
+	Dense[actor->LevelListInfo.Index] = nullptr;
+	Holes++;
+
+	Slots[slot].Actor = nullptr;
+	Slots[slot].Generation++;
+	FreeSlots.push_back(slot);
+	actor->LevelListInfo.Slot = ActorHandle::InvalidSlot;
+}
+
+void ActorList::Compact()
+{
+	if (Holes == 0)
+		return;
+
+	size_t count = 0;
+	for (UActor* actor : Dense)
+	{
+		if (actor)
+		{
+			actor->LevelListInfo.Index = (uint32_t)count;
+			Dense[count++] = actor;
+		}
+	}
+	Dense.resize(count);
+	Holes = 0;
+}
+
+void ActorList::Clear()
+{
+	for (UActor* actor : Dense)
+	{
+		if (actor)
+			Remove(actor);
+	}
+	Dense.clear();
+	Holes = 0;
+}
+
+ActorHandle ActorList::GetHandle(UActor* actor) const
+{
+	ActorHandle handle;
+	uint32_t slot = actor ? actor->LevelListInfo.Slot : (uint32_t)ActorHandle::InvalidSlot;
+	if (slot < Slots.size() && Slots[slot].Actor == actor)
+	{
+		handle.Slot = slot;
+		handle.Generation = Slots[slot].Generation;
+	}
+	return handle;
+}
+
+UActor* ActorList::Resolve(const ActorHandle& handle) const
+{
+	if (handle.Slot < Slots.size() && Slots[handle.Slot].Generation == handle.Generation)
+		return Slots[handle.Slot].Actor;
+	return nullptr;
+}
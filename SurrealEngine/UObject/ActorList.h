@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+class UActor;
+
+// Refers to an actor without keeping it alive. Resolves to null once the actor is destroyed, even if its slot was reused.
+struct ActorHandle
+{
+	enum { InvalidSlot = 0xffffffff };
+
+	uint32_t Slot = InvalidSlot;
+	uint32_t Generation = 0;
+
+	bool operator==(const ActorHandle& other) const { return Slot == other.Slot && Generation == other.Generation; }
+	bool operator!=(const ActorHandle& other) const { return !(*this == other); }
+};
+
+// The actors of a level.
+//
+// The actors are kept in a dense array in spawn order, which is the order UnrealScript iterators see them in.
+// Removing an actor only clears its entry, so loops indexing the array while actors are destroyed stay valid.
+// Compact then closes the gaps in place once the level tick is done. Every actor also gets a slot that its
+// handles resolve through, and the slots of destroyed actors are reused by the next ones spawned.
+class ActorList
+{
+public:
+	void Add(UActor* actor);
+	void Remove(UActor* actor);
+	void Compact();
+	void Clear();
+
+	ActorHandle GetHandle(UActor* actor) const;
+	UActor* Resolve(const ActorHandle& handle) const;
+
+	// Entries, including the ones cleared since the last Compact
+	size_t size() const { return Dense.size(); }
+	bool empty() const { return Dense.empty(); }
+	UActor* operator[](size_t index) const { return Dense[index]; }
+	UActor* front() const { return Dense.front(); }
+	std::vector<UActor*>::const_iterator begin() const { return Dense.begin(); }
+	std::vector<UActor*>::const_iterator end() const { return Dense.end(); }
+
+	size_t GetLiveCount() const { return Dense.size() - Holes; }
+
+private:
+	struct Slot
+	{
+		UActor* Actor = nullptr;
+		uint32_t Generation = 0;
+	};
+
+	std::vector<UActor*> Dense;
+	std::vector<Slot> Slots;
+	std::vector<uint32_t> FreeSlots;
+	size_t Holes = 0;
+};
@@ -0,0 +1,95 @@
+
+#include "Precomp.h"
+#include "ActorPool.h"
+#include "UActor.h"
+#include "UClass.h"
+
+UActor* ActorPool::Spawn(UClass* cls)
+{
+	auto it = Pools.find(cls);
+	if (it == Pools.end())
+		return nullptr;
+
+	ClassPool& pool = it->second;
+	pool.IdleTime = 0.0f;
+	if (pool.Free.empty())
+		return nullptr;
+
+	UActor* actor = pool.Free.back();
+	pool.Free.pop_back();
+
+	actor->PropertyData.Init(cls);
+	actor->SetObject("Class", actor->Class);
+	actor->SetName("Name", actor->Name);
+	actor->SetInt("ObjectFlags", (int)actor->Flags);
+	return actor;
+}
+
+bool ActorPool::Recycle(UActor* actor)
+{
+	ClassPool& pool = GetClassPool(actor->Class);
+	if (!pool.Poolable || pool.Free.size() >= MaxFreePerClass)
+		return false;
+
+	actor->PropertyData.DestructValues();
+	actor->StateFrame.reset();
+	actor->DisabledEvents.clear();
+	actor->Flags = ObjectFlags::Transient;
+
+	actor->CollisionHashInfo = {};
+	actor->LightInfo = {};
+	actor->FogInfo = {};
+	actor->BspInfo = {};
+	actor->LevelListInfo = {};
+	actor->TweenFromAnimFrame = {};
+	actor->LastDrawFrame = -1;
+	actor->SleepTimeLeft = 0.0f;
+	actor->ChildActors.clear();
+
+	pool.Free.push_back(actor);
+	return true;
+}
+
+void ActorPool::Update(float elapsed)
+{
+	for (auto& it : Pools)
+	{
+		ClassPool& pool = it.second;
+		if (pool.Free.empty())
+			continue;
+
+		pool.IdleTime += elapsed;
+		if (pool.IdleTime >= IdleTimeout)
+		{
+			pool.Free.clear();
+			pool.Free.shrink_to_fit();
+		}
+	}
+}
+
+void ActorPool::GetObjectRoots(std::vector<UObject*>& roots) const
+{
+	for (const auto& it : Pools)
+		roots.insert(roots.end(), it.second.Free.begin(), it.second.Free.end());
+}
+
+ActorPool::ClassPool& ActorPool::GetClassPool(UClass* cls)
+{
+	auto it = Pools.find(cls);
+	if (it != Pools.end())
+		return it->second;
+
+	ClassPool& pool = Pools[cls];
+	pool.Poolable = IsPoolable(cls);
+	return pool;
+}
+
+bool ActorPool::IsPoolable(UClass* cls)
+{
+	for (UStruct* cur = cls; cur != nullptr; cur = cur->BaseStruct)
+	{
+		if (cur->Name == "Projectile" || cur->Name == "Effects" || cur->Name == "Decal")
+			return true;
+	}
+	return false;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+
+class UObject;
+class UActor;
+class UClass;
+class ULevel;
+
+// Recycles the actors of the classes spawned and destroyed at a high rate: projectiles, effects and decals.
+//
+// A destroyed actor is left to the garbage collector like any other. Once the collector has proven that nothing
+// reaches it anymore, it hands the actor to Recycle instead of deleting it. The property values owning memory are
+// released and the actor is kept for the next Spawn of its class, which initializes the property data again from
+// a copy of the class defaults. The actors kept for a class are dropped once it stops being spawned, which leaves
+// them to the garbage collector again.
+class ActorPool
+{
+public:
+	UActor* Spawn(UClass* cls);
+	bool Recycle(UActor* actor);
+	void Update(float elapsed);
+	void GetObjectRoots(std::vector<UObject*>& roots) const;
+
+private:
+	struct ClassPool
+	{
+		bool Poolable = false;
+		float IdleTime = 0.0f;
+		std::vector<UActor*> Free;
+	};
+
+	ClassPool& GetClassPool(UClass* cls);
+
+	static bool IsPoolable(UClass* cls);
+
+	enum { MaxFreePerClass = 64 };
+	static constexpr float IdleTimeout = 10.0f;
+
+	std::unordered_map<UClass*, ClassPool> Pools;
+};
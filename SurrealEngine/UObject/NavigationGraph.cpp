@@ -0,0 +1,333 @@
+
+#include "Precomp.h"
+#include "NavigationGraph.h"
+#include "UActor.h"
+#include "ULevel.h"
+#include <queue>
+#include <climits>
+
+void NavigationGraph::Build(ULevel* level)
+{
+	Clear();
+
+	// Reach specs refer to actors by their index in the actor list as it was loaded
+	for (LevelReachSpec& spec : level->ReachSpecs)
+	{
+		spec.Start = (spec.startActor >= 0 && (size_t)spec.startActor < level->Actors.size()) ? level->Actors[spec.startActor] : nullptr;
+		spec.End = (spec.endActor >= 0 && (size_t)spec.endActor < level->Actors.size()) ? level->Actors[spec.endActor] : nullptr;
+	}
+
+	for (UActor* actor : level->Actors)
+	{
+		UNavigationPoint* navPoint = actor ? UObject::TryCast<UNavigationPoint>(actor) : nullptr;
+		if (navPoint && NodeIndex.find(navPoint) == NodeIndex.end())
+		{
+			NodeIndex[navPoint] = (int)Nodes.size();
+			Nodes.push_back(navPoint);
+			NodeLocations.push_back(navPoint->Location());
+			NodeExtraCosts.push_back(navPoint->ExtraCost());
+		}
+	}
+
+	// Pruned specs are redundant paths where a route of about the same length exists through other nodes
+	std::vector<std::pair<int, int>> links;
+	std::vector<const LevelReachSpec*> linkSpecs;
+	for (const LevelReachSpec& spec : level->ReachSpecs)
+	{
+		int start = FindNode(spec.Start);
+		int end = FindNode(spec.End);
+		if (start >= 0 && end >= 0 && start != end && !spec.bPruned)
+		{
+			links.push_back({ start, end });
+			linkSpecs.push_back(&spec);
+		}
+	}
+
+	size_t count = Nodes.size();
+	EdgeStart.assign(count + 1, 0);
+	ReverseEdgeStart.assign(count + 1, 0);
+	for (const auto& link : links)
+	{
+		EdgeStart[link.first + 1]++;
+		ReverseEdgeStart[link.second + 1]++;
+	}
+	for (size_t i = 0; i < count; i++)
+	{
+		EdgeStart[i + 1] += EdgeStart[i];
+		ReverseEdgeStart[i + 1] += ReverseEdgeStart[i];
+	}
+
+	Edges.resize(links.size());
+	ReverseEdges.resize(links.size());
+	std::vector<uint32_t> edgePos(EdgeStart.begin(), EdgeStart.end() - 1);
+	std::vector<uint32_t> reversePos(ReverseEdgeStart.begin(), ReverseEdgeStart.end() - 1);
+	for (size_t i = 0; i < links.size(); i++)
+	{
+		const LevelReachSpec* spec = linkSpecs[i];
+		NavEdge edge;
+		edge.Distance = std::max(spec->distance, 1);
+		edge.CollisionRadius = spec->collisionRadius;
+		edge.CollisionHeight = spec->collisionHeight;
+		edge.ReachFlags = spec->reachFlags;
+
+		edge.Target = links[i].second;
+		Edges[edgePos[links[i].first]++] = edge;
+
+		edge.Target = links[i].first;
+		ReverseEdges[reversePos[links[i].second]++] = edge;
+	}
+}
+
+void NavigationGraph::Clear()
+{
+	Nodes.clear();
+	NodeLocations.clear();
+	NodeExtraCosts.clear();
+	NodeIndex.clear();
+	EdgeStart.clear();
+	Edges.clear();
+	ReverseEdgeStart.clear();
+	ReverseEdges.clear();
+	Profiles.clear();
+	RouteTables.clear();
+	ExtraCostsValidatedTime = -1.0f;
+}
+
+int NavigationGraph::FindNode(UActor* actor) const
+{
+	if (!actor)
+		return -1;
+
+	// Inventory items point at their marker
+	if (UInventory* inventory = UObject::TryCast<UInventory>(actor))
+	{
+		if (inventory->myMarker())
+			actor = inventory->myMarker();
+	}
+
+	auto it = NodeIndex.find(actor);
+	return it != NodeIndex.end() ? it->second : -1;
+}
+
+NavMoveProfile NavigationGraph::GetMoveProfile(UPawn* pawn)
+{
+	NavMoveProfile profile;
+	if (pawn->bCanWalk()) profile.ReachFlags |= R_WALK;
+	if (pawn->bCanFly()) profile.ReachFlags |= R_FLY;
+	if (pawn->bCanSwim()) profile.ReachFlags |= R_SWIM;
+	if (pawn->bCanJump()) profile.ReachFlags |= R_JUMP;
+	if (pawn->bCanOpenDoors()) profile.ReachFlags |= R_DOOR;
+	if (pawn->bCanDoSpecial()) profile.ReachFlags |= R_SPECIAL;
+	if (pawn->bIsPlayer()) profile.ReachFlags |= R_PLAYERONLY;
+	profile.CollisionRadius = (int)pawn->CollisionRadius();
+	profile.CollisionHeight = (int)pawn->CollisionHeight();
+	return profile;
+}
+
+UActor* NavigationGraph::FindPathToward(UPawn* pawn, UActor* goal)
+{
+	if (!goal)
+		return nullptr;
+	return FindPath(pawn, goal->Location(), FindNode(goal));
+}
+
+UActor* NavigationGraph::FindPathTo(UPawn* pawn, const vec3& goal)
+{
+	return FindPath(pawn, goal, -1);
+}
+
+UNavigationPoint* NavigationGraph::FindRandomDest(UPawn* pawn)
+{
+	if (Nodes.empty())
+		return nullptr;
+
+	ValidateExtraCosts(pawn);
+	if (RouteTables.size() + MaxCandidates >= MaxCachedRoutes)
+		RouteTables.clear();
+
+	FindNearbyNodes(pawn, pawn->Location(), StartCandidates);
+	if (StartCandidates.empty())
+		return nullptr;
+
+	NavMoveProfile profile = GetMoveProfile(pawn);
+	for (int attempt = 0; attempt < MaxCandidates; attempt++)
+	{
+		int goal = std::rand() % (int)Nodes.size();
+		const NavRouteTable& table = GetRouteTable(profile, goal);
+		for (const Candidate& start : StartCandidates)
+		{
+			if (start.Node != goal && table.Cost[start.Node] != INT_MAX)
+				return Nodes[goal];
+		}
+	}
+	return nullptr;
+}
+
+UActor* NavigationGraph::FindPath(UPawn* pawn, const vec3& goalPos, int goalNode)
+{
+	if (Nodes.empty())
+		return nullptr;
+
+	ValidateExtraCosts(pawn);
+	if (RouteTables.size() + MaxCandidates >= MaxCachedRoutes)
+		RouteTables.clear();
+
+	FindNearbyNodes(pawn, pawn->Location(), StartCandidates);
+	if (StartCandidates.empty())
+		return nullptr;
+
+	GoalCandidates.clear();
+	if (goalNode >= 0)
+		GoalCandidates.push_back({ goalNode, 0 });
+	else
+		FindNearbyNodes(pawn, goalPos, GoalCandidates);
+
+	NavMoveProfile profile = GetMoveProfile(pawn);
+	const NavRouteTable* bestTable = nullptr;
+	int bestStart = -1;
+	int64_t bestCost = INT64_MAX;
+	for (const Candidate& goal : GoalCandidates)
+	{
+		const NavRouteTable& table = GetRouteTable(profile, goal.Node);
+		for (const Candidate& start : StartCandidates)
+		{
+			if (table.Cost[start.Node] == INT_MAX)
+				continue;
+
+			int64_t cost = (int64_t)start.Cost + table.Cost[start.Node] + goal.Cost;
+			if (cost < bestCost)
+			{
+				bestCost = cost;
+				bestTable = &table;
+				bestStart = start.Node;
+			}
+		}
+	}
+
+	if (!bestTable)
+		return nullptr;
+
+	// Skip the first node if we are already standing on it
+	int first = bestStart;
+	int next = bestTable->NextHop[first];
+	if (next >= 0)
+	{
+		vec3 delta = NodeLocations[first] - pawn->Location();
+		float touchDist = pawn->CollisionRadius() + Nodes[first]->CollisionRadius();
+		if (dot(delta, delta) < touchDist * touchDist)
+			first = next;
+	}
+
+	StoreRoute(pawn, *bestTable, first);
+	return Nodes[first];
+}
+
+void NavigationGraph::FindNearbyNodes(UPawn* pawn, const vec3& pos, std::vector<Candidate>& candidates)
+{
+	const float maxDist = 1200.0f;
+
+	candidates.clear();
+	for (size_t i = 0; i < NodeLocations.size(); i++)
+	{
+		vec3 delta = NodeLocations[i] - pos;
+		float dist2 = dot(delta, delta);
+		if (dist2 < maxDist * maxDist)
+			candidates.push_back({ (int)i, (int)std::sqrt(dist2) });
+	}
+
+	std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) { return a.Cost < b.Cost; });
+
+	// Keep the closest nodes that are visible from the position
+	size_t found = 0;
+	for (size_t i = 0; i < candidates.size() && found < (size_t)MaxCandidates; i++)
+	{
+		if (pawn->FastTrace(NodeLocations[candidates[i].Node], pos))
+			candidates[found++] = candidates[i];
+	}
+	candidates.resize(found);
+}
+
+const NavRouteTable& NavigationGraph::GetRouteTable(const NavMoveProfile& profile, int goal)
+{
+	auto itProfile = std::find(Profiles.begin(), Profiles.end(), profile);
+	uint64_t profileIndex = itProfile - Profiles.begin();
+	if (itProfile == Profiles.end())
+		Profiles.push_back(profile);
+
+	uint64_t key = (profileIndex << 32) | (uint32_t)goal;
+	auto it = RouteTables.find(key);
+	if (it != RouteTables.end())
+		return it->second;
+
+	NavRouteTable& table = RouteTables[key];
+	table.Cost.assign(Nodes.size(), INT_MAX);
+	table.NextHop.assign(Nodes.size(), -1);
+	table.Cost[goal] = 0;
+
+	// Dijkstra search along the incoming edges, starting at the goal
+	typedef std::pair<int32_t, int32_t> QueueItem;
+	std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>> queue;
+	queue.push({ 0, goal });
+	while (!queue.empty())
+	{
+		QueueItem item = queue.top();
+		queue.pop();
+
+		int32_t node = item.second;
+		if (item.first != table.Cost[node])
+			continue;
+
+		int32_t enterCost = item.first + std::max(NodeExtraCosts[node], 0);
+		for (uint32_t i = ReverseEdgeStart[node], end = ReverseEdgeStart[node + 1]; i < end; i++)
+		{
+			const NavEdge& edge = ReverseEdges[i];
+			if ((edge.ReachFlags & ~profile.ReachFlags) != 0 || edge.CollisionRadius < profile.CollisionRadius || edge.CollisionHeight < profile.CollisionHeight)
+				continue;
+
+			int32_t cost = enterCost + edge.Distance;
+			if (cost < table.Cost[edge.Target])
+			{
+				table.Cost[edge.Target] = cost;
+				table.NextHop[edge.Target] = node;
+				queue.push({ cost, edge.Target });
+			}
+		}
+	}
+
+	return table;
+}
+
+void NavigationGraph::ValidateExtraCosts(UPawn* pawn)
+{
+	// Scripts can change ExtraCost at any time (blocked paths, lifts). Check once per tick and drop the routes if anything changed.
+	float time = pawn->Level()->TimeSeconds();
+	if (time == ExtraCostsValidatedTime)
+		return;
+	ExtraCostsValidatedTime = time;
+
+	bool changed = false;
+	for (size_t i = 0; i < Nodes.size(); i++)
+	{
+		int32_t extraCost = Nodes[i]->ExtraCost();
+		if (NodeExtraCosts[i] != extraCost)
+		{
+			NodeExtraCosts[i] = extraCost;
+			changed = true;
+		}
+	}
+
+	if (changed)
+		RouteTables.clear();
+}
+
+void NavigationGraph::StoreRoute(UPawn* pawn, const NavRouteTable& table, int start)
+{
+	UNavigationPoint** routeCache = &pawn->RouteCache();
+	int node = start;
+	for (int i = 0; i < MaxRouteCache; i++)
+	{
+		routeCache[i] = node >= 0 ? Nodes[node] : nullptr;
+		if (node >= 0)
+			node = table.NextHop[node];
+	}
+}
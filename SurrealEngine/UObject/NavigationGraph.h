@@ -0,0 +1,106 @@
+#pragma once
+
+#include "Math/vec.h"
+#include <vector>
+#include <unordered_map>
+
+class ULevel;
+class UActor;
+class UPawn;
+class UNavigationPoint;
+
+enum EReachSpecFlags
+{
+	R_WALK = 1,
+	R_FLY = 2,
+	R_SWIM = 4,
+	R_JUMP = 8,
+	R_DOOR = 16,
+	R_SPECIAL = 32,
+	R_PLAYERONLY = 64
+};
+
+// What a pawn is able to traverse. Routes are cached per profile.
+struct NavMoveProfile
+{
+	int ReachFlags = 0;
+	int CollisionRadius = 0;
+	int CollisionHeight = 0;
+
+	bool operator==(const NavMoveProfile& other) const { return ReachFlags == other.ReachFlags && CollisionRadius == other.CollisionRadius && CollisionHeight == other.CollisionHeight; }
+};
+
+struct NavEdge
+{
+	int32_t Target;
+	int32_t Distance;
+	int32_t CollisionRadius;
+	int32_t CollisionHeight;
+	int32_t ReachFlags;
+};
+
+// Cost to reach a goal node from every node in the graph, and which node to go to next
+struct NavRouteTable
+{
+	std::vector<int32_t> Cost;
+	std::vector<int32_t> NextHop;
+};
+
+// Navigation graph built from the level reach specs.
+//
+// The edges are stored in compressed sparse row form. Route queries run a Dijkstra search backwards from the
+// goal node, which gives the next hop toward that goal from every other node. These tables are cached per
+// movement profile and goal, so repeated queries toward the same goal only cost a table lookup.
+class NavigationGraph
+{
+public:
+	void Build(ULevel* level);
+	void Clear();
+
+	// Returns the actor the pawn should move toward next, or nullptr if the goal can't be reached. Fills the pawn's RouteCache.
+	UActor* FindPathToward(UPawn* pawn, UActor* goal);
+	UActor* FindPathTo(UPawn* pawn, const vec3& goal);
+	UNavigationPoint* FindRandomDest(UPawn* pawn);
+
+	int FindNode(UActor* actor) const;
+	int GetNodeCount() const { return (int)Nodes.size(); }
+	size_t GetCachedRouteCount() const { return RouteTables.size(); }
+
+	static NavMoveProfile GetMoveProfile(UPawn* pawn);
+
+	static const int MaxRouteCache = 16;
+
+private:
+	struct Candidate
+	{
+		int Node;
+		int Cost;
+	};
+
+	UActor* FindPath(UPawn* pawn, const vec3& goalPos, int goalNode);
+	void FindNearbyNodes(UPawn* pawn, const vec3& pos, std::vector<Candidate>& candidates);
+	const NavRouteTable& GetRouteTable(const NavMoveProfile& profile, int goal);
+	void ValidateExtraCosts(UPawn* pawn);
+	void StoreRoute(UPawn* pawn, const NavRouteTable& table, int start);
+
+	std::vector<UNavigationPoint*> Nodes;
+	std::vector<vec3> NodeLocations;
+	std::vector<int32_t> NodeExtraCosts;
+	std::unordered_map<UActor*, int> NodeIndex;
+
+	// Outgoing and incoming edges for each node in CSR form
+	std::vector<uint32_t> EdgeStart;
+	std::vector<NavEdge> Edges;
+	std::vector<uint32_t> ReverseEdgeStart;
+	std::vector<NavEdge> ReverseEdges;
+
+	std::vector<NavMoveProfile> Profiles;
+	std::unordered_map<uint64_t, NavRouteTable> RouteTables;
+	float ExtraCostsValidatedTime = -1.0f;
+
+	std::vector<Candidate> StartCandidates;
+	std::vector<Candidate> GoalCandidates;
+
+	static const size_t MaxCachedRoutes = 4096;
+	static const int MaxCandidates = 4;
+};
@@ -0,0 +1,180 @@
+
+#include "Precomp.h"
+#include "PawnPerception.h"
+#include "UActor.h"
+#include "ULevel.h"
+#include "VM/ScriptCall.h"
+#include "Lib/JobSystem.h"
+#include "Math/coords.h"
+
+void PawnPerception::AddNoise(UActor* source, float loudness)
+{
+	UPawn* noisePawn = UObject::Cast<UPawn>(source->Instigator());
+	if (noisePawn)
+		Noises.push_back({ source, noisePawn, loudness });
+}
+
+void PawnPerception::Update(ULevel* level, ULevelInfo* levelInfo, float elapsed)
+{
+	Queries.clear();
+
+	if (levelInfo && levelInfo->NetMode() != NM_Client)
+	{
+		Pawns.clear();
+		for (UPawn* pawn = levelInfo->PawnList(); pawn != nullptr; pawn = pawn->nextPawn())
+		{
+			if (!pawn->bDeleteMe())
+				Pawns.push_back(pawn);
+		}
+
+		GatherSightQueries(elapsed);
+		GatherHearingQueries();
+		TraceQueries(level);
+		DispatchEvents();
+	}
+
+	LastQueryCount = (int)Queries.size();
+	Noises.clear();
+}
+
+void PawnPerception::GatherSightQueries(float elapsed)
+{
+	for (UPawn* pawn : Pawns)
+	{
+		pawn->SightCounter() -= elapsed;
+		if (pawn->SightCounter() >= 0.0f)
+			continue;
+		pawn->SightCounter() += 0.15f + 0.1f * (float)(std::rand() / (double)RAND_MAX);
+
+		vec3 eyePos = pawn->Location();
+		eyePos.z += pawn->BaseEyeHeight();
+
+		bool seePlayer = pawn->IsEventEnabled(EventName::SeePlayer);
+		bool seeMonster = pawn->IsEventEnabled(EventName::SeeMonster);
+		if (seePlayer || seeMonster)
+		{
+			for (UPawn* target : Pawns)
+			{
+				if (target == pawn || target->bHidden() || target->Health() <= 0)
+					continue;
+
+				bool isPlayer = target->bIsPlayer();
+				if ((isPlayer && !seePlayer) || (!isPlayer && !seeMonster) || !IsInSightCone(pawn, eyePos, target))
+					continue;
+
+				PerceptionQuery query;
+				query.Event = isPlayer ? PerceptionEvent::SeePlayer : PerceptionEvent::SeeMonster;
+				query.Pawn = pawn;
+				query.Target = target;
+				query.Start = eyePos;
+				query.Ends[0] = target->Location();
+				query.Ends[1] = target->Location() + vec3(0.0f, 0.0f, target->CollisionHeight() * 0.5f);
+				query.Ends[2] = target->Location() - vec3(0.0f, 0.0f, target->CollisionHeight() * 0.5f);
+				query.NumRays = 3;
+				Queries.push_back(query);
+			}
+		}
+
+		UPawn* enemy = pawn->Enemy();
+		if (enemy && !enemy->bDeleteMe() && pawn->IsEventEnabled(EventName::EnemyNotVisible))
+		{
+			PerceptionQuery query;
+			query.Event = PerceptionEvent::EnemyNotVisible;
+			query.Pawn = pawn;
+			query.Target = enemy;
+			query.Start = eyePos;
+			query.Ends[0] = enemy->Location();
+			query.Ends[1] = enemy->Location() + vec3(0.0f, 0.0f, enemy->CollisionHeight() * 0.5f);
+			query.Ends[2] = enemy->Location() - vec3(0.0f, 0.0f, enemy->CollisionHeight() * 0.5f);
+			query.NumRays = 3;
+			Queries.push_back(query);
+		}
+	}
+}
+
+void PawnPerception::GatherHearingQueries()
+{
+	for (const Noise& noise : Noises)
+	{
+		for (UPawn* pawn : Pawns)
+		{
+			if (pawn == noise.NoisePawn || !pawn->IsEventEnabled(EventName::HearNoise) || !pawn->IsNoiseAudible(noise.Source, noise.Loudness))
+				continue;
+
+			PerceptionQuery query;
+			query.Event = PerceptionEvent::HearNoise;
+			query.Pawn = pawn;
+			query.Target = noise.Source;
+			query.Loudness = noise.Loudness;
+			query.Start = noise.Source->Location();
+			query.Ends[0] = pawn->Location();
+			query.NumRays = 1;
+			Queries.push_back(query);
+		}
+	}
+}
+
+void PawnPerception::TraceQueries(ULevel* level)
+{
+	// Only the static level geometry is traced. This only reads from the BSP and is safe to do from multiple threads.
+	JobSystem::ParallelFor(Queries.size(), 16, [&](size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; i++)
+			{
+				PerceptionQuery& query = Queries[i];
+				query.Visible = false;
+				for (int ray = 0; ray < query.NumRays && !query.Visible; ray++)
+				{
+					query.Visible = !level->TraceRayAnyHit(query.Start, query.Ends[ray], query.Pawn, false, true, false);
+				}
+			}
+		});
+}
+
+void PawnPerception::DispatchEvents()
+{
+	for (const PerceptionQuery& query : Queries)
+	{
+		// An earlier event in this pass may have destroyed the pawn or changed its mind
+		if (query.Pawn->bDeleteMe())
+			continue;
+
+		switch (query.Event)
+		{
+		case PerceptionEvent::SeePlayer:
+			if (query.Visible && !query.Target->bDeleteMe())
+				CallEvent(query.Pawn, EventName::SeePlayer, { ExpressionValue::ObjectValue(query.Target) });
+			break;
+		case PerceptionEvent::SeeMonster:
+			if (query.Visible && !query.Target->bDeleteMe())
+				CallEvent(query.Pawn, EventName::SeeMonster, { ExpressionValue::ObjectValue(query.Target) });
+			break;
+		case PerceptionEvent::EnemyNotVisible:
+			if (!query.Visible && query.Pawn->Enemy() == query.Target)
+				CallEvent(query.Pawn, EventName::EnemyNotVisible);
+			break;
+		case PerceptionEvent::HearNoise:
+			if (query.Visible && !query.Target->bDeleteMe())
+				CallEvent(query.Pawn, EventName::HearNoise, { ExpressionValue::FloatValue(query.Loudness), ExpressionValue::ObjectValue(query.Target) });
+			break;
+		}
+	}
+}
+
+bool PawnPerception::IsInSightCone(UPawn* pawn, const vec3& eyePos, UActor* target)
+{
+	vec3 delta = target->Location() - eyePos;
+	float dist2 = dot(delta, delta);
+	if (dist2 > pawn->SightRadius() * pawn->SightRadius())
+		return false;
+
+	// PeripheralVision is the cosine of the half angle of the view cone
+	if (dist2 > 0.0f)
+	{
+		vec3 forward = Coords::Rotation(pawn->Rotation()).XAxis;
+		if (dot(forward, delta) < pawn->PeripheralVision() * std::sqrt(dist2))
+			return false;
+	}
+
+	return true;
+}
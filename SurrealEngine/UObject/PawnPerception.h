@@ -0,0 +1,65 @@
+#pragma once
+
+#include "Math/vec.h"
+#include <vector>
+
+class ULevel;
+class ULevelInfo;
+class UActor;
+class UPawn;
+
+enum class PerceptionEvent
+{
+	SeePlayer,
+	SeeMonster,
+	EnemyNotVisible,
+	HearNoise
+};
+
+struct PerceptionQuery
+{
+	PerceptionEvent Event = PerceptionEvent::SeePlayer;
+	UPawn* Pawn = nullptr;
+	UActor* Target = nullptr;
+	float Loudness = 0.0f;
+
+	// Line of sight succeeds if any of the rays from Start reach their end point
+	vec3 Start = vec3(0.0f);
+	vec3 Ends[3] = { vec3(0.0f), vec3(0.0f), vec3(0.0f) };
+	int NumRays = 0;
+	bool Visible = false;
+};
+
+// Once per tick sight and hearing stage for pawns.
+//
+// Queries are gathered on the game thread, the line of sight traces against the level BSP run in parallel,
+// and then the SeePlayer, SeeMonster, HearNoise and EnemyNotVisible events are sent in the order the
+// queries were gathered (pawn list order).
+class PawnPerception
+{
+public:
+	void AddNoise(UActor* source, float loudness);
+	void Update(ULevel* level, ULevelInfo* levelInfo, float elapsed);
+
+	int GetLastQueryCount() const { return LastQueryCount; }
+
+private:
+	struct Noise
+	{
+		UActor* Source;
+		UPawn* NoisePawn;
+		float Loudness;
+	};
+
+	void GatherSightQueries(float elapsed);
+	void GatherHearingQueries();
+	void TraceQueries(ULevel* level);
+	void DispatchEvents();
+
+	static bool IsInSightCone(UPawn* pawn, const vec3& eyePos, UActor* target);
+
+	std::vector<Noise> Noises;
+	std::vector<UPawn*> Pawns;
+	std::vector<PerceptionQuery> Queries;
+	int LastQueryCount = 0;
+};
@@ -0,0 +1,807 @@
+
+#include "Precomp.h"
+#include "SaveGame.h"
+#include "UActor.h"
+#include "UClass.h"
+#include "UClient.h"
+#include "ULevel.h"
+#include "UProperty.h"
+#include "USubsystem.h"
+#include "Package/Package.h"
+#include "Package/PackageManager.h"
+#include "Render/RenderSubsystem.h"
+#include "VM/Frame.h"
+#include "VM/Bytecode.h"
+#include "Engine.h"
+#include "File.h"
+#include <algorithm>
+
+// "SSAV". Bump the version whenever the layout of the file changes.
+static const uint32_t SaveGameMagic = 0x56415353;
+static const uint32_t SaveGameVersion = 3;
+
+enum class SavedObjectRef : uint8_t
+{
+	None,
+	Saved,			// Index into the object table of the save
+	LevelExport,	// Export index in the map package
+	PackageExport,	// Package name and export index
+	EngineObject	// One of the objects the engine creates at startup, like the viewport
+};
+
+SaveGame::~SaveGame()
+{
+	if (Writer.joinable())
+		Writer.join();
+}
+
+std::string SaveGame::GetFilename(int slot)
+{
+	return FilePath::combine(FilePath::combine(engine->LaunchInfo.gameRootFolder, "Save"), "SESave" + std::to_string(slot) + ".sav");
+}
+
+void SaveGame::Flush()
+{
+	if (Writer.joinable())
+		Writer.join();
+
+	std::unique_lock<std::mutex> lock(WriteErrorMutex);
+	if (!WriteError.empty())
+	{
+		engine->LogMessage("Could not write savegame: " + WriteError);
+		WriteError.clear();
+	}
+}
+
+void SaveGame::Save(int slot, const std::string& description)
+{
+	if (!engine->Level || !engine->LevelInfo)
+		return;
+
+	if (engine->net)
+	{
+		engine->LogMessage("Savegames are not supported in network games");
+		return;
+	}
+
+	Flush();
+
+	Objects.clear();
+	ObjectIndex.clear();
+	Names.clear();
+	NameIndex.clear();
+	EngineObjects = GetEngineObjects();
+
+	for (UActor* actor : engine->Level->Actors)
+	{
+		if (actor && !actor->bDeleteMe())
+		{
+			ObjectIndex[actor] = (uint32_t)Objects.size();
+			Objects.push_back(actor);
+		}
+	}
+
+	// Writing an object can add the runtime objects it references to the end of the list
+	NetWriter body;
+	for (size_t i = 0; i < Objects.size(); i++)
+		WriteObjectState(body, Objects[i]);
+
+	NetWriter table;
+	table.WriteVarUInt((uint32_t)Objects.size());
+	for (UObject* obj : Objects)
+	{
+		if (obj->package == engine->LevelPackage && engine->LevelPackage->IsExportObject(obj))
+		{
+			table.WriteUInt8(0);
+			table.WriteVarUInt(obj->exportIndex);
+		}
+		else
+		{
+			table.WriteUInt8(1);
+			WriteObject(table, obj->Class);
+			WriteName(table, obj->Name);
+			table.WriteVarUInt((uint32_t)obj->Flags);
+		}
+		table.WriteVarUInt((uint32_t)obj->PropertyData.Size);
+	}
+
+	UPlayerPawn* player = engine->viewport ? engine->viewport->Actor() : nullptr;
+	auto it = player ? ObjectIndex.find(player) : ObjectIndex.end();
+	table.WriteVarUInt(it != ObjectIndex.end() ? it->second + 1 : 0);
+
+	NetWriter file;
+	file.WriteUInt32(SaveGameMagic);
+	file.WriteUInt32(SaveGameVersion);
+	file.WriteString(description);
+	file.WriteString(engine->LevelInfo->URL.ToString());
+	file.WriteVarUInt((uint32_t)Names.size());
+	for (const NameString& name : Names)
+		file.WriteString(name.ToString());
+	file.WriteBytes(table.Data.data(), table.Size());
+	file.WriteBytes(body.Data.data(), body.Size());
+
+	size_t objectCount = Objects.size();
+	Objects.clear();
+	ObjectIndex.clear();
+	Names.clear();
+	NameIndex.clear();
+
+	// The game continues while the file is written
+	std::string filename = GetFilename(slot);
+	Writer = std::thread([this, filename, data = std::move(file.Data)]()
+	{
+		try
+		{
+			Directory::make_directory(FilePath::remove_last_component(filename));
+			File::write_all_bytes(filename, data.data(), data.size());
+		}
+		catch (const std::exception& e)
+		{
+			std::unique_lock<std::mutex> lock(WriteErrorMutex);
+			WriteError = e.what();
+		}
+	});
+
+	engine->LogMessage("Saved " + std::to_string(objectCount) + " objects to " + filename);
+}
+
+bool SaveGame::Load(int slot)
+{
+	Flush();
+
+	std::string filename = GetFilename(slot);
+	std::vector<uint8_t> data;
+	try
+	{
+		data = File::read_all_bytes(filename, 1002);
+	}
+	catch (const std::exception&)
+	{
+		engine->LogMessage("Could not open savegame " + filename);
+		return false;
+	}
+
+	NetReader reader(data.data(), data.size());
+	if (reader.ReadUInt32() != SaveGameMagic || reader.ReadUInt32() != SaveGameVersion)
+	{
+		engine->LogMessage(filename + " is not a savegame of this version");
+		return false;
+	}
+
+	std::string description = reader.ReadString();
+	UnrealURL url(reader.ReadString());
+
+	Objects.clear();
+	ObjectIndex.clear();
+	Names.clear();
+	NameIndex.clear();
+
+	uint32_t nameCount = reader.ReadVarUInt();
+	if (nameCount > reader.GetRemaining())
+	{
+		engine->LogMessage("Savegame " + filename + " is damaged");
+		return false;
+	}
+	Names.reserve(nameCount);
+	for (uint32_t i = 0; i < nameCount; i++)
+		Names.push_back(NameString(reader.ReadString()));
+
+	engine->LoadMap(url);
+
+	ULevel* level = engine->Level;
+	EngineObjects = GetEngineObjects();
+
+	// Find the map actors and create everything else before reading any state, so that all references can be resolved
+	bool matches = true;
+	uint32_t objectCount = reader.ReadVarUInt();
+	for (uint32_t i = 0; i < objectCount && matches && !reader.HasError(); i++)
+	{
+		UObject* obj = nullptr;
+		if (reader.ReadUInt8() == 0)
+		{
+			uint32_t exportIndex = reader.ReadVarUInt();
+			if (exportIndex < engine->LevelPackage->GetExportCount())
+				obj = engine->LevelPackage->GetUObject(exportIndex + 1);
+		}
+		else
+		{
+			UClass* cls = UObject::TryCast<UClass>(ReadObject(reader));
+			NameString name = ReadName(reader);
+			ObjectFlags flags = (ObjectFlags)reader.ReadVarUInt();
+			if (cls)
+				obj = engine->packages->GetPackage("Engine", 1003)->NewObject(name, cls, flags, true);
+		}
+
+		uint32_t size = reader.ReadVarUInt();
+		if (!obj || obj->PropertyData.Size != size)
+		{
+			matches = false;
+			break;
+		}
+
+		ObjectIndex[obj] = (uint32_t)Objects.size();
+		Objects.push_back(obj);
+	}
+	uint32_t playerIndex = reader.ReadVarUInt();
+
+	if (!matches || reader.HasError())
+	{
+		engine->LogMessage("Savegame " + filename + " does not match the installed game data");
+		for (UObject* obj : Objects)
+		{
+			UActor* actor = UObject::TryCast<UActor>(obj);
+			if (actor && actor->XLevel() != level)
+				actor->bDeleteMe() = true;
+		}
+		Objects.clear();
+		ObjectIndex.clear();
+		engine->LoginPlayer();
+		return false;
+	}
+
+	for (UActor* actor : level->Actors)
+	{
+		if (actor)
+		{
+			actor->RemoveFromBspNode();
+			level->Hash.RemoveFromCollision(actor);
+		}
+	}
+
+	for (UObject* obj : Objects)
+		ReadObjectState(reader, obj);
+
+	if (reader.HasError())
+	{
+		engine->LogMessage("Savegame " + filename + " is damaged");
+		Objects.clear();
+		ObjectIndex.clear();
+		engine->LoadMap(url);
+		engine->LoginPlayer();
+		return false;
+	}
+
+	// Map actors that were destroyed before the game was saved, and anything the map spawned while loading, are gone
+	for (UActor* actor : level->Actors)
+	{
+		if (actor && ObjectIndex.find(actor) == ObjectIndex.end())
+		{
+			// The garbage collector sets the references to the actor to None, as it does for UActor::Destroy
+			actor->bDeleteMe() = true;
+			actor->Flags = actor->Flags | ObjectFlags::EliminateObject;
+		}
+	}
+
+	level->Actors.Clear();
+	for (UObject* obj : Objects)
+	{
+		UActor* actor = UObject::TryCast<UActor>(obj);
+		if (actor && !actor->bDeleteMe())
+		{
+			actor->XLevel() = level;
+			level->Actors.Add(actor);
+			level->Hash.AddToCollision(actor);
+			actor->MarkBspDirty();
+		}
+	}
+
+	engine->GameInfo = UObject::TryCast<UGameInfo>(engine->LevelInfo->Game());
+
+	UPlayerPawn* player = (playerIndex > 0 && playerIndex <= Objects.size()) ? UObject::TryCast<UPlayerPawn>(Objects[playerIndex - 1]) : nullptr;
+	Objects.clear();
+	ObjectIndex.clear();
+
+	if (player && engine->viewport)
+	{
+		engine->viewport->Actor() = player;
+		player->Player() = engine->viewport;
+		if (engine->render)
+			engine->render->OnMapLoaded();
+	}
+	else
+	{
+		engine->LoginPlayer();
+	}
+
+	engine->LogMessage("Loaded " + filename + (description.empty() ? std::string() : " (" + description + ")"));
+	return true;
+}
+
+void SaveGame::WriteObjectState(NetWriter& writer, UObject* obj)
+{
+	uint8_t* data = static_cast<uint8_t*>(obj->PropertyData.Data);
+	if (obj->PropertyData.Class)
+	{
+		const ClassLayout& layout = GetLayout(obj->PropertyData.Class);
+		for (const RawRun& run : layout.Runs)
+			writer.WriteBytes(data + run.Offset, run.Size);
+
+		for (const Field& field : layout.Fields)
+		{
+			void* ptr = data + field.Offset;
+			switch (field.Type)
+			{
+			case FieldType::Name: WriteName(writer, *static_cast<NameString*>(ptr)); break;
+			case FieldType::String: writer.WriteString(*static_cast<std::string*>(ptr)); break;
+			case FieldType::Object: WriteObject(writer, *static_cast<UObject**>(ptr)); break;
+			case FieldType::Array: WriteArray(writer, field.Prop, ptr); break;
+			case FieldType::Bits: writer.WriteUInt32(*static_cast<uint32_t*>(ptr) & field.Mask); break;
+			}
+		}
+	}
+
+	// Latent state code continues from the statement it was at
+	Frame* frame = obj->StateFrame.get();
+	if (frame)
+	{
+		writer.WriteUInt8(1);
+		WriteObject(writer, frame->Func);
+		writer.WriteVarUInt((uint32_t)frame->StatementIndex);
+		writer.WriteUInt8((uint8_t)frame->LatentState);
+
+		// Sleep counts down in a native member. The other latent states wait on property values.
+		if (UActor* actor = UObject::TryCast<UActor>(obj))
+			writer.WriteFloat(actor->SleepTimeLeft);
+	}
+	else
+	{
+		writer.WriteUInt8(0);
+	}
+
+	writer.WriteVarUInt((uint32_t)obj->DisabledEvents.size());
+	for (auto& it : obj->DisabledEvents)
+	{
+		WriteName(writer, it.first);
+		writer.WriteVarUInt((uint32_t)it.second.size());
+		for (const NameString& name : it.second)
+			WriteName(writer, name);
+	}
+}
+
+void SaveGame::ReadObjectState(NetReader& reader, UObject* obj)
+{
+	uint8_t* data = static_cast<uint8_t*>(obj->PropertyData.Data);
+	if (obj->PropertyData.Class)
+	{
+		const ClassLayout& layout = GetLayout(obj->PropertyData.Class);
+		for (const RawRun& run : layout.Runs)
+			reader.ReadBytes(data + run.Offset, run.Size);
+
+		for (const Field& field : layout.Fields)
+		{
+			void* ptr = data + field.Offset;
+			switch (field.Type)
+			{
+			case FieldType::Name: *static_cast<NameString*>(ptr) = ReadName(reader); break;
+			case FieldType::String: *static_cast<std::string*>(ptr) = reader.ReadString(); break;
+			case FieldType::Object: *static_cast<UObject**>(ptr) = ReadObject(reader); break;
+			case FieldType::Array: ReadArray(reader, field.Prop, ptr); break;
+			case FieldType::Bits:
+			{
+				uint32_t& bits = *static_cast<uint32_t*>(ptr);
+				bits = (bits & ~field.Mask) | (reader.ReadUInt32() & field.Mask);
+				break;
+			}
+			}
+		}
+	}
+
+	if (reader.ReadUInt8() != 0)
+	{
+		UStruct* func = UObject::TryCast<UStruct>(ReadObject(reader));
+		size_t statementIndex = reader.ReadVarUInt();
+		LatentRunState latentState = (LatentRunState)reader.ReadUInt8();
+		if (UActor* actor = UObject::TryCast<UActor>(obj))
+			actor->SleepTimeLeft = reader.ReadFloat();
+
+		obj->StateFrame = std::make_shared<Frame>(obj, func);
+		if (func && func->Code && statementIndex < func->Code->Statements.size())
+		{
+			obj->StateFrame->StatementIndex = statementIndex;
+			obj->StateFrame->LatentState = latentState;
+		}
+	}
+	else
+	{
+		obj->StateFrame.reset();
+	}
+
+	obj->DisabledEvents.clear();
+	uint32_t stateCount = reader.ReadVarUInt();
+	for (uint32_t i = 0; i < stateCount && !reader.HasError(); i++)
+	{
+		std::set<NameString>& events = obj->DisabledEvents[ReadName(reader)];
+		uint32_t eventCount = reader.ReadVarUInt();
+		for (uint32_t j = 0; j < eventCount && !reader.HasError(); j++)
+			events.insert(ReadName(reader));
+	}
+}
+
+const SaveGame::ClassLayout& SaveGame::GetLayout(UClass* cls)
+{
+	auto it = Layouts.find(cls);
+	if (it != Layouts.end())
+		return it->second;
+
+	// 0 = padding, 1 = copied as is, 2 = written as a field or not saved
+	std::vector<uint8_t> rawBytes(cls->StructSize, 0);
+	std::map<uint32_t, uint32_t> transientBits;
+	ClassLayout layout;
+	for (UProperty* prop : cls->Properties)
+	{
+		// Transient properties keep the value they got when the map or object was created
+		if (AllFlags(prop->PropFlags, PropertyFlags::Transient))
+		{
+			if (dynamic_cast<UBoolProperty*>(prop))
+				transientBits[(uint32_t)prop->DataOffset.DataOffset] |= prop->DataOffset.BitfieldMask;
+			else
+				std::fill(rawBytes.begin() + prop->DataOffset.DataOffset, rawBytes.begin() + prop->DataOffset.DataOffset + prop->Size(), 2);
+			continue;
+		}
+		AddLayoutValue(prop, prop->DataOffset.DataOffset, rawBytes, layout.Fields);
+	}
+
+	// A bitfield word holding both saved and transient booleans only has its saved bits written
+	for (const auto& it : transientBits)
+	{
+		if (rawBytes[it.first] == 1)
+		{
+			layout.Fields.push_back({ FieldType::Bits, it.first, nullptr, ~it.second });
+			std::fill(rawBytes.begin() + it.first, rawBytes.begin() + it.first + sizeof(uint32_t), 2);
+		}
+	}
+
+	// Copy short runs of padding along rather than starting a new run
+	for (size_t i = 0; i < rawBytes.size();)
+	{
+		if (rawBytes[i] != 1)
+		{
+			i++;
+			continue;
+		}
+
+		size_t start = i;
+		size_t end = i;
+		while (i < rawBytes.size() && rawBytes[i] != 2 && i - end < 8)
+		{
+			if (rawBytes[i] == 1)
+				end = i + 1;
+			i++;
+		}
+		layout.Runs.push_back({ (uint32_t)start, (uint32_t)(end - start) });
+	}
+
+	return Layouts.emplace(cls, std::move(layout)).first->second;
+}
+
+void SaveGame::AddLayoutValue(UProperty* prop, size_t offset, std::vector<uint8_t>& rawBytes, std::vector<Field>& fields)
+{
+	if (dynamic_cast<UBoolProperty*>(prop))
+	{
+		AddLayoutElement(prop, offset, rawBytes, fields);
+		return;
+	}
+
+	size_t elementSize = prop->ElementSize();
+	for (int i = 0; i < prop->ArrayDimension; i++)
+		AddLayoutElement(prop, offset + i * elementSize, rawBytes, fields);
+}
+
+void SaveGame::AddLayoutElement(UProperty* prop, size_t offset, std::vector<uint8_t>& rawBytes, std::vector<Field>& fields)
+{
+	auto mark = [&](uint8_t value) { std::fill(rawBytes.begin() + offset, rawBytes.begin() + offset + prop->ElementSize(), value); };
+
+	if (dynamic_cast<UBoolProperty*>(prop) || dynamic_cast<UByteProperty*>(prop) || dynamic_cast<UIntProperty*>(prop) || dynamic_cast<UFloatProperty*>(prop))
+	{
+		mark(1);
+	}
+	else if (dynamic_cast<UNameProperty*>(prop))
+	{
+		fields.push_back({ FieldType::Name, (uint32_t)offset, prop });
+		mark(2);
+	}
+	else if (dynamic_cast<UStrProperty*>(prop) || dynamic_cast<UStringProperty*>(prop))
+	{
+		fields.push_back({ FieldType::String, (uint32_t)offset, prop });
+		mark(2);
+	}
+	else if (dynamic_cast<UObjectProperty*>(prop))
+	{
+		fields.push_back({ FieldType::Object, (uint32_t)offset, prop });
+		mark(2);
+	}
+	else if (dynamic_cast<UArrayProperty*>(prop))
+	{
+		fields.push_back({ FieldType::Array, (uint32_t)offset, prop });
+		mark(2);
+	}
+	else if (UStructProperty* structProp = dynamic_cast<UStructProperty*>(prop))
+	{
+		if (structProp->Struct)
+		{
+			for (UProperty* member : structProp->Struct->Properties)
+				AddLayoutValue(member, offset + member->DataOffset.DataOffset, rawBytes, fields);
+		}
+	}
+	else if (UFixedArrayProperty* fixedArray = dynamic_cast<UFixedArrayProperty*>(prop))
+	{
+		size_t innerSize = fixedArray->Inner->Size();
+		for (int i = 0; i < fixedArray->Count; i++)
+			AddLayoutValue(fixedArray->Inner, offset + i * innerSize, rawBytes, fields);
+	}
+	else
+	{
+		// Maps and native pointers are not saved
+		mark(2);
+	}
+}
+
+void SaveGame::WriteValue(NetWriter& writer, UProperty* prop, void* data)
+{
+	if (dynamic_cast<UBoolProperty*>(prop))
+	{
+		WriteElement(writer, prop, data);
+		return;
+	}
+
+	size_t elementSize = prop->ElementSize();
+	for (int i = 0; i < prop->ArrayDimension; i++)
+		WriteElement(writer, prop, static_cast<uint8_t*>(data) + i * elementSize);
+}
+
+void SaveGame::ReadValue(NetReader& reader, UProperty* prop, void* data)
+{
+	if (dynamic_cast<UBoolProperty*>(prop))
+	{
+		ReadElement(reader, prop, data);
+		return;
+	}
+
+	size_t elementSize = prop->ElementSize();
+	for (int i = 0; i < prop->ArrayDimension; i++)
+		ReadElement(reader, prop, static_cast<uint8_t*>(data) + i * elementSize);
+}
+
+void SaveGame::WriteElement(NetWriter& writer, UProperty* prop, void* data)
+{
+	if (UBoolProperty* boolProp = dynamic_cast<UBoolProperty*>(prop))
+	{
+		writer.WriteUInt8(boolProp->GetBool(data) ? 1 : 0);
+	}
+	else if (dynamic_cast<UByteProperty*>(prop) || dynamic_cast<UIntProperty*>(prop) || dynamic_cast<UFloatProperty*>(prop))
+	{
+		writer.WriteBytes(data, prop->ElementSize());
+	}
+	else if (dynamic_cast<UNameProperty*>(prop))
+	{
+		WriteName(writer, *static_cast<NameString*>(data));
+	}
+	else if (dynamic_cast<UStrProperty*>(prop) || dynamic_cast<UStringProperty*>(prop))
+	{
+		writer.WriteString(*static_cast<std::string*>(data));
+	}
+	else if (dynamic_cast<UObjectProperty*>(prop))
+	{
+		WriteObject(writer, *static_cast<UObject**>(data));
+	}
+	else if (dynamic_cast<UArrayProperty*>(prop))
+	{
+		WriteArray(writer, prop, data);
+	}
+	else if (UStructProperty* structProp = dynamic_cast<UStructProperty*>(prop))
+	{
+		if (structProp->Struct)
+		{
+			for (UProperty* member : structProp->Struct->Properties)
+				WriteValue(writer, member, static_cast<uint8_t*>(data) + member->DataOffset.DataOffset);
+		}
+	}
+	else if (UFixedArrayProperty* fixedArray = dynamic_cast<UFixedArrayProperty*>(prop))
+	{
+		size_t innerSize = fixedArray->Inner->Size();
+		for (int i = 0; i < fixedArray->Count; i++)
+			WriteValue(writer, fixedArray->Inner, static_cast<uint8_t*>(data) + i * innerSize);
+	}
+}
+
+void SaveGame::ReadElement(NetReader& reader, UProperty* prop, void* data)
+{
+	if (UBoolProperty* boolProp = dynamic_cast<UBoolProperty*>(prop))
+	{
+		boolProp->SetBool(data, reader.ReadUInt8() != 0);
+	}
+	else if (dynamic_cast<UByteProperty*>(prop) || dynamic_cast<UIntProperty*>(prop) || dynamic_cast<UFloatProperty*>(prop))
+	{
+		reader.ReadBytes(data, prop->ElementSize());
+	}
+	else if (dynamic_cast<UNameProperty*>(prop))
+	{
+		*static_cast<NameString*>(data) = ReadName(reader);
+	}
+	else if (dynamic_cast<UStrProperty*>(prop) || dynamic_cast<UStringProperty*>(prop))
+	{
+		*static_cast<std::string*>(data) = reader.ReadString();
+	}
+	else if (dynamic_cast<UObjectProperty*>(prop))
+	{
+		*static_cast<UObject**>(data) = ReadObject(reader);
+	}
+	else if (dynamic_cast<UArrayProperty*>(prop))
+	{
+		ReadArray(reader, prop, data);
+	}
+	else if (UStructProperty* structProp = dynamic_cast<UStructProperty*>(prop))
+	{
+		if (structProp->Struct)
+		{
+			for (UProperty* member : structProp->Struct->Properties)
+				ReadValue(reader, member, static_cast<uint8_t*>(data) + member->DataOffset.DataOffset);
+		}
+	}
+	else if (UFixedArrayProperty* fixedArray = dynamic_cast<UFixedArrayProperty*>(prop))
+	{
+		size_t innerSize = fixedArray->Inner->Size();
+		for (int i = 0; i < fixedArray->Count; i++)
+			ReadValue(reader, fixedArray->Inner, static_cast<uint8_t*>(data) + i * innerSize);
+	}
+}
+
+void SaveGame::WriteArray(NetWriter& writer, UProperty* prop, void* data)
+{
+	UProperty* inner = static_cast<UArrayProperty*>(prop)->Inner;
+	const std::vector<void*>& elements = *static_cast<std::vector<void*>*>(data);
+	writer.WriteVarUInt((uint32_t)elements.size());
+	for (void* element : elements)
+		WriteValue(writer, inner, element);
+}
+
+void SaveGame::ReadArray(NetReader& reader, UProperty* prop, void* data)
+{
+	// Elements are allocated the same way UArrayProperty::CopyConstruct does it
+	UProperty* inner = static_cast<UArrayProperty*>(prop)->Inner;
+	std::vector<void*>& elements = *static_cast<std::vector<void*>*>(data);
+	for (void* element : elements)
+	{
+		inner->Destruct(element);
+		delete[](int64_t*)element;
+	}
+	elements.clear();
+
+	uint32_t count = reader.ReadVarUInt();
+	if (count > reader.GetRemaining())
+	{
+		reader.Skip(reader.GetRemaining() + 1);
+		return;
+	}
+
+	size_t size = (inner->Size() + 7) / 8;
+	elements.reserve(count);
+	for (uint32_t i = 0; i < count; i++)
+	{
+		int64_t* element = new int64_t[size];
+		inner->Construct(element);
+		elements.push_back(element);
+		ReadValue(reader, inner, element);
+	}
+}
+
+void SaveGame::WriteName(NetWriter& writer, const NameString& name)
+{
+	auto it = NameIndex.find(name.GetCompareIndex());
+	if (it != NameIndex.end())
+	{
+		writer.WriteVarUInt(it->second);
+		return;
+	}
+
+	uint32_t index = (uint32_t)Names.size();
+	Names.push_back(name);
+	NameIndex[name.GetCompareIndex()] = index;
+	writer.WriteVarUInt(index);
+}
+
+NameString SaveGame::ReadName(NetReader& reader)
+{
+	uint32_t index = reader.ReadVarUInt();
+	return index < Names.size() ? Names[index] : NameString();
+}
+
+void SaveGame::WriteObject(NetWriter& writer, UObject* obj)
+{
+	if (!obj)
+	{
+		writer.WriteUInt8((uint8_t)SavedObjectRef::None);
+		return;
+	}
+
+	auto it = ObjectIndex.find(obj);
+	if (it != ObjectIndex.end())
+	{
+		writer.WriteUInt8((uint8_t)SavedObjectRef::Saved);
+		writer.WriteVarUInt(it->second);
+		return;
+	}
+
+	// Destroyed map actors are still exports of the map, but are gone once it has been loaded again
+	UActor* actor = UObject::TryCast<UActor>(obj);
+	if (actor && actor->bDeleteMe())
+	{
+		writer.WriteUInt8((uint8_t)SavedObjectRef::None);
+		return;
+	}
+
+	// Everything loaded from a package comes back with the same export index
+	if (obj->package && obj->package->IsExportObject(obj))
+	{
+		if (obj->package == engine->LevelPackage)
+		{
+			writer.WriteUInt8((uint8_t)SavedObjectRef::LevelExport);
+		}
+		else
+		{
+			writer.WriteUInt8((uint8_t)SavedObjectRef::PackageExport);
+			WriteName(writer, obj->package->GetPackageName());
+		}
+		writer.WriteVarUInt(obj->exportIndex);
+		return;
+	}
+
+	auto engineIt = std::find(EngineObjects.begin(), EngineObjects.end(), obj);
+	if (engineIt != EngineObjects.end())
+	{
+		writer.WriteUInt8((uint8_t)SavedObjectRef::EngineObject);
+		writer.WriteVarUInt((uint32_t)(engineIt - EngineObjects.begin()));
+		return;
+	}
+
+	// Actors of other levels don't exist after loading
+	if (actor)
+	{
+		writer.WriteUInt8((uint8_t)SavedObjectRef::None);
+		return;
+	}
+
+	// A runtime object, like one created with the new operator, is saved along with the actors
+	uint32_t index = (uint32_t)Objects.size();
+	Objects.push_back(obj);
+	ObjectIndex[obj] = index;
+	writer.WriteUInt8((uint8_t)SavedObjectRef::Saved);
+	writer.WriteVarUInt(index);
+}
+
+UObject* SaveGame::ReadObject(NetReader& reader)
+{
+	SavedObjectRef kind = (SavedObjectRef)reader.ReadUInt8();
+	if (kind == SavedObjectRef::Saved)
+	{
+		uint32_t index = reader.ReadVarUInt();
+		return index < Objects.size() ? Objects[index] : nullptr;
+	}
+	else if (kind == SavedObjectRef::LevelExport)
+	{
+		uint32_t index = reader.ReadVarUInt();
+		return index < engine->LevelPackage->GetExportCount() ? engine->LevelPackage->GetUObject(index + 1) : nullptr;
+	}
+	else if (kind == SavedObjectRef::PackageExport)
+	{
+		NameString packageName = ReadName(reader);
+		uint32_t index = reader.ReadVarUInt();
+		if (reader.HasError() || packageName.IsNone() || !engine->packages->PackageExists(packageName, 1004))
+			return nullptr;
+
+		Package* package = engine->packages->GetPackage(packageName, 1005);
+		return index < package->GetExportCount() ? package->GetUObject(index + 1) : nullptr;
+	}
+	else if (kind == SavedObjectRef::EngineObject)
+	{
+		uint32_t index = reader.ReadVarUInt();
+		return index < EngineObjects.size() ? EngineObjects[index] : nullptr;
+	}
+	return nullptr;
+}
+
+std::vector<UObject*> SaveGame::GetEngineObjects()
+{
+	// Never reorder this list, savegames refer to these objects by their position in it
+	return { engine->gameengine, engine->renderdev, engine->audiodev, engine->netdev, engine->client, engine->viewport, engine->canvas, engine->console };
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include "Net/NetPacket.h"
+#include "Package/NameString.h"
+#include <thread>
+#include <mutex>
+#include <unordered_map>
+#include <map>
+
+class UObject;
+class UClass;
+class UStruct;
+class UProperty;
+
+// Binary snapshot of the running level.
+//
+// Saving serializes every live actor, and any runtime object they reference, into memory on the game thread
+// and hands the buffer to a background thread that writes the file. Loading reloads the map and then replaces
+// the state of its actors with the saved one, spawning the actors created during play and removing the ones
+// that were destroyed.
+class SaveGame
+{
+public:
+	~SaveGame();
+
+	static std::string GetFilename(int slot);
+
+	void Save(int slot, const std::string& description);
+	bool Load(int slot);
+
+	// Waits for the last save to reach the disk
+	void Flush();
+
+private:
+	enum class FieldType : uint8_t
+	{
+		Name,
+		String,
+		Object,
+		Array,
+		Bits // Bitfield word shared by saved and transient booleans
+	};
+
+	struct Field
+	{
+		FieldType Type;
+		uint32_t Offset;
+		UProperty* Prop;
+		uint32_t Mask = 0; // Saved bits of a Bits field
+	};
+
+	struct RawRun
+	{
+		uint32_t Offset;
+		uint32_t Size;
+	};
+
+	// Saved parts of a class. Plain old data properties next to each other are copied as one run,
+	// so a typical actor is a few memcpy calls plus its names, strings and object references.
+	struct ClassLayout
+	{
+		std::vector<RawRun> Runs;
+		std::vector<Field> Fields;
+	};
+
+	const ClassLayout& GetLayout(UClass* cls);
+	void AddLayoutValue(UProperty* prop, size_t offset, std::vector<uint8_t>& rawBytes, std::vector<Field>& fields);
+	void AddLayoutElement(UProperty* prop, size_t offset, std::vector<uint8_t>& rawBytes, std::vector<Field>& fields);
+
+	void WriteObjectState(NetWriter& writer, UObject* obj);
+	void WriteValue(NetWriter& writer, UProperty* prop, void* data);
+	void WriteElement(NetWriter& writer, UProperty* prop, void* data);
+	void WriteArray(NetWriter& writer, UProperty* prop, void* data);
+	void WriteName(NetWriter& writer, const NameString& name);
+	void WriteObject(NetWriter& writer, UObject* obj);
+
+	void ReadObjectState(NetReader& reader, UObject* obj);
+	void ReadValue(NetReader& reader, UProperty* prop, void* data);
+	void ReadElement(NetReader& reader, UProperty* prop, void* data);
+	void ReadArray(NetReader& reader, UProperty* prop, void* data);
+	NameString ReadName(NetReader& reader);
+	UObject* ReadObject(NetReader& reader);
+
+	std::vector<UObject*> GetEngineObjects();
+
+	std::unordered_map<UClass*, ClassLayout> Layouts;
+
+	// Tables of the save or load in progress
+	std::vector<UObject*> Objects;
+	std::unordered_map<UObject*, uint32_t> ObjectIndex;
+	std::vector<NameString> Names;
+	std::unordered_map<int, uint32_t> NameIndex;
+	std::vector<UObject*> EngineObjects;
+
+	std::thread Writer;
+	std::mutex WriteErrorMutex;
+	std::string WriteError;
+};
@@ -8,10 +8,11 @@
 #include "VM/Frame.h"
 #include "Package/PackageManager.h"
 #include "Engine.h"
+#include "FrameProfiler.h"
 #include "Collision/TraceAABBModel.h"
 #include "Collision/TraceRayModel.h"
 #include "Collision/OverlapCylinderLevel.h"
-#include <iostream>
+#include "Audio/AudioSubsystem.h"
 
 static std::string tickEventName = "Tick";
 
@@ -51,7 +52,7 @@ static void ApplyRotationPhysics(UActor& actor, float elapsed)
 	}
 }
 
-UActor* UActor::Spawn(UClass* SpawnClass, UActor* SpawnOwner, NameString SpawnTag, vec3* SpawnLocation, Rotator* SpawnRotation)
+UActor* UActor::Spawn(UClass* SpawnClass, UActor* SpawnOwner, NameString SpawnTag, vec3* SpawnLocation, Rotator* SpawnRotation, bool remoteOwned)
 {
 	if (!SpawnClass || SpawnClass->ClsFlags & ClassFlags::Abstract)
 	{
@@ -65,7 +66,7 @@ UActor* UActor::Spawn(UClass* SpawnClass, UActor* SpawnOwner, NameString SpawnTa
 	float height = SpawnClass->GetDefaultObject()->GetFloat("CollisionHeight");
 	bool bCollideWorld = SpawnClass->GetDefaultObject()->GetBool("bCollideWorld");
 	bool bCollideWhenPlacing = SpawnClass->GetDefaultObject()->GetBool("bCollideWhenPlacing");
-	if (bCollideWorld || bCollideWhenPlacing)
+	if ((bCollideWorld || bCollideWhenPlacing) && !remoteOwned)
 	{
 		auto result = CheckLocation(location, radius, height, bCollideWorld || bCollideWhenPlacing);
 		if (!result.first)
@@ -73,10 +74,12 @@ UActor* UActor::Spawn(UClass* SpawnClass, UActor* SpawnOwner, NameString SpawnTa
 		location = result.second;
 	}
 
-	// To do: package needs to be grabbed from outer, or the "transient package" if it is None, a virtual package for runtime objects
-std::cout << "GP20" << std::endl;
-
-	UActor* actor = UObject::Cast<UActor>(engine->packages->GetPackage("Engine", 953)->NewObject("", UObject::Cast<UClass>(SpawnClass), ObjectFlags::Transient, true));
+	UActor* actor = XLevel()->Pool.Spawn(UObject::Cast<UClass>(SpawnClass));
+	if (!actor)
+	{
+		// To do: package needs to be grabbed from outer, or the "transient package" if it is None, a virtual package for runtime objects
+		actor = UObject::Cast<UActor>(engine->packages->GetPackage("Engine", 953)->NewObject("", UObject::Cast<UClass>(SpawnClass), ObjectFlags::Transient, true));
+	}
 
 	actor->Outer() = XLevel()->Outer();
 	actor->XLevel() = XLevel();
@@ -89,11 +92,13 @@ std::cout << "GP20" << std::endl;
 	actor->OldLocation() = location;
 	actor->Rotation() = rotation;
 	actor->Region().Zone = actor->Level();
+	if (remoteOwned)
+		std::swap(actor->Role(), actor->RemoteRole());
 
-	XLevel()->Actors.push_back(actor);
+	XLevel()->Actors.Add(actor);
 	XLevel()->Hash.AddToCollision(actor);
 
-	actor->SetOwner(SpawnOwner ? SpawnOwner : this);
+	actor->SetOwner((SpawnOwner || remoteOwned) ? SpawnOwner : this);
 
 	if (Level()->bBegunPlay())
 	{
@@ -234,6 +239,8 @@ bool UActor::Destroy()
 
 	SetOwner(nullptr);
 
+	// The map and replication set Owner without SetOwner, so ChildActors doesn't have every child.
+	// Finding them is the one part of Destroy that still scans the level.
 	for (size_t i = 0; i < level->Actors.size(); i++)
 	{
 		UActor* actor = level->Actors[i];
@@ -241,15 +248,34 @@ bool UActor::Destroy()
 		{
 			actor->SetOwner(nullptr);
 		}
-		if (actor == this)
-		{
-			level->Actors[i] = nullptr;
-		}
 	}
+	level->Actors.Remove(this);
+
+	// The garbage collector sets the references to the actor to None
+	Flags = Flags | ObjectFlags::EliminateObject;
 
 	return true;
 }
 
+void UActor::ReleaseNativeReferences()
+{
+	// Actors recycled by the pool were detached before their property values were released
+	if (!PropertyData.Class)
+		return;
+
+	// Destroy already did most of this, but script can still move an actor after destroying it
+	if (XLevel())
+	{
+		XLevel()->Hash.RemoveFromCollision(this);
+		RemoveFromBspNode();
+	}
+	if (Owner())
+		Owner()->RemoveChildActor(this);
+
+	if (engine->audio)
+		engine->audio->NoteDestroy(this);
+}
+
 PointRegion UActor::FindRegion(const vec3& offset)
 {
 	return XLevel()->Model->FindRegion(Location() + offset, Level());
@@ -371,6 +397,7 @@ void UActor::Tick(float elapsed, bool tickedFlag)
 
 	if (Role() >= ROLE_SimulatedProxy && StateFrame && StateFrame->LatentState == LatentRunState::Continue)
 	{
+		PROFILE_ZONE(ProfileZone::Script);
 		StateFrame->Tick();
 	}
 
@@ -391,6 +418,7 @@ void UActor::Tick(float elapsed, bool tickedFlag)
 
 void UActor::TickPhysics(float elapsed)
 {
+	PROFILE_ZONE(ProfileZone::Physics);
 	for (float timeLeft = elapsed; timeLeft > 0.0f && !bDeleteMe(); timeLeft -= 0.02f)
 	{
 		float physTimeElapsed = std::min(timeLeft, 0.02f);
@@ -1109,6 +1137,7 @@ bool UActor::SetLocation(const vec3& newLocation)
 	XLevel()->Hash.RemoveFromCollision(this);
 	Location() = result.second;
 	XLevel()->Hash.AddToCollision(this);
+	MarkBspDirty();
 
 	if (Level()->bBegunPlay())
 	{
@@ -1151,6 +1180,7 @@ bool UActor::SetCollisionSize(float newRadius, float newHeight)
 	CollisionRadius() = newRadius;
 	CollisionHeight() = newHeight;
 	XLevel()->Hash.AddToCollision(this);
+	MarkBspDirty();
 	return true;
 }
 
@@ -1272,6 +1302,7 @@ CollisionHit UActor::TryMove(const vec3& delta, bool dryRun)
 	XLevel()->Hash.RemoveFromCollision(this);
 	Location() += actuallyMoved;
 	XLevel()->Hash.AddToCollision(this);
+	MarkBspDirty();
 
 	// Based actors needs to move with us
 	if (StandingCount() > 0)
@@ -1785,13 +1816,8 @@ void UActor::MakeNoise(float loudness)
 		noisePawn->noise2loudness() = loudness;
 	}
 
-	for (UPawn* pawn = Level()->PawnList(); pawn != nullptr; pawn = pawn->nextPawn())
-	{
-		if (pawn != noisePawn && pawn->CanHearNoise(this, loudness))
-		{
-			CallEvent(pawn, EventName::HearNoise, { ExpressionValue::FloatValue(loudness), ExpressionValue::ObjectValue(this) });
-		}
-	}
+	// HearNoise events are sent by the perception pass at the end of the tick
+	XLevel()->Perception.AddNoise(this, loudness);
 }
 
 bool UActor::PlayerCanSeeMe()
@@ -1827,44 +1853,61 @@ bool UActor::PlayerCanSeeMe()
 
 void UActor::UpdateBspInfo()
 {
-	vec3 extents;
+	vec3 extents = GetBspExtents();
+
+	// Is actor still in the bsp tree at the correct location?
+	BspInfo.Dirty = false;
+	if (NeedsBspUpdate(extents))
+	{
+		SetBspNode(FindBspNode(Location(), extents), Location(), extents);
+	}
+}
+
+vec3 UActor::GetBspExtents()
+{
 	if (LightBrightness() == 0)
 	{
-		extents = { VisibilityRadius(), VisibilityRadius(), VisibilityHeight() };
+		return { VisibilityRadius(), VisibilityRadius(), VisibilityHeight() };
 	}
 	else
 	{
-		extents = { WorldLightRadius(), WorldLightRadius(), WorldLightRadius() };
+		return { WorldLightRadius(), WorldLightRadius(), WorldLightRadius() };
 	}
+}
 
-	// Is actor still in the bsp tree at the correct location?
-	if (!BspInfo.Node || BspInfo.Location != Location() || BspInfo.Extents != extents)
+BspNode* UActor::FindBspNode(const vec3& location, const vec3& extents)
+{
+	ULevel* level = XLevel();
+	BspNode* node = level ? &level->Model->Nodes[0] : nullptr;
+	while (node)
 	{
-		RemoveFromBspNode();
-
-		BspInfo.Location = Location();
-		BspInfo.Extents = extents;
-
-		ULevel* level = XLevel();
-		BspNode* node = level ? &level->Model->Nodes[0] : nullptr;
-		while (node)
+		int side = NodeAABBOverlap(location, extents, node);
+		if (side == 0 || (side < 0 && node->Front < 0) || (side > 0 && node->Back < 0))
 		{
-			int side = NodeAABBOverlap(BspInfo.Location, BspInfo.Extents, node);
-			if (side == 0 || (side < 0 && node->Front < 0) || (side > 0 && node->Back < 0))
-			{
-				AddToBspNode(node);
-				break;
-			}
-			else if (side < 0)
-			{
-				node = &level->Model->Nodes[node->Front];
-			}
-			else
-			{
-				node = &level->Model->Nodes[node->Back];
-			}
+			return node;
+		}
+		else if (side < 0)
+		{
+			node = &level->Model->Nodes[node->Front];
+		}
+		else
+		{
+			node = &level->Model->Nodes[node->Back];
 		}
 	}
+	return nullptr;
+}
+
+void UActor::SetBspNode(BspNode* node, const vec3& location, const vec3& extents)
+{
+	RemoveFromBspNode();
+
+	BspInfo.Dirty = false;
+	BspInfo.Location = location;
+	BspInfo.Extents = extents;
+
+	if (node)
+		AddToBspNode(node);
 }
 
 void UActor::AddToBspNode(BspNode* node)
@@ -2032,8 +2075,16 @@ bool UPawn::CanSee(UActor* other)
 }
 
 bool UPawn::CanHearNoise(UActor* source, float loudness)
+{
+	return IsNoiseAudible(source, loudness) && !XLevel()->TraceRayAnyHit(source->Location(), Location(), source, false, true, false);
+}
+
+bool UPawn::IsNoiseAudible(UActor* source, float loudness)
 {
 	UPawn* noisePawn = UObject::Cast<UPawn>(source->Instigator());
+	if (!noisePawn)
+		return false;
+
 	if (!noisePawn->bIsPlayer() && (!noisePawn->Enemy() || !noisePawn->Enemy()->bIsPlayer()))
 	{
 		if (!IsA(source->Class->Name) && !source->IsA(Class->Name))
@@ -2062,7 +2113,7 @@ bool UPawn::CanHearNoise(UActor* source, float loudness)
 		return false;
 	}
 
-	return !XLevel()->TraceRayAnyHit(source->Location(), Location(), source, false, true, false);
+	return true;
 }
 
 UActor* UPawn::PickAnyTarget(float& bestAim, float& bestDist, const vec3& FireDir, const vec3& projStart)
@@ -2250,6 +2301,7 @@ void UPawn::Tick(float elapsed, bool tickedFlag)
 	if (Weapon())
 	{
 		Weapon()->Location() = Location();
+		Weapon()->MarkBspDirty();
 		Weapon()->UpdateActorZone();
 	}
 
@@ -2534,6 +2586,13 @@ void UDecal::DetachDecal()
 	}
 }
 
+void UDecal::ReleaseNativeReferences()
+{
+	if (PropertyData.Class && XLevel())
+		DetachDecal();
+	UActor::ReleaseNativeReferences();
+}
+
 /////////////////////////////////////////////////////////////////////////////
 
 double UMover::TraceTest(ULevel* level, const dvec3& origin, double tmin, const dvec3& direction, double tmax, double height, double radius)
@@ -2,6 +2,7 @@
 
 #include "UObject.h"
 #include "UnrealURL.h"
+#include "ActorList.h"
 
 class UTexture;
 class UMesh;
@@ -148,9 +149,11 @@ class UActor : public UObject
 public:
 	using UObject::UObject;
 
-	UActor* Spawn(UClass* SpawnClass, UActor* SpawnOwner, NameString SpawnTag, vec3* SpawnLocation, Rotator* SpawnRotation);
+	// remoteOwned is for actors a network client creates for the server: they keep the given location and get their roles swapped
+	UActor* Spawn(UClass* SpawnClass, UActor* SpawnOwner, NameString SpawnTag, vec3* SpawnLocation, Rotator* SpawnRotation, bool remoteOwned = false);
 	bool Destroy();
 	void InitBase();
+	void ReleaseNativeReferences() override;
 
 	void SetBase(UActor* newBase, bool sendBaseChangeEvent);
 	void SetOwner(UActor* newOwner);
@@ -217,6 +220,12 @@ public:
 	bool PlayerCanSeeMe();
 
 	void UpdateBspInfo();
+	vec3 GetBspExtents();
+	bool NeedsBspUpdate(const vec3& extents) { return !BspInfo.Node || BspInfo.Location != Location() || BspInfo.Extents != extents; }
+	bool IsBspDirty() { return BspInfo.Dirty || (!bStatic() && LightType() != LT_None); }
+	void MarkBspDirty() { BspInfo.Dirty = true; }
+	BspNode* FindBspNode(const vec3& location, const vec3& extents); // Only reads the BSP so it can run on a worker thread
+	void SetBspNode(BspNode* node, const vec3& location, const vec3& extents);
 	void AddToBspNode(BspNode* node);
 	void RemoveFromBspNode();
 	static int NodeAABBOverlap(const vec3& center, const vec3& extents, BspNode* node);
@@ -235,7 +244,9 @@ public:
 	{
 		bool NeedsUpdate = true;
 		vec3 Location = vec3(0.0f);
-		std::vector<UActor*> LightList;
+		int GridCell = -1;
+		uint32_t GridSerial = 0;
+		std::vector<ActorHandle> LightList; // Kept across frames, so a light destroyed meanwhile resolves to null
 	} LightInfo;
 
 	// Fog between actor and camera
@@ -255,8 +266,16 @@ public:
 		BspNode* Node = nullptr;
 		UActor* Prev = nullptr;
 		UActor* Next = nullptr;
+		bool Dirty = true; // Set when the actor moves or changes size
 	} BspInfo;
 
+	// Position in the actor list of the level
+	struct
+	{
+		uint32_t Slot = ActorHandle::InvalidSlot;
+		uint32_t Index = 0;
+	} LevelListInfo;
+
 	// Tweening animation state
 	struct
 	{
@@ -493,6 +512,7 @@ public:
 
 	UObject* AttachDecal(float traceDistance, const vec3& decalDir);
 	void DetachDecal();
+	void ReleaseNativeReferences() override;
 
 	float& LastRenderedTime() { return Value<float>(PropOffsets_Decal.LastRenderedTime); }
 	int& MultiDecalLevel() { return Value<int>(PropOffsets_Decal.MultiDecalLevel); }
@@ -1412,6 +1432,8 @@ public:
 	// Similar to LineOfSightTo() but takes the Pawn's peripheral vision into account (SightRadius and PeripheralVision)
 	bool CanSee(UActor* other);
 	bool CanHearNoise(UActor* source, float loudness);
+	// CanHearNoise() without the line of sight trace
+	bool IsNoiseAudible(UActor* source, float loudness);
 	bool ActorReachable(UActor* anActor);
 	bool PointReachable(vec3 aPoint);
 
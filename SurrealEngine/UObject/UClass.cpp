@@ -135,6 +135,16 @@ void UStruct::Load(ObjectStream* stream)
 		child = child->Next;
 	}
 
+	PlainData = true;
+	for (UProperty* prop : Properties)
+	{
+		if (!prop->IsPlainData())
+		{
+			PlainData = false;
+			break;
+		}
+	}
+
 	if (FriendlyName == "Vector" || FriendlyName == "Rotator")
 	{
 		size_t alignment = sizeof(uint32_t);
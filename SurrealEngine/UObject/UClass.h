@@ -59,6 +59,7 @@ public:
 
 	size_t StructSize = 0;
 	std::vector<UProperty*> Properties;
+	bool PlainData = false; // All properties can be copied with plain memory operations
 
 private:
 	ExprToken ReadToken(ObjectStream* stream, int depth);
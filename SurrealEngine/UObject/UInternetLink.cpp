@@ -1,15 +1,22 @@
 
 #include "Precomp.h"
 #include "UInternetLink.h"
+#include "UClass.h"
+#include "UProperty.h"
 #include "VM/ScriptCall.h"
 #include "VM/Frame.h"
 #include "Package/PackageManager.h"
+#include "Net/SocketPoller.h"
 #include "Engine.h"
 
 #ifdef WIN32
 #include <WinSock2.h>
 typedef unsigned long in_addr_t;
+typedef int socklen_t;
 #pragma comment(lib, "ws2_32.lib")
+static int GetSocketError() { return WSAGetLastError(); }
+static bool IsWouldBlock(int error) { return error == WSAEWOULDBLOCK; }
+static bool IsConnectPending(int error) { return error == WSAEWOULDBLOCK; }
 #else
 #include <sys/socket.h>
 #include <sys/ioctl.h>
@@ -17,45 +24,116 @@ typedef unsigned long in_addr_t;
 #include <arpa/inet.h>
 #include <netdb.h>
 #include <unistd.h>
+#include <errno.h>
 static int closesocket(int fd) { return close(fd); }
+static int GetSocketError() { return errno; }
+static bool IsWouldBlock(int error) { return error == EWOULDBLOCK || error == EAGAIN || error == EINTR; }
+static bool IsConnectPending(int error) { return error == EINPROGRESS || error == EINTR; }
 #endif
 
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+// IpAddr holds the address and port in host byte order, like the scripts expect
+static sockaddr_in ToSockAddr(const IpAddr& Addr)
+{
+	sockaddr_in addr;
+	memset(&addr, 0, sizeof(sockaddr_in));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl((uint32_t)Addr.Addr);
+	addr.sin_port = htons((uint16_t)Addr.Port);
+	return addr;
+}
+
+static IpAddr FromSockAddr(const sockaddr_in& addr)
+{
+	IpAddr result;
+	result.Addr = (int32_t)ntohl(addr.sin_addr.s_addr);
+	result.Port = ntohs(addr.sin_port);
+	return result;
+}
+
+static void SetNonblocking(socket_t handle)
+{
+#ifdef WIN32
+	u_long nonblocking = 1;
+	ioctlsocket(handle, FIONBIO, &nonblocking);
+#else
+	int nonblocking = 1;
+	ioctl(handle, FIONBIO, &nonblocking);
+#endif
+}
+
 UInternetLink::~UInternetLink()
 {
-	if (Thread.joinable())
-		Thread.join();
+	if (engine && engine->poller)
+		engine->poller->RemoveLink(this);
+	CloseSocket();
+}
+
+void UInternetLink::CreateSocket(int type)
+{
+	handle = socket(AF_INET, type, 0);
+	if (handle != invalid_socket_value)
+	{
+		SetNonblocking(handle);
+
+		int enable = 1;
+		if (type == SOCK_DGRAM)
+			setsockopt(handle, SOL_SOCKET, SO_BROADCAST, (const char*)&enable, sizeof(int));
+#ifndef WIN32
+		else
+			setsockopt(handle, SOL_SOCKET, SO_REUSEADDR, (const char*)&enable, sizeof(int));
+#endif
+	}
+	else
+	{
+		LastError = GetSocketError();
+	}
 }
 
-void UInternetLink::Tick(float elapsed, bool tickedFlag)
+void UInternetLink::CloseSocket()
 {
-	UInternetInfo::Tick(elapsed, tickedFlag);
+	if (handle != invalid_socket_value)
+	{
+		closesocket(handle);
+		handle = invalid_socket_value;
+	}
+}
 
-	std::unique_lock<std::mutex> lock(Mutex);
-	IpAddr resolvedAddr = ResolvedAddr;
-	int resolveStatus = ResolveStatus;
-	if (resolveStatus > 1)
-		ResolveStatus = 0;
-	lock.unlock();
+int UInternetLink::BindSocket(int port, bool useNextAvailable)
+{
+	if (handle == invalid_socket_value)
+		return 0;
 
-	if (ResolveStatus == 2)
+	for (int attempt = 0; attempt < (useNextAvailable ? 20 : 1); attempt++)
 	{
-		UFunction* func = FindEventFunction(this, "Resolved");
-		if (func)
+		sockaddr_in addr;
+		memset(&addr, 0, sizeof(sockaddr_in));
+		addr.sin_family = AF_INET;
+		addr.sin_addr.s_addr = INADDR_ANY;
+		addr.sin_port = htons(port + attempt);
+
+		if (bind(handle, (const sockaddr*)&addr, sizeof(sockaddr_in)) == 0)
 		{
-			UStructProperty prop({}, nullptr, ObjectFlags::NoFlags);
-			prop.Struct = UObject::Cast<UStructProperty>(func->Properties[0])->Struct;
-			CallEvent(this, EventName::Resolved, { ExpressionValue::Variable(&resolvedAddr, &prop) });
+			socklen_t size = sizeof(sockaddr_in);
+			if (getsockname(handle, (sockaddr*)&addr, &size) != 0)
+				return 0;
+
+			LocalIP = FromSockAddr(addr);
+			return LocalIP.Port;
 		}
+
+		LastError = GetSocketError();
+		if (port == 0)
+			break;
 	}
-	else if (ResolveStatus == 3)
-	{
-		CallEvent(this, EventName::ResolveFailed);
-	}
+	return 0;
 }
 
 int UInternetLink::GetLastError()
 {
-	std::unique_lock<std::mutex> lock(Mutex);
 	return LastError;
 }
 
@@ -71,217 +149,525 @@ bool UInternetLink::IsDataPending()
 
 void UInternetLink::Resolve(const std::string& Domain)
 {
-	std::unique_lock<std::mutex> lock(Mutex);
-	if (ResolveStatus != 1)
+	if (engine->poller)
+		engine->poller->Resolve(this, Domain);
+}
+
+void UInternetLink::OnResolved(bool succeeded, uint32_t addr)
+{
+	if (succeeded)
+	{
+		UFunction* func = FindEventFunction(this, "Resolved");
+		if (func)
+		{
+			IpAddr resolvedAddr;
+			resolvedAddr.Addr = (int32_t)addr;
+			resolvedAddr.Port = 0;
+
+			UStructProperty prop({}, nullptr, ObjectFlags::NoFlags);
+			prop.Struct = UObject::Cast<UStructProperty>(func->Properties[0])->Struct;
+			CallEvent(this, EventName::Resolved, { ExpressionValue::Variable(&resolvedAddr, &prop) });
+		}
+	}
+	else
+	{
+		CallEvent(this, EventName::ResolveFailed);
+	}
+}
+
+void UInternetLink::DispatchReceived(const IpAddr* addr, const uint8_t* data, size_t size, std::string* lineBuffer)
+{
+	if (LinkMode() == MODE_Binary)
+	{
+		for (size_t pos = 0; pos < size && !bDeleteMe(); pos += 255)
+			CallReceivedEvent("ReceivedBinary", addr, data + pos, std::min(size - pos, (size_t)255));
+	}
+	else if (LinkMode() == MODE_Line)
 	{
-		ResolveStatus = 1;
+		std::string text = lineBuffer ? std::move(*lineBuffer) : std::string();
+		text.append((const char*)data, size);
 
-		if (Thread.joinable())
-			Thread.detach();
+		size_t start = 0;
+		while (!bDeleteMe())
+		{
+			size_t end = text.find('\n', start);
+			if (end == std::string::npos)
+				break;
+
+			size_t length = end - start;
+			if (length > 0 && text[end - 1] == '\r')
+				length--;
+			CallReceivedEvent("ReceivedLine", addr, (const uint8_t*)text.data() + start, length);
+			start = end + 1;
+		}
 
-		std::string _address = Domain;
-		auto threadMain = [=]()
+		// A peer that never sends a line break doesn't get to grow the buffer without limit
+		while (lineBuffer && text.size() - start >= MaxLineLength && !bDeleteMe())
 		{
-			in_addr_t ipv4_address = inet_addr(_address.c_str());
-			if (ipv4_address == INADDR_NONE)
-			{
-				hostent* host = gethostbyname(_address.c_str());
-				if (host)
-				{
-					ipv4_address = *((in_addr_t*)host->h_addr_list[0]);
-				}
-			}
+			CallReceivedEvent("ReceivedLine", addr, (const uint8_t*)text.data() + start, MaxLineLength);
+			start += MaxLineLength;
+		}
+
+		if (lineBuffer)
+			*lineBuffer = text.substr(start);
+		else if (start < text.size() && !bDeleteMe())
+			CallReceivedEvent("ReceivedLine", addr, (const uint8_t*)text.data() + start, text.size() - start);
+	}
+	else
+	{
+		CallReceivedEvent("ReceivedText", addr, data, size);
+	}
+}
 
-			std::unique_lock<std::mutex> lock2(Mutex);
-			ResolveStatus = (ipv4_address != INADDR_NONE) ? 2 : 3;
-			ResolvedAddr.Addr = ipv4_address;
-			ResolvedAddr.Port = htons(7777);
-		};
+void UInternetLink::CallReceivedEvent(const NameString& eventName, const IpAddr* addr, const uint8_t* data, size_t size)
+{
+	if (!IsEventEnabled(eventName))
+		return;
+
+	UFunction* func = FindEventFunction(this, eventName);
+	if (!func)
+		return;
+
+	// UdpLink events start with the address of the sender
+	std::vector<ExpressionValue> args;
+	IpAddr addrValue;
+	UStructProperty addrProp({}, nullptr, ObjectFlags::NoFlags);
+	if (addr)
+	{
+		addrValue = *addr;
+		addrProp.Struct = UObject::Cast<UStructProperty>(func->Properties[0])->Struct;
+		args.push_back(ExpressionValue::Variable(&addrValue, &addrProp));
+	}
 
-		Thread = std::thread(threadMain);
+	uint8_t bytes[255] = {};
+	UByteProperty bytesProp({}, nullptr, ObjectFlags::NoFlags);
+	if (eventName == "ReceivedBinary")
+	{
+		memcpy(bytes, data, size);
+		bytesProp.ArrayDimension = 255;
+		args.push_back(ExpressionValue::IntValue((int)size));
+		args.push_back(ExpressionValue::Variable(bytes, &bytesProp));
+	}
+	else
+	{
+		args.push_back(ExpressionValue::StringValue(std::string((const char*)data, size)));
 	}
+
+	Frame::Call(func, this, std::move(args));
 }
 
 std::string UInternetLink::IpAddrToString(const IpAddr& Arg)
 {
-	uint32_t addr_long = (uint32_t)ntohl(Arg.Addr);
+	uint32_t addr_long = (uint32_t)Arg.Addr;
 	return
 		std::to_string((addr_long & 0xff000000) >> 24) + "." +
 		std::to_string((addr_long & 0x00ff0000) >> 16) + "." +
 		std::to_string((addr_long & 0x0000ff00) >> 8) + "." +
 		std::to_string(addr_long & 0x000000ff) + ":" +
-		std::to_string(ntohs(Arg.Port));
+		std::to_string(Arg.Port);
 }
 
 bool UInternetLink::StringToIpAddr(const std::string& Str, IpAddr& Addr)
 {
 	size_t portStart = Str.find(':');
-	if (portStart == std::string::npos)
-		portStart = Str.size();
 	in_addr_t ipv4_address = inet_addr(Str.substr(0, portStart).c_str());
-	Addr.Addr = ipv4_address;
-	if (portStart == std::string::npos)
-		Addr.Port = htons(7777);
-	else
-		Addr.Port = htons(std::atoi(Str.substr(portStart + 1).c_str()));
-	return ipv4_address != INADDR_NONE && Addr.Port != 0 && Addr.Port != 0xffff;
+	if (ipv4_address == INADDR_NONE)
+		return false;
+
+	Addr.Addr = (int32_t)ntohl(ipv4_address);
+	Addr.Port = (portStart != std::string::npos) ? std::atoi(Str.substr(portStart + 1).c_str()) : 0;
+	return Addr.Port >= 0 && Addr.Port <= 0xffff;
 }
 
 /////////////////////////////////////////////////////////////////////////////
 
 UTcpLink::UTcpLink(NameString name, UClass* base, ObjectFlags flags) : UInternetLink(name, base, flags)
 {
-	handle = socket(AF_INET, SOCK_STREAM, 0);
+	CreateSocket(SOCK_STREAM);
+	if (engine && engine->poller)
+		engine->poller->AddLink(this);
+}
 
-	if (handle != invalid_socket_value)
+int UTcpLink::GetPollEvents()
+{
+	switch (LinkState())
 	{
-#ifdef WIN32
-		u_long nonblocking = 1;
-		ioctlsocket(handle, FIONBIO, &nonblocking);
-#else
-		int nonblocking = 1;
-		ioctl(handle, FIONBIO, &nonblocking);
-#endif
+	case STATE_Listening:
+		return LinkPoll_Read;
+	case STATE_Connecting:
+		return LinkPoll_Write;
+	case STATE_Connected:
+		// Stop reading while a manual mode link has plenty of unread data. The OS buffers the rest.
+		if (ReceiveMode() == RMODE_Manual && RecvBuffer.size() >= 0x10000)
+			return SendBuffer.empty() ? 0 : LinkPoll_Write;
+		return SendBuffer.empty() ? LinkPoll_Read : LinkPoll_Read | LinkPoll_Write;
+	case STATE_ConnectClosePending:
+		return SendBuffer.empty() ? LinkPoll_Always : LinkPoll_Write;
+	case STATE_ListenClosePending:
+		return LinkPoll_Always;
+	default:
+		return 0;
 	}
 }
 
-UTcpLink::~UTcpLink()
+void UTcpLink::OnSocketEvents(int events)
 {
-	if (handle != invalid_socket_value)
-		closesocket(handle);
+	switch (LinkState())
+	{
+	case STATE_Listening:
+		AcceptConnections();
+		break;
+	case STATE_Connecting:
+		FinishConnect();
+		break;
+	case STATE_Connected:
+		if ((events & LinkPoll_Write) && !FlushSendBuffer())
+		{
+			CloseConnection();
+			break;
+		}
+		if (events & (LinkPoll_Read | LinkPoll_Error))
+			ReceiveData();
+		break;
+	case STATE_ConnectClosePending:
+		if (!FlushSendBuffer() || SendBuffer.empty() || (events & LinkPoll_Error))
+			CloseConnection();
+		break;
+	case STATE_ListenClosePending:
+		CloseConnection();
+		break;
+	}
 }
 
-void UTcpLink::Tick(float elapsed, bool tickedFlag)
+void UTcpLink::AcceptConnections()
 {
-	UInternetLink::Tick(elapsed, tickedFlag);
+	// Limit how many connections are taken each tick, so that a flood of them can't stall the game
+	for (int i = 0; i < 16 && LinkState() == STATE_Listening && !bDeleteMe(); i++)
+	{
+		sockaddr_in addr;
+		memset(&addr, 0, sizeof(sockaddr_in));
+		socklen_t size = sizeof(sockaddr_in);
+		socket_t client = accept(handle, (sockaddr*)&addr, &size);
+		if (client == invalid_socket_value)
+			break;
+
+		SetNonblocking(client);
 
-	// event ReceivedText(string Text);
-	// event ReceivedLine(string Line);
-	// event ReceivedBinary(int Count, byte B[255]);
+		if (AcceptClass())
+		{
+			UTcpLink* link = UObject::TryCast<UTcpLink>(Spawn(AcceptClass(), this, NameString(), nullptr, nullptr));
+			if (!link)
+			{
+				closesocket(client);
+				continue;
+			}
 
-	// event Accepted();
-	// event Opened();
-	// event Closed();
+			link->CloseSocket();
+			link->handle = client;
+			link->LocalIP = LocalIP;
+			link->RemoteAddr() = FromSockAddr(addr);
+			link->LinkState() = STATE_Connected;
+			CallEvent(link, "Accepted");
+		}
+		else
+		{
+			// Without an accept class the listening link takes the connection itself
+			CloseSocket();
+			handle = client;
+			RemoteAddr() = FromSockAddr(addr);
+			LinkState() = STATE_Connected;
+			CallEvent(this, "Accepted");
+		}
+	}
+}
+
+void UTcpLink::FinishConnect()
+{
+	int error = 0;
+	socklen_t size = sizeof(int);
+	if (getsockopt(handle, SOL_SOCKET, SO_ERROR, (char*)&error, &size) != 0)
+		error = GetSocketError();
+
+	if (error != 0)
+	{
+		LastError = error;
+		CloseSocket();
+		CreateSocket(SOCK_STREAM);
+		LinkState() = STATE_Initialized;
+		return;
+	}
+
+	LinkState() = STATE_Connected;
+	CallEvent(this, "Opened");
+}
+
+void UTcpLink::ReceiveData()
+{
+	uint8_t buffer[4096];
+	for (int i = 0; i < 16 && LinkState() == STATE_Connected && !bDeleteMe(); i++)
+	{
+		int received = recv(handle, (char*)buffer, sizeof(buffer), 0);
+		if (received > 0)
+		{
+			if (ReceiveMode() == RMODE_Manual)
+			{
+				RecvBuffer.insert(RecvBuffer.end(), buffer, buffer + received);
+				DataPending() = (int)RecvBuffer.size();
+			}
+			else
+			{
+				DispatchReceived(nullptr, buffer, received, &LineBuffer);
+			}
+		}
+		else
+		{
+			if (received == 0 || !IsWouldBlock(GetSocketError()))
+			{
+				if (received != 0)
+					LastError = GetSocketError();
+				CloseConnection();
+			}
+			break;
+		}
+	}
+}
+
+bool UTcpLink::FlushSendBuffer()
+{
+	size_t pos = 0;
+	while (pos < SendBuffer.size())
+	{
+		int sent = send(handle, (const char*)SendBuffer.data() + pos, (int)std::min(SendBuffer.size() - pos, (size_t)0x10000), MSG_NOSIGNAL);
+		if (sent <= 0)
+		{
+			if (sent < 0 && !IsWouldBlock(GetSocketError()))
+			{
+				LastError = GetSocketError();
+				SendBuffer.clear();
+				return false;
+			}
+			break;
+		}
+		pos += sent;
+	}
+	SendBuffer.erase(SendBuffer.begin(), SendBuffer.begin() + pos);
+	return true;
+}
+
+int UTcpLink::QueueSend(const uint8_t* data, size_t size)
+{
+	if (LinkState() != STATE_Connected)
+		return 0;
+
+	// Send right away if possible. Errors are left for the poller, as closing here would run script events in the middle of a native call.
+	bool wasEmpty = SendBuffer.empty();
+	SendBuffer.insert(SendBuffer.end(), data, data + size);
+	if (wasEmpty)
+		FlushSendBuffer();
+	return (int)size;
+}
+
+void UTcpLink::CloseConnection()
+{
+	CloseSocket();
+	CreateSocket(SOCK_STREAM);
+	LinkState() = STATE_Initialized;
+	SendBuffer.clear();
+	LineBuffer.clear();
+	CallEvent(this, "Closed");
 }
 
 int UTcpLink::BindPort(int Port, bool bUseNextAvailable)
 {
-	return 0;
+	if (LinkState() != STATE_Initialized)
+		return 0;
+
+	int port = BindSocket(Port, bUseNextAvailable);
+	if (port != 0)
+		LinkState() = STATE_Ready;
+	return port;
 }
 
 bool UTcpLink::Listen()
 {
-	return false;
+	if (LinkState() != STATE_Ready)
+		return false;
+
+	if (listen(handle, SOMAXCONN) != 0)
+	{
+		LastError = GetSocketError();
+		return false;
+	}
+
+	LinkState() = STATE_Listening;
+	return true;
 }
 
 bool UTcpLink::Open(const IpAddr& Addr)
 {
-	return false;
+	if (handle == invalid_socket_value || (LinkState() != STATE_Initialized && LinkState() != STATE_Ready))
+		return false;
+
+	// The connection completes in the background. Opened is sent once the poller sees the socket become writable.
+	sockaddr_in addr = ToSockAddr(Addr);
+	if (connect(handle, (const sockaddr*)&addr, sizeof(sockaddr_in)) != 0 && !IsConnectPending(GetSocketError()))
+	{
+		LastError = GetSocketError();
+		return false;
+	}
+
+	RecvBuffer.clear();
+	DataPending() = 0;
+	RemoteAddr() = Addr;
+	LinkState() = STATE_Connecting;
+	return true;
 }
 
 bool UTcpLink::Close()
 {
+	// The socket is closed from the poller, after any queued data has been sent
+	if (LinkState() == STATE_Connected || LinkState() == STATE_Connecting)
+	{
+		LinkState() = STATE_ConnectClosePending;
+		return true;
+	}
+	else if (LinkState() == STATE_Listening)
+	{
+		LinkState() = STATE_ListenClosePending;
+		return true;
+	}
 	return false;
 }
 
 bool UTcpLink::IsConnected()
 {
-	return false;
+	return LinkState() == STATE_Connected;
 }
 
 int UTcpLink::ReadBinary(int Count, uint8_t& B)
 {
-	return 0;
+	size_t count = std::min(RecvBuffer.size(), (size_t)clamp(Count, 0, 255));
+	memcpy(&B, RecvBuffer.data(), count);
+	RecvBuffer.erase(RecvBuffer.begin(), RecvBuffer.begin() + count);
+	DataPending() = (int)RecvBuffer.size();
+	return (int)count;
 }
 
-int UTcpLink::SendBinary(int Count, uint8_t B)
+int UTcpLink::SendBinary(int Count, uint8_t& B)
 {
-	return 0;
+	return QueueSend(&B, clamp(Count, 0, 255));
 }
 
 int UTcpLink::ReadText(std::string& Str)
 {
-	return 0;
+	Str.assign((const char*)RecvBuffer.data(), RecvBuffer.size());
+	RecvBuffer.clear();
+	DataPending() = 0;
+	return (int)Str.size();
 }
 
 int UTcpLink::SendText(const std::string& Str)
 {
-	return 0;
+	std::string msg = Str;
+	if (LinkMode() == MODE_Line)
+		msg += "\r\n";
+	return QueueSend((const uint8_t*)msg.data(), msg.size());
 }
 
 /////////////////////////////////////////////////////////////////////////////
 
 UUdpLink::UUdpLink(NameString name, UClass* base, ObjectFlags flags) : UInternetLink(name, base, flags)
 {
-	handle = socket(AF_INET, SOCK_DGRAM, 0);
-	if (handle != invalid_socket_value)
-	{
-#ifdef WIN32
-		u_long nonblocking = 1;
-		ioctlsocket(handle, FIONBIO, &nonblocking);
-#else
-		int nonblocking = 1;
-		ioctl(handle, FIONBIO, &nonblocking);
-#endif
-	}
+	CreateSocket(SOCK_DGRAM);
+	if (engine && engine->poller)
+		engine->poller->AddLink(this);
 }
 
-UUdpLink::~UUdpLink()
+int UUdpLink::GetPollEvents()
 {
-	if (handle != invalid_socket_value)
-		closesocket(handle);
+	// Stop reading while a manual mode link has plenty of unread datagrams. The OS buffers the rest.
+	if (!Bound || (ReceiveMode() == RMODE_Manual && RecvQueue.size() >= 256))
+		return 0;
+	return LinkPoll_Read;
 }
 
-void UUdpLink::Tick(float elapsed, bool tickedFlag)
+void UUdpLink::OnSocketEvents(int events)
 {
-	UInternetLink::Tick(elapsed, tickedFlag);
+	if (!(events & LinkPoll_Read))
+		return;
 
-	// int result = recvfrom(handle, (char*)data, size, 0, (sockaddr *)&addr, &addr_len);
+	std::vector<uint8_t> buffer(0x10000);
+	for (int i = 0; i < 64 && !bDeleteMe(); i++)
+	{
+		sockaddr_in addr;
+		memset(&addr, 0, sizeof(sockaddr_in));
+		socklen_t size = sizeof(sockaddr_in);
+		int received = recvfrom(handle, (char*)buffer.data(), (int)buffer.size(), 0, (sockaddr*)&addr, &size);
+		if (received < 0)
+		{
+			if (!IsWouldBlock(GetSocketError()))
+				LastError = GetSocketError();
+			break;
+		}
 
-	// event ReceivedText(string Text);
-	// event ReceivedLine(string Line);
-	// event ReceivedBinary(int Count, byte B[255]);
+		IpAddr from = FromSockAddr(addr);
+		if (ReceiveMode() == RMODE_Manual)
+		{
+			Datagram datagram;
+			datagram.Addr = from;
+			datagram.Data.assign(buffer.data(), buffer.data() + received);
+			RecvQueue.push_back(std::move(datagram));
+			DataPending() = (int)RecvQueue.size();
+			if (RecvQueue.size() >= 256)
+				break;
+		}
+		else
+		{
+			DispatchReceived(&from, buffer.data(), received, nullptr);
+		}
+	}
 }
 
 int UUdpLink::BindPort(int Port, bool bUseNextAvailable)
 {
-	sockaddr_in addr;
-	memset(&addr, 0, sizeof(sockaddr_in));
-	addr.sin_addr.s_addr = INADDR_ANY;
-	addr.sin_port = htons(Port);
-
-	int result = bind(handle, (const sockaddr*)&addr, sizeof(sockaddr_in));
-	if (result == -1)
-		return 0;
-
-#ifdef WIN32
-	int size = sizeof(sockaddr_in);
-#else
-	socklen_t size = sizeof(sockaddr_in);
-#endif
-	result = getsockname(handle, (sockaddr*)&addr, &size);
-	if (result == -1)
+	if (Bound)
 		return 0;
 
-	LocalIP.Addr = addr.sin_addr.s_addr;
-	LocalIP.Port = addr.sin_port;
-
-	return ntohs(addr.sin_port);
+	int port = BindSocket(Port, bUseNextAvailable);
+	Bound = port != 0;
+	return port;
 }
 
 int UUdpLink::ReadBinary(IpAddr& Addr, int Count, uint8_t& B)
 {
-	return 0;
+	if (RecvQueue.empty())
+		return 0;
+
+	const Datagram& datagram = RecvQueue.front();
+	size_t count = std::min(datagram.Data.size(), (size_t)clamp(Count, 0, 255));
+	Addr = datagram.Addr;
+	memcpy(&B, datagram.Data.data(), count);
+	RecvQueue.pop_front();
+	DataPending() = (int)RecvQueue.size();
+	return (int)count;
 }
 
-bool UUdpLink::SendBinary(const IpAddr& Addr, int Count, uint8_t B)
+bool UUdpLink::SendBinary(const IpAddr& Addr, int Count, uint8_t& B)
 {
-	return false;
+	return SendDatagram(Addr, &B, clamp(Count, 0, 255));
 }
 
 int UUdpLink::ReadText(IpAddr& Addr, std::string& Str)
 {
-	return 0;
+	if (RecvQueue.empty())
+		return 0;
+
+	const Datagram& datagram = RecvQueue.front();
+	Addr = datagram.Addr;
+	Str.assign((const char*)datagram.Data.data(), datagram.Data.size());
+	RecvQueue.pop_front();
+	DataPending() = (int)RecvQueue.size();
+	return (int)Str.size();
 }
 
 bool UUdpLink::SendText(const IpAddr& Addr, const std::string& Str)
@@ -289,15 +675,20 @@ bool UUdpLink::SendText(const IpAddr& Addr, const std::string& Str)
 	if (Str.size() > 0x7ffffff0)
 		return false;
 
-	sockaddr_in addr;
-	memset(&addr, 0, sizeof(sockaddr_in));
-	addr.sin_addr.s_addr = Addr.Addr;
-	addr.sin_port = Addr.Port;
-
 	std::string msg = Str;
 	if (LinkMode() == MODE_Line)
 		msg += "\r\n";
+	return SendDatagram(Addr, (const uint8_t*)msg.data(), msg.size());
+}
 
-	int result = sendto(handle, msg.c_str(), (int)msg.size(), 0, (const sockaddr*)&addr, sizeof(sockaddr_in));
-	return result != -1;
+bool UUdpLink::SendDatagram(const IpAddr& Addr, const uint8_t* data, size_t size)
+{
+	sockaddr_in addr = ToSockAddr(Addr);
+	int result = sendto(handle, (const char*)data, (int)size, 0, (const sockaddr*)&addr, sizeof(sockaddr_in));
+	if (result == -1)
+	{
+		LastError = GetSocketError();
+		return false;
+	}
+	return true;
 }
@@ -1,8 +1,7 @@
 #pragma once
 
 #include "UActor.h"
-#include <thread>
-#include <mutex>
+#include <list>
 
 #ifdef WIN32
 typedef SOCKET socket_t;
@@ -25,14 +24,34 @@ enum EReceiveMode
 	RMODE_Event
 };
 
+enum ETcpLinkState
+{
+	STATE_Initialized,
+	STATE_Ready,
+	STATE_Listening,
+	STATE_Connecting,
+	STATE_Connected,
+	STATE_ListenClosePending,
+	STATE_ConnectClosePending,
+	STATE_ListenClosing,
+	STATE_ConnectClosing
+};
+
+// What a link wants the socket poller to wait for
+enum LinkPollEvents
+{
+	LinkPoll_Read = 1,
+	LinkPoll_Write = 2,
+	LinkPoll_Error = 4,
+	LinkPoll_Always = 8 // Call OnSocketEvents this tick even if the socket has no activity
+};
+
 class UInternetLink : public UInternetInfo
 {
 public:
 	using UInternetInfo::UInternetInfo;
 	~UInternetLink();
 
-	void Tick(float elapsed, bool tickedFlag) override;
-
 	int GetLastError();
 	IpAddr GetLocalIP();
 	bool IsDataPending();
@@ -41,6 +60,12 @@ public:
 	std::string IpAddrToString(const IpAddr& Arg);
 	bool StringToIpAddr(const std::string& Str, IpAddr& Addr);
 
+	// Called by the socket poller
+	virtual int GetPollEvents() { return 0; }
+	virtual void OnSocketEvents(int events) { }
+	void OnResolved(bool succeeded, uint32_t addr);
+	void CloseSocket();
+
 	int& DataPending() { return Value<int>(PropOffsets_InternetLink.DataPending); }
 	uint8_t& LinkMode() { return Value<uint8_t>(PropOffsets_InternetLink.LinkMode); }
 	int& Port() { return Value<int>(PropOffsets_InternetLink.Port); }
@@ -49,21 +74,28 @@ public:
 	int& RemoteSocket() { return Value<int>(PropOffsets_InternetLink.RemoteSocket); }
 	int& Socket() { return Value<int>(PropOffsets_InternetLink.Socket); }
 
-	std::thread Thread;
-	std::mutex Mutex;
 	int LastError = 0;
-	IpAddr ResolvedAddr = { 0 };
-	int ResolveStatus = 0;
 	IpAddr LocalIP = { 0 };
+
+	socket_t handle = invalid_socket_value;
+
+protected:
+	void CreateSocket(int type);
+	int BindSocket(int port, bool useNextAvailable);
+
+	// Sends received data to the ReceivedText, ReceivedLine or ReceivedBinary event depending on the link mode.
+	// Lines split across calls are collected in lineBuffer, up to MaxLineLength bytes, after which the collected
+	// data is sent as a line. Without a buffer, a trailing partial line is sent as is.
+	void DispatchReceived(const IpAddr* addr, const uint8_t* data, size_t size, std::string* lineBuffer);
+	void CallReceivedEvent(const NameString& eventName, const IpAddr* addr, const uint8_t* data, size_t size);
+
+	enum { MaxLineLength = 4096 };
 };
 
 class UTcpLink : public UInternetLink
 {
 public:
 	UTcpLink(NameString name, UClass* base, ObjectFlags flags);
-	~UTcpLink();
-
-	void Tick(float elapsed, bool tickedFlag) override;
 
 	int BindPort(int Port, bool bUseNextAvailable);
 	bool Listen();
@@ -74,36 +106,59 @@ public:
 	bool IsConnected();
 
 	int ReadBinary(int Count, uint8_t& B);
-	int SendBinary(int Count, uint8_t B);
+	int SendBinary(int Count, uint8_t& B);
 
 	int ReadText(std::string& Str);
 	int SendText(const std::string& Str);
 
+	int GetPollEvents() override;
+	void OnSocketEvents(int events) override;
+
 	UClass*& AcceptClass() { return Value<UClass*>(PropOffsets_TcpLink.AcceptClass); }
 	uint8_t& LinkState() { return Value<uint8_t>(PropOffsets_TcpLink.LinkState); }
 	IpAddr& RemoteAddr() { return Value<IpAddr>(PropOffsets_TcpLink.RemoteAddr); }
 	std::vector<void*>& SendFIFO() { return Value<std::vector<void*>>(PropOffsets_TcpLink.SendFIFO); }
 
-	socket_t handle = invalid_socket_value;
+private:
+	void AcceptConnections();
+	void FinishConnect();
+	void ReceiveData();
+	bool FlushSendBuffer();
+	int QueueSend(const uint8_t* data, size_t size);
+	void CloseConnection();
+
+	std::vector<uint8_t> RecvBuffer; // Data waiting for ReadText or ReadBinary in manual receive mode
+	std::vector<uint8_t> SendBuffer; // Data the socket didn't accept yet
+	std::string LineBuffer;
 };
 
 class UUdpLink : public UInternetLink
 {
 public:
 	UUdpLink(NameString name, UClass* base, ObjectFlags flags);
-	~UUdpLink();
-
-	void Tick(float elapsed, bool tickedFlag) override;
 
 	int BindPort(int Port, bool bUseNextAvailable);
 
 	int ReadBinary(IpAddr& Addr, int Count, uint8_t& B);
-	bool SendBinary(const IpAddr& Addr, int Count, uint8_t B);
+	bool SendBinary(const IpAddr& Addr, int Count, uint8_t& B);
 
 	int ReadText(IpAddr& Addr, std::string& Str);
 	bool SendText(const IpAddr& Addr, const std::string& Str);
 
+	int GetPollEvents() override;
+	void OnSocketEvents(int events) override;
+
 	int& BroadcastAddr() { return Value<int>(PropOffsets_UdpLink.BroadcastAddr); }
 
-	socket_t handle = invalid_socket_value;
+private:
+	bool SendDatagram(const IpAddr& Addr, const uint8_t* data, size_t size);
+
+	struct Datagram
+	{
+		IpAddr Addr;
+		std::vector<uint8_t> Data;
+	};
+
+	bool Bound = false;
+	std::list<Datagram> RecvQueue; // Datagrams waiting for ReadText or ReadBinary in manual receive mode
 };
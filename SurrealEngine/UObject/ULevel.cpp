@@ -5,6 +5,7 @@
 #include "UTexture.h"
 #include "UClass.h"
 #include "VM/ScriptCall.h"
+#include "FrameProfiler.h"
 #include "Collision/TraceRayLevel.h"
 #include "Collision/TraceRayModel.h"
 #include "Collision/TraceCylinderLevel.h"
@@ -33,7 +34,7 @@ void ULevelBase::Load(ObjectStream* stream)
 	int32_t dbmax = stream->ReadInt32();
 	for (int32_t i = 0; i < dbnum; i++)
 	{
-		Actors.push_back(stream->ReadObject<UActor>());
+		Actors.Add(stream->ReadObject<UActor>());
 	}
 
 	Protocol = stream->ReadString();
@@ -83,6 +84,7 @@ void ULevel::Load(ObjectStream* stream)
 
 void ULevel::Tick(float elapsed)
 {
+	PROFILE_ZONE(ProfileZone::LevelTick);
 	// To do: owned actors must tick before their children:
 	for (size_t i = 0; i < Actors.size(); i++)
 	{
@@ -103,14 +105,11 @@ void ULevel::Tick(float elapsed)
 		}
 	}
 
-	std::vector<UActor*> newActorList;
-	newActorList.reserve(Actors.size());
-	for (UActor* actor : Actors)
-	{
-		if (actor)
-			newActorList.push_back(actor);
-	}
-	Actors.swap(newActorList);
+	UActor* levelInfo = !Actors.empty() ? Actors.front() : nullptr;
+	Perception.Update(this, levelInfo ? levelInfo->Level() : nullptr, elapsed);
+
+	Actors.Compact();
+	Pool.Update(elapsed);
 
 	ticked = !ticked;
 }
@@ -349,6 +348,12 @@ void UModel::Load(ObjectStream* stream)
 
 	RootOutside = stream->ReadInt32();
 	Linked = stream->ReadInt32();
+
+	size_t bytes = MemoryStats::GetVectorBytes(Vectors) + MemoryStats::GetVectorBytes(Points) + MemoryStats::GetVectorBytes(Nodes) +
+		MemoryStats::GetVectorBytes(Surfaces) + MemoryStats::GetVectorBytes(Vertices) + MemoryStats::GetVectorBytes(Zones) +
+		MemoryStats::GetVectorBytes(LightMap) + MemoryStats::GetVectorBytes(LightBits) + MemoryStats::GetVectorBytes(Bounds) +
+		MemoryStats::GetVectorBytes(LeafHulls) + MemoryStats::GetVectorBytes(Leaves);
+	DataMemory.Set(MemoryCategory::Models, bytes);
 }
 
 CollisionHitList UModel::TraceRay(const dvec3& origin, double tmin, const dvec3& dirNormalized, double tmax, bool visibilityOnly)
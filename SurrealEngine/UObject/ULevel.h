@@ -4,6 +4,10 @@
 #include "Math/bbox.h"
 #include "Collision/CollisionHash.h"
 #include "Collision/CollisionHit.h"
+#include "PawnPerception.h"
+#include "NavigationGraph.h"
+#include "ActorList.h"
+#include "ActorPool.h"
 
 class UTexture;
 class UActor;
@@ -197,6 +201,8 @@ public:
 
 	int32_t RootOutside;
 	int32_t Linked;
+
+	TrackedMemory DataMemory;
 };
 
 class LevelReachSpec
@@ -209,6 +215,10 @@ public:
 	int32_t collisionHeight;
 	int32_t reachFlags;
 	int8_t bPruned;
+
+	// Resolved when the navigation graph is built
+	UActor* Start = nullptr;
+	UActor* End = nullptr;
 };
 
 class ULevelBase : public UObject
@@ -217,7 +227,7 @@ public:
 	using UObject::UObject;
 	void Load(ObjectStream* stream) override;
 
-	std::vector<UActor*> Actors;
+	ActorList Actors;
 
 	std::string Protocol;
 	std::string Host;
@@ -264,6 +274,9 @@ public:
 	UModel* Model = nullptr;
 
 	CollisionHash Hash;
+	PawnPerception Perception;
+	NavigationGraph Navigation;
+	ActorPool Pool;
 	std::vector<std::unique_ptr<LevelDecal>> Decals;
 
 	std::map<std::string, std::string> TravelInfo;
@@ -4,7 +4,26 @@
 #include "UTexture.h"
 #include "Engine.h"
 #include "Package/PackageManager.h"
-#include <iostream>
+
+static size_t GetDataBytes(const UMesh* mesh)
+{
+	return MemoryStats::GetVectorBytes(mesh->Verts) + MemoryStats::GetVectorBytes(mesh->Tris) + MemoryStats::GetVectorBytes(mesh->AnimSeqs) +
+		MemoryStats::GetVectorBytes(mesh->Connects) + MemoryStats::GetVectorBytes(mesh->BoundingBoxes) + MemoryStats::GetVectorBytes(mesh->BoundingSpheres) +
+		MemoryStats::GetVectorBytes(mesh->VertLinks) + MemoryStats::GetVectorBytes(mesh->Normals);
+}
+
+static size_t GetDataBytes(const ULodMesh* mesh)
+{
+	return GetDataBytes(static_cast<const UMesh*>(mesh)) + MemoryStats::GetVectorBytes(mesh->CollapsePointThus) + MemoryStats::GetVectorBytes(mesh->FaceLevel) +
+		MemoryStats::GetVectorBytes(mesh->Faces) + MemoryStats::GetVectorBytes(mesh->CollapseWedgeThus) + MemoryStats::GetVectorBytes(mesh->Wedges) +
+		MemoryStats::GetVectorBytes(mesh->SpecialFaces) + MemoryStats::GetVectorBytes(mesh->ReMapAnimVerts);
+}
+
+static size_t GetDataBytes(const USkeletalMesh* mesh)
+{
+	return GetDataBytes(static_cast<const ULodMesh*>(mesh)) + MemoryStats::GetVectorBytes(mesh->ExtWedges) + MemoryStats::GetVectorBytes(mesh->Points) +
+		MemoryStats::GetVectorBytes(mesh->BoneWeightIndices) + MemoryStats::GetVectorBytes(mesh->BoneWeights) + MemoryStats::GetVectorBytes(mesh->LocalPoints);
+}
 
 void UPrimitive::Load(ObjectStream* stream)
 {
@@ -39,7 +58,6 @@ void UMesh::Load(ObjectStream* stream)
 	//      of indicator as to what mesh type we're looking at.
 	//      Maybe just some optional metadata in the package that describes 
 	//			which type of mesh this is?
-std::cout << "GP13" << std::endl;
 	if (stream->GetPackage()->GetPackageManager()->IsDeusEx())
 	{
 		for (int i = 0; i < NumVerts; i++)
@@ -212,6 +230,8 @@ std::cout << "GP13" << std::endl;
 	// Build smoothed normals
 	// 
 	// To do: build normals from mesh faces (maybe using the Connects array?)
+
+	DataMemory.Set(MemoryCategory::Meshes, GetDataBytes(this));
 }
 
 /////////////////////////////////////////////////////////////////////////////
@@ -320,6 +340,8 @@ void ULodMesh::Load(ObjectStream* stream)
 	{
 		n = normalize(n);
 	}
+
+	DataMemory.Set(MemoryCategory::Meshes, GetDataBytes(this));
 }
 
 /////////////////////////////////////////////////////////////////////////////
@@ -417,6 +439,8 @@ void USkeletalMesh::Load(ObjectStream* stream)
 	WeaponAdjust.ZAxis.x = stream->ReadFloat();
 	WeaponAdjust.ZAxis.y = stream->ReadFloat();
 	WeaponAdjust.ZAxis.y = stream->ReadFloat();
+
+	DataMemory.Set(MemoryCategory::Meshes, GetDataBytes(this));
 }
 
 /////////////////////////////////////////////////////////////////////////////
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "UObject.h"
+#include "MemoryStats.h"
 #include "Math/bbox.h"
 #include "Math/vec.h"
 #include "Math/quaternion.h"
@@ -102,6 +103,8 @@ public:
 
 	std::vector<vec3> Normals;
 	mat4 meshToObject;
+
+	TrackedMemory DataMemory;
 };
 
 class ULodMesh : public UMesh
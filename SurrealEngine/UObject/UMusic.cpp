@@ -12,4 +12,5 @@ void UMusic::Load(ObjectStream* stream)
 	uint32_t size = stream->ReadIndex();
 	Data.resize(size);
 	stream->ReadBytes(Data.data(), size);
+	DataMemory.Set(MemoryCategory::Music, MemoryStats::GetVectorBytes(Data));
 }
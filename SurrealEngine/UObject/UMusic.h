@@ -1,6 +1,7 @@
 #pragma once
 
 #include "UObject.h"
+#include "MemoryStats.h"
 
 class UMusic : public UObject
 {
@@ -10,4 +11,5 @@ public:
 
 	NameString Format;
 	std::vector<uint8_t> Data;
+	TrackedMemory DataMemory;
 };
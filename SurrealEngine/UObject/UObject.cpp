@@ -9,6 +9,8 @@
 #include "VM/Frame.h"
 #include "Engine.h"
 #include "Exception.h"
+#include "GC/GC.h"
+#include "GC/GCHeap.h"
 
 UObject::UObject(NameString name, UClass* cls, ObjectFlags flags) : Name(name), Class(cls), Flags(flags)
 {
@@ -32,6 +34,7 @@ void UObject::LoadNow()
 				s->BaseStruct->LoadNow();
 				s->Properties = s->BaseStruct->Properties;
 				s->StructSize = s->BaseStruct->StructSize;
+				s->PlainData = s->BaseStruct->PlainData;
 			}
 
 			if (dynamic_cast<UClass*>(this))
@@ -250,6 +253,7 @@ void UObject::SetName(const NameString& name, const NameString& value)
 void UObject::SetObject(const NameString& name, const UObject* value)
 {
 	*static_cast<const UObject**>(GetProperty(name)) = value;
+	GC::WriteBarrier(const_cast<UObject*>(value));
 }
 
 bool UObject::IsA(const NameString& className) const
@@ -464,19 +468,37 @@ void PropertyDataBlock::Reset()
 			prop->Destruct(Ptr(prop));
 		}
 	}*/
-	delete[](int64_t*)Data;
+	GCHeap::Free(Data, Size);
 	Data = nullptr;
+	Size = 0;
 	Class = nullptr;
 }
 
 void PropertyDataBlock::Init(UClass* cls)
 {
-	Reset();
-
+	// Keep the allocation when initializing a recycled block of the same size
+	size_t size = (cls->StructSize + 7) / 8 * 8;
+	if (!Data || Size != size)
+	{
+		Reset();
+		Data = GCHeap::Alloc(size);
+		Size = size;
+	}
 	Class = cls;
-	Size = (cls->StructSize + 7) / 8;
-	Data = new int64_t[Size];
-	Size *= 8;
+
+	if (&cls->PropertyData != this && cls->PropertyData.Data && cls->PropertyData.Size == Size)
+	{
+		// Start from a copy of the defaults and only run the constructors of the values that own memory
+		memcpy(Data, cls->PropertyData.Data, Size);
+		for (UProperty* prop : cls->PropertyData.NonPlainProperties)
+			prop->CopyConstruct(Ptr(prop), cls->PropertyData.Ptr(prop));
+		GC::WriteBarrier(cls, Data);
+		return;
+	}
+
+	if (&cls->PropertyData == this)
+		NonPlainProperties.clear();
+
 	for (UProperty* prop : cls->Properties)
 	{
 #ifdef _DEBUG
@@ -490,9 +512,24 @@ void PropertyDataBlock::Init(UClass* cls)
 			prop->CopyConstruct(Ptr(prop), cls->BaseStruct->PropertyData.Ptr(prop));
 		else
 			prop->Construct(Ptr(prop));
+
+		if (&cls->PropertyData == this && !prop->IsPlainData())
+			NonPlainProperties.push_back(prop);
 	}
 }
 
+void PropertyDataBlock::DestructValues()
+{
+	if (!Data || !Class || &Class->PropertyData == this)
+		return;
+
+	for (UProperty* prop : Class->PropertyData.NonPlainProperties)
+		prop->Destruct(Ptr(prop));
+
+	// The memory is kept for the next Init, but there are no values left in it to destruct or scan
+	Class = nullptr;
+}
+
 void PropertyDataBlock::ReadProperties(ObjectStream* stream)
 {
 	while (true)
@@ -139,6 +139,7 @@ public:
 	~PropertyDataBlock() { Reset(); }
 
 	void Init(UClass* cls);
+	void DestructValues();
 	void ReadProperties(ObjectStream* stream);
 
 	void* Ptr(const UProperty* prop);
@@ -153,6 +154,9 @@ public:
 	size_t Size = 0;
 	UClass* Class = nullptr;
 
+	// Properties of a class default block whose values can't be copied with memcpy
+	std::vector<UProperty*> NonPlainProperties;
+
 private:
 	void Reset();
 
@@ -182,6 +186,9 @@ public:
 
 	virtual void SaveConfig();
 
+	// Called by the garbage collector before the object is deleted, while the other garbage still exists
+	virtual void ReleaseNativeReferences() { }
+
 	uint8_t GetByte(const NameString& name) const;
 	uint32_t GetInt(const NameString& name) const;
 	bool GetBool(const NameString& name) const;
@@ -241,6 +248,9 @@ public:
 	PropertyDataBlock PropertyData;
 	std::shared_ptr<Frame> StateFrame;
 
+	// Cycle in which the garbage collector last reached this object
+	uint32_t GCMark = 0;
+
 	template<typename T>
 	T& Value(PropertyDataOffset offset) { return *static_cast<T*>(PropertyData.Ptr(offset.DataOffset)); }
 
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "UClass.h"
+#include "GC/GC.h"
 
 #include <sstream>
 
@@ -171,6 +172,9 @@ public:
 	virtual void Destruct(void* data) { }
 	virtual bool IsDefaultValue(void* val) { return false; }
 
+	// True if a value can be constructed, copied and destroyed with plain memory operations
+	virtual bool IsPlainData() { return true; }
+
 	virtual std::string PrintValue(const void* data) { return "?"; }
 
 	virtual void SetValueFromString(void* data, const std::string& valueString) 
@@ -247,6 +251,12 @@ public:
 		UObject* o2 = *(UObject**)v2;
 		return o1 == o2;
 	}
+	void CopyConstruct(void* data, void* src) override
+	{
+		UProperty::CopyConstruct(data, src);
+		for (int i = 0; i < ArrayDimension; i++)
+			GC::WriteBarrier(static_cast<UObject**>(data)[i]);
+	}
 	std::string PrintValue(const void* data) override
 	{
 		UObject* obj = *(UObject**)data;
@@ -312,6 +322,8 @@ public:
 		}
 	}
 
+	bool IsPlainData() override { return Inner->IsPlainData(); }
+
 	std::string PrintValue(const void* data) override { return "fixed array"; }
 
 	UProperty* Inner = nullptr;
@@ -387,6 +399,8 @@ public:
 		}
 	}
 
+	bool IsPlainData() override { return false; }
+
 	std::string PrintValue(const void* data) override { return "array"; }
 
 	UProperty* Inner = nullptr;
@@ -445,6 +459,8 @@ public:
 		}
 	}
 
+	bool IsPlainData() override { return false; }
+
 	std::string PrintValue(const void* data) override { return "map"; }
 
 	UProperty* Key = nullptr;
@@ -770,6 +786,8 @@ public:
 			str[i].~basic_string();
 	}
 
+	bool IsPlainData() override { return false; }
+
 	void SetValueFromString(void* data, const std::string& valueString) override
 	{
 		*(std::string*)data = valueString;
@@ -815,6 +833,8 @@ public:
 			str[i].~basic_string();
 	}
 
+	bool IsPlainData() override { return false; }
+
 	void SetValueFromString(void* data, const std::string& valueString) override
 	{
 		*(std::string*)data = valueString;
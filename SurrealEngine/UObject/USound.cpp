@@ -16,6 +16,7 @@ void USound::Load(ObjectStream* stream)
 	uint32_t size = stream->ReadIndex();
 	Data.resize(size);
 	stream->ReadBytes(Data.data(), size);
+	DataMemory.Set(MemoryCategory::Sounds, MemoryStats::GetVectorBytes(Data));
 }
 
 void USound::GetSound()
@@ -28,6 +29,7 @@ void USound::GetSound()
 	#define ALIGN(x, a) ((x & ~(a-1)) + a)
 	samples.resize(ALIGN(source->GetSamples(), 4));
 	samples.resize(ALIGN(source->ReadSamples(samples.data(), samples.size()), 4));
+	SamplesMemory.Set(MemoryCategory::SoundSamples, MemoryStats::GetVectorBytes(samples));
 
 	frequency = source->GetFrequency();
 	duration = samples.size() / (float)frequency;
@@ -37,7 +39,8 @@ void USound::GetSound()
 	loopInfo.LoopStart = source->loopStart;
 	loopInfo.LoopEnd = source->loopEnd;
 
-	engine->audio->GetDevice()->AddSound(this);
+	if (engine->audio)
+		engine->audio->GetDevice()->AddSound(this);
 }
 
 float USound::GetDuration()
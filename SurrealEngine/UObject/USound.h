@@ -1,6 +1,7 @@
 #pragma once
 
 #include "UObject.h"
+#include "MemoryStats.h"
 
 class AudioLoopInfo
 {
@@ -29,8 +30,10 @@ public:
 
 	NameString Format;
 	std::vector<uint8_t> Data;
+	TrackedMemory DataMemory;
 
 	std::vector<float> samples;
+	TrackedMemory SamplesMemory;
 	float duration = 0.0f;
 	int frequency = 0;
 	int channels = 0;
@@ -198,6 +198,20 @@ std::string USurrealNetworkDevice::GetPropertyAsString(const NameString& propert
 {
 	if (propertyName == "Class")
 		return "class'" + Class + "'";
+	else if (propertyName == "MaxClientRate")
+		return IniPropertyConverter<int>::ToString(MaxClientRate);
+	else if (propertyName == "NetServerMaxTickRate")
+		return IniPropertyConverter<float>::ToString(NetServerMaxTickRate);
+	else if (propertyName == "ConnectionTimeout")
+		return IniPropertyConverter<float>::ToString(ConnectionTimeout);
+	else if (propertyName == "InitialConnectTimeout")
+		return IniPropertyConverter<float>::ToString(InitialConnectTimeout);
+	else if (propertyName == "RelevantTimeout")
+		return IniPropertyConverter<float>::ToString(RelevantTimeout);
+	else if (propertyName == "MaxConnections")
+		return IniPropertyConverter<int>::ToString(MaxConnections);
+	else if (propertyName == "MaxPendingConnections")
+		return IniPropertyConverter<int>::ToString(MaxPendingConnections);
 
 	engine->LogMessage("Queried unknown property for SurrealNetworkDevice: " + propertyName.ToString());
 	return {};
@@ -205,8 +219,52 @@ std::string USurrealNetworkDevice::GetPropertyAsString(const NameString& propert
 
 void USurrealNetworkDevice::SetPropertyFromString(const NameString& propertyName, const std::string& value)
 {
-	engine->LogMessage("Setting unknown property for SurrealNetworkDevice: " + propertyName.ToString());
-	engine->packages->SetIniValue("System", Class, propertyName, value);
+	if (propertyName == "MaxClientRate")
+		MaxClientRate = IniPropertyConverter<int>::FromString(value);
+	else if (propertyName == "NetServerMaxTickRate")
+		NetServerMaxTickRate = IniPropertyConverter<float>::FromString(value);
+	else if (propertyName == "ConnectionTimeout")
+		ConnectionTimeout = IniPropertyConverter<float>::FromString(value);
+	else if (propertyName == "InitialConnectTimeout")
+		InitialConnectTimeout = IniPropertyConverter<float>::FromString(value);
+	else if (propertyName == "RelevantTimeout")
+		RelevantTimeout = IniPropertyConverter<float>::FromString(value);
+	else if (propertyName == "MaxConnections")
+		MaxConnections = IniPropertyConverter<int>::FromString(value);
+	else if (propertyName == "MaxPendingConnections")
+		MaxPendingConnections = IniPropertyConverter<int>::FromString(value);
+	else
+	{
+		engine->LogMessage("Setting unknown property for SurrealNetworkDevice: " + propertyName.ToString());
+		engine->packages->SetIniValue("System", Class, propertyName, value);
+	}
+}
+
+void USurrealNetworkDevice::LoadProperties(const NameString& from)
+{
+	NameString name_from = from;
+
+	if (from == "")
+		name_from = NameString(Class);
+
+	MaxClientRate = IniPropertyConverter<int>::FromIniFile(*engine->packages->GetIniFile("System"), name_from, "MaxClientRate", MaxClientRate);
+	NetServerMaxTickRate = IniPropertyConverter<float>::FromIniFile(*engine->packages->GetIniFile("System"), name_from, "NetServerMaxTickRate", NetServerMaxTickRate);
+	ConnectionTimeout = IniPropertyConverter<float>::FromIniFile(*engine->packages->GetIniFile("System"), name_from, "ConnectionTimeout", ConnectionTimeout);
+	InitialConnectTimeout = IniPropertyConverter<float>::FromIniFile(*engine->packages->GetIniFile("System"), name_from, "InitialConnectTimeout", InitialConnectTimeout);
+	RelevantTimeout = IniPropertyConverter<float>::FromIniFile(*engine->packages->GetIniFile("System"), name_from, "RelevantTimeout", RelevantTimeout);
+	MaxConnections = IniPropertyConverter<int>::FromIniFile(*engine->packages->GetIniFile("System"), name_from, "MaxConnections", MaxConnections);
+	MaxPendingConnections = IniPropertyConverter<int>::FromIniFile(*engine->packages->GetIniFile("System"), name_from, "MaxPendingConnections", MaxPendingConnections);
+}
+
+void USurrealNetworkDevice::SaveConfig()
+{
+	engine->packages->SetIniValue("System", Class, "MaxClientRate", IniPropertyConverter<int>::ToString(MaxClientRate));
+	engine->packages->SetIniValue("System", Class, "NetServerMaxTickRate", IniPropertyConverter<float>::ToString(NetServerMaxTickRate));
+	engine->packages->SetIniValue("System", Class, "ConnectionTimeout", IniPropertyConverter<float>::ToString(ConnectionTimeout));
+	engine->packages->SetIniValue("System", Class, "InitialConnectTimeout", IniPropertyConverter<float>::ToString(InitialConnectTimeout));
+	engine->packages->SetIniValue("System", Class, "RelevantTimeout", IniPropertyConverter<float>::ToString(RelevantTimeout));
+	engine->packages->SetIniValue("System", Class, "MaxConnections", IniPropertyConverter<int>::ToString(MaxConnections));
+	engine->packages->SetIniValue("System", Class, "MaxPendingConnections", IniPropertyConverter<int>::ToString(MaxPendingConnections));
 }
 
 /////////////////////////////////////////////////////////////////////////////
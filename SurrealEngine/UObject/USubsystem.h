@@ -118,9 +118,19 @@ public:
 	using UNetDriver::UNetDriver;
 
 	std::string Class = "Engine.SurrealNetworkDevice";
+	int MaxClientRate = 20000;
+	float NetServerMaxTickRate = 20.0f;
+	float ConnectionTimeout = 15.0f;
+	float InitialConnectTimeout = 30.0f;
+	float RelevantTimeout = 5.0f;
+	int MaxConnections = 64;
+	int MaxPendingConnections = 16;
+
+	void LoadProperties(const NameString& from = "") override;
+	void SaveConfig() override;
 
 	std::string GetPropertyAsString(const NameString& propertyName) const override;
-	void SetPropertyFromString(const NameString& propertyName, const std::string& value);
+	void SetPropertyFromString(const NameString& propertyName, const std::string& value) override;
 };
 
 class USurrealClient : public UClient
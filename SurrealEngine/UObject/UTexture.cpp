@@ -1,6 +1,8 @@
 
 #include "Precomp.h"
 #include "UTexture.h"
+#include "Package/PackageManager.h"
+#include "Package/PackageStream.h"
 
 void UTexture::Load(ObjectStream* stream)
 {
@@ -10,6 +12,7 @@ void UTexture::Load(ObjectStream* stream)
 
 	int mipsCount = stream->ReadUInt8();
 	Mipmaps.resize(mipsCount);
+	MipmapFileOffsets.clear();
 
 	for (UnrealMipmap& mipmap : Mipmaps)
 	{
@@ -17,6 +20,7 @@ void UTexture::Load(ObjectStream* stream)
 		if (stream->GetVersion() >= 63)
 			widthoffset = stream->ReadInt32();
 		int bytes = stream->ReadIndex();
+		MipmapFileOffsets.push_back(stream->Tell());
 		mipmap.Data.resize(bytes);
 		stream->ReadBytes(mipmap.Data.data(), bytes);
 		mipmap.Width = stream->ReadUInt32();
@@ -31,12 +35,14 @@ void UTexture::Load(ObjectStream* stream)
 
 		mipsCount = stream->ReadUInt8();
 		Mipmaps.resize(mipsCount);
+		MipmapFileOffsets.clear();
 		for (UnrealMipmap& mipmap : Mipmaps)
 		{
 			uint32_t widthoffset = 0;
 			if (stream->GetVersion() >= 68)
 				widthoffset = stream->ReadInt32();
 			int bytes = stream->ReadIndex();
+			MipmapFileOffsets.push_back(stream->Tell());
 			mipmap.Data.resize(bytes);
 			stream->ReadBytes(mipmap.Data.data(), bytes);
 			mipmap.Width = stream->ReadUInt32();
@@ -45,6 +51,60 @@ void UTexture::Load(ObjectStream* stream)
 			uint8_t VBits = stream->ReadUInt8();
 		}
 	}
+
+	UpdateMipmapMemory();
+}
+
+void UTexture::UpdateMipmapMemory()
+{
+	size_t bytes = 0;
+	for (const UnrealMipmap& mipmap : Mipmaps)
+		bytes += MemoryStats::GetVectorBytes(mipmap.Data);
+	MipmapMemory.Set(MemoryCategory::Textures, bytes);
+}
+
+bool UTexture::CanReleaseMipmapData()
+{
+	if (!ReleaseMipmapsAfterUpload || !MipmapDataResident || KeepMipmapData || TextureModified || IsProcedural())
+		return false;
+
+	// Only data that can be read back from the package file may be dropped
+	if (!package || MipmapFileOffsets.size() != Mipmaps.size())
+		return false;
+
+	return !bRealtime() && !bParametric();
+}
+
+void UTexture::ReleaseMipmapData()
+{
+	if (!CanReleaseMipmapData())
+		return;
+
+	MipmapDataSizes.resize(Mipmaps.size());
+	for (size_t i = 0; i < Mipmaps.size(); i++)
+	{
+		MipmapDataSizes[i] = (uint32_t)Mipmaps[i].Data.size();
+		std::vector<uint8_t>().swap(Mipmaps[i].Data);
+	}
+	MipmapDataResident = false;
+	UpdateMipmapMemory();
+}
+
+void UTexture::LoadMipmapData()
+{
+	if (MipmapDataResident)
+		return;
+
+	auto stream = package->GetPackageManager()->GetStream(package);
+	for (size_t i = 0; i < Mipmaps.size(); i++)
+	{
+		UnrealMipmap& mipmap = Mipmaps[i];
+		mipmap.Data.resize(MipmapDataSizes[i]);
+		stream->Seek(MipmapFileOffsets[i]);
+		stream->ReadBytes(mipmap.Data.data(), (uint32_t)mipmap.Data.size());
+	}
+	MipmapDataResident = true;
+	UpdateMipmapMemory();
 }
 
 void UTexture::Update(float elapsed)
@@ -84,6 +144,7 @@ void UFractalTexture::Load(ObjectStream* stream)
 
 	ActualFormat = TextureFormat::P8;
 	Mipmaps.resize(1);
+	MipmapFileOffsets.clear();
 
 	int width = GetInt("UClamp");
 	int height = GetInt("VClamp");
@@ -94,6 +155,8 @@ void UFractalTexture::Load(ObjectStream* stream)
 	mipmap.Data.resize((size_t)mipmap.Width * mipmap.Height);
 	uint8_t* pixels = (uint8_t*)mipmap.Data.data();
 	memset(pixels, 0, (size_t)width * height);
+
+	UpdateMipmapMemory();
 }
 
 /////////////////////////////////////////////////////////////////////////////
@@ -342,6 +405,11 @@ void UIceTexture::UpdateFrame()
 		int count = width * height;
 
 		UTexture* tex = SourceTexture();
+		if (tex)
+		{
+			tex->KeepMipmapData = true;
+			tex->LoadMipmapData();
+		}
 		if (tex && !tex->Mipmaps.empty() && tex->Mipmaps.front().Width == mipmap.Width && tex->Mipmaps.front().Height == mipmap.Height)
 		{
 			const uint8_t* srcpixels = (const uint8_t*)tex->Mipmaps.front().Data.data();
@@ -570,6 +638,11 @@ void UWetTexture::UpdateFrame()
 		UnrealMipmap& mipmap = Mipmaps.front();
 
 		UTexture* tex = SourceTexture();
+		if (tex)
+		{
+			tex->KeepMipmapData = true;
+			tex->LoadMipmapData();
+		}
 		if (tex && !tex->Mipmaps.empty() && tex->Mipmaps.front().Width == mipmap.Width && tex->Mipmaps.front().Height == mipmap.Height)
 		{
 			int width = mipmap.Width;
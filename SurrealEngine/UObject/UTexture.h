@@ -1,6 +1,7 @@
 #pragma once
 
 #include "UObject.h"
+#include "MemoryStats.h"
 
 class UPalette;
 class USound;
@@ -190,8 +191,25 @@ public:
 	virtual void Update(float elapsed);
 	virtual void UpdateFrame();
 
+	void UpdateMipmapMemory();
+
+	// Mipmap data residency. Once the render device has uploaded a static texture the CPU copy can be
+	// released. LoadMipmapData reads it back from the package file whenever it is needed again.
+	virtual bool IsProcedural() { return false; }
+	bool CanReleaseMipmapData();
+	bool IsMipmapDataResident() const { return MipmapDataResident; }
+	void ReleaseMipmapData();
+	void LoadMipmapData();
+
+	static inline bool ReleaseMipmapsAfterUpload = true;
+
 	TextureFormat ActualFormat = TextureFormat::P8;
 	std::vector<UnrealMipmap> Mipmaps;
+	TrackedMemory MipmapMemory;
+	std::vector<uint32_t> MipmapFileOffsets;
+	std::vector<uint32_t> MipmapDataSizes;
+	bool MipmapDataResident = true;
+	bool KeepMipmapData = false; // Set when something other than the render device reads the pixels
 	bool TextureModified = false;
 	int RealtimeChangeCount = 0;
 
@@ -308,6 +326,7 @@ class UFractalTexture : public UTexture
 public:
 	using UTexture::UTexture;
 	void Load(ObjectStream* stream) override;
+	bool IsProcedural() override { return true; }
 
 	uint8_t& AuxPhase() { return Value<uint8_t>(PropOffsets_FractalTexture.AuxPhase); }
 	uint8_t& DrawPhase() { return Value<uint8_t>(PropOffsets_FractalTexture.DrawPhase); }
@@ -567,6 +586,7 @@ class UScriptedTexture : public UTexture
 {
 public:
 	using UTexture::UTexture;
+	bool IsProcedural() override { return true; }
 
 	int& Junk1() { return Value<int>(PropOffsets_ScriptedTexture.Junk1); }
 	int& Junk2() { return Value<int>(PropOffsets_ScriptedTexture.Junk2); }
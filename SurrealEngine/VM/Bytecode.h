@@ -17,6 +17,13 @@ public:
 		return OffsetToExpression.find(offset)->second->StatementIndex;
 	}
 
+	// Replication conditions are stored as offsets into the class bytecode
+	Expression* FindExpression(uint16_t offset) const
+	{
+		auto it = OffsetToExpression.find(offset);
+		return it != OffsetToExpression.end() ? it->second : nullptr;
+	}
+
 	int FindLabelIndex(const NameString& label)
 	{
 		LabelTableExpression* labels = dynamic_cast<LabelTableExpression*>(Statements.back());
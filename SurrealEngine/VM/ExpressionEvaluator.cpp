@@ -364,7 +364,14 @@ void ExpressionEvaluator::Expr(StructCmpNeExpression* expr)
 void ExpressionEvaluator::Expr(StructMemberExpression* expr)
 {
 	if (expr->Field)
-		Result.Value = Eval(expr->Value).Value.Member(expr->Field);
+	{
+		// Members of variables are accessed in place. A temporary struct is gone once this returns, so only the member is kept
+		ExpressionEvalResult result = Eval(expr->Value);
+		ExpressionValue& value = result.Value;
+		Result.Value = value.Member(expr->Field);
+		if (!value.IsVariable())
+			Result.Value.Load();
+	}
 	else
 		Frame::ThrowException("Null field encountered in struct member expression");
 }
@@ -649,6 +656,10 @@ void ExpressionEvaluator::Call(UFunction* func, const std::vector<Expression*>&
 	{
 		Result.Value = ExpressionValue::BoolValue(Eval(exprArgs[0], Self, Self, LocalVariables).Value.ToBool() || Eval(exprArgs[1], Self, Self, LocalVariables).Value.ToBool());
 	}
+	else if (func->NativeFuncIndex != 0 && AllFlags(func->FuncFlags, FunctionFlags::Native | FunctionFlags::Final) && AnyFlags(func->FuncFlags, FunctionFlags::Operator | FunctionFlags::Static) && !AnyFlags(func->FuncFlags, FunctionFlags::Latent | FunctionFlags::Net))
+	{
+		CallFinalNative(func, exprArgs);
+	}
 	else
 	{
 		std::vector<ExpressionValue> args;
@@ -659,6 +670,72 @@ void ExpressionEvaluator::Call(UFunction* func, const std::vector<Expression*>&
 	}
 }
 
+void ExpressionEvaluator::CallFinalNative(UFunction* func, const std::vector<Expression*>& exprArgs)
+{
+	// The operators and the static functions, which is where the vector and rotator math is, cannot be events or be
+	// replicated. They are called without going through Frame::Call, with the arguments on the stack.
+
+	UProperty* parms[MaxFinalNativeParms];
+	int parmCount = 0;
+	for (UField* field = func->Children; field != nullptr; field = field->Next)
+	{
+		UProperty* prop = dynamic_cast<UProperty*>(field);
+		if (prop && AllFlags(prop->PropFlags, PropertyFlags::Parm))
+		{
+			if (parmCount == MaxFinalNativeParms)
+			{
+				std::vector<ExpressionValue> args;
+				args.reserve(exprArgs.size());
+				for (Expression* arg : exprArgs)
+					args.push_back(Eval(arg, Self, Self, LocalVariables).Value);
+				Result.Value = Frame::Call(func, Context, std::move(args));
+				return;
+			}
+			parms[parmCount++] = prop;
+		}
+	}
+
+	ExpressionValue args[MaxFinalNativeParms];
+	int argCount = 0;
+	UProperty* returnparm = nullptr;
+	for (int i = 0; i < parmCount; i++)
+	{
+		if (AllFlags(parms[i]->PropFlags, PropertyFlags::ReturnParm))
+		{
+			returnparm = parms[i];
+		}
+		else
+		{
+			if (argCount < (int)exprArgs.size())
+				args[argCount] = Eval(exprArgs[argCount], Self, Self, LocalVariables).Value;
+			argCount++;
+		}
+	}
+
+	// The return value goes after the arguments, like in Frame::Call
+	if (returnparm)
+		args[argCount] = ExpressionValue::PropertyValue(returnparm);
+
+	// Still on the callstack for the log messages and the debugger, but native functions have no local variables
+	Frame frame(Context, nullptr);
+	frame.Func = func;
+	Frame::Callstack.push_back(&frame);
+	try
+	{
+		auto& callback = NativeFunctions::NativeByIndex[func->NativeFuncIndex];
+		if (!callback)
+			Exception::Throw("Unknown native function " + func->NativeStruct->Name.ToString() + "." + func->Name.ToString());
+		callback(Context, args);
+	}
+	catch (const std::exception& e)
+	{
+		Frame::ThrowException(e.what());
+	}
+	Frame::Callstack.pop_back();
+
+	Result.Value = returnparm ? std::move(args[argCount]) : ExpressionValue::NothingValue();
+}
+
 void ExpressionEvaluator::Expr(FunctionArgumentsExpression* expr)
 {
 	Result.Value = ExpressionValue::NothingValue();
@@ -128,6 +128,9 @@ private:
 	void Expr(FunctionArgumentsExpression* expr) override;
 
 	void Call(UFunction* func, const std::vector<Expression*>& exprArgs);
+	void CallFinalNative(UFunction* func, const std::vector<Expression*>& exprArgs);
+
+	enum { MaxFinalNativeParms = 8 };
 
 	ExpressionEvalResult Result;
 	UObject* Self = nullptr;
@@ -2,9 +2,14 @@
 
 #include "UObject/UObject.h"
 #include "UObject/UProperty.h"
+#include "GC/GCHeap.h"
 
 class UProperty;
 
+// A struct value that is not in property memory.
+//
+// The struct data comes from the small block allocator, so loading a plane or a coords struct doesn't go to
+// malloc. Structs made of plain data, the ones without strings or arrays in them, are copied in one go.
 class StructValue
 {
 public:
@@ -28,12 +33,7 @@ public:
 	void Store(void* dest) const
 	{
 		if (Struct)
-		{
-			for (UProperty* prop : Struct->Properties)
-				prop->CopyValue(
-					static_cast<uint8_t*>(dest) + prop->DataOffset.DataOffset,
-					static_cast<uint8_t*>(Ptr) + prop->DataOffset.DataOffset);
-		}
+			CopyValue(Struct, dest, Ptr);
 	}
 
 	void Load(UStruct* type, void* src)
@@ -42,11 +42,18 @@ public:
 		Struct = type;
 		if (Struct)
 		{
-			Ptr = new uint64_t[(Struct->StructSize + 7) / 8];
-			for (UProperty* prop : Struct->Properties)
-				prop->CopyConstruct(
-					static_cast<uint8_t*>(Ptr) + prop->DataOffset.DataOffset,
-					static_cast<uint8_t*>(src) + prop->DataOffset.DataOffset);
+			Ptr = GCHeap::Alloc(Struct->StructSize);
+			if (Struct->PlainData)
+			{
+				memcpy(Ptr, src, Struct->StructSize);
+			}
+			else
+			{
+				for (UProperty* prop : Struct->Properties)
+					prop->CopyConstruct(
+						static_cast<uint8_t*>(Ptr) + prop->DataOffset.DataOffset,
+						static_cast<uint8_t*>(src) + prop->DataOffset.DataOffset);
+			}
 		}
 	}
 
@@ -54,10 +61,14 @@ public:
 	{
 		if (Struct)
 		{
-			for (UProperty* prop : Struct->Properties)
-				prop->Destruct(static_cast<uint8_t*>(Ptr) + prop->DataOffset.DataOffset);
-			delete[](uint64_t*)Ptr;
+			if (!Struct->PlainData)
+			{
+				for (UProperty* prop : Struct->Properties)
+					prop->Destruct(static_cast<uint8_t*>(Ptr) + prop->DataOffset.DataOffset);
+			}
+			GCHeap::Free(Ptr, Struct->StructSize);
 			Struct = nullptr;
+			Ptr = nullptr;
 		}
 	}
 
@@ -74,6 +85,7 @@ public:
 	{
 		if (this != &other)
 		{
+			Reset();
 			Struct = other.Struct;
 			Ptr = other.Ptr;
 			other.Struct = nullptr;
@@ -82,6 +94,26 @@ public:
 		return *this;
 	}
 
+	// Copies a struct over another one in place
+	static void CopyValue(UStruct* type, void* dest, void* src)
+	{
+		if (dest == src)
+			return;
+
+		if (type->PlainData)
+		{
+			memcpy(dest, src, type->StructSize);
+			GC::WriteBarrier(type, dest);
+		}
+		else
+		{
+			for (UProperty* prop : type->Properties)
+				prop->CopyValue(
+					static_cast<uint8_t*>(dest) + prop->DataOffset.DataOffset,
+					static_cast<uint8_t*>(src) + prop->DataOffset.DataOffset);
+		}
+	}
+
 	UStruct* Struct = nullptr;
 	void* Ptr = nullptr;
 };
@@ -173,6 +205,38 @@ public:
 		return *this;
 	}
 
+	ExpressionValue& operator=(ExpressionValue&& v)
+	{
+		if (this != &v)
+		{
+			Deinit();
+
+			Type = v.Type;
+			if (!v.VariableProperty)
+			{
+				Ptr = (Type != ExpressionValueType::Nothing) ? &Buffer : nullptr;
+				switch (Type)
+				{
+				default: Buffer = v.Buffer; break;
+				case ExpressionValueType::ValueVector: new(PtrByte) vec3(std::move(*v.PtrVector)); break;
+				case ExpressionValueType::ValueRotator: new(PtrByte) Rotator(std::move(*v.PtrRotator)); break;
+				case ExpressionValueType::ValueString: new(PtrByte) std::string(std::move(*v.PtrString)); break;
+				case ExpressionValueType::ValueName: new(PtrByte) NameString(std::move(*v.PtrName)); break;
+				case ExpressionValueType::ValueColor: new(PtrByte) Color(std::move(*v.PtrColor)); break;
+				case ExpressionValueType::ValueStruct: new(PtrByte) StructValue(std::move(*v.GetStructValue())); Ptr = GetStructValue()->Ptr; break;
+				}
+			}
+			else
+			{
+				VariableProperty = v.VariableProperty;
+				Ptr = v.Ptr;
+			}
+			BoolInfo.Ptr = (uint32_t*)Ptr;
+			BoolInfo.Mask = v.BoolInfo.Mask;
+		}
+		return *this;
+	}
+
 	~ExpressionValue()
 	{
 		Deinit();
@@ -288,6 +352,10 @@ private:
 	const StructValue* GetStructValue() const { return reinterpret_cast<const StructValue*>(Buffer.Struct); }
 	StructValue* GetStructValue() { return reinterpret_cast<StructValue*>(Buffer.Struct); }
 
+	UStruct* GetStructType() const { return VariableProperty ? static_cast<UStructProperty*>(VariableProperty)->Struct : GetStructValue()->Struct; }
+
+	static bool IsStructEqual(UStruct* type, void* data1, void* data2);
+
 	union
 	{
 		uint8_t Byte;
@@ -407,28 +475,15 @@ inline void ExpressionValue::Store(const ExpressionValue& rvalue)
 	case ExpressionValueType::ValueInt: *PtrInt = rvalue.ToInt(); break;
 	case ExpressionValueType::ValueBool: BoolInfo.Set(rvalue.ToBool()); break;
 	case ExpressionValueType::ValueFloat: *PtrFloat = rvalue.ToFloat(); break;
-	case ExpressionValueType::ValueObject: *PtrObject = rvalue.ToObject(); break;
+	case ExpressionValueType::ValueObject: *PtrObject = rvalue.ToObject(); GC::WriteBarrier(*PtrObject); break;
 	case ExpressionValueType::ValueVector: *PtrVector = rvalue.ToVector(); break;
 	case ExpressionValueType::ValueRotator: *PtrRotator = rvalue.ToRotator(); break;
 	case ExpressionValueType::ValueString: *PtrString = rvalue.ToString(); break;
 	case ExpressionValueType::ValueName: *PtrName = rvalue.ToName(); break;
 	case ExpressionValueType::ValueColor: *PtrColor = rvalue.ToColor(); break;
 	case ExpressionValueType::ValueStruct:
-		if (rvalue.VariableProperty)
-		{
-			UStruct* Struct = static_cast<UStructProperty*>(rvalue.VariableProperty)->Struct;
-			if (Struct)
-			{
-				for (UProperty* prop : Struct->Properties)
-					prop->CopyValue(
-						static_cast<uint8_t*>(Ptr) + prop->DataOffset.DataOffset,
-						static_cast<uint8_t*>(rvalue.Ptr) + prop->DataOffset.DataOffset);
-			}
-		}
-		else
-		{
-			rvalue.GetStructValue()->Store(Ptr);
-		}
+		if (UStruct* type = rvalue.GetStructType())
+			StructValue::CopyValue(type, Ptr, rvalue.Ptr);
 		break;
 	}
 }
@@ -453,7 +508,7 @@ inline void ExpressionValue::Load()
 		case ExpressionValueType::ValueName: *value.PtrName = *PtrName; break;
 		case ExpressionValueType::ValueColor: *value.PtrColor = *PtrColor; break;
 		case ExpressionValueType::ValueStruct:
-			value.GetStructValue()->Load(dynamic_cast<UStructProperty*>(VariableProperty)->Struct, Ptr);
+			value.GetStructValue()->Load(GetStructType(), Ptr);
 			value.Ptr = value.GetStructValue()->Ptr;
 			break;
 		}
@@ -477,8 +532,31 @@ inline bool ExpressionValue::IsEqual(const ExpressionValue& value) const
 	case ExpressionValueType::ValueString: return ToString() == value.ToString();
 	case ExpressionValueType::ValueName: return ToName() == value.ToName();
 	case ExpressionValueType::ValueColor: return ToColor() == value.ToColor();
-	case ExpressionValueType::ValueStruct: Exception::Throw("IsEqual not implemented for complex structs");
+	case ExpressionValueType::ValueStruct:
+		{
+			UStruct* type = GetStructType();
+			if (value.Type != ExpressionValueType::ValueStruct || type != value.GetStructType())
+				return false;
+			return !type || IsStructEqual(type, Ptr, value.Ptr);
+		}
+	}
+}
+
+inline bool ExpressionValue::IsStructEqual(UStruct* type, void* data1, void* data2)
+{
+	// Compared member by member in place, as the padding and the unused bits of the bool bitfields can differ
+	for (UProperty* prop : type->Properties)
+	{
+		size_t size = prop->ElementSize();
+		for (int i = 0; i < prop->ArrayDimension; i++)
+		{
+			ExpressionValue member1(static_cast<uint8_t*>(data1) + prop->DataOffset.DataOffset + size * i, prop);
+			ExpressionValue member2(static_cast<uint8_t*>(data2) + prop->DataOffset.DataOffset + size * i, prop);
+			if (!member1.IsEqual(member2))
+				return false;
+		}
 	}
+	return true;
 }
 
 inline uint8_t ExpressionValue::ToByte() const
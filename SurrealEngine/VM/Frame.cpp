@@ -8,6 +8,8 @@
 #include "Audio/AudioSubsystem.h"
 #include "Engine.h"
 #include "Package/PackageManager.h"
+#include "Net/NetDriver.h"
+#include "UObject/UActor.h"
 
 std::function<void()> Frame::RunDebugger;
 std::vector<Breakpoint> Frame::Breakpoints;
@@ -70,7 +72,8 @@ void Frame::Break()
 
 	if (RunDebugger)
 	{
-		engine->audio->BreakpointTriggered();
+		if (engine->audio)
+			engine->audio->BreakpointTriggered();
 		RunDebugger();
 	}
 	else
@@ -149,6 +152,14 @@ ExpressionValue Frame::Call(UFunction* func, UObject* instance, std::vector<Expr
 		return ExpressionValue::NothingValue();
 	}
 
+	// Replicated functions may have to run on the other side of the connection instead
+	if (AllFlags(func->FuncFlags, FunctionFlags::Net) && engine->net)
+	{
+		UActor* actor = UObject::TryCast<UActor>(instance);
+		if (actor && engine->net->ProcessRemoteFunction(actor, func, args))
+			return ExpressionValue::NothingValue();
+	}
+
 	int argindex = 0;
 	for (UField* field = func->Children; field != nullptr; field = field->Next)
 	{
@@ -190,7 +201,8 @@ ExpressionValue Frame::Call(UFunction* func, UObject* instance, std::vector<Expr
 				auto& callback = NativeFunctions::NativeByIndex[func->NativeFuncIndex];
 				if (callback)
 				{
-					Frame frame(instance, func);
+					Frame frame(instance, nullptr);
+					frame.Func = func;
 					Callstack.push_back(&frame);
 					callback(instance, args.data());
 					Callstack.pop_back();
@@ -205,7 +217,8 @@ ExpressionValue Frame::Call(UFunction* func, UObject* instance, std::vector<Expr
 				auto& callback = NativeFunctions::NativeByName[{ func->Name, func->NativeStruct->Name }];
 				if (callback)
 				{
-					Frame frame(instance, func);
+					Frame frame(instance, nullptr);
+					frame.Func = func;
 					Callstack.push_back(&frame);
 					callback(instance, args.data());
 					Callstack.pop_back();
@@ -239,7 +252,11 @@ ExpressionValue Frame::Call(UFunction* func, UObject* instance, std::vector<Expr
 				{
 					if (argindex < args.size())
 					{
-						lvalue.Store(args[argindex]);
+						// Static arrays are passed whole
+						if (prop->ArrayDimension > 1 && args[argindex].IsVariable())
+							prop->CopyValue(lvalue.ToType<uint8_t*>(), args[argindex].ToType<uint8_t*>());
+						else
+							lvalue.Store(args[argindex]);
 					}
 
 					argindex++;
@@ -260,7 +277,10 @@ ExpressionValue Frame::Call(UFunction* func, UObject* instance, std::vector<Expr
 
 				if (AllFlags(prop->PropFlags, PropertyFlags::Parm | PropertyFlags::OutParm) && argindex < args.size())
 				{
-					args[argindex].Store(lvalue);
+					if (prop->ArrayDimension > 1 && args[argindex].IsVariable())
+						prop->CopyValue(args[argindex].ToType<uint8_t*>(), lvalue.ToType<uint8_t*>());
+					else
+						args[argindex].Store(lvalue);
 				}
 
 				if (AllFlags(prop->PropFlags, PropertyFlags::ReturnParm) && result.GetType() == ExpressionValueType::Nothing)
@@ -7,6 +7,7 @@
 #include "UObject/ULevel.h"
 #include "UObject/UActor.h"
 #include "Collision/OverlapCylinderLevel.h"
+#include "Trace.h"
 
 AllObjectsIterator::AllObjectsIterator(UObject* BaseClass, UObject** ReturnValue, NameString MatchTag) : BaseClass(BaseClass), ReturnValue(ReturnValue), MatchTag(MatchTag)
 {
@@ -36,7 +37,7 @@ AllFilesIterator::AllFilesIterator(const std::string& FileExtension, const std::
 
 	for (auto& packageName : packageNames)
 	{
-std::cout << "GP10" << std::endl;		
+		TRACE_EVENT_TEXT(TraceCategory::VM, "AllFiles", packageName.ToString());
 		auto package = engine->packages->GetPackage(packageName, 958);
 
 		if ((FileExtension.empty() || FilePath::extension(package->GetPackageFilename()) == FileExtension) && 
@@ -2,6 +2,7 @@
 #include "Precomp.h"
 #include "ScriptCall.h"
 #include "Frame.h"
+#include "FrameProfiler.h"
 #include <unordered_map>
 
 NameString ToNameString(EventName name)
@@ -67,9 +68,14 @@ ExpressionValue CallEvent(UObject* Context, EventName eventname, std::vector<Exp
 
 	UFunction* func = FindEventFunction(Context, ToNameString(eventname));
 	if (func)
+	{
+		PROFILE_ZONE(ProfileZone::Script);
 		return Frame::Call(func, Context, std::move(args));
+	}
 	else
+	{
 		return ExpressionValue::NothingValue();
+	}
 }
 
 ExpressionValue CallEvent(UObject* Context, const NameString& name, std::vector<ExpressionValue> args)
@@ -79,9 +85,14 @@ ExpressionValue CallEvent(UObject* Context, const NameString& name, std::vector<
 
 	UFunction* func = FindEventFunction(Context, name);
 	if (func)
+	{
+		PROFILE_ZONE(ProfileZone::Script);
 		return Frame::Call(func, Context, std::move(args));
+	}
 	else
+	{
 		return ExpressionValue::NothingValue();
+	}
 }
 
 UFunction* FindEventFunction(UObject* Context, const NameString& name)
@@ -62,9 +62,6 @@ SDL2Window::SDL2Window(GameWindowHost *windowHost) : windowHost(windowHost)
         std::cout << "SDL_GL_CreateContext: " << SDL_GetError() << std::endl;
         exit(1);
     }
-    else {
-        std::cout << "glContext is not nuLL! " << std::endl;
-    }
 
     GLenum result = glewInit();
 
@@ -73,9 +70,6 @@ SDL2Window::SDL2Window(GameWindowHost *windowHost) : windowHost(windowHost)
         fprintf(stderr, "Error: %s\n", glewGetErrorString(result));
         exit(1);
     }
-    else {
-        std::cout << "OPENGL INITIALIZE SUCCESS!" << std::endl;
-    }
 
     SDL_GL_MakeCurrent(m_SDLWindow, glContext);
 